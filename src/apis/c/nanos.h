@@ -123,6 +123,8 @@
  * - nanos interface family: deps_api
  *   - 1000: First implementation of dependencies plugins.
  *   - 1001: Commutative clause support.
+ *   - 1002: Task graph record and replay.
+ *   - 1003: Early release of a subset of the task dependences.
  * - nanos interface family: openmp
  *   - 1: First Nanos OpenMP interface: nanos_omp_single ( b ) service
  *   - 2: Including nanos_omp_barrier() service
@@ -226,6 +228,10 @@ NANOS_API_DECL(nanos_err_t, nanos_create_sliced_wd, ( nanos_wd_t *uwd, size_t nu
                                      nanos_wd_props_t *props, nanos_wd_dyn_props_t *dyn_props, size_t num_copies, nanos_copy_data_t **copies, size_t num_dimensions, nanos_region_dimension_internal_t **dimensions ));
 
 NANOS_API_DECL(nanos_err_t, nanos_submit, ( nanos_wd_t wd, size_t num_data_accesses, nanos_data_access_t *data_accesses, nanos_team_t team ));
+
+NANOS_API_DECL(nanos_err_t, nanos_create_wds_compact, ( nanos_wd_t *wds, size_t num_wds, nanos_const_wd_definition_t *const_data,
+                                                        nanos_wd_dyn_props_t *dyn_props, size_t data_size, void **data, nanos_wg_t wg ));
+NANOS_API_DECL(nanos_err_t, nanos_submit_wds, ( nanos_wd_t *wds, size_t num_wds, nanos_team_t team ));
 NANOS_API_DECL(nanos_err_t, nanos_outline, ( nanos_wd_t wd, nanos_pe_t pe ));
 
 NANOS_API_DECL(nanos_err_t, nanos_create_wd_and_run_compact, ( nanos_const_wd_definition_t *const_data, nanos_wd_dyn_props_t *dyn_props,
@@ -294,9 +300,16 @@ NANOS_API_DECL(nanos_err_t, nanos_expel_current_thread, (void));
 
 /* dependence */
 NANOS_API_DECL(nanos_err_t, nanos_dependence_release_all, ( void ) );
+NANOS_API_DECL(nanos_err_t, nanos_dependence_release, ( size_t num_data_accesses, nanos_data_access_t *data_accesses ) );
 NANOS_API_DECL(nanos_err_t, nanos_dependence_pendant_writes, ( bool *res, void *addr ));
 NANOS_API_DECL(nanos_err_t, nanos_dependence_create, ( nanos_wd_t pred, nanos_wd_t succ ) );
 
+/* task graph */
+NANOS_API_DECL(nanos_err_t, nanos_taskgraph_begin, ( nanos_taskgraph_t *graph ) );
+NANOS_API_DECL(nanos_err_t, nanos_taskgraph_end, ( nanos_taskgraph_t graph ) );
+NANOS_API_DECL(nanos_err_t, nanos_taskgraph_replay, ( nanos_taskgraph_t graph ) );
+NANOS_API_DECL(nanos_err_t, nanos_taskgraph_delete, ( nanos_taskgraph_t graph ) );
+
 /* worksharing */
 NANOS_API_DECL(nanos_err_t, nanos_worksharing_create ,( nanos_ws_desc_t **wsd, nanos_ws_t ws, nanos_ws_info_t *info, bool *b ) );
 NANOS_API_DECL(nanos_err_t, nanos_worksharing_next_item, ( nanos_ws_desc_t *wsd, nanos_ws_item_t *wsi ) );
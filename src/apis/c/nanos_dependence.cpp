@@ -25,6 +25,7 @@
 #include "instrumentationmodule_decl.hpp"
 #include "basethread.hpp"
 #include "workdescriptor.hpp"
+#include "taskgraph.hpp"
 
 /*! \defgroup capi_dependence Dependence services.
  *  \ingroup capi
@@ -50,6 +51,27 @@ NANOS_API_DEF(nanos_err_t, nanos_dependence_release_all, ( void ) )
    return NANOS_OK;
 }
 
+/*! \brief Releases some of the dependences of the current WD before it finishes
+ *
+ *  Each data access is matched by its dependence address with the accesses the current WD was
+ *  submitted with. Sibling tasks that only wait for the released accesses become ready, and
+ *  tasks created afterwards do not depend on them.
+ *
+ *  \param [in] num_data_accesses is the number of data accesses to release
+ *  \param [in] data_accesses is the array of data accesses to release
+ */
+NANOS_API_DEF(nanos_err_t, nanos_dependence_release, ( size_t num_data_accesses, nanos_data_access_t *data_accesses ))
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","dependence_release",NANOS_RUNTIME) );
+   try {
+      WD *wd = myThread->getCurrentWD();
+      if ( wd ) wd->releaseDependencies( num_data_accesses, ( DataAccess * ) data_accesses );
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
+
 /*! \brief Returns if there are any pendant write for a given addr
  *
  *  \param [out] res is the result
@@ -83,6 +105,87 @@ NANOS_API_DEF(nanos_err_t, nanos_dependence_create, ( nanos_wd_t pred, nanos_wd_
    }
    return NANOS_OK;
 }
+
+/*! \brief Starts recording the tasks submitted by the current WorkDescriptor
+ *
+ *  Every task submitted by the current WorkDescriptor until nanos_taskgraph_end is
+ *  called is executed as usual and recorded, together with the edges created by its
+ *  dependences, in a new task graph. Undeferred tasks are recorded as well, and are
+ *  run inline when the graph is replayed.
+ *
+ *  \param [out] graph is the new task graph
+ */
+NANOS_API_DEF(nanos_err_t, nanos_taskgraph_begin, ( nanos_taskgraph_t *graph ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","taskgraph_begin",NANOS_RUNTIME) );
+   try {
+      WD *wd = myThread->getCurrentWD();
+      ensure( wd->getTaskGraph() == NULL, "Current WD is already recording a task graph" );
+
+      TaskGraph *tg = NEW TaskGraph( *wd );
+      wd->setTaskGraph( tg );
+      *graph = ( nanos_taskgraph_t ) tg;
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
+
+/*! \brief Stops recording a task graph
+ *
+ *  \param [in] graph is the task graph being recorded by the current WorkDescriptor
+ */
+NANOS_API_DEF(nanos_err_t, nanos_taskgraph_end, ( nanos_taskgraph_t graph ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","taskgraph_end",NANOS_RUNTIME) );
+   try {
+      WD *wd = myThread->getCurrentWD();
+      ensure( wd->getTaskGraph() == ( TaskGraph * ) graph, "Task graph is not being recorded by the current WD" );
+
+      (( TaskGraph * ) graph)->end();
+      wd->setTaskGraph( NULL );
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
+
+/*! \brief Submits again the tasks recorded in a task graph
+ *
+ *  The tasks are linked with the edges computed while recording, without going
+ *  through the dependencies domain. The tasks previously submitted by the current
+ *  WorkDescriptor are waited for before replaying the graph, and the replayed tasks
+ *  must be waited for before submitting new tasks that access the same data.
+ *
+ *  \param [in] graph is a task graph recorded by the current WorkDescriptor
+ */
+NANOS_API_DEF(nanos_err_t, nanos_taskgraph_replay, ( nanos_taskgraph_t graph ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","taskgraph_replay",NANOS_SCHEDULING) );
+   try {
+      (( TaskGraph * ) graph)->replay( *myThread->getCurrentWD() );
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
+
+/*! \brief Deletes a task graph
+ *
+ *  \param [in] graph is the task graph to delete
+ */
+NANOS_API_DEF(nanos_err_t, nanos_taskgraph_delete, ( nanos_taskgraph_t graph ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","taskgraph_delete",NANOS_RUNTIME) );
+   try {
+      TaskGraph *tg = ( TaskGraph * ) graph;
+      ensure( !tg->isRecording(), "Deleting a task graph that is being recorded" );
+      delete tg;
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+   return NANOS_OK;
+}
 /*!
  * \}
  */ 
@@ -25,6 +25,7 @@
 #include "debug.hpp"
 #include "system.hpp"
 #include "workdescriptor.hpp"
+#include "taskgraph.hpp"
 #include "smpdd.hpp"
 #include "gpudd.hpp"
 #include "plugin.hpp"
@@ -113,7 +114,8 @@ NANOS_API_DEF( nanos_err_t, nanos_create_wd_compact, ( nanos_wd_t *uwd, nanos_co
 
    try
    {
-      if ( !const_data->props.mandatory_creation && !sys.throttleTaskIn() ) {
+      // Tasks submitted while recording a task graph are always created, so that the graph is complete
+      if ( !const_data->props.mandatory_creation && myThread->getCurrentWD()->getTaskGraph() == NULL && !sys.throttleTaskIn() ) {
          *uwd = 0;
          return NANOS_OK;
       }
@@ -128,6 +130,51 @@ NANOS_API_DEF( nanos_err_t, nanos_create_wd_compact, ( nanos_wd_t *uwd, nanos_co
    return NANOS_OK;
 }
 
+/*! \brief Creates several sibling WorkDescriptors of the same task at once
+ *
+ *  All the WorkDescriptors and their data environments are placed in a single memory chunk, and
+ *  the number of components of wg is updated once. They must be submitted with nanos_submit_wds.
+ *  Copies are not supported, NANOS_INVALID_PARAM is returned if const_data_ext has any. If the
+ *  runtime throttles task creation, all the elements of wds are set to 0 and the caller is
+ *  expected to run the task bodies itself.
+ *
+ *  \param wds array where the num_wds WorkDescriptors are stored
+ *  \param num_wds number of WorkDescriptors to create
+ *  \param const_data_ext bundle of constant information (shared among all work descriptor instances)
+ *  \param dyn_props bundle of dynamic properties (applied to every instance)
+ *  \param data_size size of the data environment of each instance
+ *  \param data if not NULL, array where the data environment of each instance is stored
+ *  \param uwg if (wg != 0) the new WDs are added to that WD
+ *  \sa nanos::System::createWDs
+ */
+NANOS_API_DEF( nanos_err_t, nanos_create_wds_compact, ( nanos_wd_t *wds, size_t num_wds, nanos_const_wd_definition_t *const_data_ext,
+                                                        nanos_wd_dyn_props_t *dyn_props, size_t data_size, void **data, nanos_wg_t uwg ) )
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","*_create_wd",NANOS_CREATION) );
+
+   nanos_const_wd_definition_internal_t *const_data = reinterpret_cast<nanos_const_wd_definition_internal_t*>(const_data_ext);
+
+   try
+   {
+      if ( num_wds == 0 ) return NANOS_OK;
+      // Copies are not supported when creating several WDs at once
+      if ( const_data->num_copies != 0 ) return NANOS_INVALID_PARAM;
+
+      // Tasks submitted while recording a task graph are always created, so that the graph is complete
+      if ( !const_data->props.mandatory_creation && myThread->getCurrentWD()->getTaskGraph() == NULL && !sys.throttleTaskIn() ) {
+         for ( size_t i = 0; i < num_wds; i++ ) wds[i] = 0;
+         return NANOS_OK;
+      }
+      sys.createWDs ( (WD **) wds, num_wds, const_data->num_devices, const_data->devices, data_size, const_data->data_alignment,
+                      data, (WD *) uwg, &const_data->props, dyn_props, const_data->description );
+
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+
+   return NANOS_OK;
+}
+
 /*! \brief Set arguments ready for translation
  *
  *  \sa nanos::WorkDescriptor
@@ -196,7 +243,13 @@ NANOS_API_DEF(nanos_err_t, nanos_submit, ( nanos_wd_t uwd, size_t num_data_acces
          *myThread->_file << "Submitting WD " << wd->getId() << " " << (wd->getDescription() == NULL ? "n/a" : wd->getDescription()) << std::endl;
       }
 
-      sys.setupWD( *wd, myThread->getCurrentWD() );
+      WD *current = myThread->getCurrentWD();
+      TaskGraph *graph = current->getTaskGraph();
+      if ( graph != NULL ) {
+         graph->record( *wd, data_accesses != NULL ? num_data_accesses : 0, data_accesses );
+      }
+
+      sys.setupWD( *wd, current );
 
       NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
 
@@ -238,6 +291,68 @@ NANOS_API_DEF(nanos_err_t, nanos_submit, ( nanos_wd_t uwd, size_t num_data_acces
 }
 
 
+/*! \brief Submits several WorkDescriptors without dependences at once
+ *
+ *  The WorkDescriptors are handed to the scheduler in a single batch. The contents of wds are
+ *  undefined after the call. NANOS_INVALID_PARAM is returned, having submitted none of them, if
+ *  any of them is NULL or sliced.
+ *
+ *  \sa nanos_create_wds_compact
+ */
+NANOS_API_DEF(nanos_err_t, nanos_submit_wds, ( nanos_wd_t *uwds, size_t num_wds, nanos_team_t team ))
+{
+   NANOS_INSTRUMENT( InstrumentStateAndBurst inst("api","submit_wds",NANOS_SCHEDULING) );
+
+   try {
+      if ( num_wds == 0 ) return NANOS_OK;
+      if ( uwds == NULL ) return NANOS_INVALID_PARAM;
+
+      WD ** wds = ( WD ** ) uwds;
+      for ( size_t i = 0; i < num_wds; i++ ) {
+         if ( wds[i] == NULL || wds[i]->getSlicer() != NULL ) return NANOS_INVALID_PARAM;
+      }
+
+      if ( team != NULL ) {
+         warning( "Submitting to another team not implemented yet" );
+      }
+
+      WD *current = myThread->getCurrentWD();
+      TaskGraph *graph = current->getTaskGraph();
+
+      NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
+      NANOS_INSTRUMENT ( static nanos_event_key_t create_wd_id = ID->getEventKey("create-wd-id"); )
+      NANOS_INSTRUMENT ( static nanos_event_key_t create_wd_ptr = ID->getEventKey("create-wd-ptr"); )
+      NANOS_INSTRUMENT ( nanos_event_key_t Keys[2]; )
+      NANOS_INSTRUMENT ( nanos_event_value_t Values[2]; )
+      NANOS_INSTRUMENT ( Keys[0] = create_wd_id; )
+      NANOS_INSTRUMENT ( Keys[1] = create_wd_ptr; )
+
+      for ( size_t i = 0; i < num_wds; i++ ) {
+         WD *wd = wds[i];
+
+         if ( sys.getVerboseCopies() ) {
+            *myThread->_file << "Submitting WD " << wd->getId() << " " << (wd->getDescription() == NULL ? "n/a" : wd->getDescription()) << std::endl;
+         }
+
+         if ( graph != NULL ) graph->record( *wd, 0, NULL );
+
+         sys.setupWD( *wd, current );
+
+         NANOS_INSTRUMENT ( Values[0] = (nanos_event_value_t) wd->getId(); )
+         NANOS_INSTRUMENT ( Values[1] = (nanos_event_value_t) wd; )
+         NANOS_INSTRUMENT( sys.getInstrumentation()->raisePointEvents(2, Keys, Values); )
+         NANOS_INSTRUMENT (sys.getInstrumentation()->raiseOpenPtPEvent ( NANOS_WD_DOMAIN, (nanos_event_id_t) wd->getId(), 0, 0 );)
+      }
+
+      sys.submit( wds, num_wds );
+   } catch ( nanos_err_t e) {
+      return e;
+   }
+
+   return NANOS_OK;
+}
+
+
 /*! \brief Creates a new WorkDescriptor and execute it inmediately
  *
  *  \param const_data_ext
@@ -304,6 +419,12 @@ NANOS_API_DEF( nanos_err_t, nanos_create_wd_and_run_compact, ( nanos_const_wd_de
          wd.setSchedulerData( reinterpret_cast<ScheduleWDData*>( schedData ), /* ownedByWD */ false );
       }
 
+      // Undeferred tasks are recorded too, so that replaying the graph runs them in order
+      TaskGraph *graph = myThread->getCurrentWD()->getTaskGraph();
+      if ( graph != NULL ) {
+         graph->record( wd, data_accesses != NULL ? num_data_accesses : 0, data_accesses, /* undeferred */ true );
+      }
+
       sys.setupWD( wd, myThread->getCurrentWD() );
 
       NANOS_INSTRUMENT ( static InstrumentationDictionary *ID = sys.getInstrumentation()->getInstrumentationDictionary(); )
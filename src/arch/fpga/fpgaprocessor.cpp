@@ -234,7 +234,7 @@ bool FPGAProcessor::tryPostOutlineTasks( size_t max )
          if ( wd->isOutlined() ) {
             //Only delete tasks executed using outlineWorkDependent
             Scheduler::postOutlineWork( wd, true /* schedule */, myThread );
-            delete[] (char *) wd;
+            sys.releaseWDMemory( wd );
          } else {
             //Mark inline tasks as done, they will be finished from the Scheduler
             wd->setDone();
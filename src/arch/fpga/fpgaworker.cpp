@@ -153,7 +153,7 @@ void FPGAWorker::handleFPGACreatedTasks() {
          totalSize = NANOS_ALIGNED_MEMORY_OFFSET( offsetPMD, sizePMD, 1);
       }
 
-      char * chunk = NEW char[totalSize];
+      char * chunk = ( char * ) sys.getWDChunkPool().allocate( totalSize );
       WD * uwd = ( WD * )( chunk );
       unsigned long long int * data = ( unsigned long long int * )( chunk + offsetData );
 
@@ -170,6 +170,7 @@ void FPGAWorker::handleFPGACreatedTasks() {
       FPGAWD * createdWd = new (uwd) FPGAWD( info->numDevices, devPtrs, sizeData, alignData, data,
          task->numCopies, ( task->numCopies > 0 ? copies : NULL ), info->translate, info->description.c_str() );
 
+      createdWd->setInChunkPool();
       createdWd->setHwRuntimeIds( task->parentId, task->taskId );
       createdWd->setTotalSize( totalSize );
       createdWd->setVersionGroupId( ( unsigned long )( info->numDevices ) );
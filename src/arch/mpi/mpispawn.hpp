@@ -149,8 +149,7 @@ class RemoteSpawn {
 							myThread->setCurrentWD(*previousWD);
 
 							// Destroy wd
-							finishedWD->~WorkDescriptor();
-							delete[] (char *)finishedWD;
+							sys.destroyWD( finishedWD );
 						}
 					}
 				}
@@ -161,7 +161,7 @@ bool OpenCLThread::processDependentWD ( WD * wd )
    if ( doSubmit != NULL ) {
       DependableObject::DependableObjectVector & preds = wd->getDOSubmit()->getPredecessors();
       for ( DependableObject::DependableObjectVector::iterator it = preds.begin(); it != preds.end(); it++ ) {
-         WD * wdPred = ( WD * ) it->second->getRelatedObject();
+         WD * wdPred = ( WD * ) (*it)->getRelatedObject();
          OpenCLDD& ddPred=static_cast<OpenCLDD&>(wdPred->getActiveDevice());
          if ( wdPred != NULL ) {
             if ( wdPred->isTiedTo() == NULL || wdPred->isTiedTo() == ( BaseThread * ) this ) {
@@ -43,7 +43,7 @@ SMPDevice &nanos::ext::getSMPDevice() {
 size_t SMPDD::_stackSize = 256*1024;
 
 inline SMPDD::~SMPDD() {
-   if ( _stack ) delete[] (char *) _stack;
+   if ( _stack ) getSMPDevice().getStackPool().release( _stack, _stackSize );
 #ifdef NANOS_DEBUG_ENABLED
    VALGRIND_STACK_DEREGISTER( _valgrind_stack_id );
 #endif
@@ -61,6 +61,8 @@ void SMPDD::prepareConfig ( Config &config )
    //! \note Get the stack size for this specific device
    config.registerConfigOption ( "smp-stack-size", NEW Config::SizeVar( _stackSize ), "Defines SMP::task stack size" );
    config.registerArgOption("smp-stack-size", "smp-stack-size");
+
+   getSMPDevice().getStackPool().config( config );
 }
 
 void SMPDD::initStack ( WD *wd )
@@ -98,7 +100,7 @@ void SMPDD::lazyInit ( WD &wd, bool isUserLevelThread, WD *previous )
    verbose0("Task " << wd.getId() << " initialization"); 
    if (isUserLevelThread) {
       if (previous == NULL) {
-         _stack = (void *) NEW char[_stackSize];
+         _stack = getSMPDevice().getStackPool().allocate( _stackSize );
 #ifdef NANOS_DEBUG_ENABLED
          _valgrind_stack_id = VALGRIND_STACK_REGISTER(
                  _stack, (void*)(((uintptr_t)_stack)+_stackSize) );
@@ -28,12 +28,13 @@
 #include "copydescriptor.hpp"
 #include "system_decl.hpp"
 #include "smptransferqueue.hpp"
+#include "smpstackpool.hpp"
 #include "globalregt.hpp"
 
 namespace nanos {
 
-SMPDevice::SMPDevice ( const char *n ) : Device ( n ), _transferQueue() {}
-SMPDevice::SMPDevice ( const SMPDevice &arch ) : Device ( arch ), _transferQueue() {}
+SMPDevice::SMPDevice ( const char *n ) : Device ( n ), _transferQueue(), _stackPool() {}
+SMPDevice::SMPDevice ( const SMPDevice &arch ) : Device ( arch ), _transferQueue(), _stackPool() {}
 
 /*! \brief SMPDevice destructor
  */
@@ -205,6 +206,10 @@ bool SMPDevice::tryExecuteTransfer() {
    return _transferQueue.tryExecuteOne();
 }
 
+SMPStackPool & SMPDevice::getStackPool() {
+   return _stackPool;
+}
+
 } // namespace nanos
 
 #endif
@@ -27,6 +27,7 @@
 #include "processingelement_fwd.hpp"
 #include "copydescriptor.hpp"
 #include "smptransferqueue_decl.hpp"
+#include "smpstackpool_decl.hpp"
 
 namespace nanos {
 
@@ -36,6 +37,7 @@ namespace nanos {
    class SMPDevice : public Device
    {
       SMPTransferQueue _transferQueue;
+      SMPStackPool     _stackPool;      /**< Stacks of the user level threads */
       public:
          /*! \brief SMPDevice constructor
           */
@@ -76,6 +78,10 @@ namespace nanos {
           */
          bool tryExecuteTransfer();
 
+         /*! \brief Returns the pool of user level thread stacks
+          */
+         SMPStackPool & getStackPool();
+
    };
 } // namespace nanos
 
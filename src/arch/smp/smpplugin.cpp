@@ -436,6 +436,11 @@ nanos::PE * smpProcessorFactory ( int id, int uid )
       }
    }
 
+   std::string SMPPlugin::getExecutionSummary() const
+   {
+      return getSMPDevice().getStackPool().getSummary();
+   }
+
    void SMPPlugin::addPEs( PEMap &pes ) const
    {
       for ( std::vector<SMPProcessor *>::const_iterator it = _cpus->begin(); it != _cpus->end(); it++ ) {
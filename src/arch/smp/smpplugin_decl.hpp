@@ -124,6 +124,8 @@ class SMPPlugin : public SMPBasePlugin
 
    virtual void finalize();
 
+   virtual std::string getExecutionSummary() const;
+
    virtual void addPEs( PEMap &pes ) const;
 
    virtual void addDevices( DeviceList &devices ) const;
@@ -169,7 +169,7 @@ void SMPProcessor::switchTo ( WD *wd, SchedulerHelper *helper )
    // wd MUST have an active SMP Device when it gets here
    ensure( wd->hasActiveDevice(),"WD has no active SMP device" );
    SMPDD &dd = ( SMPDD & )wd->getActiveDevice();
-   ensure( dd.hasStack(), "DD has no stack for ULT");
+   ensure( dd.hasStack() || wd->isStackless(), "DD has no stack for ULT");
    WD * currentWD = myThread->getCurrentWD();
 
    ::switchStacks(
@@ -184,7 +184,7 @@ void SMPProcessor::exitTo ( WD *wd, SchedulerHelper *helper)
    // wd MUST have an active SMP Device when it gets here
    ensure( wd->hasActiveDevice(),"WD has no active SMP device" );
    SMPDD &dd = ( SMPDD & )wd->getActiveDevice();
-   ensure( dd.hasStack(), "DD has no stack for ULT");
+   ensure( dd.hasStack() || wd->isStackless(), "DD has no stack for ULT");
    WD * currentWD = myThread->getCurrentWD();
 
    //TODO: optimize... we don't really need to save a context in this case
@@ -0,0 +1,235 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "smpstackpool.hpp"
+#include "basethread.hpp"
+#include "processingelement.hpp"
+#include "config.hpp"
+#include "debug.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <sstream>
+
+using namespace nanos;
+
+volatile unsigned SMPStackPool::_numPools = 0;
+__thread SMPStackPool::ThreadCache * SMPStackPool::_myCaches[SMPStackPool::MAX_CACHED_POOLS];
+
+SMPStackPool::SMPStackPool () : _id( newId() ), _threadCacheSize( 16 ), _reservoirSize( 64 ), _guardPages( false ),
+   _pageSize( sysconf( _SC_PAGESIZE ) ), _lock(), _reservoirs(), _caches( NULL ), _reservoirHits( 0 ),
+   _mapped( 0 ), _peak( 0 ), _created( 0 ) {}
+
+SMPStackPool::~SMPStackPool ()
+{
+   for ( ReservoirList::iterator it = _reservoirs.begin(); it != _reservoirs.end(); it++ ) {
+      unmapStacks( it->_head );
+   }
+
+   while ( _caches != NULL ) {
+      ThreadCache *cache = _caches;
+      _caches = cache->_next;
+      unmapStacks( cache->_free._head );
+      delete cache;
+   }
+}
+
+void SMPStackPool::config ( Config &cfg )
+{
+   cfg.registerConfigOption ( "smp-stack-cache", NEW Config::UintVar( _threadCacheSize ),
+                              "Number of stacks kept by every thread for reuse, 0 disables the pool (default = 16)" );
+   cfg.registerArgOption ( "smp-stack-cache", "smp-stack-cache" );
+   cfg.registerEnvOption ( "smp-stack-cache", "NX_SMP_STACK_CACHE" );
+
+   cfg.registerConfigOption ( "smp-stack-reservoir", NEW Config::UintVar( _reservoirSize ),
+                              "Number of stacks shared by the threads of each NUMA node (default = 64)" );
+   cfg.registerArgOption ( "smp-stack-reservoir", "smp-stack-reservoir" );
+
+   cfg.registerConfigOption ( "smp-stack-guard", NEW Config::FlagOption( _guardPages ),
+                              "Protect the stacks with a guard page (default = no)" );
+   cfg.registerArgOption ( "smp-stack-guard", "smp-stack-guard" );
+}
+
+unsigned SMPStackPool::newId ()
+{
+   // Pools may be created during the static initialization, _numPools has no constructor to run
+   unsigned id;
+   do {
+      id = _numPools;
+   } while ( !compareAndSwap( &_numPools, id, id + 1 ) );
+   return id;
+}
+
+SMPStackPool::ThreadCache * SMPStackPool::createCache ()
+{
+   // External threads may finish at any time, they use the reservoirs directly
+   BaseThread *thread = getMyThreadSafe();
+   if ( thread == NULL ) return NULL;
+
+   ProcessingElement *pe = thread->runningOn();
+   ThreadCache *cache = NEW ThreadCache( pe != NULL ? pe->getNumaNode() : 0 );
+
+   LockBlock lock( _lock );
+   cache->_next = _caches;
+   _caches = cache;
+
+   return cache;
+}
+
+SMPStackPool::FreeList & SMPStackPool::getReservoir ( unsigned node )
+{
+   if ( node >= _reservoirs.size() ) _reservoirs.resize( node + 1 );
+   return _reservoirs[node];
+}
+
+void * SMPStackPool::allocateSlow ( ThreadCache *cache, size_t size )
+{
+   if ( _threadCacheSize > 0 ) {
+      LockBlock lock( _lock );
+      FreeList &reservoir = getReservoir( cache != NULL ? cache->_node : 0 );
+
+      // Stacks of another size (left by a previous stack size setting) are not reused
+      StackHeader **prev = &reservoir._head;
+      while ( *prev != NULL && ( *prev )->_size != size ) prev = &( *prev )->_next;
+
+      if ( *prev != NULL ) {
+         StackHeader *stack = *prev;
+         *prev = stack->_next;
+         reservoir._size--;
+         _reservoirHits++;
+         return ( void * ) stack;
+      }
+   }
+
+   return ( void * ) mapStack( size );
+}
+
+void SMPStackPool::releaseSlow ( ThreadCache *cache, StackHeader *stack )
+{
+   if ( _threadCacheSize == 0 ) {
+      stack->_next = NULL;
+      unmapStacks( stack );
+      return;
+   }
+
+   // Leave half of the cache in the thread and move the rest, with the released stack, to the reservoir
+   StackHeader *head = stack, *tail = stack;
+   size_t moved = 1;
+   if ( cache != NULL ) {
+      size_t keep = _threadCacheSize / 2;
+      tail->_next = cache->_free._head;
+      for ( ; moved <= cache->_free._size - keep; moved++ ) tail = tail->_next;
+      cache->_free._head = tail->_next;
+      cache->_free._size = keep;
+   }
+   tail->_next = NULL;
+
+   // Give the memory back to the OS but keep the mapping. The first page holds the header
+   for ( StackHeader *it = head; it != NULL; it = it->_next ) {
+      size_t length = ( ( it->_size + _pageSize - 1 ) & ~( _pageSize - 1 ) ) - _pageSize;
+#ifdef MADV_FREE
+      madvise( ( char * ) it + _pageSize, length, MADV_FREE );
+#else
+      madvise( ( char * ) it + _pageSize, length, MADV_DONTNEED );
+#endif
+   }
+
+   // The stacks that do not fit in the reservoir are unmapped out of the lock
+   StackHeader *excess = NULL;
+   {
+      LockBlock lock( _lock );
+      FreeList &reservoir = getReservoir( cache != NULL ? cache->_node : 0 );
+      size_t room = reservoir._size < _reservoirSize ? _reservoirSize - reservoir._size : 0;
+
+      if ( room < moved ) {
+         if ( room == 0 ) {
+            excess = head;
+            head = NULL;
+         } else {
+            moved = room;
+            for ( tail = head; room > 1; room-- ) tail = tail->_next;
+            excess = tail->_next;
+            tail->_next = NULL;
+         }
+      }
+
+      if ( head != NULL ) {
+         tail->_next = reservoir._head;
+         reservoir._head = head;
+         reservoir._size += moved;
+      }
+   }
+
+   unmapStacks( excess );
+}
+
+SMPStackPool::StackHeader * SMPStackPool::mapStack ( size_t size )
+{
+   size_t guard = getGuardSize();
+   size_t length = guard + ( ( size + _pageSize - 1 ) & ~( _pageSize - 1 ) );
+
+   char *base = ( char * ) mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+   fatal_cond0( base == MAP_FAILED, "Cannot map a stack of " << size << " bytes" );
+
+   // Stacks grow downwards in all the supported architectures
+   if ( guard > 0 && mprotect( base, guard, PROT_NONE ) != 0 ) {
+      warning0( "Cannot protect the guard page of a stack" );
+   }
+
+   {
+      LockBlock lock( _lock );
+      _created++;
+      if ( ++_mapped > _peak ) _peak = _mapped;
+   }
+
+   return ( StackHeader * ) ( base + guard );
+}
+
+void SMPStackPool::unmapStacks ( StackHeader *head )
+{
+   size_t unmapped = 0;
+   size_t guard = getGuardSize();
+
+   while ( head != NULL ) {
+      StackHeader *next = head->_next;
+      size_t length = guard + ( ( head->_size + _pageSize - 1 ) & ~( _pageSize - 1 ) );
+      munmap( ( char * ) head - guard, length );
+      unmapped++;
+      head = next;
+   }
+
+   if ( unmapped > 0 ) {
+      LockBlock lock( _lock );
+      _mapped -= unmapped;
+   }
+}
+
+std::string SMPStackPool::getSummary ()
+{
+   LockBlock lock( _lock );
+
+   size_t hits = _reservoirHits;
+   for ( ThreadCache *cache = _caches; cache != NULL; cache = cache->_next ) hits += cache->_hits;
+
+   std::ostringstream output;
+   if ( _created > 0 ) {
+      output << "=== Stacks mapped: " << _created << ", reused: " << hits
+             << " (" << _reservoirHits << " from the reservoirs), peak mapped: " << _peak << std::endl;
+   }
+   return output.str();
+}
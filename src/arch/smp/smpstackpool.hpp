@@ -0,0 +1,77 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMP_STACK_POOL
+#define _NANOS_SMP_STACK_POOL
+
+#include "smpstackpool_decl.hpp"
+
+namespace nanos {
+
+inline SMPStackPool::ThreadCache * SMPStackPool::myCache ()
+{
+   if ( _id >= MAX_CACHED_POOLS ) return NULL;
+
+   ThreadCache *&cache = _myCaches[_id];
+   if ( cache == NULL && _threadCacheSize > 0 ) cache = createCache();
+   return cache;
+}
+
+inline size_t SMPStackPool::getGuardSize () const
+{
+   return _guardPages ? _pageSize : 0;
+}
+
+inline void * SMPStackPool::allocate ( size_t size )
+{
+   ThreadCache *cache = myCache();
+
+   if ( cache != NULL ) {
+      StackHeader *stack = cache->_free._head;
+      if ( stack != NULL && stack->_size == size ) {
+         cache->_free._head = stack->_next;
+         cache->_free._size--;
+         cache->_hits++;
+         return ( void * ) stack;
+      }
+   }
+
+   return allocateSlow( cache, size );
+}
+
+inline void SMPStackPool::release ( void *stack, size_t size )
+{
+   // The header lives at the bottom of the stack, which the task may have overwritten
+   StackHeader *header = ( StackHeader * ) stack;
+   header->_size = size;
+
+   ThreadCache *cache = myCache();
+   if ( cache != NULL && cache->_free._size < _threadCacheSize ) {
+      header->_next = cache->_free._head;
+      cache->_free._head = header;
+      cache->_free._size++;
+      return;
+   }
+
+   releaseSlow( cache, header );
+}
+
+} // namespace nanos
+
+#endif
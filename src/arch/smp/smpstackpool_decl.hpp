@@ -0,0 +1,146 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMP_STACK_POOL_DECL
+#define _NANOS_SMP_STACK_POOL_DECL
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "lock_decl.hpp"
+#include "config_fwd.hpp"
+
+namespace nanos {
+
+   /*! \class SMPStackPool
+    *  \brief Recycles the stacks of the user level threads (see SMPDD::lazyInit)
+    *
+    *  Stacks are mapped with mmap and, if enabled, have a PROT_NONE guard page below them so an
+    *  overflow faults instead of corrupting memory. Guard pages are disabled by default: each one
+    *  costs an mprotect and splits the stack in two mappings, which is noticeable with many
+    *  stacks. A released stack is kept in a free list that the releasing thread has for the
+    *  pool; once that list holds threadCacheSize stacks, half of them
+    *  go to a reservoir of the NUMA node of the thread, where their pages are handed back to
+    *  the OS with MADV_FREE while keeping the mapping. The reservoir of each node keeps at most
+    *  reservoirSize stacks and the rest are unmapped. Only stacks of the requested size are
+    *  reused.
+    */
+   class SMPStackPool
+   {
+      public:
+         enum {
+            MAX_CACHED_POOLS = 4   /**< Pools with a cache in every thread, the others only use their reservoirs */
+         };
+
+      private:
+         struct StackHeader {
+            StackHeader   *_next;        /**< Next stack in a free list */
+            size_t         _size;        /**< Usable size of the stack */
+         };
+
+         struct FreeList {
+            StackHeader   *_head;
+            size_t         _size;
+
+            FreeList () : _head( NULL ), _size( 0 ) {}
+         };
+
+         struct ThreadCache {
+            FreeList       _free;        /**< Free stacks, only used by the owner */
+            unsigned       _node;        /**< NUMA node of the reservoir used by the thread */
+            size_t         _hits;        /**< Stacks taken from _free */
+            ThreadCache   *_next;        /**< Next cache of the pool */
+
+            ThreadCache ( unsigned node ) : _free(), _node( node ), _hits( 0 ), _next( NULL ) {}
+         };
+
+         typedef std::vector<FreeList> ReservoirList;
+
+         unsigned                    _id;               /**< Index of the caches of the pool in _myCaches */
+         unsigned                    _threadCacheSize;  /**< Stacks kept by every thread */
+         unsigned                    _reservoirSize;    /**< Stacks kept in the reservoir of each NUMA node */
+         bool                        _guardPages;       /**< Whether stacks get a guard page */
+         size_t                      _pageSize;
+         Lock                        _lock;             /**< Protects the reservoirs, the statistics and the list of caches */
+         ReservoirList               _reservoirs;       /**< Stacks shared by the threads of each NUMA node */
+         ThreadCache                *_caches;           /**< Caches created so far */
+         size_t                      _reservoirHits;    /**< Stacks taken from the reservoirs */
+         size_t                      _mapped;           /**< Stacks currently mapped */
+         size_t                      _peak;             /**< Maximum value of _mapped */
+         size_t                      _created;          /**< Stacks mapped so far */
+
+         static volatile unsigned    _numPools;         /**< Pools created so far */
+         static __thread ThreadCache *_myCaches[MAX_CACHED_POOLS]; /**< Caches of the current thread, NULL if none yet */
+
+         /*! \brief SMPStackPool copy constructor (private)
+          */
+         SMPStackPool ( const SMPStackPool & );
+         /*! \brief SMPStackPool copy assignment operator (private)
+          */
+         const SMPStackPool & operator= ( const SMPStackPool & );
+
+         /*! \brief Returns the cache of the current thread for this pool, creating it if needed
+          *
+          *  Returns NULL if the cache is disabled, for threads that are not Nanos++ threads and
+          *  for pools created after the first MAX_CACHED_POOLS.
+          */
+         ThreadCache * myCache ();
+         ThreadCache * createCache ();
+         static unsigned newId ();
+
+         /*! \brief Size of the guard area below new stacks */
+         size_t getGuardSize () const;
+
+         /*! \brief Returns the reservoir of a NUMA node, the lock must be held */
+         FreeList & getReservoir ( unsigned node );
+
+         /*! \brief Takes a stack from the reservoir or maps a new one */
+         void * allocateSlow ( ThreadCache *cache, size_t size );
+         /*! \brief Moves half of the cache and the stack to the reservoir */
+         void releaseSlow ( ThreadCache *cache, StackHeader *stack );
+
+         StackHeader * mapStack ( size_t size );
+         void unmapStacks ( StackHeader *head );
+
+      public:
+         /*! \brief SMPStackPool default constructor
+          */
+         SMPStackPool ();
+         /*! \brief SMPStackPool destructor
+          */
+         ~SMPStackPool ();
+
+         void config ( Config &cfg );
+
+         /*! \brief Returns a stack of size bytes
+          */
+         void * allocate ( size_t size );
+
+         /*! \brief Releases a stack returned by allocate( size )
+          */
+         void release ( void *stack, size_t size );
+
+         /*! \brief Returns the statistics of the pool for the execution summary
+          */
+         std::string getSummary ();
+   };
+
+} // namespace nanos
+
+#endif
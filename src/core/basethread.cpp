@@ -69,6 +69,43 @@ WD * BaseThread::getNextWD ()
    return next;
 }
 
+void BaseThread::deferWD ( WD *wd )
+{
+   _deferredWDs.push_back( wd );
+}
+
+void BaseThread::resumeDeferredWDs ()
+{
+   if ( _deferredWDs.empty() ) return;
+   _nextWDs.transferElemsFrom( _deferredWDs );
+   sys.getThreadManager()->unblockThread(this);
+}
+
+void BaseThread::moveSchedulingLoop ()
+{
+   if ( _loopWD == NULL ) {
+      // Set up as the thread WD, it gets its stack when the thread first switches to it
+      WD &loop = runningOn()->getWorkerWD();
+      if ( sys.getPMInterface().getInternalDataSize() > 0 ) {
+         char *data = NEW char[sys.getPMInterface().getInternalDataSize()];
+         sys.getPMInterface().initInternalData( data );
+         loop.setInternalData( data );
+      }
+      sys.getPMInterface().setupWD( loop );
+      loop._mcontrol.preInit();
+      loop.tieTo( *this );
+      _loopWD = &loop;
+   }
+   resumeDeferredWDs();
+}
+
+void BaseThread::restoreSchedulingLoop ()
+{
+   // The moved loop is suspended in a switch or was never started, nothing runs on its stack any more
+   delete _loopWD;
+   _loopWD = NULL;
+}
+
 WDDeque &BaseThread::getNextWDQueue() {
    return _nextWDs;
 }
@@ -154,8 +191,9 @@ void BaseThread::leaveTeam()
    TeamData *td = _teamData;
    leaveTeamNoDeleteTeamData();
    if ( td ) {
-      //Remove thread's teamData
-      delete td;
+      // The rest of the team may still be stealing from our queues, the team keeps it
+      // until we rejoin or the team is destroyed
+      td->getTeam()->keepLeftTeamData( *this, td );
    }
 }
 
@@ -33,6 +33,7 @@
 #include "processingelement.hpp"
 #include "basethread_decl.hpp"
 #include "wddeque.hpp"
+#include "idletuner.hpp"
 #include "smpthread.hpp"
 #include <stdio.h>
 
@@ -53,6 +54,15 @@ namespace nanos {
 
    inline bool TeamData::isCreator ( void ) const { return _creator; }
 
+   inline void TeamData::reset ( void )
+   {
+      _singleCount = 0;
+      _parentData = NULL;
+      _wsDescriptor = NULL;
+      _star = false;
+      _creator = false;
+   }
+
    inline nanos_ws_desc_t *TeamData::getTeamWorkSharingDescriptor( BaseThread *thread, bool *b )
    {
       nanos_ws_desc_t *next = NULL, *myNext = NULL;
@@ -112,8 +122,8 @@ namespace nanos {
 
    inline BaseThread::BaseThread ( unsigned int osId, WD &wd, ProcessingElement *creator, ext::SMPMultiThread *parent ) :
       _id( sys.nextThreadId() ), _osId( osId ), _maxPrefetch( 1 ), _status( ), _parent( parent ), _pe( creator ), _mlock( ),
-      _threadWD( wd ), _currentWD( NULL ), _heldWD( NULL ), _nextWDs( /* enableDeviceCounter */ false ), _teamData( NULL ), _nextTeamData( NULL ),
-      _name( "Thread" ), _description( "" ), _allocator( ), _steps(0), _bpCallBack( NULL ), _nextTeam( NULL ), _gasnetAllowAM( true ), _pendingRequests()
+      _threadWD( wd ), _currentWD( NULL ), _heldWD( NULL ), _nextWDs( /* enableDeviceCounter */ false ), _deferredWDs( /* enableDeviceCounter */ false ), _loopWD( NULL ), _teamData( NULL ), _nextTeamData( NULL ),
+      _name( "Thread" ), _description( "" ), _allocator( ), _steps(0), _bpCallBack( NULL ), _nextTeam( NULL ), _idleTuner(), _gasnetAllowAM( true ), _pendingRequests()
    {
          if ( sys.getSplitOutputForThreads() ) {
             if ( _parent != NULL ) {
@@ -147,7 +157,13 @@ namespace nanos {
 
    inline void BaseThread::stop() { _status.must_stop = true; }
 
-   inline void BaseThread::wakeup() { _status.must_sleep = false; }
+   inline void BaseThread::wakeup()
+   {
+      // Only the adaptive idle mode measures wake ups
+      ThreadManager *thread_manager = sys.getThreadManager();
+      if ( thread_manager != NULL && thread_manager->isAdaptive() ) _idleTuner.requestWakeup();
+      _status.must_sleep = false;
+   }
 
    inline void BaseThread::pause ()
    {
@@ -177,7 +193,7 @@ namespace nanos {
 
    inline WD * BaseThread::getCurrentWD () const { return _currentWD; }
 
-   inline WD & BaseThread::getThreadWD () const { return _threadWD; }
+   inline WD & BaseThread::getThreadWD () const { return _loopWD != NULL ? *_loopWD : _threadWD; }
 
    inline int BaseThread::getMaxPrefetch () const { return ( int ) _maxPrefetch; }
 
@@ -187,6 +203,10 @@ namespace nanos {
 
    inline bool BaseThread::hasNextWD () const { return !_nextWDs.empty(); }
 
+   inline bool BaseThread::hasDeferredWDs () const { return !_deferredWDs.empty(); }
+
+   inline bool BaseThread::hasMovedSchedulingLoop () const { return _loopWD != NULL; }
+
    inline int BaseThread::getMaxConcurrentTasks () const { return 1; }
 
    inline ext::SMPMultiThread * BaseThread::getParent() { return _parent; }
@@ -256,6 +276,8 @@ namespace nanos {
 
    inline Allocator & BaseThread::getAllocator() { return _allocator; }
 
+   inline IdleTuner & BaseThread::getIdleTuner() { return _idleTuner; }
+
    inline void BaseThread::rename ( const char *name ) { _name = name; }
 
    inline const std::string & BaseThread::getName ( void ) const { return _name; }
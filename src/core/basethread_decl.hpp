@@ -35,6 +35,7 @@
 #include "workdescriptor_decl.hpp"
 #include "allocator_decl.hpp"
 #include "wddeque_decl.hpp"
+#include "idletuner_decl.hpp"
 
 namespace nanos {
 
@@ -110,6 +111,10 @@ namespace nanos {
 
          void setCreator ( bool value ) ;
          bool isCreator ( void ) const;
+
+        /*! \brief Resets the TeamData of a thread rejoining its team, keeping its scheduling data
+         */
+         void reset ( void ) ;
    };
 
    namespace ext {
@@ -187,6 +192,8 @@ namespace nanos {
          WD                     *_currentWD;     /**< Current WorkDescriptor the thread is executing */
          WD                     *_heldWD;
          WDDeque                 _nextWDs;       /**< Queue with all the tasks that the thread is being run simultaneously */
+         WDDeque                 _deferredWDs;   /**< Started WDs waiting for the stackless WDs of the thread to finish */
+         WD                     *_loopWD;        /**< Scheduling loop moved to a new stack while a blocked stackless WD keeps the stack below it, NULL if none */
          // Thread's Team info:
          TeamData               *_teamData;      /**< Current team data, thread is registered and also it has entered to the team */
          TeamData               *_nextTeamData;  /**< Next team data, thread is already registered in a new team but has not enter yet */
@@ -199,6 +206,7 @@ namespace nanos {
          unsigned short          _steps;         //!< Number of scheduler steps (zero means infinite)
          callback_t              _bpCallBack;    //!< Break point callback. We call it after _steps scheduler ops
          ThreadTeam             *_nextTeam;      //!< If thread has no team, which team should it join
+         IdleTuner               _idleTuner;     //!< Spin/yield/block budgets of the adaptive idle mode
 
       private:
          virtual void runDependent () = 0;
@@ -293,6 +301,29 @@ namespace nanos {
          virtual WD * getNextWD ();
          virtual bool hasNextWD () const;
 
+         /*! \brief Keeps a started WD tied to the thread until its stackless WDs finish or block
+          *
+          *  A stackless WD runs on the stack of the thread, so the thread cannot resume a suspended
+          *  WD on top of it (see Scheduler::switchTo).
+          */
+         void deferWD ( WD *wd );
+         //! \brief Makes the deferred WDs available again as next WDs of the thread
+         void resumeDeferredWDs ();
+         //! \brief Whether the thread keeps deferred WDs that wait for its stackless WDs to finish
+         bool hasDeferredWDs () const;
+
+         /*! \brief Moves the scheduling loop of the thread to a new stack, if not done yet, and resumes its deferred WDs
+          *
+          *  A stackless WD that blocks keeps the stack it runs on, with the frames of the WD that started
+          *  it below, as its own context. Until it finishes, getThreadWD() returns a new worker WD that
+          *  runs the scheduling loop on a stack of its own (see Scheduler::switchTo).
+          */
+         void moveSchedulingLoop ();
+         //! \brief Deletes the moved scheduling loop once the stackless WDs of the thread have finished
+         void restoreSchedulingLoop ();
+         //! \brief Whether the scheduling loop runs on a new stack because a stackless WD has blocked
+         bool hasMovedSchedulingLoop () const;
+
          // Return the number of concurrent tasks (tasks that can be run by this thread at the same time)
          int getMaxConcurrentTasks() const;
 
@@ -374,6 +405,10 @@ namespace nanos {
           */
          Allocator & getAllocator();
 
+         /*! \brief Get the idle phase measurements of the thread (adaptive idle mode)
+          */
+         IdleTuner & getIdleTuner();
+
          /*! \brief Rename the basethread
           */
          void rename ( const char *name );
@@ -0,0 +1,69 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_COMMUTATIVE_GROUP_H
+#define _NANOS_COMMUTATIVE_GROUP_H
+
+#include "commutativegroup_decl.hpp"
+#include "lock.hpp"
+
+namespace nanos {
+
+inline WorkDescriptor * CommutativeGroup::getOwner () const
+{
+   return _owner;
+}
+
+inline Lock & CommutativeGroup::getLock ()
+{
+   return _lock;
+}
+
+inline bool CommutativeGroup::acquireInLock ( WorkDescriptor &wd )
+{
+   // A free target has no waiting tasks: they are handed the target on release
+   if ( _owner == NULL ) _owner = &wd;
+   return _owner == &wd;
+}
+
+inline bool CommutativeGroup::acquire ( WorkDescriptor &wd, bool wait )
+{
+   LockBlock lock( _lock );
+   if ( acquireInLock( wd ) ) return true;
+   if ( wait ) _waiting.push_back( &wd );
+   return false;
+}
+
+inline WorkDescriptor * CommutativeGroup::release ( WorkDescriptor &wd )
+{
+   LockBlock lock( _lock );
+   if ( _owner != &wd ) return NULL;
+
+   if ( _waiting.empty() ) {
+      _owner = NULL;
+   } else {
+      _owner = _waiting.front();
+      _waiting.pop_front();
+   }
+   return _owner;
+}
+
+} // namespace nanos
+
+#endif
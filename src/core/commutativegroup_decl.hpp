@@ -0,0 +1,81 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_COMMUTATIVE_GROUP_DECL_H
+#define _NANOS_COMMUTATIVE_GROUP_DECL_H
+
+#include <deque>
+#include "lock_decl.hpp"
+#include "workdescriptor_fwd.hpp"
+#include "commutativegroup_fwd.hpp"
+
+namespace nanos {
+
+   /*! \class CommutativeGroup
+    *  \brief Exclusive ownership of a commutative target among the sibling tasks accessing it
+    *
+    *  Ready tasks that find the target owned by another task wait in the group instead of
+    *  being queued in the scheduler. When the owner releases the target, ownership is handed
+    *  directly to the first waiting task, which is then resumed (see
+    *  WorkDescriptor::releaseCommutativeAccesses).
+    */
+   class CommutativeGroup
+   {
+      private:
+         typedef std::deque<WorkDescriptor *> WaitingList;
+
+         Lock              _lock;      //!< Protects the owner and the waiting list
+         WorkDescriptor   *_owner;     //!< Task holding the target (NULL if free)
+         WaitingList       _waiting;   //!< Tasks waiting for the target, in arrival order
+
+      private:
+         /*! \brief CommutativeGroup copy constructor (disabled) */
+         CommutativeGroup ( const CommutativeGroup & );
+         /*! \brief CommutativeGroup copy assignment operator (disabled) */
+         const CommutativeGroup & operator= ( const CommutativeGroup & );
+
+      public:
+         /*! \brief CommutativeGroup default constructor */
+         CommutativeGroup () : _lock(), _owner( NULL ), _waiting() {}
+
+         /*! \brief Returns the task holding the target, if any */
+         WorkDescriptor * getOwner () const;
+
+         /*! \brief Returns the lock protecting the group */
+         Lock & getLock ();
+
+         /*! \brief Takes the target for wd if it is free
+          *  \param wait If set and the target is owned by another task, wd is queued to be
+          *         handed the target when it is released
+          *  \return whether wd owns the target
+          */
+         bool acquire ( WorkDescriptor &wd, bool wait );
+
+         /*! \brief Takes the target for wd if it is free, group lock must be held */
+         bool acquireInLock ( WorkDescriptor &wd );
+
+         /*! \brief Releases the target held by wd
+          *  \return the waiting task that now owns the target, or NULL if it is free
+          */
+         WorkDescriptor * release ( WorkDescriptor &wd );
+   };
+
+} // namespace nanos
+
+#endif
@@ -21,7 +21,7 @@
 #include "instrumentation.hpp"
 #include "system.hpp"
 #include "basethread.hpp"
-#include <alloca.h>
+#include <algorithm>
 
 using namespace nanos;
 
@@ -30,22 +30,24 @@ void DependableObject::finished ( )
    if ( --_references == 0) {
       DependableObject& depObj = *this;
 
-      // This step guarantees that any Object that wants to add depObj as a successor has done it
-      // before we continue or, alternatively, won't do it.
+      // Remove depObj as last writer of its targets. A submission that found it as last writer
+      // locks it before releasing the writer lock of the target (see dependOnLastWriter), so
+      // once depObj is locked here, any object that wanted to add depObj as a successor has
+      // done it before we continue or, alternatively, won't do it.
       TargetVector const &outs = depObj.getWrittenTargets();
       DependenciesDomain *domain = depObj.getDependenciesDomain();
       if ( domain != 0 && outs.size() > 0 ) {
-         SyncRecursiveLockBlock lock1( domain->getInstanceLock() ); // This is needed here to avoid a dead-lock
-         SyncLockBlock lock2( depObj.getLock() );
          for ( unsigned int i = 0; i < outs.size(); i++ ) {
             BaseDependency const &target = *outs[i];
             
             domain->deleteLastWriter ( depObj, target );
          }
+         SyncLockBlock lock2( depObj.getLock() );
       }
       
-      //  Delete depObj from all trackableObjects it reads 
-      if ( domain != 0 ) {
+      //  Delete depObj from all trackableObjects it reads, unless the writers that came after it
+      //  have already flushed it from all of them
+      if ( domain != 0 && depObj.isListedAsReader() ) {
          DependableObject::TargetVector const &reads = depObj.getReadTargets();
          for ( DependableObject::TargetVector::const_iterator it = reads.begin(); it != reads.end(); it++ ) {
             BaseDependency const & target = *(*it);
@@ -67,61 +69,50 @@ void DependableObject::finished ( )
       //}
       //*(myThread->_file) << " }" << std::endl;
 
-      // See if it's worth batch releasing.
-      // The idea here is to prevent initialising the vector unless we will
-      // use it.
-      if ( succ.size() > 1 )
-      {
-         // Construct list of successors to be released immediately.
-         // Allocate as many elements as we have in the successor list
-         WD** immediateSucc = (WD**) alloca( sizeof(WD*) * succ.size() );
-         WD** pIS = immediateSucc;
-         
-         for ( DependableObject::DependableObjectVector::iterator it = succ.begin(); it != succ.end(); it++ ) {
-            NANOS_INSTRUMENT ( instrument ( *(it->second) ); ) 
-            // If this dependable object can't be released in batch
-            if ( !it->second->canBeBatchReleased() )
-            {
-               it->second->decreasePredecessors( NULL, this, false, false );
-               continue;
-            }
-            
-            // Release this Dependable Object without triggering submission
-            DependableObject& dSucc = *it->second;
-            // Decrease predecessors
-            int numPred = dSucc.decreasePredecessors( NULL, this, true, false );
-            
-            // If after decreasing the predecessors it's not 0, fatal_cond
-            fatal_cond( numPred != 0, "Num predecessors is not 0" );
-            
-            // dependenciesSatisfied code
-            dSucc.dependenciesSatisfiedNoSubmit();
-            
-            // Convert to WD*
-            WD* wd = (WD*) dSucc.getRelatedObject();
-            fatal_cond( wd == NULL, "Cannot cast the related object to WD" );
+      // Successors made ready by this object are submitted together, so that the
+      // scheduling policy can enqueue them at once. Batches have a bounded size, so
+      // that they fit on the stack whatever the number of successors (this may run
+      // on a small user level thread stack)
+      const size_t batchSize = 64;
+      WD* immediateSucc[batchSize];
+      size_t numImmediate = 0;
 
-            if ( this->getWD() != NULL ) {
-               wd->predecessorFinished( this->getWD() );
-            }
-            
-            *pIS++ = wd ;
+      for ( DependableObject::DependableObjectVector::iterator it = succ.begin(); it != succ.end(); it++ ) {
+         NANOS_INSTRUMENT ( instrument ( **it ); )
+         DependableObject& dSucc = **it;
+
+         // Decrease predecessors without triggering submission
+         if ( dSucc.decreasePredecessors( NULL, this, true, false ) != 0 ) continue;
+
+         // If this dependable object can't be released in batch, submit it on its own
+         if ( !dSucc.canBeBatchReleased() ) {
+            dSucc.dependenciesSatisfied();
+            continue;
          }
 
-         size_t numImmediate = pIS - immediateSucc;
-      
-         // Batch submit and counter decrement
-         if ( numImmediate > 0 ){
+         // dependenciesSatisfied code
+         dSucc.dependenciesSatisfiedNoSubmit();
+
+         // Convert to WD*
+         WD* wd = (WD*) dSucc.getRelatedObject();
+         fatal_cond( wd == NULL, "Cannot cast the related object to WD" );
+
+         if ( this->getWD() != NULL ) {
+            wd->predecessorFinished( this->getWD() );
+         }
+
+         immediateSucc[numImmediate++] = wd;
+         if ( numImmediate == batchSize ) {
             DependenciesDomain::decreaseTasksInGraph( numImmediate );
             Scheduler::submit( immediateSucc, numImmediate );
+            numImmediate = 0;
          }
       }
-      else 
-      {
-         for ( DependableObject::DependableObjectVector::iterator it = succ.begin(); it != succ.end(); it++ ) {
-            NANOS_INSTRUMENT ( instrument ( *it->second ); )
-            it->second->decreasePredecessors( NULL, this, false, false );
-         }
+
+      // Batch submit and counter decrement
+      if ( numImmediate > 0 ) {
+         DependenciesDomain::decreaseTasksInGraph( numImmediate );
+         Scheduler::submit( immediateSucc, numImmediate );
       }
    }
 }
@@ -137,7 +128,7 @@ void DependableObject::releaseReadDependencies ()
    DependableObject::TargetVector const &reads = depObj.getReadTargets();
    DependableObject::TargetVector const &writes = depObj.getWrittenTargets();
    //  Delete depObj from all trackableObjects it reads 
-   if ( domain != 0 ) {
+   if ( domain != 0 && depObj.isListedAsReader() ) {
       for ( DependableObject::TargetVector::const_iterator it = reads.begin(); it != reads.end(); it++ ) {
          BaseDependency const & target = *(*it);
          //if ( target.getAddress() == addr ) {    
@@ -149,8 +140,8 @@ void DependableObject::releaseReadDependencies ()
    //Decrease predecessor for sucessor tasks
    //Only decrease if they are NOT writing or reading something that we write
    for ( DependableObject::DependableObjectVector::iterator currSucessorIt = succ.begin(); currSucessorIt != succ.end(); ) {
-      DependableObject::TargetVector const &sucessorWrites = currSucessorIt->second->getWrittenTargets();
-      DependableObject::TargetVector const &sucessorReads = currSucessorIt->second->getReadTargets();
+      DependableObject::TargetVector const &sucessorWrites = (*currSucessorIt)->getWrittenTargets();
+      DependableObject::TargetVector const &sucessorReads = (*currSucessorIt)->getReadTargets();
       bool canRemovePredecessor=true;
       for ( DependableObject::TargetVector::const_iterator itCurrWrites = writes.begin(); itCurrWrites != writes.end() && canRemovePredecessor; itCurrWrites++ ) {
          BaseDependency const & currWrite = *(*itCurrWrites);
@@ -168,9 +159,9 @@ void DependableObject::releaseReadDependencies ()
       }
       if (canRemovePredecessor) {
          //DependenciesDomain::decreaseTasksInGraph();
-         NANOS_INSTRUMENT ( instrument ( *currSucessorIt->second ); ) 
-         currSucessorIt->second->decreasePredecessors( NULL, this, false, false );
-         succ.erase(currSucessorIt++);
+         NANOS_INSTRUMENT ( instrument ( **currSucessorIt ); ) 
+         (*currSucessorIt)->decreasePredecessors( NULL, this, false, false );
+         currSucessorIt = succ.erase(currSucessorIt);
       }
       else 
       {
@@ -180,6 +171,93 @@ void DependableObject::releaseReadDependencies ()
 }
 
 
+bool DependableObject::isReleasedTarget ( BaseDependency const &target, std::vector<void *> const &addresses )
+{
+   return std::find( addresses.begin(), addresses.end(), target.getAddress() ) != addresses.end();
+}
+
+void DependableObject::releaseDependencies ( std::vector<void *> const &addresses )
+{
+   DependableObject& depObj = *this;
+   DependenciesDomain *domain = depObj.getDependenciesDomain();
+   if ( domain == 0 || addresses.empty() ) return;
+
+   // Stop being the last writer of the released targets. As in finished(), locking depObj
+   // afterwards guarantees that any submission that found it as last writer has already added
+   // its successor, so the successors list is complete for the released targets
+   for ( TargetVector::iterator it = _outputObjects.begin(); it != _outputObjects.end(); ) {
+      if ( isReleasedTarget( **it, addresses ) ) {
+         domain->deleteLastWriter ( depObj, **it );
+         delete *it;
+         it = _outputObjects.erase( it );
+      } else {
+         it++;
+      }
+   }
+
+   for ( TargetVector::iterator it = _readObjects.begin(); it != _readObjects.end(); ) {
+      if ( isReleasedTarget( **it, addresses ) ) {
+         if ( depObj.isListedAsReader() ) domain->deleteReader ( depObj, **it );
+         delete *it;
+         it = _readObjects.erase( it );
+      } else {
+         it++;
+      }
+   }
+
+   // Successors that no longer conflict with the remaining targets are detached from depObj.
+   // Only task successors with targets are considered: the others (commutation objects, taskwaits
+   // on dependences or explicit edges) must still wait for depObj to finish
+   DependableObjectVector released;
+   {
+      SyncLockBlock lock( depObj.getLock() );
+      for ( DependableObjectVector::iterator it = _successors.begin(); it != _successors.end(); ) {
+         DependableObject &succ = **it;
+         if ( succ.getWD() == NULL || succ.waits() || !depObj.canReleaseSuccessor( succ ) ) {
+            it++;
+            continue;
+         }
+         released.insert( &succ );
+         it = _successors.erase( it );
+      }
+   }
+
+   for ( DependableObjectVector::iterator it = released.begin(); it != released.end(); it++ ) {
+      NANOS_INSTRUMENT ( instrument ( **it ); )
+      (*it)->decreasePredecessors( NULL, this, false, false );
+   }
+}
+
+bool DependableObject::canReleaseSuccessor ( DependableObject &succ )
+{
+   // The targets of succ are complete and visible once its submission has finished. Before that,
+   // the submitting thread may still be adding them
+   if ( !succ.isSubmitted() ) return false;
+
+   TargetVector const &succWrites = succ.getWrittenTargets();
+   TargetVector const &succReads = succ.getReadTargets();
+   if ( succWrites.empty() && succReads.empty() ) return false;
+
+   for ( TargetVector::const_iterator it = _outputObjects.begin(); it != _outputObjects.end(); it++ ) {
+      BaseDependency const &write = **it;
+      for ( TargetVector::const_iterator sit = succWrites.begin(); sit != succWrites.end(); sit++ ) {
+         if ( write.overlap( **sit ) ) return false;
+      }
+      for ( TargetVector::const_iterator sit = succReads.begin(); sit != succReads.end(); sit++ ) {
+         if ( write.overlap( **sit ) ) return false;
+      }
+   }
+
+   for ( TargetVector::const_iterator it = _readObjects.begin(); it != _readObjects.end(); it++ ) {
+      BaseDependency const &read = **it;
+      for ( TargetVector::const_iterator sit = succWrites.begin(); sit != succWrites.end(); sit++ ) {
+         if ( read.overlap( **sit ) ) return false;
+      }
+   }
+
+   return true;
+}
+
 bool DependableObject::canBeBatchReleased ( ) const
 {
    return false;
@@ -194,17 +272,16 @@ DependableObject * DependableObject::releaseImmediateSuccessor ( DependableObjec
 
    {
       SyncLockBlock lock( this->getLock() );
-      // NOTE: it gets incremented in the erase
+      // NOTE: erase returns the next successor to visit
       for ( DependableObject::DependableObjectVector::iterator it = succ.begin(); it != succ.end(); ) {
          // Is this an immediate successor? 
-         if ( it->second->numPredecessors() == 1 && condition(*it->second) && !(it->second->waits()) ) {
-            if (it->second->isSubmitted()) {
+         if ( (*it)->numPredecessors() == 1 && condition(**it) && !((*it)->waits()) ) {
+            if ((*it)->isSubmitted()) {
                // remove it
-               found = it->second;
-               unsigned int wdId = it->first;
-               succ.erase(it++);
+               found = *it;
+               it = succ.erase(it);
                if ( found->numPredecessors() != 1 ) {
-                  incorrectlyErased.insert( std::make_pair( wdId, found ) );
+                  incorrectlyErased.insert( found );
                   found = NULL;
                } else {
                   NANOS_INSTRUMENT ( instrument ( *found ); )
@@ -219,7 +296,7 @@ DependableObject * DependableObject::releaseImmediateSuccessor ( DependableObjec
                      // because someone else will do it
                      // Keep the dependency to signal when the WD can actually be run respecting dependencies
                      found->disableSubmission();
-                     succ.insert( std::make_pair( wdId, found ) );
+                     succ.insert( found );
                   } else {
                      // We have removed the successor, so we need to decrease its predecessors
                      found->decreasePredecessors( NULL, this, true, false );
@@ -26,6 +26,7 @@
 
 #include "atomic.hpp"
 #include "lock.hpp"
+#include "smallset.hpp"
 
 #include "dependableobject_decl.hpp"
 #include "basedependency_decl.hpp"
@@ -42,7 +43,7 @@ inline DependableObject::~DependableObject ( )
    {
       SyncLockBlock lock( this->getLock() );
       for ( DependableObjectVector::iterator it = _predecessors.begin(); it != _predecessors.end(); it++ ) {
-         it->second->deleteSuccessor( *this );
+         (*it)->deleteSuccessor( *this );
       }
    }
 
@@ -51,7 +52,7 @@ inline DependableObject::~DependableObject ( )
 }
 
 inline DependableObject::DependableObject ( const DependableObject &depObj )
-   : _id(), _numPredecessors(), _references(), _predecessors(), _successors(), _domain(),
+   : _id(), _numPredecessors(), _readerListings(), _references(), _predecessors(), _successors(), _domain(),
    _outputObjects(), _readObjects(), _objectLock(), _submitted( false ),
    _needsSubmission( false ), _wd(), _schedulerData( NULL ), _num(), _lss()
 {
@@ -151,10 +152,7 @@ inline void DependableObject::decreasePredecessorsInLock ( DependableObject * fi
 
       //remove the predecessor from the list!
       if ( _predecessors.size() != 0 ) {
-         unsigned int wdId = finishedPred->getWD() == NULL ? 0 : finishedPred->getWD()->getId();
-         DependableObjectVector::iterator it = _predecessors.find( std::make_pair( wdId, finishedPred ) );
-         if ( it != _predecessors.end() )
-            _predecessors.erase( it );
+         _predecessors.erase( finishedPred );
       }
    }
 
@@ -168,6 +166,26 @@ inline int DependableObject::numPredecessors () const
    return _numPredecessors.value();
 }
 
+inline void DependableObject::listedAsReader ()
+{
+   _readerListings++;
+}
+
+inline void DependableObject::unlistedAsReader ()
+{
+   _readerListings--;
+}
+
+inline bool DependableObject::isListedAsReader () const
+{
+   if ( _readerListings.value() != 0 ) return true;
+
+   // Pairs with the decrement done by the writer that flushed this reader, so that the
+   // successors it added before flushing are visible
+   memoryFence();
+   return false;
+}
+
 inline DependableObject::DependableObjectVector & DependableObject::getPredecessors ( )
 {
    return _predecessors;
@@ -183,9 +201,7 @@ inline bool DependableObject::addPredecessor ( DependableObject &depObj )
    // Avoiding create cycles in dependence graph
    if ( this == &depObj ) return false;
 
-   bool inserted = _predecessors.insert (
-         std::make_pair( depObj.getWD() == NULL ? 0 : depObj.getWD()->getId(), &depObj)
-         ).second;
+   bool inserted = _predecessors.insert( &depObj ).second;
 
    return inserted;
 }
@@ -203,8 +219,8 @@ inline bool DependableObject::addSuccessor ( DependableObject &depObj )
             SyncLockBlock lock( depObj._objectLock );
             for ( DependableObjectVector::const_iterator it = depObj._predecessors.begin();
                   it != depObj._predecessors.end(); it++ ) {
-               int value = (it->second->_lss == -1 ) ? depObj._num - 1 : (it->second->_lss < depObj._num - 1 ? depObj._num - 1 : it->second->_lss );
-               it->second->_lss = value;
+               int value = ((*it)->_lss == -1 ) ? depObj._num - 1 : ((*it)->_lss < depObj._num - 1 ? depObj._num - 1 : (*it)->_lss );
+               (*it)->_lss = value;
             }
          }
       }
@@ -223,12 +239,12 @@ inline bool DependableObject::addSuccessor ( DependableObject &depObj )
 
    sys.getDefaultSchedulePolicy()->atSuccessor( depObj, *this );
 
-   return _successors.insert ( std::make_pair( depObj.getWD() == NULL ? 0 : depObj.getWD()->getId(), &depObj ) ).second;
+   return _successors.insert ( &depObj ).second;
 }
 
 inline bool DependableObject::deleteSuccessor ( DependableObject *depObj )
 {
-   return _successors.erase( std::make_pair( depObj->getWD() == NULL ? 0 : depObj->getWD()->getId(), depObj ) ) > 0;
+   return _successors.erase( depObj ) > 0;
 }
 
 inline bool DependableObject::deleteSuccessor ( DependableObject &depObj )
@@ -27,6 +27,7 @@
 
 #include "atomic_decl.hpp"
 #include "lock_decl.hpp"
+#include "smallset_decl.hpp"
 
 #include "dependenciesdomain_fwd.hpp"
 #include "basedependency_fwd.hpp"
@@ -86,13 +87,13 @@ namespace nanos {
    class DependableObject
    {
       public:
-         typedef std::pair< unsigned int, DependableObject * > DependableObjectVectorKey;
-         typedef std::set<DependableObjectVectorKey> DependableObjectVector; /**< Type vector of successors  */
+         typedef SmallSet<DependableObject *, 4> DependableObjectVector; /**< Type vector of successors  */
          typedef std::vector<BaseDependency*> TargetVector; /**< Type vector of output objects */
          
       private:
          unsigned int             _id;              /**< DependableObject identifier */
          Atomic<unsigned int>     _numPredecessors; /**< Number of predecessors locking this object */
+         Atomic<unsigned int>     _readerListings;  /**< Number of TrackableObjects listing this object as a reader */
          unsigned int             _references;      /** References counter */
          DependableObjectVector   _predecessors;    /**< List of predecessors */
          DependableObjectVector   _successors;      /**< List of successors */
@@ -115,11 +116,11 @@ namespace nanos {
         /*! \brief DependableObject default constructor
          */
          DependableObject ( ) 
-            :  _id ( 0 ), _numPredecessors ( 0 ), _references( 1 ), _predecessors(), _successors(), _domain( NULL ), _outputObjects(),
+            :  _id ( 0 ), _numPredecessors ( 0 ), _readerListings ( 0 ), _references( 1 ), _predecessors(), _successors(), _domain( NULL ), _outputObjects(),
                _readObjects(), _objectLock(), _submitted( false ), _needsSubmission( false ), _wd( NULL ), _schedulerData(NULL), _num(0), _lss(-1) {}
 
          DependableObject ( WorkDescriptor *wd ) 
-            :  _id ( 0 ), _numPredecessors ( 0 ), _references( 1 ), _predecessors(), _successors(), _domain( NULL ), _outputObjects(),
+            :  _id ( 0 ), _numPredecessors ( 0 ), _readerListings ( 0 ), _references( 1 ), _predecessors(), _successors(), _domain( NULL ), _outputObjects(),
                _readObjects(), _objectLock(), _submitted( false ), _needsSubmission( false ), _wd( wd ), _schedulerData(NULL), _num(0), _lss(-1) {}
 
         /*! \brief DependableObject copy constructor
@@ -167,8 +168,9 @@ namespace nanos {
           */
          virtual const void * getRelatedObject ( ) const;
          
-         /*! \brief Checks if this class supports batch release and, if so, if
-          *  it has only one predecessor.
+         /*! \brief Checks if this object, once its dependencies are satisfied,
+          *  can be submitted in a batch together with the rest of successors
+          *  released by the same predecessor.
           */
          virtual bool canBeBatchReleased ( ) const;
 
@@ -208,6 +210,21 @@ namespace nanos {
           */
          int numPredecessors () const;
 
+         /*! \brief Accounts for a TrackableObject that has added this object to its readers
+          */
+         void listedAsReader ();
+
+         /*! \brief Accounts for a TrackableObject that has removed this object from its readers
+          */
+         void unlistedAsReader ();
+
+         /*! \brief Returns whether any TrackableObject may still list this object as a reader
+          *
+          *  Once it returns false, no TrackableObject refers to this object any more, so there
+          *  is no reader to detach when it finishes.
+          */
+         bool isListedAsReader () const;
+
          /*! \brief Obtain the list of predecessors
           *  \return List of DependableObject* that "this" depends on
           */
@@ -315,6 +332,22 @@ namespace nanos {
          */
          void releaseReadDependencies ();
 
+        /*! \brief Early-release the targets whose address is in addresses
+         *  Successors that do not conflict with the remaining targets are released, and later
+         *  objects do not depend on the released targets anymore.
+         *  NOTE: this function is not thread safe
+         */
+         void releaseDependencies ( std::vector<void *> const &addresses );
+
+      private:
+        /*! \brief Returns whether target is one of the addresses being released */
+         static bool isReleasedTarget ( BaseDependency const &target, std::vector<void *> const &addresses );
+
+        /*! \brief Returns whether succ, already submitted, only depends on targets that are not held anymore */
+         bool canReleaseSuccessor ( DependableObject &succ );
+
+      public:
+
         /*! If there is an object that only depends from this dependable object, then release it and
             return it
          */
@@ -44,7 +44,7 @@ void DOSubmit::dependenciesSatisfiedNoSubmit( )
 
 bool DOSubmit::canBeBatchReleased ( ) const
 {
-   return numPredecessors() == 1 && sys.getDefaultSchedulePolicy()->isValidForBatch( getWD() ) && needsSubmission();
+   return needsSubmission() && getWD()->getSlicer() == NULL && sys.getDefaultSchedulePolicy()->isValidForBatch( getWD() );
 }
 
 unsigned long DOSubmit::getDescription ( )
@@ -60,7 +60,7 @@ void DOSubmit::instrument ( DependableObject &successor )
                       if ( succ == NULL ) {
                          DependableObject::DependableObjectVector &succ2 = successor.getSuccessors();
                          for ( DependableObject::DependableObjectVector::iterator it = succ2.begin(); it != succ2.end(); it++ ) {
-                            instrument ( *(it->second) ); 
+                            instrument ( **it ); 
                          }
                          return;
                       }
@@ -116,7 +116,7 @@ void DOWait::instrument ( DependableObject &successor )
                       if ( succ == NULL ) {
                          DependableObject::DependableObjectVector &succ2 = successor.getSuccessors();
                          for ( DependableObject::DependableObjectVector::iterator it = succ2.begin(); it != succ2.end(); it++ ) {
-                            instrument ( *(it->second) ); 
+                            instrument ( **it ); 
                          }
                          return;
                       }
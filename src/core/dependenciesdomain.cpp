@@ -30,6 +30,7 @@ namespace nanos {
 
 Atomic<int> DependenciesDomain::_atomicSeed( 0 );
 Atomic<int> DependenciesDomain::_tasksInGraph( 0 );
+Atomic<int> DependenciesDomain::_trackedObjects( 0 );
 Lock DependenciesDomain::_lock;
 
 using namespace dependencies_domain_internal;
@@ -52,4 +53,20 @@ void DependenciesDomain::decreaseTasksInGraph( size_t num )
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, (nanos_event_value_t *) &tasks );)
    NANOS_INSTRUMENT(unlock();)
 }
+
+void DependenciesDomain::increaseTrackedObjects()
+{
+   _trackedObjects++;
+   NANOS_INSTRUMENT(nanos_event_value_t objects = (nanos_event_value_t) _trackedObjects.value();)
+   NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("deps-tracked-objects");)
+   NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, (nanos_event_value_t *) &objects );)
+}
+
+void DependenciesDomain::decreaseTrackedObjects()
+{
+   _trackedObjects--;
+   NANOS_INSTRUMENT(nanos_event_value_t objects = (nanos_event_value_t) _trackedObjects.value();)
+   NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("deps-tracked-objects");)
+   NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, (nanos_event_value_t *) &objects );)
+}
 } // namespace nanos
@@ -49,6 +49,11 @@ inline Lock& DependenciesDomain::getLock()
    return _lock;
 }
 
+inline int DependenciesDomain::getNumTrackedObjects ( )
+{
+   return _trackedObjects.value();
+}
+
 inline void DependenciesDomain::lock ( )
 {
    _lock.acquire();
@@ -97,6 +97,7 @@ using namespace dependencies_domain_internal;
          int                  _id;                   /**< Domain's id */
          RecursiveLock        _instanceLock;         /**< Needed to access _addressDependencyMap */
          static Atomic<int>   _tasksInGraph;         /**< Current number of tasks in the graph */
+         static Atomic<int>   _trackedObjects;       /**< Current number of TrackableObjects in all the domains */
          static Lock          _lock;
 
       private:
@@ -168,6 +169,14 @@ using namespace dependencies_domain_internal;
 
          static void decreaseTasksInGraph( size_t num = 1 );
 
+         static void increaseTrackedObjects();
+
+         static void decreaseTrackedObjects();
+
+        /*! \brief Returns the number of TrackableObjects alive in all the domains
+         */
+         static int getNumTrackedObjects();
+
         /*! \brief Returns a reference to the instance lock
          */
          RecursiveLock& getInstanceLock();
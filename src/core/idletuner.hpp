@@ -0,0 +1,102 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_IDLETUNER_H
+#define _NANOS_IDLETUNER_H
+
+#include "idletuner_decl.hpp"
+#include "os.hpp"
+
+namespace nanos {
+
+inline IdleTuner::IdleTuner () : _idleStart( 0.0 ), _blockStart( 0.0 ), _wakeRequest( 0.0 ), _workArrival( 0.0 ),
+   _wakeLatency( DEFAULT_WAKE_LATENCY ), _shortRatio( 1.0 ), _spinTime( DEFAULT_WAKE_LATENCY ) {}
+
+inline double IdleTuner::average ( double avg, double sample )
+{
+   return avg + ( sample - avg ) / 8;
+}
+
+inline void IdleTuner::update ()
+{
+   // Do not give up the CPU on every brief lack of work, even during serial phases
+   double minSpinTime = _wakeLatency / 16;
+   _spinTime = _wakeLatency * _shortRatio;
+   if ( _spinTime < minSpinTime ) _spinTime = minSpinTime;
+}
+
+inline void IdleTuner::beginIdle ()
+{
+   _idleStart = OS::getMonotonicTime();
+   _workArrival = 0.0;
+}
+
+inline void IdleTuner::endIdle ()
+{
+   // If the thread was woken up, work arrived at the wake up request, not when the thread noticed it
+   double end = _workArrival > 0.0 ? _workArrival : OS::getMonotonicTime();
+   _shortRatio = average( _shortRatio, ( end - _idleStart ) < _wakeLatency ? 1.0 : 0.0 );
+   update();
+}
+
+inline IdleTuner::Action IdleTuner::getAction () const
+{
+   double elapsed = OS::getMonotonicTime() - _idleStart;
+   if ( elapsed < _spinTime ) return SPIN;
+   if ( elapsed < 2 * _spinTime ) return YIELD;
+   return BLOCK;
+}
+
+inline void IdleTuner::blocking ()
+{
+   _blockStart = OS::getMonotonicTime();
+}
+
+inline void IdleTuner::resumed ()
+{
+   double wakeRequest = _wakeRequest;
+   // Ignore wake ups of a thread that was not blocked yet
+   if ( _blockStart > 0.0 && wakeRequest >= _blockStart ) {
+      _wakeLatency = average( _wakeLatency, OS::getMonotonicTime() - wakeRequest );
+      _workArrival = wakeRequest;
+      update();
+   }
+   _blockStart = 0.0;
+}
+
+inline void IdleTuner::slept ( double requested, double elapsed )
+{
+   // Only the overshoot is the cost of getting the CPU back, the requested time was chosen by the user
+   double overshoot = elapsed - requested;
+   _wakeLatency = average( _wakeLatency, overshoot > 0.0 ? overshoot : 0.0 );
+   update();
+}
+
+inline void IdleTuner::requestWakeup ()
+{
+   _wakeRequest = OS::getMonotonicTime();
+}
+
+inline double IdleTuner::getWakeLatency () const { return _wakeLatency; }
+
+inline double IdleTuner::getSpinTime () const { return _spinTime; }
+
+} // namespace nanos
+
+#endif
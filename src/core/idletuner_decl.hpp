@@ -0,0 +1,98 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_IDLETUNER_DECL_H
+#define _NANOS_IDLETUNER_DECL_H
+
+namespace nanos {
+
+   /*! \brief Chooses online how long an idle thread spins and yields before giving up its CPU
+    *
+    *  Each thread measures how long its idle phases last (until work shows up)
+    *  and how long it takes to get the CPU back once it has blocked or slept.
+    *  Following competitive spinning, the thread spins for at most the cost of
+    *  a wake up, so it never wastes more than twice the optimal time. The spin
+    *  budget shrinks with the fraction of idle phases that are longer than a
+    *  wake up, as spinning is useless then: short bursts keep the threads hot
+    *  while long serial phases release the CPUs quickly.
+    *
+    *  All times are in seconds, as returned by OS::getMonotonicTime().
+    */
+   class IdleTuner
+   {
+      public:
+         /*! \brief What an idle thread should do next */
+         enum Action {
+            SPIN,    /**< Keep looking for work */
+            YIELD,   /**< Yield the CPU */
+            BLOCK    /**< Block or sleep, as configured in the ThreadManager */
+         };
+
+      private:
+         double            _idleStart;    /**< Start of the current idle phase */
+         double            _blockStart;   /**< When the thread last blocked, 0 if it is not blocked */
+         volatile double   _wakeRequest;  /**< Last time another thread woke this one up */
+         double            _workArrival;  /**< Wake up that ended the current idle phase, 0 if none */
+         double            _wakeLatency;  /**< Average time to get the CPU back after giving it up */
+         double            _shortRatio;   /**< Average fraction of idle phases shorter than _wakeLatency */
+         double            _spinTime;     /**< Spin budget of an idle phase (yielding takes as long) */
+
+         /*! \brief IdleTuner copy constructor (private)
+          */
+         IdleTuner ( const IdleTuner & );
+         /*! \brief IdleTuner copy assignment operator (private)
+          */
+         const IdleTuner & operator= ( const IdleTuner & );
+
+         /*! \brief Adds a sample to a running average */
+         static double average ( double avg, double sample );
+         /*! \brief Recomputes the spin budget from the measurements */
+         void update ();
+
+      public:
+         /*! \brief Initial estimation of the wake up latency (seconds) */
+         static const double DEFAULT_WAKE_LATENCY;
+
+         /*! \brief IdleTuner default constructor
+          */
+         IdleTuner ();
+
+         /*! \brief The thread starts looking for work */
+         void beginIdle ();
+         /*! \brief The thread found work, accounts the idle phase */
+         void endIdle ();
+         /*! \brief Returns what the thread should do after looking for work without success */
+         Action getAction () const;
+
+         /*! \brief The thread is about to block */
+         void blocking ();
+         /*! \brief The thread got its CPU back after blocking */
+         void resumed ();
+         /*! \brief The thread slept (instead of blocking) for requested seconds, but got its CPU back after elapsed */
+         void slept ( double requested, double elapsed );
+         /*! \brief Another thread wakes this one up */
+         void requestWakeup ();
+
+         double getWakeLatency () const;
+         double getSpinTime () const;
+   };
+
+} // namespace nanos
+
+#endif
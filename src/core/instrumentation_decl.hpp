@@ -413,6 +413,7 @@ namespace nanos {
             registerEventValue("api","get_wd_id","nanos_get_wd_id()");
             registerEventValue("api","*_create_wd","nanos_create_xxx_wd()");
             registerEventValue("api","submit","nanos_submit()");
+            registerEventValue("api","submit_wds","nanos_submit_wds()");
             registerEventValue("api","create_wd_and_run","nanos_create_wd_and_run()");
             registerEventValue("api","set_internal_wd_data","nanos_set_internal_wd_data()");
             registerEventValue("api","get_internal_wd_data","nanos_get_internal_wd_data()");
@@ -439,6 +440,7 @@ namespace nanos {
             registerEventValue("api","in_final","nanos_in_final()");
             registerEventValue("api","set_final","nanos_set_final()");
             registerEventValue("api","dependence_release_all","nanos_dependence_release_all()");
+            registerEventValue("api","dependence_release","nanos_dependence_release()");
             registerEventValue("api","set_translate_function","nanos_set_translate_function()");
             registerEventValue("api","memalign","nanos_memalign()");
             registerEventValue("api","cmalloc","nanos_cmalloc()");
@@ -722,6 +724,8 @@ namespace nanos {
             registerEventValue("fpga-api", "unlock", "FPGA task accelerator is releasing a lock" ); /* 3 */
             registerEventValue("fpga-api", "trylock", "FPGA task accelerator is trying to acquiring a lock" ); /* 4 */
 
+            /* 86 */ registerEventKey("deps-tracked-objects","Number of tracked objects in the dependencies domains", true, EVENT_USER );
+
             /* ** */ registerEventKey("debug","Debug Key", true, EVENT_ADVANCED ); /* Keep this key as the last one */
          }
 
@@ -176,6 +176,7 @@ typedef nanos::CopyData nanos_copy_data_t;
 typedef void * nanos_thread_t;
 typedef void * nanos_wd_t;
 typedef void * nanos_pe_t;
+typedef void * nanos_taskgraph_t;
 
 /* SlicerCompoundWD data structure */
 typedef struct {
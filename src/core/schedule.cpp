@@ -32,6 +32,7 @@
 #include "nanos-int.h"
 
 #include <iostream>
+#include <algorithm>
 
 using namespace nanos;
 
@@ -48,8 +49,17 @@ void SchedulerConf::config (Config &cfg)
    cfg.registerConfigOption ( "num-steal", NEW Config::PositiveVar( _numStealAfterSpins ), "Try to steal every so spins (default = 1)" );
    cfg.registerArgOption ( "num-steal", "spins-steal" );
 
+   cfg.registerConfigOption ( "steal-backoff", NEW Config::PositiveVar( _stealBackoff ), "Failed steal rounds before stealing from a farther level of the topology (default = 2)" );
+   cfg.registerArgOption ( "steal-backoff", "steal-backoff" );
+
    cfg.registerConfigOption ( "hold-tasks", NEW Config::FlagOption( _holdTasks ), "Do not submit tasks until a taskwait is reached." );
    cfg.registerArgOption ( "hold-tasks", "hold-tasks" );
+
+   cfg.registerConfigOption ( "stackless-tasks", NEW Config::FlagOption( _stacklessTasks ),
+                              "Workers run tied tasks on their own stack. Blocked tasks then run their new descendants inline, and are only "
+                              "suspended when other suspended tasks have to run, moving the worker to a new stack" );
+   cfg.registerArgOption ( "stackless-tasks", "stackless-tasks" );
+   cfg.registerEnvOption ( "stackless-tasks", "NX_STACKLESS_TASKS" );
 }
 
 void Scheduler::submit ( WD &wd, bool force_queue )
@@ -71,6 +81,9 @@ void Scheduler::_submit ( WD &wd, bool force_queue )
 
    debug ( "submitting task " << wd.getId() << " " << ( wd.getDescription() != NULL ? wd.getDescription() : "") << " team: " << mythread->getTeam() << " this thread is " << mythread );
 
+   /* tasks waiting for a commutative target are submitted again once they are handed it */
+   if ( !wd.acquireCommutativeAccesses() ) return;
+
    wd.submitted();
    wd.setReady();
 
@@ -85,14 +98,10 @@ void Scheduler::_submit ( WD &wd, bool force_queue )
       return;
    }
 
-   /* By checking if there's available WDs in the queue before queuing the current one,
+   /* By counting the available WDs in the queue before queuing the current one,
     * we ensure that we only trigger a wakeup if at least the current thread will not remain
     * idle after the WD submission. */
-   ThreadManager *const thread_manager = sys.getThreadManager();
-   if ( thread_manager->isGreedy()
-         && mythread->getTeam()->getSchedulePolicy().testDequeue() ) {
-      thread_manager->acquireOne();
-   }
+   sys.getThreadManager()->wakeUpForReadyTasks( 1 );
 
    /* handle tasks which cannot run in current thread */
    if ( force_queue || !mythread->runningOn()->canRun( wd ) ) {
@@ -151,35 +160,49 @@ void Scheduler::_submit ( WD ** wds, size_t numElems )
 
    BaseThread *mythread = myThread;
 
-   // create a vector of threads for each wd
-   BaseThread ** threadList = NEW BaseThread*[numElems];
-   for( size_t i = 0; i < numElems; ++i )
-   {
-      WD* wd = wds[i];
-      wd->_mcontrol.preInit();
-
-      // If the wd is tied to anyone
-      BaseThread *wd_tiedto = wd->isTiedTo();
-      if ( wd->isTied() && wd_tiedto != mythread ) {
-         if ( wd_tiedto->getTeam() == NULL ) {
-            //wd_tiedto->addNextWD( &wd );
-            // WHAT HERE???
-            fatal( "Uncontrolled batch path");
+   // The batch is processed in pieces of bounded size, so that the thread list fits on the
+   // stack whatever the number of WDs (this may run on a small user level thread stack)
+   const size_t pieceSize = 64;
+   BaseThread * threadList[pieceSize];
+
+   for ( size_t first = 0; first < numElems; first += pieceSize ) {
+      WD ** piece = wds + first;
+      const size_t pieceElems = std::min( pieceSize, numElems - first );
+      size_t numQueued = 0;
+      for( size_t i = 0; i < pieceElems; ++i )
+      {
+         WD* wd = piece[i];
+         wd->_mcontrol.preInit();
+
+         // Tasks waiting for a commutative target are submitted again once they are handed it
+         if ( !wd->acquireCommutativeAccesses() ) continue;
+
+         wd->submitted();
+         wd->setReady();
+
+         // If the wd is tied to anyone
+         BaseThread *wd_tiedto = wd->isTiedTo();
+         if ( wd->isTied() && wd_tiedto != mythread ) {
+            if ( wd_tiedto->getTeam() == NULL ) {
+               // Teamless threads only run their next WDs, out of the batch
+               wd_tiedto->addNextWD( wd );
+               continue;
+            }
+            threadList[numQueued] = wd_tiedto;
          } else {
-            //wd_tiedto->getTeam()->getSchedulePolicy().queue( wd_tiedto, wd );
-            threadList[i] = wd_tiedto;
+            // Otherwise, use mythread
+            threadList[numQueued] = mythread;
          }
-         continue;
+         piece[numQueued++] = wd;
       }
-      // Otherwise, use mythread
-      threadList[i] = mythread;
-   }
+      if ( numQueued == 0 ) continue;
 
-   // Call the scheduling policy
-   mythread->getTeam()->getSchedulePolicy().queue( threadList, wds, numElems );
+      // Call the scheduling policy, which may spread the piece among several queues
+      mythread->getTeam()->getSchedulePolicy().queue( threadList, piece, numQueued );
 
-   // Release
-   delete[] threadList;
+      // Wake up as many blocked threads as needed to run the piece
+      sys.getThreadManager()->wakeUpForReadyTasks( numQueued );
+   }
 }
 
 void Scheduler::updateCreateStats ( WD &wd )
@@ -255,10 +278,12 @@ inline void Scheduler::idleLoop ()
    NANOS_INSTRUMENT ( unsigned long long time_scheds = 0; ) /* Time of yields by idle phase */
 
    ThreadManager *const thread_manager = sys.getThreadManager();
+   const bool adaptive_idle = thread_manager->isAdaptive();
 
    WD *current = myThread->getCurrentWD();
    sys.getSchedulerStats()._idleThreads++;
    myThread->setIdle( true );
+   if ( adaptive_idle ) myThread->getIdleTuner().beginIdle();
 
    for ( ; ; ) {
       BaseThread *thread = getMyThreadSafe();
@@ -296,8 +321,12 @@ inline void Scheduler::idleLoop ()
 
          NANOS_INSTRUMENT( sys.getInstrumentation()->raisePointEvents(event_num, &Keys[event_start], &Values[event_start]); )
 
+         if ( adaptive_idle ) thread->getIdleTuner().blocking();
+
          thread->wait();
 
+         if ( adaptive_idle ) thread->getIdleTuner().resumed();
+
          NANOS_INSTRUMENT (total_spins = 0; )
          NANOS_INSTRUMENT (total_blocks = 0; )
          NANOS_INSTRUMENT (total_yields = 0; )
@@ -327,7 +356,7 @@ inline void Scheduler::idleLoop ()
 
       if ( !next && thread->getTeam() != NULL ) {
          memoryFence();
-         if ( sys.getSchedulerStats()._readyTasks > 0 ) {
+         if ( sys.getSchedulerStats().getApproxReadyTasks() > 0 ) {
             NANOS_INSTRUMENT ( total_scheds++; )
             NANOS_INSTRUMENT ( unsigned long long begin_sched = (unsigned long long) ( OS::getMonotonicTime() * 1.0e9  ); )
 
@@ -343,12 +372,6 @@ inline void Scheduler::idleLoop ()
          }
       }
 
-      // Trigger a wakeup if there's more WDs in the queue
-      if ( next && thread->getTeam() != NULL && thread_manager->isGreedy()
-            && thread->getTeam()->getSchedulePolicy().testDequeue() ) {
-         thread_manager->acquireOne();
-      }
-
       if ( next ) {
 
          NANOS_INSTRUMENT (total_spins+= (init_spins - spins); )
@@ -373,6 +396,10 @@ inline void Scheduler::idleLoop ()
 
          thread->setIdle( false );
          sys.getSchedulerStats()._idleThreads--;
+         if ( adaptive_idle ) thread->getIdleTuner().endIdle();
+
+         // Trigger a wakeup if there's more WDs in the queue
+         if ( thread->getTeam() != NULL ) thread_manager->wakeUpForReadyTasks( 1 );
 
          behaviour::switchWD(thread, current, next);
 
@@ -381,6 +408,7 @@ inline void Scheduler::idleLoop ()
 
          sys.getSchedulerStats()._idleThreads++;
          thread->setIdle( true );
+         if ( adaptive_idle ) thread->getIdleTuner().beginIdle();
 
          NANOS_INSTRUMENT (total_spins = 0; )
          NANOS_INSTRUMENT (total_blocks = 0; )
@@ -445,7 +473,9 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
    WD * current = thread->getCurrentWD();
    current->setSyncCond( condition );
 
-   bool supportULT = thread->runningOn()->supportsUserLevelThreads();
+   // A stackless WD is only suspended once the scheduling loop has left its stack, until then it keeps
+   // running its new descendants inline
+   bool supportULT = thread->runningOn()->supportsUserLevelThreads() && ( !current->isStackless() || thread->hasMovedSchedulingLoop() );
 
    ThreadManager *const thread_manager = sys.getThreadManager();
 
@@ -459,6 +489,12 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
             //! If condition is not acomplished yet, release wd and get more work to do
             WD * next = NULL;
 
+            //! A stackless WD must block to let the suspended WDs deferred by its thread run (see switchTo)
+            if ( current->isStackless() && thread->hasDeferredWDs() && thread->runningOn()->supportsUserLevelThreads() ) {
+               thread->moveSchedulingLoop();
+               supportULT = true;
+            }
+
             if ( thread->canGetWork() ) {
                //! First checking prefetching queue
                next = thread->getNextWD();
@@ -470,7 +506,7 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
                   //! Second calling scheduler policy at block
                   if ( !next ) {
                      memoryFence();
-                     if ( sys.getSchedulerStats()._readyTasks > 0 ) {
+                     if ( sys.getSchedulerStats().getApproxReadyTasks() > 0 ) {
                         if ( sys.getSchedulerConf().getSchedulerEnabled() )
                            next = thread->getTeam()->getSchedulePolicy().atBlock( thread, current );
                if ( next != NULL ) {
@@ -481,9 +517,8 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
                }
 
                // Trigger a wakeup if there's more WDs in the queue
-               if ( next && thread->getTeam() != NULL && thread_manager->isGreedy()
-                     && thread->getTeam()->getSchedulePolicy().testDequeue() ) {
-                  thread_manager->acquireOne();
+               if ( next && thread->getTeam() != NULL ) {
+                  thread_manager->wakeUpForReadyTasks( 1 );
                }
             }
 
@@ -501,7 +536,7 @@ void Scheduler::waitOnCondition (GenericSyncCond *condition)
                verbose("   switching to " << next->getId() ); //FIXME:xteruel
                switchTo ( next );
                thread = getMyThreadSafe();
-               supportULT = thread->runningOn()->supportsUserLevelThreads();
+               supportULT = thread->runningOn()->supportsUserLevelThreads() && ( !current->isStackless() || thread->hasMovedSchedulingLoop() );
                thread->step();
             } else {
                condition->unlock();
@@ -606,8 +641,7 @@ struct AsyncWorkerBehaviour
          // Since this is the async behavior, set schedule to false:
          // do not prefetch at this point, as the thread will be always prefetching
          if ( Scheduler::inlineWorkAsync ( next, /* schedule */ false ) ) {
-            next->~WorkDescriptor();
-            delete[] ( char * ) next;
+            sys.destroyWD( next );
          }
       }
    }
@@ -986,7 +1020,45 @@ void Scheduler::switchHelper (WD *oldWD, WD *newWD, void *arg)
 
 void Scheduler::switchTo ( WD *to )
 {
-   if ( myThread->runningOn()->supportsUserLevelThreads() ) {
+   const bool supportULT = myThread->runningOn()->supportsUserLevelThreads();
+   WD *current = myThread->getCurrentWD();
+
+   // With stackless tasks, a tied WD starting from the thread WD or from an implicit WD runs inline on
+   // their stack instead of getting its own one. Only the new descendants of a stackless WD are nested
+   // on top of it, so the nesting is bounded by the task depth. Any other work goes back to the
+   // scheduler, and the started WDs tied to the thread are deferred, as they cannot run on top of it.
+   // A stackless WD waiting while there are deferred WDs blocks (see waitOnCondition): it keeps the
+   // stack as its own context and the scheduling loop of the thread moves to a new stack. Until the
+   // stack unwinds back to the WD that started the stackless WDs, new WDs get their own stack as well
+   if ( current->isStackless() ) {
+      if ( !to->started() && to->isDescendantOf( *current ) ) {
+         to->setStackless();
+         if ( inlineWork( to, /*schedule*/ true ) ) {
+            sys.destroyWD( to );
+         }
+         return;
+      }
+      if ( !myThread->hasMovedSchedulingLoop() ) {
+         GenericSyncCond *syncCond = current->getSyncCond();
+         if ( syncCond != NULL ) syncCond->unlock();
+         // A suspended WD of this thread would come back at once through its next WDs
+         if ( to->isTiedTo() == myThread ) myThread->deferWD( to );
+         else myThread->getTeam()->getSchedulePolicy().queue( myThread, *to );
+         return;
+      }
+   }
+
+   if ( supportULT && !to->started() && to->isToBeTied() && sys.getSchedulerConf().getStacklessTasksEnabled() &&
+         ( current == &(myThread->getThreadWD()) || current->isImplicit() ) && !myThread->hasMovedSchedulingLoop() &&
+         ( current->getSyncCond() == NULL || to->isDescendantOf( *current ) ) ) {
+      to->setStackless();
+      if ( inlineWork( to, /*schedule*/ true ) ) {
+         sys.destroyWD( to );
+      }
+      // Back to the WD that started the stackless WDs, it gets the scheduling loop back
+      if ( myThread->hasMovedSchedulingLoop() ) myThread->restoreSchedulingLoop();
+      myThread->resumeDeferredWDs();
+   } else if ( supportULT ) {
 
       if (!to->started()) {
          to->_mcontrol.initialize( *(myThread->runningOn()) );
@@ -1017,8 +1089,7 @@ void Scheduler::switchTo ( WD *to )
 
    } else {
       if (inlineWork(to, /*schedule*/ true)) {
-         to->~WorkDescriptor();
-         delete[] (char *)to;
+         sys.destroyWD( to );
       }
    }
 }
@@ -1038,6 +1109,7 @@ void Scheduler::switchToThread ( BaseThread *thread )
 
       // Tie wd to target thread
       WD *wd = myThread->getCurrentWD();
+      fatal_cond( wd->isStackless(), "A task running with --stackless-tasks cannot move to another thread" );
       wd->tieTo( *thread );
 
       // Get a candidate to execute in current thread
@@ -1054,8 +1126,7 @@ void Scheduler::exitHelper (WD *oldWD, WD *newWD, void *arg)
 {
     myThread->runningOn()->exitHelperDependent(oldWD, newWD, arg);
     myThread->setCurrentWD( *newWD );
-    oldWD->~WorkDescriptor();
-    delete[] (char *)oldWD;
+    sys.destroyWD( oldWD );
 }
 
 struct ExitBehaviour
@@ -1073,8 +1144,7 @@ struct ExitBehaviour
       }
       else {
         if ( Scheduler::inlineWork ( next /*jb merge */, /*schedule*/ true ) ) {
-          next->~WorkDescriptor();
-          delete[] (char *)next;
+          sys.destroyWD( next );
         }
       }
    }
@@ -1145,6 +1215,9 @@ void Scheduler::exit ( void )
    fatal("A thread should never return from Scheduler::exit");
 }
 
-int SchedulerStats::getCreatedTasks() { return _createdTasks.value(); }
-int SchedulerStats::getReadyTasks() { return _readyTasks.value(); }
-int SchedulerStats::getTotalTasks() { return _totalTasks.value(); }
+int SchedulerStats::getCreatedTasks() const { return _createdTasks.value(); }
+int SchedulerStats::getReadyTasks() const { return _readyTasks.value(); }
+int SchedulerStats::getIdleThreads() const { return _idleThreads.value(); }
+int SchedulerStats::getTotalTasks() const { return _totalTasks.value(); }
+int SchedulerStats::getApproxReadyTasks() const { return _readyTasks.approxValue(); }
+int SchedulerStats::getApproxIdleThreads() const { return _idleThreads.approxValue(); }
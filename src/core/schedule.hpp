@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include "atomic.hpp"
+#include "shardedcounter.hpp"
 #include "synchronizedcondition_fwd.hpp"
 
 #include "schedule_decl.hpp"
@@ -74,11 +75,21 @@ inline unsigned int SchedulerConf::getNumStealAfterSpins ( void ) const
    return _numStealAfterSpins;
 }
 
+inline unsigned int SchedulerConf::getStealBackoff ( void ) const
+{
+   return _stealBackoff;
+}
+
 inline bool SchedulerConf::getHoldTasksEnabled ( void ) const
 {
    return _holdTasks;
 }
 
+inline bool SchedulerConf::getStacklessTasksEnabled ( void ) const
+{
+   return _stacklessTasks;
+}
+
 inline const std::string & SchedulePolicy::getName () const
 {
    return _name;
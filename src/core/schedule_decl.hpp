@@ -30,6 +30,7 @@
 
 #include "workdescriptor_decl.hpp"
 #include "atomic_decl.hpp"
+#include "shardedcounter_decl.hpp"
 #include "functors_decl.hpp"
 #include "basethread_decl.hpp"
 #include "schedule_fwd.hpp"
@@ -96,14 +97,16 @@ namespace nanos {
          unsigned int                  _numChecks;         //!< Number of checks before schedule
          bool                          _schedulerEnabled;  //!< Scheduler is enabled
          int                           _numStealAfterSpins;//!< Steal every so spins
+         int                           _stealBackoff;      //!< Failed steal rounds before stealing farther (see StealOrder)
          bool                          _holdTasks;         //!< Submit tasks when a taskwait is reached
+         bool                          _stacklessTasks;    //!< Workers run tied tasks inline on their own stack
       private: /* PRIVATE METHODS */
         //! \brief SchedulerConf default constructor (private)
         SchedulerConf() : _numSpins(1), _numChecks(1), _schedulerEnabled(true),
-        _numStealAfterSpins(1), _holdTasks(false) {}
+        _numStealAfterSpins(1), _stealBackoff(2), _holdTasks(false), _stacklessTasks(false) {}
         //! \brief SchedulerConf copy constructor (private)
         SchedulerConf ( SchedulerConf &sc ) : _numSpins(), _numChecks(),
-        _schedulerEnabled(), _holdTasks()
+        _schedulerEnabled(), _stealBackoff(), _holdTasks(), _stacklessTasks()
         {
            fatal("SchedulerConf: Illegal use of class");
         }
@@ -122,10 +125,14 @@ namespace nanos {
          unsigned int getNumChecks ( void ) const;
          //! \brief Returns the number of spins before stealing
          unsigned int getNumStealAfterSpins ( void ) const;
+         //! \brief Returns the number of failed steal rounds before stealing from a farther topology level
+         unsigned int getStealBackoff ( void ) const;
          //! \brief Returns if scheduler is enabled
          bool getSchedulerEnabled () const;
          //! \brief Returns if holding tasks is enabled
          bool getHoldTasksEnabled () const;
+         //! \brief Returns if workers run tied tasks inline on their own stack
+         bool getStacklessTasksEnabled () const;
 
          //! \brief Configure scheduler runtime options
          void config ( Config &cfg );
@@ -135,6 +142,7 @@ namespace nanos {
    {
          friend class WDDeque;
          friend class WDLFQueue;
+         friend class WDChaseLevDeque;
          friend class WDPriorityQueue<WD::PriorityType>;
          friend class WDPriorityQueue<double>;
          friend class Scheduler;
@@ -146,10 +154,10 @@ namespace nanos {
          friend class SlicerRepeatN;
          friend class SlicerCompoundWD;
       private:
-         Atomic<int>          _createdTasks;
-         Atomic<int>          _readyTasks;
-         Atomic<int>          _idleThreads;
-         Atomic<int>          _totalTasks;
+         ShardedCounter       _createdTasks;
+         ShardedCounter       _readyTasks;
+         ShardedCounter       _idleThreads;
+         ShardedCounter       _totalTasks;
       private:
          /*! \brief SchedulerStats copy constructor (private)
           */
@@ -165,19 +173,19 @@ namespace nanos {
           */
          ~SchedulerStats () {}
 
-         int getCreatedTasks();
-         int getReadyTasks();
-#ifdef HAVE_NEW_GCC_ATOMIC_OPS
-         int * getReadyTasksAddr( void ) { return &_readyTasks.override(); }
-#else
-         volatile int * getReadyTasksAddr( void ) { return &_readyTasks.override(); }
-#endif
-         int getTotalTasks();
-#ifdef HAVE_NEW_GCC_ATOMIC_OPS
-         int * getTotalTasksAddr( void ) { return &_totalTasks.override(); }
-#else
-         volatile int * getTotalTasksAddr( void ) { return &_totalTasks.override(); }
-#endif
+         int getCreatedTasks() const;
+         int getReadyTasks() const;
+         int getIdleThreads() const;
+         int getTotalTasks() const;
+
+         /*! \brief Returns a recent, possibly outdated, number of ready tasks
+          *  \see ShardedCounter::approxValue
+          */
+         int getApproxReadyTasks() const;
+         /*! \brief Returns a recent, possibly outdated, number of idle threads
+          *  \see ShardedCounter::approxValue
+          */
+         int getApproxIdleThreads() const;
    };
 
    class ScheduleTeamData {
@@ -308,8 +316,10 @@ namespace nanos {
          virtual void atSuccessor   ( DependableObject &depObj, DependableObject &pred );
 
          virtual void queue ( BaseThread *thread, WD &wd )  = 0;
-         /*! \brief Batch processing version.
-          *  The default behaviour calls queue() individually.
+         /*! \brief Batch processing version, called with all the WDs made
+          *  ready at once (e.g. the successors released by a finished task).
+          *  Policies may spread the batch among their queues instead of
+          *  queueing to threads[i]. The default behaviour calls queue() individually.
           */
          virtual void queue ( BaseThread ** threads, WD ** wds, size_t numElems );
 
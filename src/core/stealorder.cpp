@@ -0,0 +1,130 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "stealorder.hpp"
+#include "system.hpp"
+#include "threadteam.hpp"
+
+#include <sstream>
+
+using namespace nanos;
+
+Atomic<unsigned long> StealOrder::_totalAttempts[StealOrder::NUM_LEVELS];
+Atomic<unsigned long> StealOrder::_totalSteals[StealOrder::NUM_LEVELS];
+
+StealOrder::StealOrder () : _countSteals( sys.getSummary() ), _team( NULL ), _teamSize( 0 )
+{
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      _next[level] = 0;
+      _attempts[level] = 0;
+      _steals[level] = 0;
+   }
+}
+
+StealOrder::~StealOrder () {}
+
+void StealOrder::update ( BaseThread *thread )
+{
+   ThreadTeam *team = thread->getTeam();
+   if ( team != _team || ( team != NULL && team->size() != _teamSize ) ) build( thread );
+}
+
+void StealOrder::build ( BaseThread *thread )
+{
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      _victims[level].clear();
+      _next[level] = 0;
+   }
+
+   _team = thread->getTeam();
+   _teamSize = 0;
+   if ( _team == NULL ) return;
+
+   unsigned int cpu = thread->getCpuId();
+   unsigned int core = sys._hwloc.getCoreOfCpu( cpu );
+   unsigned int socket = sys._hwloc.getSocketOfCpu( cpu );
+
+   // Threads may be entering or leaving the team meanwhile
+   _team->lock();
+   _teamSize = _team->size();
+   for ( unsigned i = 0; i < _teamSize; i++ ) {
+      BaseThread &victim = _team->getThread( i );
+      if ( &victim == thread ) continue;
+
+      unsigned int victimCpu = victim.getCpuId();
+      if ( sys._hwloc.getCoreOfCpu( victimCpu ) == core ) {
+         _victims[SAME_CORE].push_back( &victim );
+      } else if ( sys._hwloc.getSocketOfCpu( victimCpu ) == socket ) {
+         _victims[SAME_SOCKET].push_back( &victim );
+      } else {
+         _victims[REMOTE].push_back( &victim );
+      }
+   }
+   _team->unlock();
+
+   // Do not make all the threads of a level start with the same victim
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      if ( !_victims[level].empty() ) _next[level] = thread->getId() % _victims[level].size();
+   }
+}
+
+int StealOrder::getMaxLevel ( int numSteal ) const
+{
+   int rounds = numSteal > 0 ? ( numSteal - 1 ) / sys.getSchedulerConf().getStealBackoff() : 0;
+   int maxLevel = -1;
+
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      if ( _victims[level].empty() ) continue;
+      maxLevel = level;
+      if ( rounds-- == 0 ) break;
+   }
+
+   return maxLevel;
+}
+
+void StealOrder::flush ()
+{
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      if ( _attempts[level] != 0 ) {
+         _totalAttempts[level] += _attempts[level];
+         _attempts[level] = 0;
+      }
+      if ( _steals[level] != 0 ) {
+         _totalSteals[level] += _steals[level];
+         _steals[level] = 0;
+      }
+   }
+}
+
+std::string StealOrder::getSummary ()
+{
+   static const char *names[NUM_LEVELS] = { "same core:  ", "same socket:", "remote:     " };
+
+   unsigned long attempts = 0;
+   for ( int level = 0; level < NUM_LEVELS; level++ ) attempts += _totalAttempts[level].value();
+   if ( attempts == 0 ) return std::string();
+
+   std::ostringstream s;
+   s << "=== Steals by topology level (successful / attempts):" << std::endl;
+   for ( int level = 0; level < NUM_LEVELS; level++ ) {
+      s << "===  | " << names[level] << " " << _totalSteals[level].value()
+        << " / " << _totalAttempts[level].value() << std::endl;
+   }
+   return s.str();
+}
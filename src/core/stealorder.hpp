@@ -0,0 +1,71 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_STEALORDER_H
+#define _NANOS_STEALORDER_H
+
+#include "stealorder_decl.hpp"
+#include "basethread.hpp"
+
+namespace nanos {
+
+inline const StealOrder::VictimList & StealOrder::getVictims ( Level level ) const
+{
+   return _victims[level];
+}
+
+template <typename StealFunctor>
+inline WD * StealOrder::steal ( BaseThread *thread, int numSteal, StealFunctor &stealFrom )
+{
+   update( thread );
+
+   int maxLevel = getMaxLevel( numSteal );
+   for ( int level = 0; level <= maxLevel; level++ ) {
+      VictimList &victims = _victims[level];
+      size_t n = victims.size();
+
+      for ( size_t i = 0; i < n; i++ ) {
+         size_t idx = ( _next[level] + i ) % n;
+         BaseThread *victim = victims[idx];
+         if ( victim->getTeam() != _team ) continue;
+
+         if ( _countSteals ) _attempts[level]++;
+         WD *wd = stealFrom( thread, *victim );
+         if ( wd != NULL ) {
+            // Start with the same victim next time, it may have more work
+            _next[level] = idx;
+            if ( _countSteals ) {
+               _steals[level]++;
+               flush();
+            }
+            return wd;
+         }
+      }
+
+      // Spread the failed rounds among the victims of the level
+      if ( n > 0 ) _next[level] = ( _next[level] + 1 ) % n;
+   }
+
+   if ( _countSteals ) flush();
+   return NULL;
+}
+
+} // namespace nanos
+
+#endif
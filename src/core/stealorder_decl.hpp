@@ -0,0 +1,117 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_STEALORDER_DECL_H
+#define _NANOS_STEALORDER_DECL_H
+
+#include <vector>
+#include <string>
+
+#include "atomic_decl.hpp"
+#include "basethread_fwd.hpp"
+#include "threadteam_fwd.hpp"
+#include "workdescriptor_fwd.hpp"
+
+namespace nanos {
+
+   /*! \brief Topology-aware order in which a thread visits steal victims
+    *
+    *  Groups the other threads of the team by their distance to the thief:
+    *  first its SMT siblings, then the threads in its socket (sharing the
+    *  last level cache) and finally those in other sockets or NUMA nodes.
+    *  A farther level is only visited after getStealBackoff() failed steal
+    *  rounds on the closer ones, so idle threads keep the work local as long
+    *  as there is some.
+    *
+    *  Each thread owns its StealOrder (e.g. in its ScheduleThreadData). With
+    *  --summary, the steal attempts and successes of each level are counted
+    *  by the thread and added to process-wide totals at the end of every
+    *  steal() call. Otherwise steals are not counted at all.
+    */
+   class StealOrder
+   {
+      public:
+         /*! \brief Distance levels, from closer to farther */
+         enum Level {
+            SAME_CORE = 0,    /**< SMT siblings */
+            SAME_SOCKET,      /**< Other cores of the socket */
+            REMOTE,           /**< Threads in other sockets */
+            NUM_LEVELS
+         };
+
+         typedef std::vector<BaseThread *> VictimList;
+
+      private:
+         VictimList              _victims[NUM_LEVELS];   /**< Victims of each level */
+         size_t                  _next[NUM_LEVELS];      /**< Victim each level starts with */
+         unsigned long           _attempts[NUM_LEVELS];  /**< Steal attempts of the current steal() call */
+         unsigned long           _steals[NUM_LEVELS];    /**< Successful steals of the current steal() call */
+         bool                    _countSteals;           /**< Whether steals are counted for the summary */
+         ThreadTeam             *_team;                  /**< Team the victim lists were built for */
+         unsigned                _teamSize;              /**< Size of _team when the lists were built */
+
+         static Atomic<unsigned long>  _totalAttempts[NUM_LEVELS];
+         static Atomic<unsigned long>  _totalSteals[NUM_LEVELS];
+
+         /*! \brief StealOrder copy constructor (private)
+          */
+         StealOrder ( const StealOrder & );
+         /*! \brief StealOrder copy assignment operator (private)
+          */
+         const StealOrder & operator= ( const StealOrder & );
+
+         /*! \brief Builds the victim lists of thread from the topology */
+         void build ( BaseThread *thread );
+         /*! \brief Adds the counters of the current steal() call to the totals */
+         void flush ();
+
+      public:
+         /*! \brief StealOrder default constructor
+          */
+         StealOrder ();
+         /*! \brief StealOrder destructor
+          */
+         ~StealOrder ();
+
+         /*! \brief Rebuilds the victim lists if the team of thread changed */
+         void update ( BaseThread *thread );
+
+         /*! \brief Returns the victims of a level, as of the last update() */
+         const VictimList & getVictims ( Level level ) const;
+
+         /*! \brief Returns the farthest level to visit after numSteal failed steal rounds
+          *  (-1 if there are no victims). Empty levels do not count for the backoff.
+          */
+         int getMaxLevel ( int numSteal ) const;
+
+         /*! \brief Tries to steal from the reachable victims, closer levels first
+          *  \param numSteal Steal rounds failed so far, as passed to SchedulePolicy::atIdle
+          *  \param stealFrom Functor called as stealFrom( thread, victim ), returning the stolen WD or NULL
+          *  \return The stolen WD, or NULL if none
+          */
+         template <typename StealFunctor>
+         WD * steal ( BaseThread *thread, int numSteal, StealFunctor &stealFrom );
+
+         /*! \brief Returns the per level steal counters, empty if there were no steals */
+         static std::string getSummary ();
+   };
+
+} // namespace nanos
+
+#endif
@@ -22,12 +22,14 @@
 #include <signal.h>
 #include <set>
 #include <climits>
+#include <algorithm>
 
 #include "atomic.hpp"
 #include "system.hpp"
 #include "config.hpp"
 #include "plugin.hpp"
 #include "schedule.hpp"
+#include "stealorder.hpp"
 #include "barrier.hpp"
 #include "nanos-int.h"
 #include "copydata.hpp"
@@ -86,7 +88,7 @@ System::System () :
       _instrument( false ), _verboseMode( false ), _summary( false ), _executionMode( DEDICATED ), _initialMode( POOL ),
       _untieMaster( true ), _delayedStart( false ), _synchronizedStart( true ), _alreadyFinished( false ),
       _predecessorLists( false ), _throttlePolicy ( NULL ),
-      _schedStats(), _schedConf(), _defSchedule( "bf" ), _defThrottlePolicy( "hysteresis" ),
+      _schedStats(), _schedConf(), _wdChunkPool(), _defSchedule( "bf" ), _defThrottlePolicy( "hysteresis" ),
       _defBarr( "centralized" ), _defInstr ( "empty_trace" ), _defDepsManager( "plain" ), _defArch( "smp" ),
       _initializedThreads ( 0 ), /*_targetThreads ( 0 ),*/ _pausedThreads( 0 ),
       _pausedThreadsCond(), _unpausedThreadsCond(),
@@ -422,6 +424,7 @@ void System::config ()
 
    // Other configure options
    _schedConf.config( cfg );
+   _wdChunkPool.config( cfg );
    _hwloc.config( cfg );
    _threadManagerConf.config( cfg );
 
@@ -680,7 +683,7 @@ void System::finish ()
    verbose ( "...thread has been joined" );
 
 
-   ensure( _schedStats._readyTasks == 0, "Ready task counter has an invalid value!");
+   ensure( _schedStats.getReadyTasks() == 0, "Ready task counter has an invalid value!");
 
    verbose ( "NANOS++ statistics");
    verbose ( std::dec << (unsigned int) getCreatedTasks() << " tasks has been executed" );
@@ -886,7 +889,7 @@ void System::createWD ( WD **uwd, size_t num_devices, nanos_device_t *devices, s
       total_size = NANOS_ALIGNED_MEMORY_OFFSET(offset_PMD,size_PMD,1);
    }
 
-   chunk = NEW char[total_size];
+   chunk = (char *) _wdChunkPool.allocate( total_size );
    if ( props != NULL ) {
       if (props->clear_chunk)
           memset(chunk, 0, sizeof(char) * total_size);
@@ -914,6 +917,9 @@ void System::createWD ( WD **uwd, size_t num_devices, nanos_device_t *devices, s
    wd =  new (*uwd) WD( num_devices, dev_ptrs, data_size, data_align, data != NULL ? *data : NULL,
                         num_copies, (copies != NULL)? *copies : NULL, translate_args, description );
 
+   // The chunk is released with the WD unless the caller provided the WD storage
+   if ( (char *) wd == chunk ) wd->setInChunkPool();
+
    if ( slicer ) wd->setSlicer(slicer);
 
    // Set WD's socket
@@ -973,6 +979,111 @@ void System::createWD ( WD **uwd, size_t num_devices, nanos_device_t *devices, s
    if (uwg) wd->copyReductions((WorkDescriptor *)uwg);
 }
 
+/*! \brief Creates several sibling WDs of the same task in one memory chunk
+ *
+ *  \param [out] uwds array where the num_wds new WDs are stored
+ *  \param [in] num_wds number of WDs to create
+ *  \param [out] data if not NULL, array where the data environment of each WD is stored
+ *
+ *  \par Description:
+ *
+ *  The chunk starts with a WDBatch header, followed by num_wds slots with the same layout
+ *  createWD uses (WD, data, device pointers, internal data and scheduling data), so every
+ *  WD gets its own argument block. The parent's number of components is updated once for
+ *  the whole batch, and the chunk is released when the last of its WDs is destroyed (see
+ *  destroyWD). WDs with copies or slicers are not supported.
+ *
+ *  \sa createWD, destroyWD
+ */
+void System::createWDs ( WD **uwds, size_t num_wds, size_t num_devices, nanos_device_t *devices, size_t data_size,
+                         size_t data_align, void **data, WD *uwg, nanos_wd_props_t *props, nanos_wd_dyn_props_t *dyn_props,
+                         const char *description )
+{
+   ensure( num_devices > 0, "WorkDescriptor has no devices" );
+   ensure( num_wds > 0, "Creating an empty batch of WorkDescriptors" );
+
+   size_t offset_Data, size_DPtrs, offset_DPtrs, offset_PMD, offset_Sched, offset_WDs;
+   size_t slot_size, slot_align, total_size;
+
+   // Computing the layout of every slot, as createWD does
+   offset_Data   = NANOS_ALIGNED_MEMORY_OFFSET(0, sizeof(WD), data_align );
+   size_DPtrs    = sizeof(DD *) * num_devices;
+   offset_DPtrs  = NANOS_ALIGNED_MEMORY_OFFSET(offset_Data, data_size, __alignof__( DD*) );
+   slot_align    = std::max( __alignof__( WD ), std::max( data_align, __alignof__( DD* ) ) );
+
+   static size_t size_PMD   = _pmInterface->getInternalDataSize();
+   static size_t align_PMD = size_PMD != 0 ? _pmInterface->getInternalDataAlignment() : 1;
+   offset_PMD = NANOS_ALIGNED_MEMORY_OFFSET(offset_DPtrs, size_DPtrs, align_PMD );
+   slot_align = std::max( slot_align, align_PMD );
+
+   static size_t size_Sched = _defSchedulePolicy->getWDDataSize();
+   static size_t align_Sched = size_Sched != 0 ? _defSchedulePolicy->getWDDataAlignment() : 1;
+   offset_Sched = NANOS_ALIGNED_MEMORY_OFFSET(offset_PMD, size_PMD, align_Sched );
+   slot_align = std::max( slot_align, align_Sched );
+
+   // Every slot starts aligned, so all of them share the same layout
+   slot_size = NANOS_ALIGNED_MEMORY_OFFSET(offset_Sched, size_Sched, slot_align );
+   offset_WDs = NANOS_ALIGNED_MEMORY_OFFSET(0, sizeof(WDBatch), slot_align );
+   total_size = offset_WDs + slot_size * num_wds;
+
+   char *chunk = (char *) _wdChunkPool.allocate( total_size );
+   if ( props != NULL && props->clear_chunk ) memset( chunk, 0, total_size );
+
+   WDBatch *batch = new ( chunk ) WDBatch();
+   batch->_liveWDs = num_wds;
+
+   for ( size_t w = 0; w < num_wds; w++ ) {
+      char *slot = chunk + offset_WDs + w * slot_size;
+      void *wd_data = data_size != 0 ? slot + offset_Data : NULL;
+      if ( data != NULL ) data[w] = wd_data;
+
+      // allocating Device Data
+      DD **dev_ptrs = ( DD ** ) (slot + offset_DPtrs);
+      for ( size_t i = 0 ; i < num_devices ; i ++ ) dev_ptrs[i] = ( DD* ) devices[i].factory( devices[i].arg );
+
+      WD *wd = new (slot) WD( num_devices, dev_ptrs, data_size, data_align, wd_data, 0, NULL, NULL, description );
+      wd->setBatch( batch );
+      wd->setNUMANode( sys.getUserDefinedNUMANode() );
+      wd->setTotalSize( slot_size );
+      if ( wd->getNUMANode() >= (int)sys.getNumNumaNodes() ) throw NANOS_INVALID_PARAM;
+      wd->setVersionGroupId( ( unsigned long ) devices );
+
+      if ( size_PMD > 0 ) {
+         _pmInterface->initInternalData( slot + offset_PMD );
+         wd->setInternalData( slot + offset_PMD );
+      }
+
+      if ( size_Sched > 0 ) {
+         _defSchedulePolicy->initWDData( slot + offset_Sched );
+         wd->setSchedulerData( reinterpret_cast<ScheduleWDData*>( slot + offset_Sched ), /*ownedByWD*/ false );
+      }
+
+      if ( props != NULL && props->tied ) wd->tied();
+
+      if ( dyn_props != NULL ) {
+         wd->setPriority( dyn_props->priority );
+         wd->setFinal ( dyn_props->flags.is_final );
+         wd->setRecoverable ( dyn_props->flags.is_recover);
+         if ( dyn_props->flags.is_implicit ) wd->setImplicit();
+         wd->setCallback(dyn_props->callback);
+         wd->setArguments(dyn_props->arguments);
+         if ( dyn_props->tie_to ) wd->tieTo( *( BaseThread * )dyn_props->tie_to );
+      }
+
+      if (_createLocalTasks) {
+         wd->tieToLocation( 0 );
+      }
+
+      uwds[w] = wd;
+   }
+
+   // add to workdescriptor
+   if ( uwg != NULL ) {
+      uwg->addWork( num_wds, uwds );
+      for ( size_t w = 0; w < num_wds; w++ ) uwds[w]->copyReductions( uwg );
+   }
+}
+
 /*! \brief Duplicates the whole structure for a given WD
  *
  *  \param [out] uwd is the target addr for the new WD
@@ -1059,7 +1170,7 @@ void System::duplicateWD ( WD **uwd, WD *wd)
       total_size = NANOS_ALIGNED_MEMORY_OFFSET(offset_PMD,size_PMD,1);
    }
 
-   chunk = NEW char[total_size];
+   chunk = (char *) _wdChunkPool.allocate( total_size );
 
    // allocating WD and DATA; if size_Data == 0 data keep the NULL value
    if ( *uwd == NULL ) *uwd = (WD *) chunk;
@@ -1090,6 +1201,7 @@ void System::duplicateWD ( WD **uwd, WD *wd)
    // creating new WD
    // FIXME jbueno (#758) should we have to take into account dimensions?
    new (*uwd) WD( *wd, dev_ptrs, wdCopies, data );
+   if ( (char *) *uwd == chunk ) (*uwd)->setInChunkPool();
 
    // Set total size
    (*uwd)->setTotalSize(total_size );
@@ -1109,6 +1221,34 @@ void System::duplicateWD ( WD **uwd, WD *wd)
    }
 }
 
+void System::destroyWD ( WD *wd )
+{
+   bool inChunkPool = wd->isInChunkPool();
+   WDBatch *batch = wd->getBatch();
+   wd->~WorkDescriptor();
+   releaseWDChunk( wd, inChunkPool, batch );
+}
+
+void System::releaseWDMemory ( WD *wd )
+{
+   releaseWDChunk( wd, wd->isInChunkPool(), wd->getBatch() );
+}
+
+void System::releaseWDChunk ( void *chunk, bool inChunkPool, WDBatch *batch )
+{
+   if ( batch != NULL ) releaseWDBatch( batch );
+   else if ( inChunkPool ) _wdChunkPool.deallocate( chunk );
+   else delete[] ( char * ) chunk;
+}
+
+void System::releaseWDBatch ( WDBatch *batch )
+{
+   if ( --batch->_liveWDs == 0 ) {
+      batch->~WDBatch();
+      _wdChunkPool.deallocate( batch );
+   }
+}
+
 void System::setupWD ( WD &work, WD *parent )
 {
    // Inherit parent properties
@@ -1137,6 +1277,22 @@ void System::submit ( WD &work )
    work.submit();
 }
 
+//! \brief Submit several WorkDescriptors with no dependencies at once
+void System::submit ( WD **works, size_t numWorks )
+{
+   // Sliced WorkDescriptors cannot be submitted in a batch
+   for ( size_t i = 0; i < numWorks; i++ ) {
+      if ( works[i]->getSlicer() != NULL ) throw NANOS_INVALID_PARAM;
+   }
+
+   SchedulePolicy* policy = getDefaultSchedulePolicy();
+   for ( size_t i = 0; i < numWorks; i++ ) {
+      policy->onSystemSubmit( *works[i], SchedulePolicy::SYS_SUBMIT );
+   }
+
+   Scheduler::submit( works, numWorks );
+}
+
 //! \brief Submit WorkDescriptor to its parent's  dependencies domain
 void System::submitWithDependencies (WD& work, size_t numDataAccesses, DataAccess* dataAccesses)
 {
@@ -1281,20 +1437,28 @@ BaseThread * System::getWorker ( unsigned int n )
 void System::acquireWorker ( ThreadTeam * team, BaseThread * thread, bool enter, bool star, bool creator )
 {
    int thId = team->addThread( thread, star, creator );
-   TeamData *data = NEW TeamData();
-   if ( creator ) data->setCreator( true );
 
-   data->setStar(star);
+   // A thread rejoining the team gets back the TeamData it left, with its scheduling queues
+   TeamData *data = team->reuseLeftTeamData( *thread );
+   if ( data != NULL ) {
+      data->reset();
+   } else {
+      data = NEW TeamData();
 
-   SchedulePolicy &sched = team->getSchedulePolicy();
-   ScheduleThreadData *sthdata = 0;
-   if ( sched.getThreadDataSize() > 0 ) {
-      sthdata = sched.createThreadData();
+      SchedulePolicy &sched = team->getSchedulePolicy();
+      ScheduleThreadData *sthdata = 0;
+      if ( sched.getThreadDataSize() > 0 ) {
+         sthdata = sched.createThreadData();
+      }
+      data->setScheduleData(sthdata);
    }
 
+   if ( creator ) data->setCreator( true );
+
+   data->setStar(star);
+
    data->setId(thId);
    data->setTeam(team);
-   data->setScheduleData(sthdata);
    if ( creator ) {
       data->setParentTeamData(thread->getTeamData());
    }
@@ -1496,6 +1660,12 @@ void System::executionSummary()
       }
    }
 
+   std::string stealOutput = StealOrder::getSummary();
+   if ( stealOutput.length() > 0 ) {
+      output << stealOutput;
+      output << "==========================================================" << std::endl;
+   }
+
    message0( output.str() );
 }
 
@@ -1720,10 +1890,10 @@ void System::stopFirstThread( void ) {
 
 void System::notifyIntoBlockingMPICall() {
    static int created = 0;
-   if ( _schedStats._createdTasks.value() > created ) {
+   if ( _schedStats.getCreatedTasks() > created ) {
       _inIdle = true;
-      *myThread->_file << "created " << ( _schedStats._createdTasks.value() - created ) << " tasks. Send msg." << std::endl;
-      created = _schedStats._createdTasks.value();
+      *myThread->_file << "created " << ( _schedStats.getCreatedTasks() - created ) << " tasks. Send msg." << std::endl;
+      created = _schedStats.getCreatedTasks();
       _net.broadcastIdle();
    }
 }
@@ -1907,7 +2077,7 @@ void System::preSchedule() {
             DOSubmit *d = (*sit)->getDOSubmit();
             for (DependableObject::DependableObjectVector::const_iterator pit = d->getPredecessors().begin();
                   pit != d->getPredecessors().end(); pit++ ) {
-               WD *predecessor_wd = pit->second->getWD();
+               WD *predecessor_wd = (*pit)->getWD();
                predecessor_wd->_schedPredecessorLocs[ wd->_schedValues[0] ] += 1;
             }
          }
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include "schedule_decl.hpp"
+#include "wdchunkpool.hpp"
 #include "threadteam.hpp"
 #include "slicer.hpp"
 #include "nanos-int.h"
@@ -61,6 +62,8 @@ inline bool System::getVerbose () const { return _verboseMode; }
 
 inline void System::setVerbose ( bool value ) { _verboseMode = value; }
 
+inline bool System::getSummary () const { return _summary; }
+
 inline void System::setInitialMode ( System::InitialMode mode ) { _initialMode = mode; }
 
 inline System::InitialMode System::getInitialMode() const { return _initialMode; }
@@ -69,15 +72,15 @@ inline void System::setDelayedStart ( bool set) { _delayedStart = set; }
 
 inline bool System::getDelayedStart () const { return _delayedStart; }
 
-inline int System::getCreatedTasks() const { return _schedStats._createdTasks.value(); }
+inline int System::getCreatedTasks() const { return _schedStats.getCreatedTasks(); }
 
-inline int System::getTaskNum() const { return _schedStats._totalTasks.value(); }
+inline int System::getTaskNum() const { return _schedStats.getTotalTasks(); }
 
-inline int System::getReadyNum() const { return _schedStats._readyTasks.value(); }
+inline int System::getReadyNum() const { return _schedStats.getReadyTasks(); }
 
-inline int System::getIdleNum() const { return _schedStats._idleThreads.value(); }
+inline int System::getIdleNum() const { return _schedStats.getIdleThreads(); }
 
-inline int System::getRunningTasks() const { return _workers.size() - _schedStats._idleThreads.value(); }
+inline int System::getRunningTasks() const { return _workers.size() - _schedStats.getIdleThreads(); }
 
 inline void System::setUntieMaster ( bool value ) { _untieMaster = value; }
 inline bool System::getUntieMaster () const { return _untieMaster; }
@@ -343,6 +346,8 @@ inline SchedulePolicy * System::getDefaultSchedulePolicy ( ) const  { return _de
 inline SchedulerStats & System::getSchedulerStats () { return _schedStats; }
 inline SchedulerConf  & System::getSchedulerConf ()  { return _schedConf; }
 
+inline WDChunkPool & System::getWDChunkPool () { return _wdChunkPool; }
+
 inline void System::stopScheduler ()
 {
    myThread->pause();
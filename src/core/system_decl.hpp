@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include "schedule_decl.hpp"
+#include "wdchunkpool_decl.hpp"
 #include "threadteam_decl.hpp"
 #include "slicer_decl.hpp"
 #include "worksharing_decl.hpp"
@@ -129,6 +130,7 @@ namespace nanos {
          ThrottlePolicy      *_throttlePolicy;
          SchedulerStats       _schedStats;
          SchedulerConf        _schedConf;
+         WDChunkPool          _wdChunkPool;           //!< \brief Recycles the memory of finished WDs
          std::string          _defSchedule;           //!< \brief Name of default scheduler
          std::string          _defThrottlePolicy;     //!< \brief Name of default throttole policy (cutoff)
          std::string          _defBarr;               //!< \brief Name of default barrier
@@ -287,6 +289,10 @@ namespace nanos {
           */
          ProcessingElement * getPEWithDevice( const Device &arch );
 
+         /*! \brief Gives back the memory chunk of a WD placed at \a chunk
+          */
+         void releaseWDChunk ( void *chunk, bool inChunkPool, WDBatch *batch );
+
       public:
          /*! \brief System default constructor
           */
@@ -313,6 +319,12 @@ namespace nanos {
 
 
          void submit ( WD &work );
+         /*! \brief Submits several WorkDescriptors with no dependencies to the scheduler at once
+          *
+          *  The contents of works are undefined after the call. Throws NANOS_INVALID_PARAM, having
+          *  submitted none of them, if any of them is sliced.
+          */
+         void submit ( WD **works, size_t numWorks );
          void submitWithDependencies (WD& work, size_t numDataAccesses, DataAccess* dataAccesses);
          void waitOn ( size_t numDataAccesses, DataAccess* dataAccesses);
          void inlineWork ( WD &work );
@@ -325,8 +337,31 @@ namespace nanos {
                         size_t num_dimensions, nanos_region_dimension_internal_t **dimensions,
                         nanos_translate_args_t translate_args, const char *description, Slicer *slicer );
 
+         void createWDs ( WD **uwds, size_t num_wds, size_t num_devices, nanos_device_t *devices,
+                          size_t data_size, size_t data_align, void **data, WD *uwg,
+                          nanos_wd_props_t *props, nanos_wd_dyn_props_t *dyn_props, const char *description );
+
          void duplicateWD ( WD **uwd, WD *wd );
 
+         /*! \brief Destroys a finished WD and releases the memory chunk holding it
+          *
+          *  WDs created by createWD or duplicateWD go back to the WDChunkPool, the ones created
+          *  by createWDs release their shared chunk, other ones are deleted as a plain array of chars.
+          */
+         void destroyWD ( WD *wd );
+
+         /*! \brief Releases the memory chunk holding a WD without running its destructor
+          *
+          *  Same memory handling as destroyWD, for devices that tear down their WDs by themselves.
+          */
+         void releaseWDMemory ( WD *wd );
+
+         /*! \brief Releases the slot of an already destroyed WD in a chunk created by createWDs
+          *
+          *  The chunk goes back to the WDChunkPool with its last WD.
+          */
+         void releaseWDBatch ( WDBatch *batch );
+
         /* \brief prepares a WD to be scheduled/executed.
          * \param work WD to be set up
          */
@@ -347,6 +382,8 @@ namespace nanos {
 
          void setVerbose ( bool value );
 
+         bool getSummary () const;
+
          void setInitialMode ( InitialMode mode );
          InitialMode getInitialMode() const;
 
@@ -522,6 +559,9 @@ namespace nanos {
          SchedulerStats & getSchedulerStats ();
          SchedulerConf  & getSchedulerConf();
 
+         //! \brief Returns the pool where the WD chunks are allocated (see createWD)
+         WDChunkPool & getWDChunkPool();
+
          /*! \brief Disables the execution of pending WDs in the scheduler's
           queue.
          */
@@ -0,0 +1,175 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "taskgraph.hpp"
+#include "workdescriptor.hpp"
+#include "dependableobjectwd.hpp"
+#include "dependenciesdomain.hpp"
+#include "dataaccess.hpp"
+#include "schedule.hpp"
+#include "system.hpp"
+#include "instrumentation.hpp"
+
+using namespace nanos;
+
+TaskGraph::TaskGraph ( WorkDescriptor &owner ) : _owner( owner ), _nodes(), _accesses(), _recording( true ) {}
+
+TaskGraph::~TaskGraph ()
+{
+   for ( NodeVector::iterator it = _nodes.begin(); it != _nodes.end(); it++ ) {
+      WorkDescriptor *tmpl = it->_template;
+      sys.destroyWD( tmpl );
+      delete it->_wait;
+   }
+}
+
+void TaskGraph::addEdge ( int pred )
+{
+   unsigned int succ = _nodes.size() - 1;
+   if ( pred < 0 || (unsigned int) pred == succ ) return;
+
+   // Edges to the last node are only added while it is recorded, so a
+   // repeated one is always at the end of the successor list
+   NodeList &successors = _nodes[pred]._successors;
+   if ( !successors.empty() && successors.back() == succ ) return;
+
+   successors.push_back( succ );
+   _nodes[succ]._numPredecessors++;
+}
+
+void TaskGraph::record ( WorkDescriptor &wd, size_t numDeps, DataAccess *deps, bool undeferred )
+{
+   ensure( _recording, "Recording a task in a task graph that has been closed" );
+
+   // The template is registered as a component of the owner when it is copied, but
+   // it will never run so it must not be waited for. Undeferred tasks only have a
+   // forced parent, so their templates are not registered
+   WorkDescriptor *tmpl = NULL;
+   sys.duplicateWD( &tmpl, &wd );
+   if ( !undeferred && tmpl->getParent() != NULL ) tmpl->getParent()->exitWork( *tmpl );
+
+   _nodes.push_back( Node( tmpl, undeferred ? NEW DOWait() : NULL ) );
+   unsigned int node = _nodes.size() - 1;
+
+   // Edges follow the plain dependencies semantics: concurrent and commutative
+   // accesses are serialized as inout ones
+   for ( size_t i = 0; i < numDeps; i++ ) {
+      DataAccess &dep = deps[i];
+      void *target = dep.getDepAddress();
+      if ( target == NULL ) continue;
+
+      AccessStatus &status = _accesses[target];
+
+      if ( dep.isOutput() ) {
+         addEdge( status._lastWriter );
+         for ( NodeList::iterator it = status._readers.begin(); it != status._readers.end(); it++ ) {
+            addEdge( *it );
+         }
+         status._lastWriter = node;
+         status._readers.clear();
+      } else if ( dep.isInput() ) {
+         addEdge( status._lastWriter );
+         if ( status._readers.empty() || status._readers.back() != node ) status._readers.push_back( node );
+      } else {
+         fatal( "Invalid data access" );
+      }
+   }
+}
+
+void TaskGraph::end ()
+{
+   ensure( _recording, "Closing a task graph that has been closed" );
+   _recording = false;
+   _accesses.clear();
+}
+
+void TaskGraph::replay ( WorkDescriptor &parent )
+{
+   ensure( !_recording, "Replaying a task graph that is being recorded" );
+   fatal_cond( &parent != &_owner, "A task graph can only be replayed by the WorkDescriptor that recorded it" );
+
+   parent.waitCompletion();
+
+   size_t numNodes = _nodes.size();
+   if ( numNodes == 0 ) return;
+
+   SchedulePolicy *policy = sys.getDefaultSchedulePolicy();
+   std::vector<DependableObject *> instances( numNodes );
+
+   // Instantiate every deferred task, holding a fake dependency so that none of
+   // them becomes ready before the whole graph is linked. Undeferred tasks only
+   // need their wait object, which holds a fake dependency too
+   for ( size_t i = 0; i < numNodes; i++ ) {
+      DOWait *wait = _nodes[i]._wait;
+      if ( wait != NULL ) {
+         wait->init();
+         wait->setWD( &parent );
+         wait->increasePredecessors();
+         instances[i] = wait;
+         continue;
+      }
+
+      WorkDescriptor *wd = NULL;
+      sys.duplicateWD( &wd, _nodes[i]._template );
+      sys.setupWD( *wd, &parent );
+      policy->onSystemSubmit( *wd, SchedulePolicy::SYS_SUBMIT_WITH_DEPENDENCIES );
+
+      NANOS_INSTRUMENT ( sys.getInstrumentation()->raiseOpenPtPEvent ( NANOS_WD_DOMAIN, (nanos_event_id_t) wd->getId(), 0, 0 ); )
+
+      DOSubmit *depObj = wd->initDOSubmit();
+      depObj->increasePredecessors();
+      instances[i] = depObj;
+   }
+
+   // The edges leaving an undeferred task are satisfied by construction: it has
+   // run before the tasks recorded after it are released
+   for ( size_t i = 0; i < numNodes; i++ ) {
+      if ( _nodes[i]._wait != NULL ) continue;
+
+      NodeList const &successors = _nodes[i]._successors;
+      for ( NodeList::const_iterator it = successors.begin(); it != successors.end(); it++ ) {
+         instances[i]->addSuccessor( *instances[*it] );
+         instances[*it]->increasePredecessors();
+      }
+   }
+
+   for ( size_t i = 0; i < numNodes; i++ ) {
+      policy->atCreate( *instances[i] );
+      instances[i]->submitted();
+   }
+   DependenciesDomain::increaseTasksInGraph( numNodes );
+
+   // Release the fake dependencies in recording order, a task may finish (and free
+   // its DOSubmit) as soon as its own one has been released
+   for ( size_t i = 0; i < numNodes; i++ ) {
+      if ( _nodes[i]._wait == NULL ) {
+         instances[i]->decreasePredecessors( NULL, NULL, false, false );
+         continue;
+      }
+
+      _nodes[i]._wait->decreasePredecessors( NULL, NULL, false, true );
+
+      WorkDescriptor *wd = NULL;
+      sys.duplicateWD( &wd, _nodes[i]._template );
+      wd->forceParent( &parent );
+      sys.setupWD( *wd, &parent );
+      sys.inlineWork( *wd );
+      sys.destroyWD( wd );
+   }
+}
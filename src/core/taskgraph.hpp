@@ -0,0 +1,48 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_TASK_GRAPH_H
+#define _NANOS_TASK_GRAPH_H
+
+#include "taskgraph_decl.hpp"
+
+namespace nanos {
+
+inline bool TaskGraph::isRecording () const
+{
+   return _recording;
+}
+
+inline size_t TaskGraph::getNumTasks () const
+{
+   return _nodes.size();
+}
+
+inline size_t TaskGraph::getNumEdges () const
+{
+   size_t edges = 0;
+   for ( NodeVector::const_iterator it = _nodes.begin(); it != _nodes.end(); it++ ) {
+      edges += it->_successors.size();
+   }
+   return edges;
+}
+
+} // namespace nanos
+
+#endif
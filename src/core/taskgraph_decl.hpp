@@ -0,0 +1,133 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_TASK_GRAPH_DECL_H
+#define _NANOS_TASK_GRAPH_DECL_H
+
+#include <vector>
+#include "compatibility.hpp"
+#include "dataaccess_fwd.hpp"
+#include "workdescriptor_fwd.hpp"
+#include "dependableobjectwd_fwd.hpp"
+#include "taskgraph_fwd.hpp"
+
+namespace nanos {
+
+   /*! \class TaskGraph
+    *  \brief Recorded graph of the tasks submitted by a WorkDescriptor
+    *
+    *  While a WorkDescriptor is recording, every WorkDescriptor it submits is kept as a
+    *  template together with the edges that its data accesses create with the previously
+    *  recorded ones. Replaying the graph instantiates the templates again and links them
+    *  with the precomputed successor lists and predecessor counts, so that the dependencies
+    *  domain is not involved at all.
+    *
+    *  Undeferred tasks (if(0), final or included ones) are recorded too. They are not
+    *  submitted on replay: the WorkDescriptor replaying the graph waits for their
+    *  predecessors and runs them inline, in the same order they were recorded.
+    */
+   class TaskGraph
+   {
+      private:
+         typedef std::vector<unsigned int> NodeList;
+
+         /*! \brief Recorded task
+          */
+         struct Node {
+            WorkDescriptor *_template;         //!< Copy of the submitted WorkDescriptor
+            NodeList        _successors;       //!< Nodes that depend on this one
+            unsigned int    _numPredecessors;  //!< Number of nodes this one depends on
+            DOWait         *_wait;             //!< Waits for the predecessors of an undeferred task (NULL if deferred)
+
+            Node ( WorkDescriptor *tmpl, DOWait *wait ) : _template( tmpl ), _successors(), _numPredecessors( 0 ), _wait( wait ) {}
+         };
+
+         /*! \brief Recording status of an accessed address
+          */
+         struct AccessStatus {
+            int             _lastWriter;       //!< Last node writing the address (-1 if none)
+            NodeList        _readers;          //!< Nodes reading the address since the last write
+
+            AccessStatus () : _lastWriter( -1 ), _readers() {}
+         };
+
+         typedef std::vector<Node> NodeVector;
+         typedef TR1::unordered_map<void *, AccessStatus> AccessMap;
+
+         WorkDescriptor  &_owner;              //!< WorkDescriptor that recorded the graph
+         NodeVector       _nodes;              //!< Recorded tasks, in submission order
+         AccessMap        _accesses;           //!< Address status, only used while recording
+         bool             _recording;          //!< Is the graph still being recorded?
+
+         /*! \brief TaskGraph copy constructor (disabled)
+          */
+         TaskGraph ( const TaskGraph &tg );
+
+         /*! \brief TaskGraph copy assignment operator (disabled)
+          */
+         const TaskGraph & operator= ( const TaskGraph &tg );
+
+         /*! \brief Adds an edge from node pred to the last recorded node
+          */
+         void addEdge ( int pred );
+      public:
+         /*! \brief TaskGraph constructor, starts recording the tasks submitted by owner
+          */
+         TaskGraph ( WorkDescriptor &owner );
+
+         /*! \brief TaskGraph destructor
+          */
+         ~TaskGraph ();
+
+         /*! \brief Records a WorkDescriptor submitted by the owner of the graph
+          *
+          *  Must be called before the WorkDescriptor is set up and submitted. Undeferred
+          *  WorkDescriptors are replayed inline by the WorkDescriptor replaying the graph.
+          */
+         void record ( WorkDescriptor &wd, size_t numDeps, DataAccess *deps, bool undeferred = false );
+
+         /*! \brief Stops recording
+          */
+         void end ();
+
+         /*! \brief Submits a new instance of every recorded task
+          *
+          *  The tasks previously submitted by the owner are waited for first, as
+          *  the replayed ones are not ordered with them through the dependencies domain.
+          *  Undeferred tasks are run inline once their predecessors have finished, and
+          *  the tasks recorded after them are not released until they have run.
+          */
+         void replay ( WorkDescriptor &parent );
+
+         /*! \brief Is the graph being recorded?
+          */
+         bool isRecording () const;
+
+         /*! \brief Returns the number of recorded tasks
+          */
+         size_t getNumTasks () const;
+
+         /*! \brief Returns the number of recorded edges
+          */
+         size_t getNumEdges () const;
+   };
+
+} // namespace nanos
+
+#endif
@@ -23,6 +23,9 @@
 #include "system.hpp"
 #include "config.hpp"
 #include "os.hpp"
+#include "hwloc_decl.hpp"
+
+#include <algorithm>
 
 #ifdef DLB
 #include <dlb.h>
@@ -31,7 +34,8 @@
 using namespace nanos;
 
 ThreadManager::ThreadManager( bool warmup, bool tie_master, unsigned int num_yields,
-      unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb ) :
+      unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb,
+      bool use_adaptive ) :
    _lock(),
    _initialized( false ),
    _maxThreads(),
@@ -44,6 +48,7 @@ ThreadManager::ThreadManager( bool warmup, bool tie_master, unsigned int num_yie
    _useSleep( use_sleep ),
    _useBlock( use_block ),
    _useDLB( use_dlb ),
+   _useAdaptive( use_adaptive ),
    _self_managed_cpus()
 {
 }
@@ -81,10 +86,31 @@ void ThreadManager::init()
    }
 #endif
 
+   // Topology lookups are linear in hwloc, keep their results for wakeUpForReadyTasks
+   int num_cpus = OS::getMaxProcessors();
+   _cpuCore.resize( num_cpus );
+   _cpuSocket.resize( num_cpus );
+   for ( int cpu = 0; cpu < num_cpus; cpu++ ) {
+      _cpuCore[cpu] = sys._hwloc.getCoreOfCpu( cpu );
+      _cpuSocket[cpu] = sys._hwloc.getSocketOfCpu( cpu );
+   }
+
    // Consider TM not initialized if there isn't any related flag
    _initialized = _useSleep || _useBlock || _useDLB;
 }
 
+/*! \brief Returns 0 if both CPUs share a core, 1 if they share a socket and 2 otherwise
+ */
+int ThreadManager::getCpuDistance( int cpu, int other ) const
+{
+   int num_cpus = (int) _cpuCore.size();
+   if ( cpu < 0 || other < 0 || cpu >= num_cpus || other >= num_cpus ) return 2;
+
+   if ( _cpuCore[cpu] == _cpuCore[other] ) return 0;
+   if ( _cpuSocket[cpu] == _cpuSocket[other] ) return 1;
+   return 2;
+}
+
 bool ThreadManager::isGreedy()
 {
    if ( !_initialized ) return false;
@@ -130,6 +156,15 @@ void ThreadManager::idle( int& yields
 
    BaseThread *thread = getMyThreadSafe();
 
+   if ( _useAdaptive ) {
+      // Budgets are times instead of a number of yields
+      switch ( thread->getIdleTuner().getAction() ) {
+         case IdleTuner::SPIN:  return;
+         case IdleTuner::YIELD: yields = 1; break;
+         case IdleTuner::BLOCK: yields = 0; break;
+      }
+   }
+
    if ( yields > 0 ) {
 #ifdef NANOS_INSTRUMENTATION_ENABLED
       total_yields++;
@@ -153,7 +188,13 @@ void ThreadManager::idle( int& yields
          time_blocks += (unsigned long long) ( (end_block - begin_block) * 1e9 );
 #endif
       } else if ( _useSleep ) {
-         OS::nanosleep( _sleepTime );
+         if ( _useAdaptive ) {
+            double begin_sleep = OS::getMonotonicTime();
+            OS::nanosleep( _sleepTime );
+            thread->getIdleTuner().slept( _sleepTime * 1.0e-9, OS::getMonotonicTime() - begin_sleep );
+         } else {
+            OS::nanosleep( _sleepTime );
+         }
       }
       yields = _numYields;
    }
@@ -311,6 +352,81 @@ void ThreadManager::acquireOne()
    }
 }
 
+/*! \brief Wakes up blocked threads for the ready tasks no awake thread will take
+ *
+ *  Wakes up to new_ready threads, and never more than the ready tasks that
+ *  exceed the idle threads still spinning or yielding, so that bursts of
+ *  ready tasks get threads to run them without waking up threads that
+ *  would find nothing to do. Threads close in the topology to the caller
+ *  are woken up first, as they share caches with it.
+ */
+void ThreadManager::wakeUpForReadyTasks( int new_ready )
+{
+   if ( !_initialized ) return;
+   if ( !_isMalleable ) return;
+   if ( new_ready <= 0 ) return;
+
+   int sleepers = (int) _maxThreads - (int) _cpuActiveMask.size();
+   if ( sleepers <= 0 ) return;
+
+   BaseThread *thread = getMyThreadSafe();
+   if ( !thread->getTeam() ) return;
+
+   // Blocked threads are still inside their idle loop, do not count them as awake.
+   // Recent numbers of idle threads and ready tasks are enough here, but the
+   // ready tasks we have just queued must be taken into account
+   SchedulerStats &stats = sys.getSchedulerStats();
+   int awake_idle = std::max( stats.getApproxIdleThreads() - sleepers, 0 );
+   int unclaimed = std::max( stats.getApproxReadyTasks(), new_ready ) - awake_idle;
+
+   int to_wake = std::min( std::min( new_ready, sleepers ), unclaimed );
+   if ( to_wake <= 0 ) return;
+
+   // Waking up threads is a best effort optimization within the critical path,
+   // do not wait for a lock release if the lock is busy
+#ifdef DLB
+   if ( _useDLB ) {
+      if ( !_lock.tryAcquire() ) return;
+
+      CpuSet new_active_cpus = _cpuActiveMask;
+      // If there are CPUs lent while DLB was disabled, acquire them first
+      while ( to_wake > 0 && !_self_managed_cpus.empty() ) {
+         new_active_cpus.set( _self_managed_cpus.front() );
+         _self_managed_cpus.pop_front();
+         to_wake--;
+      }
+      if ( new_active_cpus != _cpuActiveMask ) sys.setCpuActiveMask( new_active_cpus );
+      // Otherwise ask DLB
+      if ( to_wake > 0 ) DLB_AcquireCpus( to_wake );
+
+      _lock.release();
+      return;
+   }
+#endif
+
+   if ( !_lock.tryAcquire() ) return;
+
+   // Activate the inactive CPUs of the process mask, closer ones first: same core,
+   // same socket and then the rest. Threads on newly active CPUs are woken up.
+   int my_cpu = thread->getCpuId();
+   CpuSet new_active_cpus = _cpuActiveMask;
+   to_wake = std::min( to_wake, (int) _maxThreads - (int) new_active_cpus.size() );
+   for ( int distance = 0; distance < 3 && to_wake > 0; distance++ ) {
+      for ( CpuSet::const_iterator it = _cpuProcessMask.begin();
+            it != _cpuProcessMask.end() && to_wake > 0; ++it ) {
+         int cpuid = *it;
+         if ( new_active_cpus.isSet( cpuid ) || getCpuDistance( my_cpu, cpuid ) != distance ) continue;
+
+         new_active_cpus.set( cpuid );
+         to_wake--;
+      }
+   }
+
+   if ( new_active_cpus != _cpuActiveMask ) sys.setCpuActiveMask( new_active_cpus );
+
+   _lock.release();
+}
+
 void ThreadManager::acquireDefaultCPUs( int max )
 {
    if ( !_initialized ) return;
@@ -454,12 +570,15 @@ void ThreadManager::poll()
 const unsigned int ThreadManagerConf::DEFAULT_SLEEP_NS = 20000;
 const unsigned int ThreadManagerConf::DEFAULT_YIELDS = 10;
 
+const double IdleTuner::DEFAULT_WAKE_LATENCY = ThreadManagerConf::DEFAULT_SLEEP_NS * 1.0e-9;
+
 ThreadManagerConf::ThreadManagerConf() :
    _numYields( DEFAULT_YIELDS ),
    _sleepTime( DEFAULT_SLEEP_NS ),
    _useSleep( false ),
    _useBlock( false ),
    _useDLB( false ),
+   _useAdaptive( false ),
    _forceTieMaster( false ),
    _warmupThreads( false )
 {
@@ -489,6 +608,11 @@ void ThreadManagerConf::config( Config &cfg )
    cfg.registerConfigOption ( "num-yields", NEW Config::UintVar( _numYields ), yield_sstream.str() );
    cfg.registerArgOption ( "num-yields", "yields" );
 
+   cfg.registerConfigOption( "adaptive-idle", NEW Config::FlagOption( _useAdaptive, true ),
+         "Tune the time idle threads spin and yield before blocking or sleeping from the measured"
+         " idle phases and wake up latencies (overrides num-yields)" );
+   cfg.registerArgOption( "adaptive-idle", "adaptive-idle" );
+
    cfg.registerConfigOption( "enable-dlb", NEW Config::FlagOption ( _useDLB ),
          "Tune Nanos Runtime to be used with Dynamic Load Balancing library" );
    cfg.registerArgOption( "enable-dlb", "enable-dlb" );
@@ -518,6 +642,11 @@ ThreadManager* ThreadManagerConf::create()
       _useSleep = false;
    }
 
+   if ( _useAdaptive && !_useSleep && !_useBlock ) {
+      warning0( "Option --adaptive-idle needs --enable-block or --enable-sleep, disabling option." );
+      _useAdaptive = false;
+   }
+
    return NEW ThreadManager( _warmupThreads, _forceTieMaster, _numYields,
-         _sleepTime, _useSleep, _useBlock, _useDLB );
+         _sleepTime, _useSleep, _useBlock, _useDLB, _useAdaptive );
 }
@@ -24,6 +24,7 @@
 #include "atomic_decl.hpp"
 #include "cpuset.hpp"
 #include "basethread_decl.hpp"
+#include <vector>
 
 namespace nanos {
 
@@ -42,16 +43,23 @@ class ThreadManager
       bool              _useSleep;
       bool              _useBlock;
       bool              _useDLB;
+      bool              _useAdaptive;
       std::deque<int>   _self_managed_cpus;  /* List of CPUs lent while DLB is disabled */
+      std::vector<unsigned int> _cpuCore;    /* Core of each CPU, computed in init() */
+      std::vector<unsigned int> _cpuSocket;  /* Socket of each CPU, computed in init() */
+
+      int getCpuDistance( int cpu, int other ) const;
 
    public:
       ThreadManager( bool warmup, bool tie_master, unsigned int num_yields,
-            unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb );
+            unsigned int sleep_time, bool use_sleep, bool use_block, bool use_dlb,
+            bool use_adaptive );
 
       ~ThreadManager();
 
       void init();
       bool isGreedy();
+      bool isAdaptive() const { return _initialized && _useAdaptive; }
       bool lastActiveThread();
       void idle( int& yields
 #ifdef NANOS_INSTRUMENTATION_ENABLED
@@ -63,6 +71,7 @@ class ThreadManager
       void unblockThread( BaseThread *thread );
       void lendCpu( BaseThread *thread );
       void acquireOne();
+      void wakeUpForReadyTasks( int new_ready );
       void acquireDefaultCPUs( int max );
       int  borrowResources();
       void returnMyCpuIfClaimed();
@@ -88,6 +97,7 @@ class ThreadManagerConf
       bool                 _useSleep;        //!< Sleep is enabled
       bool                 _useBlock;        //!< Block is enabled
       bool                 _useDLB;          //!< DLB library will be used
+      bool                 _useAdaptive;     //!< Spin, yield and block budgets are tuned at run time
       bool                 _forceTieMaster;  //!< Force Master WD (user code) to run on Master Thread
       bool                 _warmupThreads;   //!< Force the initialization of as many threads as number of CPUs, then block them if needed
 
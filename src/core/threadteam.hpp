@@ -35,12 +35,15 @@ inline ThreadTeam::ThreadTeam ( int maxThreads, SchedulePolicy &policy, Schedule
                                 _singleGuardCount( 0 ), _schedulePolicy( policy ),
                                 _scheduleData( data ), _threadTeamData( ttd ), _parent( parent ),
                                 _level( parent == NULL ? 0 : parent->getLevel() + 1 ), _creatorId(-1),
-                                _wsDescriptor(NULL), _redList(), _lock()
+                                _wsDescriptor(NULL), _redList(), _leftData(), _lock()
 { }
 
 inline ThreadTeam::~ThreadTeam ()
 {
    ensure(size() == 0, "Destroying non-empty team!");
+   for ( TeamDataList::iterator it = _leftData.begin(); it != _leftData.end(); it++ ) {
+      delete it->second;
+   }
    delete &_barrier;
    delete _scheduleData;
    delete &_threadTeamData;
@@ -141,6 +144,25 @@ inline size_t ThreadTeam::removeThread ( unsigned id )
    return ( _threads.size() );
 }
 
+inline void ThreadTeam::keepLeftTeamData ( BaseThread &thread, TeamData *data )
+{
+   LockBlock Lock( _lock );
+   TeamData *&kept = _leftData[&thread];
+   ensure( kept == NULL, "Thread left the team twice without reusing its TeamData" );
+   kept = data;
+}
+
+inline TeamData * ThreadTeam::reuseLeftTeamData ( BaseThread &thread )
+{
+   LockBlock Lock( _lock );
+   TeamDataList::iterator it = _leftData.find( &thread );
+   if ( it == _leftData.end() ) return NULL;
+
+   TeamData *data = it->second;
+   _leftData.erase( it );
+   return data;
+}
+
 inline BaseThread * ThreadTeam::popThread ( )
 {
    BaseThread * thread;
@@ -280,6 +302,12 @@ inline nanos_reduction_t *ThreadTeam::getReduction ( void* s )
 
 inline size_t ThreadTeam::getFinalSize ( void ) const { return _expectedThreads.size(); }
 
+inline size_t ThreadTeam::getNumLeftTeamData ( void )
+{
+   LockBlock Lock( _lock );
+   return _leftData.size();
+}
+
 inline void ThreadTeam::addExpectedThread( BaseThread *thread )
 {
    LockBlock Lock( _lock );
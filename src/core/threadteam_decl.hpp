@@ -58,6 +58,7 @@ namespace nanos {
          typedef std::map<unsigned, bool>          ThreadTeamIdList; /**< List of team members */
          typedef std::list<TaskReduction *>        task_reduction_list_t;  //< List of task reductions type
          typedef std::set<BaseThread *>            ThreadSet;
+         typedef std::map<BaseThread *, TeamData *> TeamDataList; /**< TeamData of each thread that left */
 
          ThreadTeamList               _threads;          /**< Threads that make up the team */
          ThreadTeamIdList             _idList;           /**< List of id usage (reusing old id's) */
@@ -79,6 +80,7 @@ namespace nanos {
          int                          _creatorId;        /**< Team Id of the thread that created the team */
          nanos_ws_desc_t             *_wsDescriptor;     /**< Worksharing queue (pointer managed due specific atomic op's over these pointers) */
          ReductionList                _redList;          /**< Reduction List */
+         TeamDataList                 _leftData;         /**< TeamData of the threads that left the team, reused if they rejoin */
          Lock                         _lock;
       private:
 
@@ -139,6 +141,18 @@ namespace nanos {
           */
          size_t  removeThread ( unsigned id );
 
+         /*! \brief Keeps the TeamData of a thread that left the team
+          *
+          *  The other members may still be stealing from the scheduling queues of that thread,
+          *  so they cannot be deleted while any of them is running. The TeamData is given back
+          *  to the thread if it rejoins the team, and deleted with the team otherwise.
+          */
+         void keepLeftTeamData ( BaseThread &thread, TeamData *data );
+
+         /*! \brief Returns the TeamData kept when thread left the team, or NULL if there is none
+          */
+         TeamData * reuseLeftTeamData ( BaseThread &thread );
+
          /*! \brief removes and returns the last thread from the team pool
           */
          BaseThread * popThread();
@@ -217,6 +231,10 @@ namespace nanos {
          */
          size_t getFinalSize ( void ) const;
 
+        /*! \brief Get the number of TeamData kept for threads that left the team
+         */
+         size_t getNumLeftTeamData ( void );
+
         /*! \brief Check whether team has the expected members
          */
          bool isStable ( void );
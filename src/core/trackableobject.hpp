@@ -28,9 +28,27 @@
 #include "dependableobject.hpp"
 #include "atomic.hpp"
 #include "lock.hpp"
+#include "instrumentation_decl.hpp"
 
 namespace nanos {
 
+inline TrackableObject::TrackableObject ()
+   : _lastWriter ( NULL ), _versionReaders(), _readersLock(), _writerLock(), _commDO(NULL), _hold(false), _references( 0 )
+{
+   DependenciesDomain::increaseTrackedObjects();
+}
+
+inline TrackableObject::TrackableObject ( const TrackableObject &obj )
+   : _lastWriter ( obj._lastWriter ), _versionReaders(), _readersLock(), _writerLock(), _commDO(NULL), _hold(false), _references( 0 )
+{
+   DependenciesDomain::increaseTrackedObjects();
+}
+
+inline TrackableObject::~TrackableObject ()
+{
+   DependenciesDomain::decreaseTrackedObjects();
+}
+
 inline const TrackableObject & TrackableObject::operator= ( const TrackableObject &obj )
 {
    _lastWriter = obj._lastWriter;
@@ -80,22 +98,31 @@ inline TrackableObject::DependableObjectList const & TrackableObject::getReaders
 
 inline void TrackableObject::setReader ( DependableObject &reader )
 {
-   _versionReaders.push_back( &reader );
+   if ( _versionReaders.insert( &reader ).second ) {
+      reader.listedAsReader();
+   }
 }
 
 inline bool TrackableObject::hasReader ( DependableObject &depObj )
 {
-   return ( find( _versionReaders.begin(), _versionReaders.end(), &depObj ) != _versionReaders.end() );
+   return ( _versionReaders.find( &depObj ) != _versionReaders.end() );
 }
 
 inline void TrackableObject::flushReaders ( )
 {
+   // A reader may skip its own detach as soon as its count drops to zero, so it must not
+   // be accessed after being unlisted
+   for ( DependableObjectList::iterator it = _versionReaders.begin(); it != _versionReaders.end(); it++ ) {
+      (*it)->unlistedAsReader();
+   }
    _versionReaders.clear();
 }
 
 inline void TrackableObject::deleteReader ( DependableObject &reader )
 {
-   _versionReaders.remove( &reader );
+   if ( _versionReaders.erase( &reader ) > 0 ) {
+      reader.unlistedAsReader();
+   }
 }
 
 inline bool TrackableObject::hasReaders ()
@@ -108,6 +135,11 @@ inline Lock& TrackableObject::getReadersLock()
    return _readersLock;
 }
 
+inline Lock& TrackableObject::getWriterLock() const
+{
+   return _writerLock;
+}
+
 inline CommutationDO* TrackableObject::getCommDO() const
 {
    return _commDO;
@@ -124,6 +156,16 @@ inline bool TrackableObject::isEmpty ()
    return ( _lastWriter == 0 ) && _versionReaders.empty() && ( _commDO == 0 );
 }
 
+inline void TrackableObject::retain ()
+{
+   _references++;
+}
+
+inline bool TrackableObject::release ()
+{
+   return --_references == 0;
+}
+
 inline bool TrackableObject::isOnHold () const
 {
    return _hold;
@@ -34,33 +34,32 @@ namespace nanos {
    class TrackableObject
    {
       public:
-         typedef std::list< DependableObject *> DependableObjectList; /**< Type list of DependableObject */
+         typedef SmallSet<DependableObject *, 4> DependableObjectList; /**< Type list of DependableObject */
       private:
          DependableObject      *_lastWriter; /**< Points to the last DependableObject registered as writer of the TrackableObject */
          DependableObjectList   _versionReaders; /**< List of readers of the last version of the object */
          Lock                   _readersLock; /**< Lock to provide exclusive access to the readers list */
-         Lock                   _writerLock; /**< Lock internally the object for secure access to _lastWriter */
+         mutable Lock           _writerLock; /**< Lock internally the object for secure access to _lastWriter */
          CommutationDO         *_commDO; /**< Will be successor of all commutation tasks using this object untill a new reader/writer appears */
          bool                   _hold; /**< Cannot be erased since it is in use */
+         Atomic<unsigned int>   _references; /**< References held on the object, see retain() */
       public:
 
         /*! \brief TrackableObject default constructor
          *
          *  Creates a TrackableObject with the given address associated.
          */
-         TrackableObject ()
-            : _lastWriter ( NULL ), _versionReaders(), _readersLock(), _writerLock(), _commDO(NULL), _hold(false) {}
+         TrackableObject ();
 
         /*! \brief TrackableObject copy constructor
          *
          *  \param obj another TrackableObject
          */
-         TrackableObject ( const TrackableObject &obj ) 
-            :   _lastWriter ( obj._lastWriter ), _versionReaders(), _readersLock(), _writerLock(), _commDO(NULL), _hold(false) {}
+         TrackableObject ( const TrackableObject &obj );
 
         /*! \brief TrackableObject destructor
          */
-         ~TrackableObject () {}
+         ~TrackableObject ();
 
         /*! \brief TrackableObject assignment operator, can be self-assigned.
          *
@@ -123,6 +122,12 @@ namespace nanos {
          */
          Lock& getReadersLock();
 
+        /*! \brief Returns the writer lock
+         *
+         *  While it is held, the last writer cannot be deleted, so it cannot finish either.
+         */
+         Lock& getWriterLock() const;
+
         /*! \brief Returns the commutationDO if it exists
          */
          CommutationDO* getCommDO() const;
@@ -147,6 +152,19 @@ namespace nanos {
         /*! \brief Returns if the region has no information
          */
          bool isEmpty ( );
+
+        /*! \brief Adds a reference to the object
+         *
+         *  Domains that remove objects while dependence targets still point to them count
+         *  their own reference and the ones of those targets, and delete the object when
+         *  the last one is released.
+         */
+         void retain ( );
+
+        /*! \brief Releases a reference to the object
+         *  \return whether it was the last one
+         */
+         bool release ( );
    };
 
    //! \brief RegionStatus stream formatter
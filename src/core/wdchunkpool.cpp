@@ -0,0 +1,171 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "wdchunkpool.hpp"
+#include "basethread.hpp"
+#include "config.hpp"
+#include "malign.hpp"
+
+using namespace nanos;
+
+size_t WDChunkPool::_headerSize = NANOS_ALIGNED_MEMORY_OFFSET( 0, sizeof(WDChunkPool::ChunkHeader), 16 );
+__thread WDChunkPool::ThreadCache * WDChunkPool::_myCache = NULL;
+
+WDChunkPool::WDChunkPool () : _threadCacheSize( 64 ), _reservoirSize( 256 ), _lock(), _reservoir(), _caches( NULL ) {}
+
+WDChunkPool::~WDChunkPool ()
+{
+   for ( size_t c = 0; c < NUM_CLASSES; c++ ) deleteChunks( _reservoir[c]._head );
+
+   while ( _caches != NULL ) {
+      ThreadCache *cache = _caches;
+      _caches = cache->_next;
+      for ( size_t c = 0; c < NUM_CLASSES; c++ ) deleteChunks( cache->_free[c]._head );
+      deleteChunks( cache->_remoteFree );
+      deleteChunks( cache->_taken );
+      delete cache;
+   }
+}
+
+void WDChunkPool::config ( Config &cfg )
+{
+   cfg.setOptionsSection ( "Core [WD chunk pool]", "Recycling of the memory of finished tasks" );
+
+   cfg.registerConfigOption ( "wd-chunk-cache", NEW Config::UintVar( _threadCacheSize ),
+                              "Number of WD chunks of each size kept by every thread for reuse, 0 disables the pool (default = 64)" );
+   cfg.registerArgOption ( "wd-chunk-cache", "wd-chunk-cache" );
+   cfg.registerEnvOption ( "wd-chunk-cache", "NX_WD_CHUNK_CACHE" );
+
+   cfg.registerConfigOption ( "wd-chunk-reservoir", NEW Config::UintVar( _reservoirSize ),
+                              "Number of WD chunks of each size shared by all the threads (default = 256)" );
+   cfg.registerArgOption ( "wd-chunk-reservoir", "wd-chunk-reservoir" );
+}
+
+WDChunkPool::ThreadCache * WDChunkPool::createCache ()
+{
+   // External threads may finish at any time, their chunks are not recycled
+   if ( getMyThreadSafe() == NULL ) return NULL;
+
+   ThreadCache *cache = NEW ThreadCache();
+
+   LockBlock lock( _lock );
+   cache->_next = _caches;
+   _caches = cache;
+
+   return cache;
+}
+
+void WDChunkPool::refill ( ThreadCache &cache, size_t c )
+{
+   // Take back all the chunks released by other threads, once the previous ones are sorted
+   ChunkHeader *remote = cache._taken;
+   if ( remote == NULL ) {
+      remote = cache._remoteFree;
+      while ( remote != NULL && !compareAndSwap( &cache._remoteFree, remote, ( ChunkHeader * ) NULL ) ) {
+         remote = cache._remoteFree;
+      }
+   }
+
+   // Only a batch of them is sorted into the free lists, the list may be very long
+   for ( size_t sorted = 0; remote != NULL && sorted < BATCH_SIZE; sorted++ ) {
+      ChunkHeader *next = remote->_next;
+      size_t rc = remote->_sizeClass;
+      FreeList &list = cache._free[rc];
+      remote->_next = list._head;
+      list._head = remote;
+      if ( ++list._size > _threadCacheSize ) flush( cache, rc );
+      remote = next;
+   }
+   cache._taken = remote;
+
+   FreeList &list = cache._free[c];
+   if ( list._head != NULL ) return;
+
+   // Then take a batch from the reservoir
+   FreeList &reservoir = _reservoir[c];
+   if ( reservoir._head == NULL ) return;
+
+   ChunkHeader *head, *tail;
+   size_t taken = 0;
+   {
+      LockBlock lock( _lock );
+      head = tail = reservoir._head;
+      if ( head == NULL ) return;
+
+      for ( taken = 1, head->_owner = &cache; taken < BATCH_SIZE && tail->_next != NULL; taken++ ) {
+         tail = tail->_next;
+         tail->_owner = &cache;
+      }
+      reservoir._head = tail->_next;
+      reservoir._size -= taken;
+   }
+
+   tail->_next = NULL;
+   list._head = head;
+   list._size = taken;
+}
+
+void WDChunkPool::flush ( ThreadCache &cache, size_t c )
+{
+   FreeList &list = cache._free[c];
+   size_t keep = _threadCacheSize / 2;
+   size_t moved = list._size - keep;
+
+   ChunkHeader *head = list._head, *tail = head;
+   for ( size_t i = 1; i < moved; i++ ) tail = tail->_next;
+   list._head = tail->_next;
+   list._size = keep;
+   tail->_next = NULL;
+
+   // The chunks that do not fit in the reservoir are deleted out of the lock
+   ChunkHeader *excess = NULL;
+   {
+      LockBlock lock( _lock );
+      FreeList &reservoir = _reservoir[c];
+      size_t room = reservoir._size < _reservoirSize ? _reservoirSize - reservoir._size : 0;
+
+      if ( room < moved ) {
+         if ( room == 0 ) {
+            excess = head;
+            head = NULL;
+         } else {
+            moved = room;
+            for ( tail = head; room > 1; room-- ) tail = tail->_next;
+            excess = tail->_next;
+         }
+      }
+
+      if ( head != NULL ) {
+         tail->_next = reservoir._head;
+         reservoir._head = head;
+         reservoir._size += moved;
+      }
+   }
+
+   deleteChunks( excess );
+}
+
+void WDChunkPool::deleteChunks ( ChunkHeader *head )
+{
+   while ( head != NULL ) {
+      ChunkHeader *next = head->_next;
+      delete[] ( char * ) head;
+      head = next;
+   }
+}
@@ -0,0 +1,103 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_WD_CHUNK_POOL_H
+#define _NANOS_WD_CHUNK_POOL_H
+
+#include "wdchunkpool_decl.hpp"
+#include "atomic.hpp"
+#include "lock.hpp"
+
+namespace nanos {
+
+inline size_t WDChunkPool::sizeClass ( size_t size )
+{
+   return size == 0 ? 0 : ( size - 1 ) / CLASS_SIZE;
+}
+
+inline WDChunkPool::ChunkHeader * WDChunkPool::getHeader ( void *chunk )
+{
+   return ( ChunkHeader * ) ( ( char * ) chunk - _headerSize );
+}
+
+inline void * WDChunkPool::getChunk ( ChunkHeader *header )
+{
+   return ( char * ) header + _headerSize;
+}
+
+inline WDChunkPool::ChunkHeader * WDChunkPool::newChunk ( size_t size, size_t sizeClass, ThreadCache *owner )
+{
+   ChunkHeader *header = ( ChunkHeader * ) NEW char[_headerSize + size];
+   header->_owner = owner;
+   header->_next = NULL;
+   header->_sizeClass = sizeClass;
+   return header;
+}
+
+inline WDChunkPool::ThreadCache * WDChunkPool::myCache ()
+{
+   if ( _myCache == NULL ) _myCache = createCache();
+   return _myCache;
+}
+
+inline void * WDChunkPool::allocate ( size_t size )
+{
+   size_t c = sizeClass( size );
+   ThreadCache *cache = ( c < NUM_CLASSES && _threadCacheSize > 0 ) ? myCache() : NULL;
+   if ( cache == NULL ) return getChunk( newChunk( size, NUM_CLASSES, NULL ) );
+
+   FreeList &list = cache->_free[c];
+   if ( list._head == NULL ) {
+      refill( *cache, c );
+      if ( list._head == NULL ) return getChunk( newChunk( ( c + 1 ) * CLASS_SIZE, c, cache ) );
+   }
+
+   ChunkHeader *header = list._head;
+   list._head = header->_next;
+   list._size--;
+   return getChunk( header );
+}
+
+inline void WDChunkPool::deallocate ( void *chunk )
+{
+   if ( chunk == NULL ) return;
+
+   ChunkHeader *header = getHeader( chunk );
+   ThreadCache *owner = header->_owner;
+
+   if ( owner == NULL ) {
+      delete[] ( char * ) header;
+   } else if ( owner == _myCache ) {
+      FreeList &list = owner->_free[header->_sizeClass];
+      header->_next = list._head;
+      list._head = header;
+      if ( ++list._size > _threadCacheSize ) flush( *owner, header->_sizeClass );
+   } else {
+      // Only the owner takes chunks out of its remote list, and it takes all of them, so there is no ABA
+      ChunkHeader *head;
+      do {
+         head = owner->_remoteFree;
+         header->_next = head;
+      } while ( !compareAndSwap( &owner->_remoteFree, head, header ) );
+   }
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,138 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_WD_CHUNK_POOL_DECL_H
+#define _NANOS_WD_CHUNK_POOL_DECL_H
+
+#include <cstddef>
+#include "lock_decl.hpp"
+#include "config_fwd.hpp"
+#include "wdchunkpool_fwd.hpp"
+
+namespace nanos {
+
+   /*! \class WDChunkPool
+    *  \brief Recycles the memory chunks holding a WD and its data (see System::createWD)
+    *
+    *  Chunks are grouped in size classes of CLASS_SIZE bytes. Every thread keeps a free list
+    *  per class, so creating a task only needs to pop a chunk from the list of the creating
+    *  thread. A chunk always returns to the thread that allocated it: when the WD finishes in
+    *  another thread, the chunk is pushed to a lock-free remote list of the owner, which takes
+    *  the whole list back the next time one of its free lists runs dry and sorts BATCH_SIZE
+    *  chunks into its free lists on every refill. Threads keeping more
+    *  than threadCacheSize chunks of a class move half of them to a global reservoir, where
+    *  the other threads refill from before allocating new memory. The reservoir keeps at most
+    *  reservoirSize chunks of each class and the rest are deleted.
+    *
+    *  Chunks larger than the largest class, and the ones allocated by threads that are not
+    *  Nanos++ threads or with the cache disabled, are plain heap allocations.
+    */
+   class WDChunkPool
+   {
+      public:
+         enum {
+            CLASS_SIZE = 128,    /**< Granularity of the size classes, in bytes */
+            NUM_CLASSES = 32,    /**< Chunks up to NUM_CLASSES * CLASS_SIZE bytes are recycled */
+            BATCH_SIZE = 16      /**< Chunks taken at once from the reservoir or the remote list */
+         };
+
+      private:
+         struct ThreadCache;
+
+         struct ChunkHeader {
+            ThreadCache   *_owner;       /**< Cache the chunk returns to, NULL if it is not recycled */
+            ChunkHeader   *_next;        /**< Next chunk in a free list */
+            size_t         _sizeClass;   /**< Size class of the chunk */
+         };
+
+         struct FreeList {
+            ChunkHeader   *_head;
+            size_t         _size;
+
+            FreeList () : _head( NULL ), _size( 0 ) {}
+         };
+
+         struct ThreadCache {
+            FreeList                 _free[NUM_CLASSES];   /**< Free chunks of each class, only used by the owner */
+            ChunkHeader             *_remoteFree;          /**< Chunks released by other threads, see deallocate() */
+            ChunkHeader             *_taken;               /**< Remote chunks taken back but not in _free yet, only used by the owner */
+            ThreadCache             *_next;                /**< Next cache of the pool */
+
+            ThreadCache () : _remoteFree( NULL ), _taken( NULL ), _next( NULL ) {}
+         };
+
+         unsigned                    _threadCacheSize;        /**< Chunks of each class kept by every thread */
+         unsigned                    _reservoirSize;          /**< Chunks of each class kept in the reservoir */
+         Lock                        _lock;                   /**< Protects the reservoir and the list of caches */
+         FreeList                    _reservoir[NUM_CLASSES]; /**< Chunks shared by all the threads */
+         ThreadCache                *_caches;                 /**< Caches created so far */
+
+         static size_t               _headerSize;             /**< Size of ChunkHeader, keeping the chunk alignment */
+         static __thread ThreadCache *_myCache;               /**< Cache of the current thread, NULL if none yet */
+
+         /*! \brief WDChunkPool copy constructor (private)
+          */
+         WDChunkPool ( const WDChunkPool & );
+         /*! \brief WDChunkPool copy assignment operator (private)
+          */
+         const WDChunkPool & operator= ( const WDChunkPool & );
+
+         static size_t sizeClass ( size_t size );
+         static ChunkHeader * getHeader ( void *chunk );
+         static void * getChunk ( ChunkHeader *header );
+         static ChunkHeader * newChunk ( size_t size, size_t sizeClass, ThreadCache *owner );
+
+         /*! \brief Returns the cache of the current thread, creating it if needed
+          *
+          *  Returns NULL for threads that are not Nanos++ threads.
+          */
+         ThreadCache * myCache ();
+         ThreadCache * createCache ();
+
+         /*! \brief Fills the free list of class c of the cache with up to BATCH_SIZE remote chunks or, if it is still empty, from the reservoir */
+         void refill ( ThreadCache &cache, size_t c );
+         /*! \brief Moves half of the free list of class c of the cache to the reservoir */
+         void flush ( ThreadCache &cache, size_t c );
+         /*! \brief Deletes all the chunks of a list */
+         static void deleteChunks ( ChunkHeader *head );
+
+      public:
+         /*! \brief WDChunkPool default constructor
+          */
+         WDChunkPool ();
+         /*! \brief WDChunkPool destructor
+          */
+         ~WDChunkPool ();
+
+         void config ( Config &cfg );
+
+         /*! \brief Returns a chunk of at least size bytes
+          */
+         void * allocate ( size_t size );
+
+         /*! \brief Releases a chunk returned by allocate()
+          *
+          *  Objects placed in the chunk (e.g. the WD) must have been destroyed already.
+          */
+         void deallocate ( void *chunk );
+   };
+
+} // namespace nanos
+
+#endif
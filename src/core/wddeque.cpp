@@ -0,0 +1,31 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "wddeque.hpp"
+#include "config.hpp"
+
+using namespace nanos;
+
+void WDPQ::registerContainerOption ( Config &cfg, ContainerType &container )
+{
+   Config::MapVar<ContainerType> *pqContainer = NEW Config::MapVar<ContainerType>( container );
+   pqContainer->addOption( "list", SORTED_LIST ).addOption( "heap", HEAP ).addOption( "buckets", BUCKETS );
+   cfg.registerConfigOption ( "schedule-priority-queue", pqContainer, "Container used by priority queues: list (default), heap or buckets (one per priority in [0,64))" );
+   cfg.registerArgOption( "schedule-priority-queue", "schedule-priority-queue" );
+}
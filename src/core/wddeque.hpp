@@ -20,6 +20,10 @@
 #ifndef _NANOS_LIB_WDDEQUE
 #define _NANOS_LIB_WDDEQUE
 
+#include <limits>
+#include <algorithm>
+#include <new>
+
 #include "wddeque_decl.hpp"
 #include "schedule.hpp"
 #include "instrumentation.hpp"
@@ -27,18 +31,129 @@
 #include "lock.hpp"
 #include "basethread.hpp"
 #include "workdescriptor.hpp"
+#include "malign.hpp"
 
 namespace nanos {
 
-inline WDDeque::WDDeque( bool enableDeviceCounter ) : _dq(), _lock(), _nelems(0), _ndevs(),
-   _deviceCounter( enableDeviceCounter )
+/*******************
+ * WDIntrusiveList *
+ *******************/
+
+inline WDIntrusiveList::iterator WDIntrusiveList::insert ( iterator pos, WorkDescriptor *wd )
 {
-   if ( _deviceCounter ) {
-      const DeviceList &devs = sys.getSupportedDevices();
-      for ( DeviceList::const_iterator it = devs.begin(); it != devs.end(); ++it ) {
-         _ndevs.insert( std::make_pair<const Device*, Atomic<unsigned int> >( *it, 0 ) );
-      }
+   WorkDescriptor *next = pos._node;
+   WorkDescriptor *prev = next ? next->_queuePrev : _tail;
+
+   wd->_queuePrev = prev;
+   wd->_queueNext = next;
+   if ( prev ) prev->_queueNext = wd;
+   else _head = wd;
+   if ( next ) next->_queuePrev = wd;
+   else _tail = wd;
+   _size++;
+
+   return iterator( wd, this );
+}
+
+inline void WDIntrusiveList::insert ( iterator pos, WorkDescriptor **first, WorkDescriptor **last )
+{
+   for ( ; first != last; ++first ) {
+      insert( pos, *first );
+   }
+}
+
+inline void WDIntrusiveList::erase ( WorkDescriptor *wd )
+{
+   WorkDescriptor *prev = wd->_queuePrev;
+   WorkDescriptor *next = wd->_queueNext;
+
+   if ( prev ) prev->_queueNext = next;
+   else _head = next;
+   if ( next ) next->_queuePrev = prev;
+   else _tail = prev;
+   wd->_queuePrev = wd->_queueNext = NULL;
+   _size--;
+}
+
+inline WDIntrusiveList::iterator WDIntrusiveList::erase ( iterator pos )
+{
+   WorkDescriptor *next = pos._node->_queueNext;
+   erase( pos._node );
+   return iterator( next, this );
+}
+
+inline void WDIntrusiveList::splice_back ( WDIntrusiveList &list )
+{
+   if ( list.empty() ) return;
+
+   list._head->_queuePrev = _tail;
+   if ( _tail ) _tail->_queueNext = list._head;
+   else _head = list._head;
+   _tail = list._tail;
+   _size += list._size;
+
+   list._head = list._tail = NULL;
+   list._size = 0;
+}
+
+/*******************
+ * WDDeviceCounter *
+ *******************/
+
+inline WDDeviceCounter::WDDeviceCounter() : _numCounters( Device::getNumDevices() ),
+   _storage( NEW char[( _numCounters + 1 ) * sizeof(Counter)] ),
+   _counters( (Counter *) NANOS_ALIGNED_MEMORY_OFFSET( _storage, 0, NANOS_CACHELINE ) )
+{
+   for ( unsigned int i = 0; i < _numCounters; i++ ) new ( &_counters[i] ) Counter();
+}
+
+inline WDDeviceCounter::~WDDeviceCounter()
+{
+   for ( unsigned int i = 0; i < _numCounters; i++ ) _counters[i].~Counter();
+   delete[] _storage;
+}
+
+inline void WDDeviceCounter::increase ( WorkDescriptor *wd )
+{
+   for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
+      unsigned int id = wd->getDevices()[i]->getDevice()->getId();
+      if ( id < _numCounters ) ++_counters[id]._value;
+   }
+}
+
+inline void WDDeviceCounter::decrease ( WorkDescriptor *wd )
+{
+   for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
+      unsigned int id = wd->getDevices()[i]->getDevice()->getId();
+      if ( id < _numCounters ) --_counters[id]._value;
+   }
+}
+
+inline bool WDDeviceCounter::hasTasks ( BaseThread const *thread ) const
+{
+   ProcessingElement *pe = thread->runningOn();
+   if ( pe->hasActiveDevice() ) {
+      //Only check the active device
+      unsigned int id = pe->getActiveDevice()->getId();
+      return id >= _numCounters || _counters[id]._value.value() > 0;
    }
+
+   //All devices are active, so look for work in any of them
+   std::vector<const Device *> const &pe_devices = pe->getDeviceTypes();
+   for ( std::vector<const Device *>::const_iterator it = pe_devices.begin(); it != pe_devices.end(); it++ ) {
+      unsigned int id = (*it)->getId();
+      if ( id >= _numCounters || _counters[id]._value.value() > 0 ) return true;
+   }
+   return false;
+}
+
+/***********
+ * WDDeque *
+ ***********/
+
+inline WDDeque::WDDeque( bool enableDeviceCounter ) : _dq(), _lock(), _nelems(0),
+   _ndevs( enableDeviceCounter ? NEW WDDeviceCounter() : NULL )
+{
 }
 
 inline std::ostream& operator<< ( std::ostream& os, WDDeque const & obj ) {
@@ -65,26 +180,28 @@ inline size_t WDDeque::size() const
 
 inline void WDDeque::push_front ( WorkDescriptor *wd )
 {
-   wd->setMyQueue( this );
    {
       LockBlock lock( _lock );
+      // Set under the lock: removeWD relies on it to know the WD is linked here
+      wd->setMyQueue( this );
       _dq.push_front( wd );
       increaseDeviceCounter( wd );
-      int tasks = ++( sys.getSchedulerStats()._readyTasks );
-      increaseTasksInQueues(tasks);
+      ++( sys.getSchedulerStats()._readyTasks );
+      increaseTasksInQueues();
       memoryFence();
    }
 }
 
 inline void WDDeque::push_back ( WorkDescriptor *wd )
 {
-   wd->setMyQueue( this );
    {
       LockBlock lock( _lock );
+      // Set under the lock: removeWD relies on it to know the WD is linked here
+      wd->setMyQueue( this );
       _dq.push_back( wd );
       increaseDeviceCounter( wd );
-      int tasks = ++( sys.getSchedulerStats()._readyTasks );
-      increaseTasksInQueues(tasks);
+      ++( sys.getSchedulerStats()._readyTasks );
+      increaseTasksInQueues();
       memoryFence();
    }
 }
@@ -104,8 +221,8 @@ inline void WDDeque::push_front( WD** wds, size_t numElems )
       _dq.push_front( wd );
       increaseDeviceCounter( wd );
    }
-   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
-   increaseTasksInQueues(tasks,numElems);
+   sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(numElems);
 }
 
 inline void WDDeque::push_back( WD** wds, size_t numElems )
@@ -118,8 +235,8 @@ inline void WDDeque::push_back( WD** wds, size_t numElems )
       _dq.push_back( wd );
       increaseDeviceCounter( wd );
    }
-   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
-   increaseTasksInQueues(tasks,numElems);
+   sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(numElems);
 }
 
 struct NoConstraints
@@ -156,23 +273,8 @@ inline WorkDescriptor * WDDeque::popFrontWithConstraints ( BaseThread const *thr
    if ( _dq.empty() )
       return NULL;
 
-   if ( _deviceCounter ) {
-      bool has_tasks = false;
-      if ( thread->runningOn()->hasActiveDevice() ) {
-         //Only check the active device
-         has_tasks = (_ndevs[thread->runningOn()->getActiveDevice()].value() > 0);
-      } else {
-         //All devices are active, so look for work in any of them
-         std::vector<const Device *> const &pe_devices = thread->runningOn()->getDeviceTypes();
-         for ( std::vector<const Device *>::const_iterator it = pe_devices.begin();
-               it != pe_devices.end() && !has_tasks; it++ ) {
-            has_tasks = (_ndevs[ *it ].value() > 0);
-         }
-      }
-      if ( !has_tasks ) {
-         return NULL;
-      }
-   }
+   if ( _ndevs && !_ndevs->hasTasks( thread ) )
+      return NULL;
 
    {
       LockBlock lock( _lock );
@@ -188,8 +290,8 @@ inline WorkDescriptor * WDDeque::popFrontWithConstraints ( BaseThread const *thr
                if ( wd.dequeue( &found ) ) {
                    _dq.erase( it );
                    decreaseDeviceCounter( found );
-                   int tasks = --(sys.getSchedulerStats()._readyTasks);
-                   decreaseTasksInQueues(tasks);
+                   --(sys.getSchedulerStats()._readyTasks);
+                   decreaseTasksInQueues();
                }
                break;
             }
@@ -235,23 +337,8 @@ inline WorkDescriptor * WDDeque::popBackWithConstraints ( BaseThread const *thre
    if ( _dq.empty() )
       return NULL;
 
-   if ( _deviceCounter ) {
-      bool has_tasks = false;
-      if ( thread->runningOn()->hasActiveDevice() ) {
-         //Only check the active device
-         has_tasks = (_ndevs[thread->runningOn()->getActiveDevice()].value() > 0);
-      } else {
-         //All devices are active, so look for work in any of them
-         std::vector<const Device *> const &pe_devices = thread->runningOn()->getDeviceTypes();
-         for ( std::vector<const Device *>::const_iterator it = pe_devices.begin();
-               it != pe_devices.end() && !has_tasks; it++ ) {
-            has_tasks = (_ndevs[ *it ].value() > 0);
-         }
-      }
-      if ( !has_tasks ) {
-         return NULL;
-      }
-   }
+   if ( _ndevs && !_ndevs->hasTasks( thread ) )
+      return NULL;
 
    {
       LockBlock lock( _lock );
@@ -267,8 +354,8 @@ inline WorkDescriptor * WDDeque::popBackWithConstraints ( BaseThread const *thre
                if ( wd.dequeue( &found ) ) {
                   _dq.erase( ( ++rit ).base() );
                   decreaseDeviceCounter( found );
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
+                  --(sys.getSchedulerStats()._readyTasks);
+                  decreaseTasksInQueues();
                }
                break;
             }
@@ -292,70 +379,52 @@ inline bool WDDeque::removeWDWithConstraints( BaseThread *thread, WorkDescriptor
    if ( !Scheduler::checkBasicConstraints( *toRem, *thread) || !Constraints::check(*toRem, *thread) ) return false;
 
    *next = NULL;
-   WDDeque::BaseContainer::iterator it;
 
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
+      // WDs are linked in the queue set in their _myQueue, no need to look for them
       if ( !_dq.empty() && toRem->getMyQueue() == this ) {
-         for ( it = _dq.begin(); it != _dq.end(); it++ ) {
-            if ( *it == toRem ) {
-               if ( ( *it )->dequeue( next ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( *next );
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               (*next)->setMyQueue( NULL );
-               return true;
-            }
+         if ( toRem->dequeue( next ) ) {
+            _dq.erase( toRem );
+            decreaseDeviceCounter( *next );
+            --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues();
          }
+         (*next)->setMyQueue( NULL );
+         return true;
       }
    }
 
    return false;
 }
 
-inline void WDDeque::increaseTasksInQueues( int tasks, int increment )
+inline void WDDeque::increaseTasksInQueues( int increment )
 {
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
-   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) sys.getSchedulerStats().getReadyTasks() );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems += increment;
 }
 
-inline void WDDeque::decreaseTasksInQueues( int tasks, int decrement )
+inline void WDDeque::decreaseTasksInQueues( int decrement )
 {
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
-   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) sys.getSchedulerStats().getReadyTasks() );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems -= decrement;
 }
 
 inline void WDDeque::increaseDeviceCounter ( WorkDescriptor *wd )
 {
-   if ( _deviceCounter ) {
-      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
-         const Device *device = wd->getDevices()[i]->getDevice();
-         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
-         ensure( device_counter != _ndevs.end(), "Device not initialized" );
-         ++device_counter->second;
-      }
-   }
+   if ( _ndevs ) _ndevs->increase( wd );
 }
 
 inline void WDDeque::decreaseDeviceCounter ( WorkDescriptor *wd )
 {
-   if ( _deviceCounter ) {
-      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
-         const Device *device = wd->getDevices()[i]->getDevice();
-         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
-         ensure( device_counter != _ndevs.end(), "Device not initialized" );
-         --device_counter->second;
-      }
-   }
+   if ( _ndevs ) _ndevs->decrease( wd );
 }
 
 inline bool WDDeque::testDequeue()
@@ -363,11 +432,14 @@ inline bool WDDeque::testDequeue()
    if ( _dq.empty() )
       return false;
 
+   if ( _ndevs && !_ndevs->hasTasks( myThread ) )
+      return false;
+
    bool wd_avail = false;
    // Skip check if there's contention in the queue
    if ( _lock.tryAcquire() ) {
       // Auxiliary map to count successful commutative accesses
-      std::map<WD**, WD*> comm_accesses;
+      std::map<CommutativeGroup*, WD*> comm_accesses;
       // ReadyQueue iterator
       WDDeque::BaseContainer::const_iterator it;
       for ( it = _dq.begin(); it != _dq.end(); ++it ) {
@@ -389,12 +461,11 @@ inline void WDDeque::transferElemsFrom( WDDeque &dq )
    memoryFence();
    WDDeque::BaseContainer::iterator it;
 
-   while( !dq._dq.empty() )
-   {
-      _dq.push_back( dq._dq.front() );
-      dq._dq.pop_front();
+   for ( it = dq._dq.begin(); it != dq._dq.end(); it++ ) {
+      (*it)->setMyQueue( this );
    }
-   _nelems = dq._nelems;
+   _dq.splice_back( dq._dq );
+   _nelems += dq._nelems;
    dq._nelems = 0;
    memoryFence();
 }
@@ -457,7 +528,7 @@ inline void WDLFQueue::push_back( WorkDescriptor *wd )
          }
       }
    }
-   /* int tasks = */ ++( sys.getSchedulerStats()._readyTasks );
+   ++( sys.getSchedulerStats()._readyTasks );
    compareAndSwap( (void **) &_tail, (void *) tail, (void *) NANOS_ABA_COMPOSE(node,tail) );
 }
 
@@ -489,7 +560,7 @@ inline void WDLFQueue::push_back_node ( WDNode *node )
          }
       }
    }
-   /* int tasks = */ ++( sys.getSchedulerStats()._readyTasks );
+   ++( sys.getSchedulerStats()._readyTasks );
    compareAndSwap( (void **) &_tail,
                    (void *) tail,
                    (void *) NANOS_ABA_COMPOSE(node,tail) );                  // Push is already done. Try to swing _tail to the
@@ -519,8 +590,7 @@ inline WorkDescriptor * WDLFQueue::pop_front ( BaseThread *thread )
             if ( compareAndSwap( (void **) &_head,
                                  (void *) head,
                                  (void *) NANOS_ABA_COMPOSE(next,head)) ) { // Try to swing _head to next node
-              /*int tasks =*/ --(sys.getSchedulerStats()._readyTasks);
-              //decreaseTasksInQueues(tasks);
+              --(sys.getSchedulerStats()._readyTasks);
               if ( Scheduler::checkBasicConstraints( *wd, *thread) /* && Constraints::check(wd,*thread) FIXME*/ ) {
                  if ( !wd->dequeue( &swd ) ) {
                     NANOS_ABA_PTR(head)->setWD(wd);
@@ -551,114 +621,563 @@ inline bool WDLFQueue::removeWD( BaseThread *thread, WorkDescriptor *toRem, Work
    return false;
 }
 
-template <typename T>
-inline WDPriorityQueue<T>::WDPriorityQueue( bool enableDeviceCounter, bool optimise, bool reverse, PriorityValueFun getter )
-   : _dq(), _lock(), _nelems(0), _optimise( optimise ), _reverse( reverse ), _ndevs(), _deviceCounter( enableDeviceCounter ),
-     _getter( getter ), _maxPriority( 0 ), _minPriority( 0 )
+/*******************
+ * WDChaseLevDeque *
+ *******************/
+
+inline WDChaseLevDeque::CircularArray * WDChaseLevDeque::allocArray ( long size )
+{
+   char *chunk = NEW char[ sizeof( CircularArray ) + size * sizeof( WorkDescriptor * ) ];
+   CircularArray *a = ( CircularArray * ) chunk;
+   a->_size = size;
+   a->_slots = ( WorkDescriptor ** ) ( chunk + sizeof( CircularArray ) );
+   return a;
+}
+
+inline void WDChaseLevDeque::updateTasksInQueues()
 {
-   if ( _deviceCounter ) {
-      const DeviceList &devs = sys.getSupportedDevices();
-      for ( DeviceList::const_iterator it = devs.begin(); it != devs.end(); ++it ) {
-         _ndevs.insert( std::make_pair<const Device*, Atomic<unsigned int> >( *it, 0 ) );
+   NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) sys.getSchedulerStats().getReadyTasks() );
+   NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
+}
+
+inline WDChaseLevDeque::WDChaseLevDeque( long initialSize )
+   : _top( 0 ), _bottom( 0 ), _array( NULL ), _owner( NULL ), _inbox( false /* enableDeviceCounter */ ), _retired()
+{
+   long size = 16;
+   while ( size < initialSize ) size <<= 1;
+   _array = allocArray( size );
+}
+
+inline WDChaseLevDeque::~WDChaseLevDeque()
+{
+   for ( RetiredList::iterator it = _retired.begin(); it != _retired.end(); ++it ) {
+      delete[] ( char * ) *it;
+   }
+   delete[] ( char * ) _array;
+}
+
+inline WDChaseLevDeque::CircularArray * WDChaseLevDeque::grow ( CircularArray *a, long bottom, long top )
+{
+   CircularArray *na = allocArray( a->_size << 1 );
+   for ( long i = top; i < bottom; i++ ) {
+      na->put( i, a->get( i ) );
+   }
+   // Thieves may still be reading from the old buffer
+   _retired.push_back( a );
+   memoryFence();
+   _array = na;
+   return na;
+}
+
+inline void WDChaseLevDeque::pushBottom ( WorkDescriptor *wd )
+{
+   long b = _bottom.value();
+   long t = _top.value();
+   CircularArray *a = _array;
+   if ( b - t > a->_size - 1 ) a = grow( a, b, t );
+   wd->setMyQueue( this );
+   a->put( b, wd );
+   // The element must be visible before the new bottom
+   memoryFence();
+   _bottom = b + 1;
+}
+
+inline WorkDescriptor * WDChaseLevDeque::popBottom ()
+{
+   long b = _bottom.value() - 1;
+   CircularArray *a = _array;
+   _bottom = b;
+   memoryFence();
+   long t = _top.value();
+
+   if ( t > b ) {
+      // Empty deque
+      _bottom = b + 1;
+      return NULL;
+   }
+
+   WorkDescriptor *wd = a->get( b );
+   if ( t == b ) {
+      // Last element: race against thieves for it
+      if ( !_top.cswap( t, t + 1 ) ) wd = NULL;
+      _bottom = b + 1;
+   }
+   return wd;
+}
+
+inline WorkDescriptor * WDChaseLevDeque::steal ()
+{
+   long t = _top.value();
+   memoryFence();
+   long b = _bottom.value();
+
+   if ( t >= b ) return NULL;
+
+   CircularArray *a = _array;
+   WorkDescriptor *wd = a->get( t );
+   if ( !_top.cswap( t, t + 1 ) ) return NULL;
+   return wd;
+}
+
+inline WorkDescriptor * WDChaseLevDeque::claim ( BaseThread *thread, WorkDescriptor *wd, bool owner )
+{
+   WorkDescriptor *found = NULL;
+
+   if ( !Scheduler::checkBasicConstraints( *wd, *thread ) ) {
+      // Hand it over to the inbox, where the right thread will find it
+      --( sys.getSchedulerStats()._readyTasks );
+      _inbox.push_back( wd );
+      return NULL;
+   }
+
+   if ( wd->dequeue( &found ) ) {
+      wd->setMyQueue( NULL );
+      --( sys.getSchedulerStats()._readyTasks );
+      updateTasksInQueues();
+   } else {
+      // Sliced WD: the remaining part goes back to the deque
+      if ( owner ) pushBottom( wd );
+      else {
+         --( sys.getSchedulerStats()._readyTasks );
+         _inbox.push_back( wd );
       }
    }
+
+   ensure( !found || !found->isTied() || found->isTiedTo() == thread, "" );
+
+   return found;
 }
 
-template<typename T>
-inline bool WDPriorityQueue<T>::empty ( void ) const
+inline bool WDChaseLevDeque::empty ( void ) const
 {
-   return _dq.empty();
+   return _bottom.value() <= _top.value() && _inbox.empty();
 }
 
-template<typename T>
-inline size_t WDPriorityQueue<T>::size() const
+inline size_t WDChaseLevDeque::size() const
 {
-   return _nelems;
+   long n = _bottom.value() - _top.value();
+   return ( n > 0 ? (size_t) n : 0 ) + _inbox.size();
+}
+
+inline void WDChaseLevDeque::push_front ( WorkDescriptor *wd )
+{
+   if ( !isOwner() ) {
+      _inbox.push_front( wd );
+      return;
+   }
+
+   // Count it before publishing it, so that a thief never sees it uncounted
+   ++( sys.getSchedulerStats()._readyTasks );
+   updateTasksInQueues();
+   pushBottom( wd );
+}
+
+inline void WDChaseLevDeque::push_back ( WorkDescriptor *wd )
+{
+   // The top end only supports steals
+   _inbox.push_back( wd );
+}
+
+inline Lock& WDChaseLevDeque::getLock()
+{
+   return _inbox.getLock();
+}
+
+inline void WDChaseLevDeque::push_front( WD** wds, size_t numElems )
+{
+   if ( !isOwner() ) {
+      _inbox.push_front( wds, numElems );
+      return;
+   }
+
+   sys.getSchedulerStats()._readyTasks += numElems;
+   for ( size_t i = 0; i < numElems; ++i ) {
+      pushBottom( wds[i] );
+   }
+}
+
+inline void WDChaseLevDeque::push_back( WD** wds, size_t numElems )
+{
+   _inbox.push_back( wds, numElems );
+}
+
+inline WorkDescriptor * WDChaseLevDeque::pop_front ( BaseThread *thread )
+{
+   if ( !isOwner() ) return pop_back( thread );
+
+   WorkDescriptor *wd;
+   while ( ( wd = popBottom() ) != NULL ) {
+      // WDs this thread cannot run are moved to the inbox
+      WorkDescriptor *found = claim( thread, wd, true );
+      if ( found ) return found;
+   }
+
+   if ( _inbox.empty() ) return NULL;
+   return _inbox.pop_front( thread );
+}
+
+inline WorkDescriptor * WDChaseLevDeque::pop_back ( BaseThread *thread )
+{
+   WorkDescriptor *wd = steal();
+   if ( wd ) {
+      WorkDescriptor *found = claim( thread, wd, false );
+      if ( found ) return found;
+   }
+
+   if ( _inbox.empty() ) return NULL;
+   return _inbox.pop_back( thread );
+}
+
+inline bool WDChaseLevDeque::removeWD( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next )
+{
+   return _inbox.removeWD( thread, toRem, next );
+}
+
+inline bool WDChaseLevDeque::testDequeue()
+{
+   return !empty();
+}
+
+/****************
+ * WDPQ classes *
+ ****************/
+
+template <typename Constraints>
+inline bool WDPQ::ConstraintsPredicate<Constraints>::operator() ( WD &wd )
+{
+   return Scheduler::checkBasicConstraints( wd, *_thread ) && Constraints::check( wd, *_thread );
+}
+
+inline bool WDPQ::ConcurrencyPredicate::operator() ( WD &wd )
+{
+   return wd.getConcurrencyLevel( _commAccesses ) > 0;
+}
+
+template <typename T>
+inline void WDPQ::Container<T>::insert ( WD **wds, size_t numElems, bool fifo )
+{
+   if ( fifo ) {
+      for ( size_t i = 0; i < numElems; ++i ) insert( wds[i], true );
+   } else {
+      // Each lifo insertion goes before the previous one
+      for ( size_t i = numElems; i > 0; --i ) insert( wds[i-1], false );
+   }
 }
 
 template<typename T>
-inline void WDPriorityQueue<T>::insertOrdered( WorkDescriptor *wd, bool fifo )
+inline WDPQ::BaseContainer::iterator WDPQ::SortedList<T>::position( const WD *wd, bool fifo )
 {
-   // Find where to insert the wd
-   WDPQ::BaseContainer::iterator it;
-   T priority = wd->getPriority();
+   T priority = this->_getter( wd );
 
    if ( fifo ) {
       // #637: Insert at the back if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.back()->getPriority() >= wd->getPriority() ) ) ){
-         it = _dq.end();
-      }
-      else
-         it = upper_bound ( wd );
+      if ( ( _optimise ) && ( ( _dq.empty() ) || ( this->_getter( _dq.back() ) >= priority ) ) )
+         return _dq.end();
+      return upper_bound( wd );
    }
-   else {
-      // #637: Insert at the front if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.front()->getPriority() < wd->getPriority() ) ) )
-         it = _dq.begin();
-      else {
-         it = lower_bound( wd );
+
+   // #637: Insert at the front if possible
+   if ( ( _optimise ) && ( ( _dq.empty() ) || ( this->_getter( _dq.front() ) < priority ) ) )
+      return _dq.begin();
+   return lower_bound( wd );
+}
+
+template<typename T>
+inline void WDPQ::SortedList<T>::insert( WD *wd, bool fifo )
+{
+   _dq.insert( position( wd, fifo ), wd );
+}
+
+template<typename T>
+inline void WDPQ::SortedList<T>::insert( WD **wds, size_t numElems, bool fifo )
+{
+   _dq.insert( position( wds[0], fifo ), wds, wds + numElems );
+}
+
+template<typename T>
+inline WDPQ::BaseContainer::iterator WDPQ::SortedList<T>::upper_bound( const WD *wd )
+{
+   if ( this->_reverse )
+      return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( this->_getter ) );
+   return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( this->_getter ) );
+}
+
+template<typename T>
+inline WDPQ::BaseContainer::iterator WDPQ::SortedList<T>::lower_bound( const WD *wd )
+{
+   if ( this->_reverse )
+      return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( this->_getter ) );
+   return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( this->_getter ) );
+}
+
+template<typename T>
+inline WD * WDPQ::SortedList<T>::find( Predicate &pred )
+{
+   for ( BaseContainer::iterator it = _dq.begin(); it != _dq.end(); ++it ) {
+      if ( pred( **it ) ) return *it;
+   }
+   return NULL;
+}
+
+template<typename T>
+inline bool WDPQ::DAryHeap<T>::precedes( const Entry &a, const Entry &b ) const
+{
+   if ( a._priority != b._priority )
+      return this->_reverse ? a._priority < b._priority : a._priority > b._priority;
+   return a._seq < b._seq;
+}
+
+template<typename T>
+inline void WDPQ::DAryHeap<T>::place( size_t pos, const Entry &entry )
+{
+   _heap[pos] = entry;
+   entry._wd->_queueSlot = pos;
+}
+
+template<typename T>
+inline void WDPQ::DAryHeap<T>::siftUp( size_t pos, Entry entry )
+{
+   while ( pos > 0 ) {
+      size_t parent = ( pos - 1 ) / Arity;
+      if ( !precedes( entry, _heap[parent] ) ) break;
+      place( pos, _heap[parent] );
+      pos = parent;
+   }
+   place( pos, entry );
+}
+
+template<typename T>
+inline void WDPQ::DAryHeap<T>::siftDown( size_t pos, Entry entry )
+{
+   size_t n = _heap.size();
+   for ( ;; ) {
+      size_t first = pos * Arity + 1;
+      if ( first >= n ) break;
+
+      size_t best = first;
+      size_t last = std::min( first + Arity, n );
+      for ( size_t child = first + 1; child < last; ++child ) {
+         if ( precedes( _heap[child], _heap[best] ) ) best = child;
       }
+      if ( !precedes( _heap[best], entry ) ) break;
+      place( pos, _heap[best] );
+      pos = best;
    }
+   place( pos, entry );
+}
+
+template<typename T>
+inline void WDPQ::DAryHeap<T>::insert( WD *wd, bool fifo )
+{
+   Entry entry;
+   entry._priority = this->_getter( wd );
+   entry._seq = fifo ? ++_backSeq : --_frontSeq;
+   entry._wd = wd;
+
+   if ( _heap.empty() || ( this->_reverse ? entry._priority > _last : entry._priority < _last ) )
+      _last = entry._priority;
 
-   _dq.insert( it, wd );
-   // If the wd was inserted at the end, it has lower priority than any other
-   if( wd == _dq.back() )
-      _minPriority = priority;
-   // If it was inserted at the start, it has more than the rest
-   if ( wd == _dq.front() )
-      _maxPriority = priority;
+   _heap.push_back( entry );
+   siftUp( _heap.size() - 1, entry );
 }
 
 template<typename T>
-inline void WDPriorityQueue<T>::insertOrdered( WorkDescriptor ** wds, size_t numElems, bool fifo )
+inline void WDPQ::DAryHeap<T>::erase( WD *wd )
 {
-   // Find where to insert the wd
-   WDPQ::BaseContainer::iterator it;
-   WD* first = wds[0];
-   T priority = first->getPriority();
+   ensure( contains( wd ), "WD is not in this heap" );
 
-   if ( fifo ) {
-      // #637: Insert at the back if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.back()->getPriority() >= priority ) ) ){
-         it = _dq.end();
+   size_t pos = wd->_queueSlot;
+   Entry last = _heap.back();
+   _heap.pop_back();
+
+   if ( pos < _heap.size() ) {
+      if ( pos > 0 && precedes( last, _heap[( pos - 1 ) / Arity] ) ) siftUp( pos, last );
+      else siftDown( pos, last );
+   }
+}
+
+template<typename T>
+inline WD * WDPQ::DAryHeap<T>::find( Predicate &pred )
+{
+   if ( _heap.empty() ) return NULL;
+   if ( pred( *_heap[0]._wd ) ) return _heap[0]._wd;
+
+   // Visit the heap in serving order: the next candidate is always the
+   // best child of the nodes already rejected
+   IndexOrder order( *this );
+   WD *found = NULL;
+
+   _frontier.clear();
+   for ( size_t pos = 0; found == NULL; ) {
+      size_t first = pos * Arity + 1;
+      size_t last = std::min( first + Arity, _heap.size() );
+      for ( size_t child = first; child < last; ++child ) {
+         _frontier.push_back( child );
+         std::push_heap( _frontier.begin(), _frontier.end(), order );
       }
-      else
-         it = upper_bound ( first );
+      if ( _frontier.empty() ) break;
+
+      std::pop_heap( _frontier.begin(), _frontier.end(), order );
+      pos = _frontier.back();
+      _frontier.pop_back();
+      if ( pred( *_heap[pos]._wd ) ) found = _heap[pos]._wd;
    }
-   else {
-      // #637: Insert at the front if possible
-      if ( ( _optimise ) && ( ( _dq.empty() ) || ( _dq.front()->getPriority() < priority ) ) )
-         it = _dq.begin();
-      else {
-         it = lower_bound( first );
+
+   return found;
+}
+
+template<typename T>
+inline int WDPQ::Buckets<T>::firstBucket() const
+{
+   return this->_reverse ? __builtin_ctzll( _used ) : NumBuckets - 1 - __builtin_clzll( _used );
+}
+
+template<typename T>
+inline int WDPQ::Buckets<T>::lastBucket() const
+{
+   return this->_reverse ? NumBuckets - 1 - __builtin_clzll( _used ) : __builtin_ctzll( _used );
+}
+
+template<typename T>
+inline int WDPQ::Buckets<T>::nextBucket( int b ) const
+{
+   unsigned long long rest;
+   if ( this->_reverse ) {
+      rest = b + 1 < NumBuckets ? _used & ( ~0ULL << ( b + 1 ) ) : 0;
+      return rest ? __builtin_ctzll( rest ) : -1;
+   }
+   rest = _used & ( ( 1ULL << b ) - 1 );
+   return rest ? NumBuckets - 1 - __builtin_clzll( rest ) : -1;
+}
+
+template<typename T>
+inline void WDPQ::Buckets<T>::insert( WD *wd, bool fifo )
+{
+   T priority = this->_getter( wd );
+
+   if ( priority < 0 ) {
+      ( this->_reverse ? _ahead : _behind ).insert( wd, fifo );
+   } else if ( priority >= NumBuckets ) {
+      ( this->_reverse ? _behind : _ahead ).insert( wd, fifo );
+   } else {
+      int b = (int) priority;
+      if ( fifo ) _buckets[b].push_back( wd );
+      else _buckets[b].push_front( wd );
+      wd->_queueSlot = b;
+      _used |= 1ULL << b;
+   }
+   _size++;
+}
+
+template<typename T>
+inline void WDPQ::Buckets<T>::erase( WD *wd )
+{
+   // Do not look at its priority, it may have changed (see reorderWD)
+   if ( _ahead.contains( wd ) ) {
+      _ahead.erase( wd );
+   } else if ( _behind.contains( wd ) ) {
+      _behind.erase( wd );
+   } else {
+      int b = wd->_queueSlot;
+      _buckets[b].erase( wd );
+      if ( _buckets[b].empty() ) _used &= ~( 1ULL << b );
+   }
+   _size--;
+}
+
+template<typename T>
+inline WD * WDPQ::Buckets<T>::front() const
+{
+   if ( !_ahead.empty() ) return _ahead.front();
+   if ( _used ) return _buckets[firstBucket()].front();
+   return _behind.front();
+}
+
+template<typename T>
+inline T WDPQ::Buckets<T>::lastPriority() const
+{
+   if ( !_behind.empty() ) return _behind.lastPriority();
+   if ( _used ) return this->_getter( _buckets[lastBucket()].back() );
+   return _ahead.lastPriority();
+}
+
+template<typename T>
+inline WD * WDPQ::Buckets<T>::find( Predicate &pred )
+{
+   WD *found = _ahead.find( pred );
+
+   for ( int b = _used ? firstBucket() : -1; b >= 0 && found == NULL; b = nextBucket( b ) ) {
+      for ( BaseContainer::iterator it = _buckets[b].begin(); it != _buckets[b].end(); ++it ) {
+         if ( pred( **it ) ) {
+            found = *it;
+            break;
+         }
       }
    }
 
-   _dq.insert( it, wds, wds + numElems );
-   // If the wd was inserted at the end, it has lower priority than any other
-   if( first == _dq.back() )
-      _minPriority = priority;
-   // If it was inserted at the start, it has more than the rest
-   if ( first == _dq.front() )
-      _maxPriority = priority;
+   if ( found == NULL ) found = _behind.find( pred );
+   return found;
+}
+
+/*******************
+ * WDPriorityQueue *
+ *******************/
+
+template <typename T>
+inline WDPriorityQueue<T>::WDPriorityQueue( bool enableDeviceCounter, bool optimise, bool reverse, PriorityValueFun getter )
+   : _container( NULL ), _lock(), _nelems(0), _optimise( optimise ), _reverse( reverse ),
+     _ndevs( enableDeviceCounter ? NEW WDDeviceCounter() : NULL ),
+     _getter( getter ), _maxPriority( 0 ), _minPriority( 0 )
+{
+   _container = NEW WDPQ::SortedList<T>( _optimise, _reverse, _getter );
+}
+
+template <typename T>
+inline void WDPriorityQueue<T>::setContainer( WDPQ::ContainerType container )
+{
+   LockBlock lock( _lock );
+
+   fatal_cond( !_container->empty(), "Cannot change the container of a non empty priority queue" );
+
+   if ( container == WDPQ::BUCKETS && !std::numeric_limits<T>::is_integer ) container = WDPQ::HEAP;
+
+   delete _container;
+   switch ( container ) {
+      case WDPQ::HEAP:
+         _container = NEW WDPQ::DAryHeap<T>( _reverse, _getter );
+         break;
+      case WDPQ::BUCKETS:
+         _container = NEW WDPQ::Buckets<T>( _reverse, _getter );
+         break;
+      default:
+         _container = NEW WDPQ::SortedList<T>( _optimise, _reverse, _getter );
+         break;
+   }
+}
+
+template<typename T>
+inline bool WDPriorityQueue<T>::empty ( void ) const
+{
+   return _container->empty();
 }
 
 template<typename T>
-inline WDPQ::BaseContainer::iterator
-WDPriorityQueue<T>::upper_bound( const WD *wd )
+inline size_t WDPriorityQueue<T>::size() const
 {
-   if ( _reverse )
-      return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( _getter ) );
-   return std::upper_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( _getter ) );
+   return _nelems;
 }
 
 template<typename T>
-inline WDPQ::BaseContainer::iterator
-WDPriorityQueue<T>::lower_bound( const WD *wd )
+inline void WDPriorityQueue<T>::updatePriorities()
 {
-   if ( _reverse )
-      return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparisonReverse<T>( _getter ) );
-   return std::lower_bound( _dq.begin(), _dq.end(), wd, WDPriorityComparison<T>( _getter ) );
+   if ( _container->empty() ) {
+      _maxPriority = 0;
+      _minPriority = 0;
+   } else {
+      _maxPriority = _getter( _container->front() );
+      _minPriority = _container->lastPriority();
+   }
 }
 
 /*!
@@ -668,13 +1187,14 @@ WDPriorityQueue<T>::lower_bound( const WD *wd )
 template<typename T>
 inline void WDPriorityQueue<T>::push_back ( WorkDescriptor *wd )
 {
-   wd->setMyQueue( this );
    {
       LockBlock lock( _lock );
-      insertOrdered( wd, true );
+      wd->setMyQueue( this );
+      _container->insert( wd, true );
+      updatePriorities();
       increaseDeviceCounter( wd );
-      int tasks = ++( sys.getSchedulerStats()._readyTasks );
-      increaseTasksInQueues(tasks);
+      ++( sys.getSchedulerStats()._readyTasks );
+      increaseTasksInQueues();
       memoryFence();
    }
 }
@@ -686,13 +1206,14 @@ inline void WDPriorityQueue<T>::push_back ( WorkDescriptor *wd )
 template<typename T>
 inline void WDPriorityQueue<T>::push_front ( WorkDescriptor *wd )
 {
-   wd->setMyQueue( this );
    {
       LockBlock lock( _lock );
-      insertOrdered( wd, false );
+      wd->setMyQueue( this );
+      _container->insert( wd, false );
+      updatePriorities();
       increaseDeviceCounter( wd );
-      int tasks = ++( sys.getSchedulerStats()._readyTasks );
-      increaseTasksInQueues(tasks);
+      ++( sys.getSchedulerStats()._readyTasks );
+      increaseTasksInQueues();
       memoryFence();
    }
 }
@@ -732,12 +1253,13 @@ inline void WDPriorityQueue<T>::push_front( WD** wds, size_t numElems )
    {
       WD* wd = wds[i];
       wd->setMyQueue( this );
-      insertOrdered( wd, false );
+      _container->insert( wd, false );
       increaseDeviceCounter( wd );
    }
-   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
-   increaseTasksInQueues(tasks,numElems);
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size" );
+   updatePriorities();
+   sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(numElems);
+   fatal_cond( _container->size() != _nelems, "List size does not match queue size" );
 }
 
 template<typename T>
@@ -760,9 +1282,10 @@ inline void WDPriorityQueue<T>::push_back( WD** wds, size_t numElems )
       {
          WD* wd = wds[i];
          wd->setMyQueue( this );
-         insertOrdered( wd, true );
+         _container->insert( wd, true );
          increaseDeviceCounter( wd );
       }
+      updatePriorities();
    /*}
    // Otherwise, insert in the same position
    else
@@ -776,9 +1299,9 @@ inline void WDPriorityQueue<T>::push_back( WD** wds, size_t numElems )
       increaseDeviceCounter( wd );
 
    }*/
-   int tasks = sys.getSchedulerStats()._readyTasks += numElems;
-   increaseTasksInQueues(tasks,numElems);
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size" );
+   sys.getSchedulerStats()._readyTasks += numElems;
+   increaseTasksInQueues(numElems);
+   fatal_cond( _container->size() != _nelems, "List size does not match queue size" );
 }
 
 /*!
@@ -797,37 +1320,24 @@ inline WorkDescriptor * WDPriorityQueue<T>::popFrontWithConstraints ( BaseThread
 {
    WorkDescriptor *found = NULL;
 
-   if ( _dq.empty() )
+   if ( _container->empty() )
       return NULL;
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
-      if ( !_dq.empty() ) {
-         WDPQ::BaseContainer::iterator it;
-         for ( it = _dq.begin(); it != _dq.end() ; ++it ) {
-            WD &wd = *(WD *)*it;
-            if ( Scheduler::checkBasicConstraints( wd, *thread) && Constraints::check(wd,*thread)) {
-               if ( wd.dequeue( &found ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( found );
-                  // Update max and min
-                  if ( _dq.empty() ){
-                     _maxPriority = 0;
-                     _minPriority = 0;
-                  }
-                  // Note that, due to constraints, we might not have extracted
-                  // the first element of the queue, but the last one.
-                  else{
-                     _maxPriority = _dq.front()->getPriority();
-                     _minPriority = _dq.back()->getPriority();
-                  }
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               break;
-            }
+      if ( !_container->empty() ) {
+         // Note that, due to constraints, we might not extract the first
+         // element of the queue
+         WDPQ::ConstraintsPredicate<Constraints> canRun( thread );
+         WD *wd = _container->find( canRun );
+         if ( wd != NULL && wd->dequeue( &found ) ) {
+            _container->erase( wd );
+            decreaseDeviceCounter( found );
+            updatePriorities();
+            --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues();
          }
       }
 
@@ -847,38 +1357,24 @@ inline WorkDescriptor * WDPriorityQueue<T>::popBackWithConstraints ( BaseThread
    // FIXME: at the moment this method is implemented as pop_front, change behaviour!!!
    WorkDescriptor *found = NULL;
 
-   if ( _dq.empty() )
+   if ( _container->empty() )
       return NULL;
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
-      if ( !_dq.empty() ) {
-         WDPQ::BaseContainer::iterator it;
-
-         for ( it = _dq.begin(); it != _dq.end() ; ++it ) {
-            WD &wd = *(WD *)*it;
-            if ( Scheduler::checkBasicConstraints( wd, *thread) && Constraints::check(wd,*thread)) {
-               if ( wd.dequeue( &found ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( found );
-                  // Update max and min
-                  if ( _dq.empty() ){
-                     _maxPriority = 0;
-                     _minPriority = 0;
-                  }
-                  // Note that, due to constraints, we might not have extracted
-                  // the last element of the queue, but the first one.
-                  else{
-                     _maxPriority = _dq.front()->getPriority();
-                     _minPriority = _dq.back()->getPriority();
-                  }
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               break;
-            }
+      if ( !_container->empty() ) {
+         // Note that, due to constraints, we might not extract the first
+         // element of the queue
+         WDPQ::ConstraintsPredicate<Constraints> canRun( thread );
+         WD *wd = _container->find( canRun );
+         if ( wd != NULL && wd->dequeue( &found ) ) {
+            _container->erase( wd );
+            decreaseDeviceCounter( found );
+            updatePriorities();
+            --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues();
          }
       }
 
@@ -895,31 +1391,27 @@ template <typename T>
 template <typename Constraints>
 inline bool WDPriorityQueue<T>::removeWDWithConstraints( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next )
 {
-   if ( _dq.empty() ) return false;
+   if ( _container->empty() ) return false;
 
    if ( !Scheduler::checkBasicConstraints( *toRem, *thread) || !Constraints::check(*toRem, *thread) ) return false;
 
    *next = NULL;
-   WDPQ::BaseContainer::iterator it;
 
    {
       LockBlock lock( _lock );
 
       memoryFence();
 
-      if ( !_dq.empty() && toRem->getMyQueue() == this ) {
-         for ( it = _dq.begin(); it != _dq.end(); it++ ) {
-            if ( *it == toRem ) {
-               if ( ( *it )->dequeue( next ) ) {
-                  _dq.erase( it );
-                  decreaseDeviceCounter( *next );
-                  int tasks = --(sys.getSchedulerStats()._readyTasks);
-                  decreaseTasksInQueues(tasks);
-               }
-               (*next)->setMyQueue( NULL );
-               return true;
-            }
+      if ( !_container->empty() && toRem->getMyQueue() == this ) {
+         if ( toRem->dequeue( next ) ) {
+            _container->erase( toRem );
+            decreaseDeviceCounter( *next );
+            updatePriorities();
+            --(sys.getSchedulerStats()._readyTasks);
+            decreaseTasksInQueues();
          }
+         (*next)->setMyQueue( NULL );
+         return true;
       }
    }
 
@@ -931,18 +1423,15 @@ inline bool WDPriorityQueue<T>::reorderWD( WorkDescriptor *wd )
 {
    LockBlock l( _lock );
 
-   // Find the WD
-   WDPQ::BaseContainer::iterator it =
-      std::find( _dq.begin(), _dq.end(), wd );
-
-   // If the WD was not found, return false
-   if( it == _dq.end() ){
+   // If the WD is not linked in this queue, return false
+   if( wd->getMyQueue() != this ){
       return false;
    }
 
    // Otherwise, reorder it
-   _dq.erase( it );
-   insertOrdered( wd );
+   _container->erase( wd );
+   _container->insert( wd, true );
+   updatePriorities();
 
    return true;
 }
@@ -960,71 +1449,53 @@ inline WD::PriorityType WDPriorityQueue<T>::minPriority() const
 }
 
 template<typename T>
-inline void WDPriorityQueue<T>::increaseTasksInQueues( int tasks, int increment )
+inline void WDPriorityQueue<T>::increaseTasksInQueues( int increment )
 {
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
-   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) sys.getSchedulerStats().getReadyTasks() );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems += increment;
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size (increase)" );
+   fatal_cond( _container->size() != _nelems, "List size does not match queue size (increase)" );
 }
 
 template<typename T>
-inline void WDPriorityQueue<T>::decreaseTasksInQueues( int tasks, int decrement )
+inline void WDPriorityQueue<T>::decreaseTasksInQueues( int decrement )
 {
    NANOS_INSTRUMENT(static nanos_event_key_t key = sys.getInstrumentation()->getInstrumentationDictionary()->getEventKey("num-ready");)
-   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) tasks );
+   NANOS_INSTRUMENT( nanos_event_value_t nb =  (nanos_event_value_t ) sys.getSchedulerStats().getReadyTasks() );
    NANOS_INSTRUMENT(sys.getInstrumentation()->raisePointEvents(1, &key, &nb );)
    _nelems -= decrement;
-   fatal_cond( _dq.size() != _nelems, "List size does not match queue size (decrease)" );
+   fatal_cond( _container->size() != _nelems, "List size does not match queue size (decrease)" );
 }
 
 template<typename T>
 inline void WDPriorityQueue<T>::increaseDeviceCounter ( WorkDescriptor *wd )
 {
-   if ( _deviceCounter ) {
-      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
-         const Device *device = wd->getDevices()[i]->getDevice();
-         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
-         ensure( device_counter != _ndevs.end(), "Device not initialized" );
-         ++device_counter->second;
-      }
-   }
+   if ( _ndevs ) _ndevs->increase( wd );
 }
 
 template<typename T>
 inline void WDPriorityQueue<T>::decreaseDeviceCounter ( WorkDescriptor *wd )
 {
-   if ( _deviceCounter ) {
-      for ( unsigned int i = 0; i < wd->getNumDevices(); i++ ) {
-         const Device *device = wd->getDevices()[i]->getDevice();
-         WDDeviceCounter::iterator device_counter = _ndevs.find( device );
-         ensure( device_counter != _ndevs.end(), "Device not initialized" );
-         --device_counter->second;
-      }
-   }
+   if ( _ndevs ) _ndevs->decrease( wd );
 }
 
 template<typename T>
 inline bool WDPriorityQueue<T>::testDequeue()
 {
-   if ( _dq.empty() )
+   if ( _container->empty() )
+      return false;
+
+   if ( _ndevs && !_ndevs->hasTasks( myThread ) )
       return false;
 
    bool wd_avail = false;
    // Skip check if there's contention in the queue
    if ( _lock.tryAcquire() ) {
       // Auxiliary map to count successful commutative accesses
-      std::map<WD**, WD*> comm_accesses;
-      // ReadyQueue iterator
-      WDPQ::BaseContainer::const_iterator it;
-      for ( it = _dq.begin(); it != _dq.end(); ++it ) {
-         const WD &wd = *(WD *)*it;
-         if ( wd.getConcurrencyLevel( comm_accesses ) > 0 ) {
-            wd_avail = true;
-            break;
-         }
-      }
+      std::map<CommutativeGroup*, WD*> comm_accesses;
+      WDPQ::ConcurrencyPredicate available( comm_accesses );
+      wd_avail = _container->find( available ) != NULL;
       _lock.release();
    }
 
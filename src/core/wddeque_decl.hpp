@@ -20,15 +20,19 @@
 #ifndef _NANOS_LIB_WDDEQUE_DECL_H
 #define _NANOS_LIB_WDDEQUE_DECL_H
 
-#include <list>
+#include <vector>
+#include <iterator>
+#include <cstddef>
 #include <functional>
 #include <map>
 
 #include "debug.hpp"
 #include "atomic_decl.hpp"
 #include "lock_decl.hpp"
+#include "allocator_decl.hpp"
 
 #include "basethread_fwd.hpp"
+#include "config_fwd.hpp"
 
 #include "workdescriptor_decl.hpp"
 
@@ -106,17 +110,152 @@ namespace nanos {
          virtual bool testDequeue() { return !empty(); }
    };
 
+   /*! \brief Intrusive doubly-linked list of WorkDescriptors
+    *
+    *  Links WDs through the hooks embedded in WorkDescriptor (_queuePrev,
+    *  _queueNext) instead of allocating a node per element, so inserting and
+    *  removing never touches the allocator. A WD can only be linked in one
+    *  list at a time: the one of the WDPool set in its _myQueue.
+    *
+    *  The interface mimics the subset of std::list used by the ready queues.
+    */
+   class WDIntrusiveList
+   {
+      public:
+         class iterator
+         {
+            private:
+               friend class WDIntrusiveList;
+               WorkDescriptor          *_node;   /**< Current WD, NULL for end() */
+               const WDIntrusiveList   *_list;   /**< Owner list, needed to decrement end() */
+            public:
+               typedef std::bidirectional_iterator_tag   iterator_category;
+               typedef WorkDescriptor *                  value_type;
+               typedef ptrdiff_t                         difference_type;
+               typedef WorkDescriptor * const *          pointer;
+               typedef WorkDescriptor *                  reference;
+
+               iterator () : _node( NULL ), _list( NULL ) {}
+               iterator ( WorkDescriptor *node, const WDIntrusiveList *list ) : _node( node ), _list( list ) {}
+
+               WorkDescriptor * operator* () const { return _node; }
+
+               iterator & operator++ () { _node = _node->_queueNext; return *this; }
+               iterator operator++ ( int ) { iterator tmp( *this ); ++( *this ); return tmp; }
+               iterator & operator-- () { _node = _node ? _node->_queuePrev : _list->_tail; return *this; }
+               iterator operator-- ( int ) { iterator tmp( *this ); --( *this ); return tmp; }
+
+               bool operator== ( const iterator &it ) const { return _node == it._node; }
+               bool operator!= ( const iterator &it ) const { return _node != it._node; }
+         };
+         typedef iterator                          const_iterator;
+         typedef std::reverse_iterator<iterator>   reverse_iterator;
+         typedef reverse_iterator                  const_reverse_iterator;
+
+      private:
+         WorkDescriptor   *_head;    /**< First WD */
+         WorkDescriptor   *_tail;    /**< Last WD */
+         size_t            _size;    /**< Number of linked WDs */
+
+         /*! \brief WDIntrusiveList copy constructor (private)
+          */
+         WDIntrusiveList ( const WDIntrusiveList & );
+         /*! \brief WDIntrusiveList copy assignment operator (private)
+          */
+         const WDIntrusiveList & operator= ( const WDIntrusiveList & );
+
+      public:
+         /*! \brief WDIntrusiveList default constructor
+          */
+         WDIntrusiveList () : _head( NULL ), _tail( NULL ), _size( 0 ) {}
+         /*! \brief WDIntrusiveList destructor
+          */
+         ~WDIntrusiveList () {}
+
+         bool empty () const { return _head == NULL; }
+         size_t size () const { return _size; }
+
+         WorkDescriptor * front () const { return _head; }
+         WorkDescriptor * back () const { return _tail; }
+
+         iterator begin () const { return iterator( _head, this ); }
+         iterator end () const { return iterator( NULL, this ); }
+         reverse_iterator rbegin () const { return reverse_iterator( end() ); }
+         reverse_iterator rend () const { return reverse_iterator( begin() ); }
+
+         /*! \brief Links wd before pos and returns an iterator to it */
+         iterator insert ( iterator pos, WorkDescriptor *wd );
+         /*! \brief Links the WDs in [first, last) before pos, keeping their order */
+         void insert ( iterator pos, WorkDescriptor **first, WorkDescriptor **last );
+         /*! \brief Unlinks the WD at pos and returns an iterator to the next one */
+         iterator erase ( iterator pos );
+         /*! \brief Unlinks wd, which must be linked in this list */
+         void erase ( WorkDescriptor *wd );
+
+         void push_front ( WorkDescriptor *wd ) { insert( begin(), wd ); }
+         void push_back ( WorkDescriptor *wd ) { insert( end(), wd ); }
+         void pop_front () { erase( _head ); }
+         void pop_back () { erase( _tail ); }
+
+         /*! \brief Moves all the WDs of list at the end of this one */
+         void splice_back ( WDIntrusiveList &list );
+   };
+
+   /*! \brief Number of WDs in a queue that can run on each Device
+    *
+    *  Counters are indexed by Device::getId(), each one in a cache line of its
+    *  own. Queues update them with their lock held and read them without it,
+    *  as a hint of whether a thread may find work in the queue.
+    *
+    *  There is a counter for each Device that existed when the queue was
+    *  created. WDs of devices created later are not counted, and threads
+    *  running on them are always told to look into the queue.
+    */
+   class WDDeviceCounter
+   {
+      private:
+         struct Counter {
+            Atomic<unsigned int> _value;
+            char                 _pad[NANOS_CACHELINE - sizeof(Atomic<unsigned int>)];
+
+            Counter () : _value( 0 ) {}
+         };
+
+         unsigned int   _numCounters;   /**< Devices with a counter, see Device::getNumDevices() */
+         char          *_storage;       /**< Memory holding the counters */
+         Counter       *_counters;      /**< Counters, at the first cache line boundary of _storage */
+
+         /*! \brief WDDeviceCounter copy constructor (private)
+          */
+         WDDeviceCounter ( const WDDeviceCounter & );
+         /*! \brief WDDeviceCounter copy assignment operator (private)
+          */
+         const WDDeviceCounter & operator= ( const WDDeviceCounter & );
+      public:
+         /*! \brief WDDeviceCounter default constructor
+          */
+         WDDeviceCounter ();
+         /*! \brief WDDeviceCounter destructor
+          */
+         ~WDDeviceCounter ();
+
+         void increase ( WorkDescriptor *wd );
+         void decrease ( WorkDescriptor *wd );
+
+         /*! \brief Returns whether there are WDs for any of the devices \a thread can run now
+          */
+         bool hasTasks ( BaseThread const *thread ) const;
+   };
+
    class WDDeque : public WDPool
    {
       private:
-         typedef std::list<WorkDescriptor *> BaseContainer;
-         typedef std::map< const Device *, Atomic<unsigned int> > WDDeviceCounter;
+         typedef WDIntrusiveList BaseContainer;
 
          BaseContainer     _dq;
          Lock              _lock;
          size_t            _nelems;
-         WDDeviceCounter   _ndevs;
-         bool              _deviceCounter;
+         WDDeviceCounter  *_ndevs;          /**< Per device WD counters, NULL if disabled */
 
 
       private:
@@ -127,8 +266,8 @@ namespace nanos {
           */
          const WDDeque & operator= ( const WDDeque & );
 
-         void increaseTasksInQueues( int tasks, int increment = 1 );
-         void decreaseTasksInQueues( int tasks, int decrement = 1 );
+         void increaseTasksInQueues( int increment = 1 );
+         void decreaseTasksInQueues( int decrement = 1 );
 
          void increaseDeviceCounter ( WorkDescriptor *wd );
          void decreaseDeviceCounter ( WorkDescriptor *wd );
@@ -139,7 +278,7 @@ namespace nanos {
          WDDeque( bool enableDeviceCounter = true );
          /*! \brief WDDeque destructor
           */
-         ~WDDeque() {}
+         ~WDDeque() { delete _ndevs; }
 
          friend std::ostream& operator<< ( std::ostream& os, WDDeque const & obj );
 
@@ -246,6 +385,107 @@ namespace nanos {
 
    };
 
+   /*! \brief Chase-Lev work-stealing deque
+    *
+    *  Dynamic circular work-stealing deque (Chase & Lev, SPAA'05, with the
+    *  fences of Le et al., PPoPP'13). The owner thread pushes and pops at
+    *  the bottom (front) without taking any lock; other threads steal from
+    *  the top (back) with a single compare-and-swap. The circular buffer
+    *  doubles when full; retired buffers are kept until the deque is
+    *  destroyed, so a thief never reads from freed memory.
+    *
+    *  Operations that the algorithm does not allow (insertions by a thread
+    *  other than the owner, insertions at the top, WDs that a thread pops
+    *  but cannot run) go through a small locked WDDeque, the inbox, that
+    *  both the owner and the thieves also check.
+    *
+    *  The owner is the thread set through setOwner(). Until it is set,
+    *  every operation goes through the inbox.
+    */
+   class WDChaseLevDeque : public WDPool
+   {
+      private:
+         struct CircularArray
+         {
+            long              _size;   /**< Number of slots, always a power of two */
+            WorkDescriptor  **_slots;  /**< Slots (follows the header in the same chunk) */
+
+            WorkDescriptor * get ( long i ) const { return _slots[ i & ( _size - 1 ) ]; }
+            void put ( long i, WorkDescriptor *wd ) { _slots[ i & ( _size - 1 ) ] = wd; }
+         };
+         typedef std::vector<CircularArray *> RetiredList;
+
+         Atomic<long>               _top;           /**< Next element to steal */
+         char                       _pad0[NANOS_CACHELINE - sizeof(Atomic<long>)];
+         Atomic<long>               _bottom;        /**< Next free slot for the owner */
+         CircularArray * volatile   _array;         /**< Current buffer */
+         BaseThread                *_owner;         /**< Thread allowed to push/pop at the bottom */
+         char                       _pad1[NANOS_CACHELINE];
+         WDDeque                    _inbox;         /**< Locked fallback for non-owner insertions */
+         RetiredList                _retired;       /**< Old buffers, released at destruction */
+
+      private:
+         /*! \brief WDChaseLevDeque copy constructor (private)
+          */
+         WDChaseLevDeque ( const WDChaseLevDeque & );
+         /*! \brief WDChaseLevDeque copy assignment operator (private)
+          */
+         const WDChaseLevDeque & operator= ( const WDChaseLevDeque & );
+
+         static CircularArray * allocArray ( long size );
+         /*! \brief Doubles the buffer holding elements [top, bottom) (owner only) */
+         CircularArray * grow ( CircularArray *a, long bottom, long top );
+
+         /*! \brief Pushes a WD at the bottom (owner only) */
+         void pushBottom ( WorkDescriptor *wd );
+         /*! \brief Pops a WD from the bottom (owner only) */
+         WorkDescriptor * popBottom ();
+         /*! \brief Steals a WD from the top (any thread) */
+         WorkDescriptor * steal ();
+
+         /*! \brief Checks the constraints of a WD just taken out of the deque and
+          *  dequeues it, giving it back to the deque if it cannot run in thread
+          */
+         WorkDescriptor * claim ( BaseThread *thread, WorkDescriptor *wd, bool owner );
+
+         bool isOwner () const { return _owner != NULL && _owner == myThread; }
+
+         void updateTasksInQueues();
+
+      public:
+         /*! \brief WDChaseLevDeque default constructor
+          *  \param initialSize Initial number of slots (rounded up to a power of two)
+          */
+         WDChaseLevDeque( long initialSize = 256 );
+         /*! \brief WDChaseLevDeque destructor
+          */
+         ~WDChaseLevDeque();
+
+         /*! \brief Sets the thread allowed to operate on the bottom of the deque */
+         void setOwner ( BaseThread *owner ) { _owner = owner; }
+         BaseThread * getOwner () const { return _owner; }
+
+         bool empty ( void ) const;
+         size_t size() const;
+
+         void push_front ( WorkDescriptor *wd );
+         void push_back( WorkDescriptor *wd );
+
+         Lock& getLock();
+         void push_front( WD** wds, size_t numElems );
+         void push_back( WD** wds, size_t numElems );
+
+         /*! \brief Owner: pops the most recently pushed WD. Others: steals */
+         WorkDescriptor * pop_front ( BaseThread *thread );
+         /*! \brief Steals the oldest WD */
+         WorkDescriptor * pop_back ( BaseThread *thread );
+
+         /*! \brief Only WDs held in the inbox can be removed */
+         bool removeWD( BaseThread *thread, WorkDescriptor *toRem, WorkDescriptor **next );
+
+         bool testDequeue();
+   };
+
    /*! \brief Class used to compare WDs by priority.
     *  \see WDPriorityQueue::push
     */
@@ -295,7 +535,228 @@ namespace nanos {
     */
    namespace WDPQ
    {
-       typedef std::list<WorkDescriptor *> BaseContainer;
+      typedef WDIntrusiveList BaseContainer;
+
+      /*! \brief Containers that can back a WDPriorityQueue
+       */
+      enum ContainerType {
+         SORTED_LIST,   /**< Sorted list, O(n) insertion (default) */
+         HEAP,          /**< d-ary heap, O(log n) insertion and removal */
+         BUCKETS        /**< One FIFO per small integer priority, O(1) insertion */
+      };
+
+      /*! \brief Registers the schedule-priority-queue option of a scheduler plugin,
+       *  which chooses the container of its priority queues
+       */
+      void registerContainerOption ( Config &cfg, ContainerType &container );
+
+      /*! \brief Condition a WD must fulfil to be found in a Container
+       */
+      class Predicate
+      {
+         public:
+            virtual ~Predicate () {}
+            virtual bool operator() ( WD &wd ) = 0;
+      };
+
+      /*! \brief Predicate accepting WDs the thread can run
+       */
+      template <typename Constraints>
+      class ConstraintsPredicate : public Predicate
+      {
+         private:
+            BaseThread *_thread;
+         public:
+            ConstraintsPredicate ( BaseThread *thread ) : _thread( thread ) {}
+            bool operator() ( WD &wd );
+      };
+
+      /*! \brief Predicate accepting WDs that can run concurrently (see WD::getConcurrencyLevel)
+       */
+      class ConcurrencyPredicate : public Predicate
+      {
+         private:
+            std::map<CommutativeGroup*, WD*> &_commAccesses;
+         public:
+            ConcurrencyPredicate ( std::map<CommutativeGroup*, WD*> &commAccesses ) : _commAccesses( commAccesses ) {}
+            bool operator() ( WD &wd );
+      };
+
+      /*! \brief Ordered WD container used by WDPriorityQueue
+       *
+       *  WDs are kept in descending priority order (ascending if reverse is
+       *  set). WDs with the same priority are served in FIFO order for those
+       *  inserted with fifo set, and before them in LIFO order otherwise.
+       *  Containers are not thread-safe: WDPriorityQueue calls them with its
+       *  lock held.
+       */
+      template <typename T>
+      class Container
+      {
+         public:
+            typedef std::const_mem_fun_t<T, WD> PriorityValueFun;
+
+         protected:
+            bool              _reverse;  /**< Serve lower priorities first */
+            PriorityValueFun  _getter;   /**< Gets the priority of a WD */
+
+         public:
+            Container ( bool reverse, PriorityValueFun getter ) : _reverse( reverse ), _getter( getter ) {}
+            virtual ~Container () {}
+
+            virtual bool empty () const = 0;
+            virtual size_t size () const = 0;
+
+            /*! \brief Inserts wd after (fifo) or before (!fifo) the WDs with its same priority */
+            virtual void insert ( WD *wd, bool fifo ) = 0;
+            /*! \brief Inserts numElems WDs keeping their relative order */
+            virtual void insert ( WD **wds, size_t numElems, bool fifo );
+            /*! \brief Removes wd, which must be in the container. Its priority may have changed since it was inserted */
+            virtual void erase ( WD *wd ) = 0;
+
+            /*! \brief Returns the first WD to be served */
+            virtual WD * front () const = 0;
+            /*! \brief Returns the priority of the last WD to be served (a bound of it for HEAP) */
+            virtual T lastPriority () const = 0;
+            /*! \brief Returns the first WD, in serving order, that fulfils pred (NULL if none) */
+            virtual WD * find ( Predicate &pred ) = 0;
+      };
+
+      /*! \brief Container keeping a sorted WDIntrusiveList
+       */
+      template <typename T>
+      class SortedList : public Container<T>
+      {
+         private:
+            typedef typename Container<T>::PriorityValueFun PriorityValueFun;
+
+            BaseContainer     _dq;
+            /*! \brief When this is enabled, elements with the same priority
+             * as the one in the back will be inserted at the back.
+             * \note When this is enabled, it will override the LIFO behaviour
+             * in the above case.
+             */
+            bool              _optimise;
+
+            /*! \brief Performs upper bound reversely or not depending on the settings */
+            BaseContainer::iterator upper_bound( const WD *wd );
+            /*! \brief Performs lower bound reversely or not depending on the settings */
+            BaseContainer::iterator lower_bound( const WD *wd );
+            /*! \brief Position where a WD with the priority of wd has to be inserted */
+            BaseContainer::iterator position( const WD *wd, bool fifo );
+
+         public:
+            SortedList ( bool optimise, bool reverse, PriorityValueFun getter )
+               : Container<T>( reverse, getter ), _dq(), _optimise( optimise ) {}
+
+            bool empty () const { return _dq.empty(); }
+            size_t size () const { return _dq.size(); }
+
+            void insert ( WD *wd, bool fifo );
+            void insert ( WD **wds, size_t numElems, bool fifo );
+            void erase ( WD *wd ) { _dq.erase( wd ); }
+
+            WD * front () const { return _dq.front(); }
+            T lastPriority () const { return this->_getter( _dq.back() ); }
+            WD * find ( Predicate &pred );
+      };
+
+      /*! \brief Container keeping a d-ary heap of WDs
+       *
+       *  Each WD stores its index in the heap (WD::_queueSlot), so removing
+       *  or reordering an arbitrary WD is O(log n) too. Insertion order is
+       *  kept with a sequence number.
+       */
+      template <typename T>
+      class DAryHeap : public Container<T>
+      {
+         private:
+            typedef typename Container<T>::PriorityValueFun PriorityValueFun;
+
+            struct Entry {
+               T     _priority;  /**< Priority of _wd when it was inserted */
+               long  _seq;       /**< Insertion order among equal priorities */
+               WD   *_wd;
+            };
+
+            /*! \brief Orders heap indices by their entries, the first to be served last */
+            struct IndexOrder {
+               const DAryHeap &_heap;
+               IndexOrder ( const DAryHeap &heap ) : _heap( heap ) {}
+               bool operator() ( size_t a, size_t b ) const { return _heap.precedes( _heap._heap[b], _heap._heap[a] ); }
+            };
+
+            static const size_t Arity = 4;
+
+            std::vector<Entry>   _heap;
+            long                 _backSeq;   /**< Last sequence number given to a fifo insertion */
+            long                 _frontSeq;  /**< Last sequence number given to a lifo insertion */
+            T                    _last;      /**< Priority of the last WD inserted to be served, since the heap was empty */
+            std::vector<size_t>  _frontier;  /**< Indices pending to be visited by find() */
+
+            bool precedes ( const Entry &a, const Entry &b ) const;
+            void place ( size_t pos, const Entry &entry );
+            void siftUp ( size_t pos, Entry entry );
+            void siftDown ( size_t pos, Entry entry );
+
+         public:
+            DAryHeap ( bool reverse, PriorityValueFun getter )
+               : Container<T>( reverse, getter ), _heap(), _backSeq( 0 ), _frontSeq( 0 ), _last(), _frontier() {}
+
+            bool empty () const { return _heap.empty(); }
+            size_t size () const { return _heap.size(); }
+            /*! \brief Whether wd is in this heap */
+            bool contains ( const WD *wd ) const { return wd->_queueSlot < _heap.size() && _heap[wd->_queueSlot]._wd == wd; }
+
+            void insert ( WD *wd, bool fifo );
+            void erase ( WD *wd );
+
+            WD * front () const { return _heap[0]._wd; }
+            T lastPriority () const { return _last; }
+            WD * find ( Predicate &pred );
+      };
+
+      /*! \brief Container keeping one FIFO per priority in [0, NumBuckets)
+       *
+       *  A bitmap of the non-empty buckets gives the first one to be served in
+       *  constant time. WDs with priorities out of that range are kept in two
+       *  heaps, served before and after the buckets. Only meant for integer
+       *  priorities.
+       */
+      template <typename T>
+      class Buckets : public Container<T>
+      {
+         private:
+            typedef typename Container<T>::PriorityValueFun PriorityValueFun;
+
+            static const int NumBuckets = 64;
+
+            BaseContainer        _buckets[NumBuckets];
+            unsigned long long   _used;     /**< Bit i set if _buckets[i] is not empty */
+            size_t               _size;
+            DAryHeap<T>          _ahead;    /**< Out of range WDs served before the buckets */
+            DAryHeap<T>          _behind;   /**< Out of range WDs served after the buckets */
+
+            /*! \brief Index of the first (or last) non-empty bucket to be served */
+            int firstBucket () const;
+            int lastBucket () const;
+            /*! \brief Returns the index of the non-empty bucket served after b, or -1 */
+            int nextBucket ( int b ) const;
+
+         public:
+            Buckets ( bool reverse, PriorityValueFun getter )
+               : Container<T>( reverse, getter ), _used( 0 ), _size( 0 ), _ahead( reverse, getter ), _behind( reverse, getter ) {}
+
+            bool empty () const { return _size == 0; }
+            size_t size () const { return _size; }
+
+            void insert ( WD *wd, bool fifo );
+            void erase ( WD *wd );
+
+            WD * front () const;
+            T lastPriority () const;
+            WD * find ( Predicate &pred );
+      };
    }
 
    template<typename T = WD::PriorityType>
@@ -304,11 +765,9 @@ namespace nanos {
       public:
          typedef T         type;
          typedef std::const_mem_fun_t<T, WD> PriorityValueFun;
-         typedef std::map< const Device *, Atomic<unsigned int> > WDDeviceCounter;
 
       private:
-         // TODO (gmiranda): Measure if vector is better as a container
-         WDPQ::BaseContainer _dq;
+         WDPQ::Container<T> *_container;
          Lock                _lock;
          size_t              _nelems;
          /*! \brief When this is enabled, elements with the same priority
@@ -321,9 +780,8 @@ namespace nanos {
          /*! \brief Revert insertion */
          bool              _reverse;
 
-         /*! \brief Counts the number of WDs in the queue for each architecture */
-         WDDeviceCounter   _ndevs;
-         bool              _deviceCounter;
+         /*! \brief Counts the number of WDs in the queue for each architecture, NULL if disabled */
+         WDDeviceCounter  *_ndevs;
 
          /*! \brief Functor that will be used to get the priority or
           *  deadline */
@@ -341,21 +799,11 @@ namespace nanos {
           */
          const WDPriorityQueue & operator= ( const WDPriorityQueue & );
 
-         /*! \brief Inserts a WD in the expected order.
-          *  \param fifo Insert WDs with the same after the current ones?
-          */
-         void insertOrdered ( WorkDescriptor *wd, bool fifo = true );
-         void insertOrdered ( WorkDescriptor ** wds, size_t numElems, bool fifo = true );
+         /*! \brief Updates max and min priorities after changing the container */
+         void updatePriorities ();
 
-         /*! \brief Performs upper bound reversely or not depending on the settings */
-         WDPQ::BaseContainer::iterator upper_bound( const WD *wd );
-
-         /*! \brief Performs lower bound reversely or not depending on the settings */
-         WDPQ::BaseContainer::iterator lower_bound( const WD *wd );
-
-
-         void increaseTasksInQueues( int tasks, int increment = 1 );
-         void decreaseTasksInQueues( int tasks, int decrement = 1 );
+         void increaseTasksInQueues( int increment = 1 );
+         void decreaseTasksInQueues( int decrement = 1 );
 
          void increaseDeviceCounter ( WorkDescriptor *wd );
          void decreaseDeviceCounter ( WorkDescriptor *wd );
@@ -368,7 +816,12 @@ namespace nanos {
 
          /*! \brief WDPriorityQueue destructor
           */
-         ~WDPriorityQueue() {}
+         ~WDPriorityQueue() { delete _container; delete _ndevs; }
+
+         /*! \brief Changes the container keeping the WDs. The queue must be empty.
+          *  \note BUCKETS falls back to HEAP when priorities are not integers.
+          */
+         void setContainer ( WDPQ::ContainerType container );
 
          bool empty ( void ) const;
          size_t size() const;
@@ -24,10 +24,17 @@ namespace nanos {
 
    class SchedulePredicate;
    class WDPool;
+   class WDIntrusiveList;
    class WDDeque;
    class WDLFQueue;
+   class WDChaseLevDeque;
    template<typename T> class WDPriorityQueue;
 
+   namespace WDPQ {
+      template<typename T> class DAryHeap;
+      template<typename T> class Buckets;
+   }
+
 } // namespace nanos
 
 #endif
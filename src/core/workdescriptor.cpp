@@ -21,6 +21,8 @@
 #include "schedule.hpp"
 #include "processingelement.hpp"
 #include "basethread.hpp"
+#include "commutativegroup.hpp"
+#include <algorithm>
 #include "debug.hpp"
 #include "schedule.hpp"
 #include "system.hpp"
@@ -30,6 +32,8 @@
 
 using namespace nanos;
 
+unsigned int Device::_numDevices = 0;
+
 void WorkDescriptor::init ()
 {
    if ( _state != INIT ) return;
@@ -375,6 +379,18 @@ void WorkDescriptor::predecessorFinished( WorkDescriptor *predecessorWd )
    _mcontrol.getInfoFromPredecessor( predecessorWd->_mcontrol );
 }
 
+void WorkDescriptor::releaseDependencies( size_t numDataAccesses, DataAccess const *dataAccesses )
+{
+   if ( _doSubmit == NULL || numDataAccesses == 0 ) return;
+
+   std::vector<void *> addresses;
+   addresses.reserve( numDataAccesses );
+   for ( size_t i = 0; i < numDataAccesses; i++ ) {
+      addresses.push_back( dataAccesses[i].getDepAddress() );
+   }
+   _doSubmit->releaseDependencies( addresses );
+}
+
 void WorkDescriptor::wgdone()
 {
    //if (!_listed)
@@ -416,60 +432,94 @@ void WorkDescriptor::initCommutativeAccesses( WorkDescriptor &wd, size_t numDeps
 
    if ( numCommutative == 0 )
       return;
-   if (wd._commutativeOwners == NULL) wd._commutativeOwners = NEW WorkDescriptorPtrList();
-   wd._commutativeOwners->reserve(numCommutative);
+   if (wd._commutativeGroups == NULL) wd._commutativeGroups = NEW CommutativeGroupList();
+   wd._commutativeGroups->reserve(numCommutative);
 
    for ( size_t i = 0; i < numDeps; i++ ) {
       if ( !deps[i].isCommutative() )
          continue;
 
-      if ( _commutativeOwnerMap == NULL ) _commutativeOwnerMap = NEW CommutativeOwnerMap();
+      if ( _commutativeGroupMap == NULL ) _commutativeGroupMap = NEW CommutativeGroupMap();
 
-      // Lookup owner in map in parent WD
-      CommutativeOwnerMap::iterator iter = _commutativeOwnerMap->find( deps[i].getDepAddress() );
+      // Lookup group in map in parent WD
+      CommutativeGroupMap::iterator iter = _commutativeGroupMap->find( deps[i].getDepAddress() );
 
-      if ( iter != _commutativeOwnerMap->end() ) {
-         // Already in map => insert into owner list in child WD
-         wd._commutativeOwners->push_back( iter->second.get() );
+      if ( iter != _commutativeGroupMap->end() ) {
+         // Already in map => insert into group list in child WD
+         wd._commutativeGroups->push_back( iter->second.get() );
       }
       else {
-         // Not in map => allocate new owner pointer container and insert
-         std::pair<CommutativeOwnerMap::iterator, bool> ret =
-               _commutativeOwnerMap->insert( std::make_pair( deps[i].getDepAddress(),
-                                                            TR1::shared_ptr<WorkDescriptor *>( NEW WorkDescriptor *(NULL) ) ) );
+         // Not in map => allocate new group and insert
+         std::pair<CommutativeGroupMap::iterator, bool> ret =
+               _commutativeGroupMap->insert( std::make_pair( deps[i].getDepAddress(),
+                                                            TR1::shared_ptr<CommutativeGroup>( NEW CommutativeGroup() ) ) );
 
-         // Insert into owner list in child WD
-         wd._commutativeOwners->push_back( ret.first->second.get() );
+         // Insert into group list in child WD
+         wd._commutativeGroups->push_back( ret.first->second.get() );
       }
    }
+
+   // Groups are always taken in the same order, so that tasks waiting while they hold some
+   // of them cannot deadlock
+   std::sort( wd._commutativeGroups->begin(), wd._commutativeGroups->end() );
+   wd._commutativeGroups->erase( std::unique( wd._commutativeGroups->begin(), wd._commutativeGroups->end() ),
+                                 wd._commutativeGroups->end() );
 }
 
 bool WorkDescriptor::tryAcquireCommutativeAccesses()
 {
-   if ( _commutativeOwners == NULL ) return true;
+   if ( _commutativeGroups == NULL ) return true;
 
-   const size_t n = _commutativeOwners->size();
-   for ( size_t i = 0; i < n; i++ ) {
+   const size_t n = _commutativeGroups->size();
+   if ( _numCommutativeOwned == n ) return true;
 
-      WorkDescriptor *owner = *(*_commutativeOwners)[i];
+   // Lock all the groups (in order) to take them at once, or none of them
+   for ( size_t i = 0; i < n; i++ ) (*_commutativeGroups)[i]->getLock().acquire();
 
-      if ( owner == this )
-         continue;
+   bool free = true;
+   for ( size_t i = 0; i < n && free; i++ ) {
+      WorkDescriptor *owner = (*_commutativeGroups)[i]->getOwner();
+      free = ( owner == NULL || owner == this );
+   }
+   if ( free ) {
+      for ( size_t i = 0; i < n; i++ ) (*_commutativeGroups)[i]->acquireInLock( *this );
+      _numCommutativeOwned = n;
+   }
 
-      if ( owner == NULL &&
-           nanos::compareAndSwap( (void **) (*_commutativeOwners)[i], (void *) NULL, (void *) this ) )
-         continue;
+   for ( size_t i = n; i > 0; i-- ) (*_commutativeGroups)[i-1]->getLock().release();
 
-      // Failed to obtain exclusive access to all accesses, release the obtained ones
+   return free;
+}
 
-      for ( ; i > 0; i-- )
-         *(*_commutativeOwners)[i-1] = NULL;
+bool WorkDescriptor::acquireCommutativeAccesses()
+{
+   if ( _commutativeGroups == NULL ) return true;
 
-      return false;
+   // Once this WD is waiting in a group, the task releasing it resumes this loop
+   const size_t n = _commutativeGroups->size();
+   for ( ; _numCommutativeOwned < n; _numCommutativeOwned++ ) {
+      if ( !(*_commutativeGroups)[_numCommutativeOwned]->acquire( *this, true ) ) return false;
    }
    return true;
 }
 
+void WorkDescriptor::releaseCommutativeAccesses()
+{
+   if ( _commutativeGroups == NULL ) return;
+
+   const size_t n = _numCommutativeOwned;
+   _numCommutativeOwned = 0;
+   for ( size_t i = 0; i < n; i++ ) {
+      WorkDescriptor *next = (*_commutativeGroups)[i]->release( *this );
+
+      // The next owner has been waiting in the group instead of retrying from the ready queues.
+      // Submit it once it holds all of its targets.
+      if ( next != NULL && next->acquireCommutativeAccesses() ) {
+         Scheduler::submit( *next, true );
+      }
+   }
+}
+
 void WorkDescriptor::setCopies(size_t numCopies, CopyData * copies)
 {
     ensure(_numCopies == 0, "This WD already had copies. Overriding them is not possible");
@@ -509,7 +559,7 @@ void WorkDescriptor::waitCompletion( bool avoidFlush )
       delete _submittedWDs;
       _submittedWDs = NULL;
    }
-   _depsDomain->finalizeAllReductions();
+   if ( _depsDomain != NULL ) _depsDomain->finalizeAllReductions();
    _componentsSyncCond.waitConditionAndSignalers();
    if ( !avoidFlush ) {
       _mcontrol.synchronize();
@@ -523,7 +573,7 @@ void WorkDescriptor::waitCompletion( bool avoidFlush )
       myThread->getTeam()->cleanUpReductionList();
    }
 
-   _depsDomain->clearDependenciesDomain();
+   if ( _depsDomain != NULL ) _depsDomain->clearDependenciesDomain();
 }
 
 void WorkDescriptor::exitWork ( WorkDescriptor &work )
@@ -662,7 +712,7 @@ bool WorkDescriptor::resourceCheck( BaseThread const &thd, bool considerInvalida
 
 
 // comm_accesses is a map of access:owner for commutative accesess
-int WorkDescriptor::getConcurrencyLevel( std::map<WD**, WD*> &comm_accesses ) const
+int WorkDescriptor::getConcurrencyLevel( std::map<CommutativeGroup*, WD*> &comm_accesses ) const
 {
    int num_wds = 0;
 
@@ -684,35 +734,34 @@ int WorkDescriptor::getConcurrencyLevel( std::map<WD**, WD*> &comm_accesses ) co
    }
 
    // Commutative: return 0 to 1
-   else if ( _commutativeOwners != NULL ) {
-      WorkDescriptorPtrList::const_iterator owner_it;
+   else if ( _commutativeGroups != NULL ) {
+      CommutativeGroupList::const_iterator group_it;
       // Check first that all the WD'a accesses can be acquired
-      for ( owner_it = _commutativeOwners->begin();
-            owner_it != _commutativeOwners->end();
-            ++owner_it ) {
-         // WD** that contains the parent's commutative access
-         WD **owner_ptr = *owner_it;
+      for ( group_it = _commutativeGroups->begin();
+            group_it != _commutativeGroups->end();
+            ++group_it ) {
+         // Group of the parent's commutative access
+         CommutativeGroup *group = *group_it;
          // WD* owner of the actual access
-         WD *owner = *owner_ptr;
+         WD *owner = group->getOwner();
 
          // If the access has an owner, update the local structure
-         if ( owner && owner != comm_accesses[owner_ptr] ) {
-            comm_accesses[owner_ptr] = owner;
+         if ( owner && owner != comm_accesses[group] ) {
+            comm_accesses[group] = owner;
          }
 
          // We stop looking if the access is reserved by other WD
-         if ( comm_accesses[owner_ptr] != NULL && comm_accesses[owner_ptr] != (WD*) this ) {
+         if ( comm_accesses[group] != NULL && comm_accesses[group] != (WD*) this ) {
             break;
          }
       }
 
       // All the WD's accessed can be acquired, register them into comm_accesses
-      if ( owner_it == _commutativeOwners->end() ) {
-         for ( owner_it = _commutativeOwners->begin();
-               owner_it != _commutativeOwners->end();
-               ++owner_it ) {
-            WD **owner_ptr = *owner_it;
-            comm_accesses[owner_ptr] = (WD*) this;
+      if ( group_it == _commutativeGroups->end() ) {
+         for ( group_it = _commutativeGroups->begin();
+               group_it != _commutativeGroups->end();
+               ++group_it ) {
+            comm_accesses[*group_it] = (WD*) this;
          }
          num_wds = 1;
       }
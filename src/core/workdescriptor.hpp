@@ -42,23 +42,23 @@ inline WorkDescriptor::WorkDescriptor ( int ndevices, DeviceData **devs, size_t
                                  size_t numCopies, CopyData *copies, nanos_translate_args_t translate_args, const char *description )
                                : _id( sys.getWorkDescriptorId() ), _hostId(0), _components( 0 ),
                                  _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _parent(NULL), _forcedParent(NULL),
-                                 _data_size ( data_size ), _data_align( data_align ),  _data ( wdata ), _totalSize(0),
+                                 _data_size ( data_size ), _data_align( data_align ),  _data ( wdata ), _totalSize(0), _batch( NULL ),
                                  _wdData ( NULL ), _scheduleData( NULL ),
                                  _flags(), _tiedTo ( NULL ), _tiedToLocation( (memory_space_id_t) -1 ),
-                                 _state( INIT ), _syncCond( NULL ),  _myQueue ( NULL ), _depth ( 0 ),
+                                 _state( INIT ), _syncCond( NULL ),  _myQueue ( NULL ), _queuePrev( NULL ), _queueNext( NULL ), _queueSlot( 0 ), _depth ( 0 ),
                                  _numDevices ( ndevices ), _devices ( devs ), _activeDeviceIdx( ndevices == 1 ? 0 : ndevices ),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( -1 ),
 #endif
                                  _numCopies( numCopies ), _copies( copies ), _paramsSize( 0 ),
                                  _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
-                                 _doSubmit(NULL), _doWait(), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _doSubmit(NULL), _doWait(), _depsDomain( NULL ),
                                  _translateArgs( translate_args ),
-                                 _priority( 0 ), _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
+                                 _priority( 0 ), _commutativeGroupMap(NULL), _commutativeGroups(NULL), _numCommutativeOwned(0),
                                  _copiesNotInChunk(false), _description(description), _instrumentationContextData(), _slicer(NULL),
                                  _taskReductions(),
                                  _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _taskGraph( NULL ), _schedPredecessorLocs(),
                                  _mcontrol( this, numCopies )
                                  {
                                     _flags.is_final = 0;
@@ -66,6 +66,8 @@ inline WorkDescriptor::WorkDescriptor ( int ndevices, DeviceData **devs, size_t
                                     _flags.is_recoverable = false;
                                     _flags.is_invalid = false;
                                     _flags.is_outlined = false;
+                                    _flags.in_chunk_pool = false;
+                                    _flags.is_stackless = false;
                                     if ( copies != NULL ) {
                                        for ( unsigned int i = 0; i < numCopies; i += 1 ) {
                                           copies[i].setHostBaseAddress( 0 );
@@ -81,22 +83,22 @@ inline WorkDescriptor::WorkDescriptor ( DeviceData *device, size_t data_size, si
                                  size_t numCopies, CopyData *copies, nanos_translate_args_t translate_args, const char *description )
                                : _id( sys.getWorkDescriptorId() ), _hostId( 0 ), _components( 0 ),
                                  _componentsSyncCond( EqualConditionChecker<int>( &_components.override(), 0 ) ), _parent(NULL), _forcedParent(NULL),
-                                 _data_size ( data_size ), _data_align ( data_align ), _data ( wdata ), _totalSize(0),
+                                 _data_size ( data_size ), _data_align ( data_align ), _data ( wdata ), _totalSize(0), _batch( NULL ),
                                  _wdData ( NULL ), _scheduleData( NULL ),
                                  _flags(), _tiedTo ( NULL ), _tiedToLocation( (memory_space_id_t) -1 ),
-                                 _state( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _depth ( 0 ),
+                                 _state( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _queuePrev( NULL ), _queueNext( NULL ), _queueSlot( 0 ), _depth ( 0 ),
                                  _numDevices ( 1 ), _devices ( NULL ), _activeDeviceIdx( 0 ),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( -1 ),
 #endif
                                  _numCopies( numCopies ), _copies( copies ), _paramsSize( 0 ),
                                  _versionGroupId( 0 ), _executionTime( 0.0 ), _estimatedExecTime( 0.0 ),
-                                 _doSubmit(NULL), _doWait(), _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _doSubmit(NULL), _doWait(), _depsDomain( NULL ),
                                  _translateArgs( translate_args ),
-                                 _priority( 0 ),  _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
+                                 _priority( 0 ),  _commutativeGroupMap(NULL), _commutativeGroups(NULL), _numCommutativeOwned(0),
                                  _copiesNotInChunk(false), _description(description), _instrumentationContextData(), _slicer(NULL), _taskReductions(),
                                  _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _taskGraph( NULL ), _schedPredecessorLocs(),
                                  _mcontrol( this, numCopies )
                                  {
                                      _devices = new DeviceData*[1];
@@ -106,6 +108,8 @@ inline WorkDescriptor::WorkDescriptor ( DeviceData *device, size_t data_size, si
                                     _flags.is_recoverable = false;
                                     _flags.is_invalid = false;
                                     _flags.is_outlined = false;
+                                    _flags.in_chunk_pool = false;
+                                    _flags.is_stackless = false;
                                     if ( copies != NULL ) {
                                        for ( unsigned int i = 0; i < numCopies; i += 1 ) {
                                           copies[i].setHostBaseAddress( 0 );
@@ -120,10 +124,10 @@ inline WorkDescriptor::WorkDescriptor ( DeviceData *device, size_t data_size, si
 inline WorkDescriptor::WorkDescriptor ( const WorkDescriptor &wd, DeviceData **devs, CopyData * copies, void *data, const char *description )
                                : _id( sys.getWorkDescriptorId() ), _hostId( 0 ), _components( 0 ),
                                  _componentsSyncCond( EqualConditionChecker<int>(&_components.override(), 0 ) ), _parent(NULL), _forcedParent(wd._forcedParent),
-                                 _data_size( wd._data_size ), _data_align( wd._data_align ), _data ( data ), _totalSize(0),
+                                 _data_size( wd._data_size ), _data_align( wd._data_align ), _data ( data ), _totalSize(0), _batch( NULL ),
                                  _wdData ( NULL ), _scheduleData( NULL ),
                                  _flags(), _tiedTo ( wd._tiedTo ), _tiedToLocation( wd._tiedToLocation ),
-                                 _state ( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _depth ( wd._depth ),
+                                 _state ( INIT ), _syncCond( NULL ), _myQueue ( NULL ), _queuePrev( NULL ), _queueNext( NULL ), _queueSlot( 0 ), _depth ( wd._depth ),
                                  _numDevices ( wd._numDevices ), _devices ( devs ), _activeDeviceIdx( wd._numDevices == 1 ? 0 : wd._numDevices ),
 #ifdef GPU_DEV
                                  _cudaStreamIdx( wd._cudaStreamIdx ),
@@ -131,12 +135,12 @@ inline WorkDescriptor::WorkDescriptor ( const WorkDescriptor &wd, DeviceData **d
                                  _numCopies( wd._numCopies ), _copies( wd._numCopies == 0 ? NULL : copies ), _paramsSize( wd._paramsSize ),
                                  _versionGroupId( wd._versionGroupId ), _executionTime( wd._executionTime ),
                                  _estimatedExecTime( wd._estimatedExecTime ), _doSubmit(NULL), _doWait(),
-                                 _depsDomain( sys.getDependenciesManager()->createDependenciesDomain() ),
+                                 _depsDomain( NULL ),
                                  _translateArgs( wd._translateArgs ),
-                                 _priority( wd._priority ), _commutativeOwnerMap(NULL), _commutativeOwners(NULL),
+                                 _priority( wd._priority ), _commutativeGroupMap(NULL), _commutativeGroups(NULL), _numCommutativeOwned(0),
                                  _copiesNotInChunk( wd._copiesNotInChunk), _description(description), _instrumentationContextData(), _slicer(wd._slicer), _taskReductions(),
                                  _notifyCopy( NULL ), _notifyThread( NULL ), _remoteAddr( NULL ), _callback(0), _arguments(0),
-                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _schedPredecessorLocs(),
+                                 _submittedWDs( NULL ), _reachedTaskwait( false ), _taskGraph( NULL ), _schedPredecessorLocs(),
                                  _mcontrol( this, wd._numCopies )
                                  {
                                     if ( wd._parent != NULL ) wd._parent->addWork(*this);
@@ -149,6 +153,8 @@ inline WorkDescriptor::WorkDescriptor ( const WorkDescriptor &wd, DeviceData **d
                                     _flags.is_invalid = false;
                                     _flags.is_runtime_task = wd._flags.is_runtime_task;
                                     _flags.is_outlined = wd._flags.is_outlined;
+                                    _flags.in_chunk_pool = false;
+                                    _flags.is_stackless = false;
 
                                     _mcontrol.preInit();
                                     for (unsigned int __i=0; __i<8;__i+=1) {
@@ -171,6 +177,10 @@ inline WorkDescriptor::~WorkDescriptor()
     //! Delete Dependence Domain
     delete _depsDomain;
 
+    //! Delete commutative groups (the ones in the map are shared with the children)
+    delete _commutativeGroupMap;
+    delete _commutativeGroups;
+
     //! Delete internal data (if any)
     union { char* p; intptr_t i; } u = { (char*)_wdData };
     bool internalDataOwned = (u.i & 1);
@@ -205,6 +215,14 @@ inline void WorkDescriptor::setTotalSize ( size_t size ) { _totalSize = size; }
 inline WorkDescriptor * WorkDescriptor::getParent() const { return _parent!=NULL?_parent:_forcedParent ; }
 inline void WorkDescriptor::forceParent ( WorkDescriptor * p ) { _forcedParent = p; }
 
+inline bool WorkDescriptor::isDescendantOf ( const WorkDescriptor &ancestor ) const
+{
+   for ( WorkDescriptor *wd = getParent(); wd != NULL; wd = wd->getParent() ) {
+      if ( wd == &ancestor ) return true;
+   }
+   return false;
+}
+
 inline WDPool * WorkDescriptor::getMyQueue() { return _myQueue; }
 inline void WorkDescriptor::setMyQueue ( WDPool * myQ ) { _myQueue = myQ; }
 
@@ -223,6 +241,8 @@ inline WorkDescriptor & WorkDescriptor::tieToLocation ( memory_space_id_t loc )
 
 inline bool WorkDescriptor::isTied() const { return _tiedTo != NULL; }
 
+inline bool WorkDescriptor::isToBeTied() const { return _tiedTo != NULL || _flags.to_tie; }
+
 inline bool WorkDescriptor::isTiedLocation() const { return _tiedToLocation != ( (memory_space_id_t) -1); }
 
 inline BaseThread* WorkDescriptor::isTiedTo() const { return _tiedTo; }
@@ -364,21 +384,27 @@ inline void WorkDescriptor::setEstimatedExecutionTime( double time ) { _estimate
 
 inline DOSubmit * WorkDescriptor::getDOSubmit() { return _doSubmit; }
 
+inline DOSubmit * WorkDescriptor::initDOSubmit()
+{
+   _doSubmit = NEW DOSubmit();
+   _doSubmit->setWD( this );
+   return _doSubmit;
+}
+
 inline int WorkDescriptor::getNumDepsPredecessors() { return ( _doSubmit == NULL ? 0 : _doSubmit->numPredecessors() ); }
 
 inline bool WorkDescriptor::hasDepsPredecessors() { return ( _doSubmit == NULL ? false : ( _doSubmit->numPredecessors() != 0 ) ); }
 
 inline void WorkDescriptor::submitWithDependencies( WorkDescriptor &wd, size_t numDeps, DataAccess* deps )
 {
-   wd._doSubmit = NEW DOSubmit();
-   wd._doSubmit->setWD(&wd);
+   wd.initDOSubmit();
 
    // Defining call back (cb)
    SchedulePolicySuccessorFunctor cb( *sys.getDefaultSchedulePolicy() );
 
    initCommutativeAccesses( wd, numDeps, deps );
 
-   _depsDomain->submitDependableObject( *(wd._doSubmit), numDeps, deps, &cb );
+   getDependenciesDomain().submitDependableObject( *(wd._doSubmit), numDeps, deps, &cb );
    if ( sys._preSchedule ) {
       sys._slots[wd._doSubmit->getNum()].insert(&wd);
    }
@@ -388,7 +414,7 @@ inline void WorkDescriptor::submitWithDependencies( WorkDescriptor &wd, size_t n
 inline void WorkDescriptor::waitOn( size_t numDeps, DataAccess* deps )
 {
    _doWait->setWD(this);
-   _depsDomain->submitDependableObject( *_doWait, numDeps, deps );
+   getDependenciesDomain().submitDependableObject( *_doWait, numDeps, deps );
    _mcontrol.synchronize( numDeps, deps );
 }
 
@@ -444,6 +470,8 @@ inline void WorkDescriptor::releaseInputDependencies()
 
 inline DependenciesDomain & WorkDescriptor::getDependenciesDomain()
 {
+   // Only the WD itself submits to its domain, so it is created the first time it is needed
+   if ( _depsDomain == NULL ) _depsDomain = sys.getDependenciesManager()->createDependenciesDomain();
    return *_depsDomain;
 }
 
@@ -463,14 +491,6 @@ inline void WorkDescriptor::setPriority( WorkDescriptor::PriorityType priority )
 }
 inline WorkDescriptor::PriorityType WorkDescriptor::getPriority() const { return _priority; }
 
-inline void WorkDescriptor::releaseCommutativeAccesses()
-{
-   if ( _commutativeOwners == NULL ) return;
-   const size_t n = _commutativeOwners->size();
-   for ( size_t i = 0; i < n; i++ )
-      *(*_commutativeOwners)[i] = NULL;
-}
-
 inline void WorkDescriptor::setImplicit( bool b )
 {
    //! Set implicit flag to parameter value
@@ -500,6 +520,12 @@ inline void WorkDescriptor::addWork ( WorkDescriptor &work )
    work.addToGroup( *this );
 }
 
+inline void WorkDescriptor::addWork ( size_t numWorks, WorkDescriptor **works )
+{
+   _components += numWorks;
+   for ( size_t i = 0; i < numWorks; i++ ) works[i]->addToGroup( *this );
+}
+
 inline void WorkDescriptor::addToGroup ( WorkDescriptor &parent )
 {
    if ( _parent == NULL ) _parent = &parent;
@@ -547,6 +573,14 @@ inline void const *WorkDescriptor::getRemoteAddr() const {
    return _remoteAddr;
 }
 
+inline void WorkDescriptor::setTaskGraph( TaskGraph *graph ) {
+   _taskGraph = graph;
+}
+
+inline TaskGraph * WorkDescriptor::getTaskGraph() const {
+   return _taskGraph;
+}
+
 inline bool WorkDescriptor::setInvalid ( bool flag )
 {
    if (_flags.is_invalid != flag) {
@@ -595,6 +629,15 @@ inline void WorkDescriptor::setDone() { _state = DONE; }
 inline bool WorkDescriptor::isOutlined() const { return _flags.is_outlined; }
 inline void WorkDescriptor::setOutlined( bool flag ) { _flags.is_outlined = flag; }
 
+inline bool WorkDescriptor::isInChunkPool() const { return _flags.in_chunk_pool; }
+inline void WorkDescriptor::setInChunkPool() { _flags.in_chunk_pool = true; }
+
+inline WDBatch * WorkDescriptor::getBatch() const { return _batch; }
+inline void WorkDescriptor::setBatch( WDBatch *batch ) { _batch = batch; }
+
+inline bool WorkDescriptor::isStackless() const { return _flags.is_stackless; }
+inline void WorkDescriptor::setStackless() { _flags.is_stackless = true; }
+
 } // namespace nanos
 
 #endif
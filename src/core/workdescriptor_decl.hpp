@@ -29,6 +29,8 @@
 #include "basethread_fwd.hpp"
 #include "processingelement_fwd.hpp"
 #include "wddeque_fwd.hpp"
+#include "taskgraph_fwd.hpp"
+#include "commutativegroup_fwd.hpp"
 
 #include "dependableobjectwd_decl.hpp"
 #include "copydata_decl.hpp"
@@ -50,6 +52,14 @@ namespace nanos {
 
 typedef std::set<const Device *>  DeviceList;
 
+   /*! \brief Header of a memory chunk holding several sibling WorkDescriptors (see System::createWDs)
+    *
+    *  The chunk goes back to the WDChunkPool when the last WorkDescriptor placed in it is destroyed.
+    */
+   struct WDBatch {
+      Atomic<unsigned int>          _liveWDs;                //!< WorkDescriptors of the chunk not destroyed yet
+   };
+
    /*! \brief This class represents a device object
     */
    class Device
@@ -58,16 +68,24 @@ typedef std::set<const Device *>  DeviceList;
 
          const char *_name; /**< Identifies device type */
          Atomic<unsigned int> _numOps;
+         unsigned int _id;  /**< Dense identifier, from 0 to getNumDevices()-1 */
+
+         /*! \brief Number of devices created so far.
+          *  \note Devices are created during static initialization or plugin loading,
+          *  which is single threaded. A plain integer keeps it zero-initialized
+          *  before any static constructor runs.
+          */
+         static unsigned int _numDevices;
 
       public:
 
          /*! \brief Device constructor
           */
-         Device ( const char *n ) : _name ( n ), _numOps(0) {}
+         Device ( const char *n ) : _name ( n ), _numOps(0), _id( _numDevices++ ) {}
 
          /*! \brief Device copy constructor
           */
-         Device ( const Device &arch ) : _name ( arch._name ), _numOps( arch._numOps ) {}
+         Device ( const Device &arch ) : _name ( arch._name ), _numOps( arch._numOps ), _id( arch._id ) {}
 
          /*! \brief Device destructor
           */
@@ -75,7 +93,7 @@ typedef std::set<const Device *>  DeviceList;
 
          /*! \brief Device assignment operator
           */
-         const Device & operator= ( const Device &arch ) { _name = arch._name; _numOps = arch._numOps; return *this; }
+         const Device & operator= ( const Device &arch ) { _name = arch._name; _numOps = arch._numOps; _id = arch._id; return *this; }
 
          /*! \brief Device equals operator
           */
@@ -87,6 +105,14 @@ typedef std::set<const Device *>  DeviceList;
          const char * getName ( void ) const { return _name; }
          unsigned int increaseNumOps() { return _numOps++; }
 
+         /*! \brief Get the device identifier, suitable to index per-device arrays
+          */
+         unsigned int getId ( void ) const { return _id; }
+
+         /*! \brief Get the number of device identifiers given so far
+          */
+         static unsigned int getNumDevices ( void ) { return _numDevices; }
+
          virtual void *memAllocate( std::size_t size, SeparateMemoryAddressSpace &mem, WorkDescriptor const *wd, unsigned int copyIdx) = 0;
          virtual void memFree( uint64_t addr, SeparateMemoryAddressSpace &mem ) = 0;
          virtual void _canAllocate( SeparateMemoryAddressSpace &mem, std::size_t *sizes, unsigned int numChunks, std::size_t *remainingSizes ) = 0;
@@ -201,8 +227,8 @@ typedef std::set<const Device *>  DeviceList;
    {
       public: /* types */
          typedef enum { IsNotAUserLevelThread=false, IsAUserLevelThread=true } ULTFlag;
-         typedef std::vector<WorkDescriptor **> WorkDescriptorPtrList;
-         typedef TR1::unordered_map<void *, TR1::shared_ptr<WorkDescriptor *> > CommutativeOwnerMap;
+         typedef std::vector<CommutativeGroup *> CommutativeGroupList;
+         typedef TR1::unordered_map<void *, TR1::shared_ptr<CommutativeGroup> > CommutativeGroupMap;
          typedef struct {
             bool is_final;         //!< Work descriptor will not create more work descriptors
             bool is_initialized;   //!< Work descriptor is initialized
@@ -216,6 +242,8 @@ typedef std::set<const Device *>  DeviceList;
             bool is_invalid;       //!< Flags an invalid workdescriptor. Used in resiliency when a task fails.
             bool is_runtime_task;  //!< Is the WD a task for doing runtime jobs?
             bool is_outlined;      //!< Is the WD executed as an outline task?
+            bool in_chunk_pool;    //!< Is the WD placed at the start of a WDChunkPool chunk?
+            bool is_stackless;     //!< Is the WD running inline on the stack of its thread (see Scheduler::switchTo)?
          } WDFlags;
          typedef enum { INIT, START, READY, BLOCKED, DONE } State;
          typedef int PriorityType;
@@ -232,6 +260,7 @@ typedef std::set<const Device *>  DeviceList;
          size_t                        _data_align;             //!< WD data alignment
          void                         *_data;                   //!< WD data
          size_t                        _totalSize;              //!< Chunk total size, when allocating WD + extra data
+         WDBatch                      *_batch;                  //!< Chunk shared with the WD siblings, NULL if none (see System::createWDs)
          void                         *_wdData;                 //!< Internal WD data. Allowing higher layer to associate data to WD
          ScheduleWDData               *_scheduleData;           //!< Data set by the scheduling policy
          WDFlags                       _flags;                  //!< WD Flags
@@ -240,6 +269,12 @@ typedef std::set<const Device *>  DeviceList;
          State                         _state;                  //!< Workdescriptor current state
          GenericSyncCond              *_syncCond;               //!< Generic synchronize condition
          WDPool                       *_myQueue;                //!< Allows dequeuing from third party (e.g. Cilk schedulers)
+         WorkDescriptor               *_queuePrev;              //!< Intrusive ready queue hook, owned by _myQueue
+         WorkDescriptor               *_queueNext;              //!< Intrusive ready queue hook, owned by _myQueue
+         size_t                        _queueSlot;              //!< Slot (heap index or bucket) in _myQueue, if it keeps one
+         friend class WDIntrusiveList;
+         template <typename T> friend class WDPQ::DAryHeap;
+         template <typename T> friend class WDPQ::Buckets;
          unsigned                      _depth;                  //!< Level (depth) of the task
          unsigned char                 _numDevices;             //!< Number of suported devices for this workdescriptor
          DeviceData                  **_devices;                //!< Supported devices for this workdescriptor
@@ -255,11 +290,12 @@ typedef std::set<const Device *>  DeviceList;
          double                        _estimatedExecTime;      //!< FIXME:scheduler data. WD estimated execution time, accounting data transfers
          DOSubmit                     *_doSubmit;               //!< DependableObject representing this WD in its parent's depsendencies domain
          LazyInit<DOWait>              _doWait;                 //!< DependableObject used by this task to wait on dependencies
-         DependenciesDomain           *_depsDomain;             //!< Dependences domain. Each WD has one where DependableObjects can be submitted            //!< Directory to mantain cache coherence
+         DependenciesDomain           *_depsDomain;             //!< Dependences domain where DependableObjects can be submitted, NULL until first used            //!< Directory to mantain cache coherence
          nanos_translate_args_t        _translateArgs;          //!< Translates the addresses in _data to the ones obtained by get_address()
          PriorityType                  _priority;               //!< Task priority
-         CommutativeOwnerMap          *_commutativeOwnerMap;    //!< Map from commutative target address to owner pointer
-         WorkDescriptorPtrList        *_commutativeOwners;      //!< Array of commutative target owners
+         CommutativeGroupMap          *_commutativeGroupMap;    //!< Map from commutative target address to its group
+         CommutativeGroupList         *_commutativeGroups;      //!< Groups of the commutative targets, in acquisition order
+         size_t                        _numCommutativeOwned;    //!< Number of groups in _commutativeGroups owned by this WD
          int                           _numaNode;               //!< FIXME:scheduler data. The NUMA node this WD was assigned to
          bool                          _copiesNotInChunk;       //!< States whether the buffer of the copies is allocated in the chunk of the WD
          const char                   *_description;            //!< WorkDescriptor description, usually user function name
@@ -276,6 +312,7 @@ typedef std::set<const Device *>  DeviceList;
          void                         *_arguments;
          std::vector<WorkDescriptor *>*_submittedWDs;
          bool                          _reachedTaskwait;
+         TaskGraph                    *_taskGraph;              //!< Task graph being recorded by this WD (NULL if none)
       public:
          int                           _schedValues[8];
          std::map<memory_space_id_t,unsigned int>   _schedPredecessorLocs;
@@ -372,6 +409,9 @@ typedef std::set<const Device *>  DeviceList;
 
          WorkDescriptor * getParent() const;
 
+         //! \brief Returns whether \a ancestor is found walking up the parents of the WD
+         bool isDescendantOf ( const WorkDescriptor &ancestor ) const;
+
          void forceParent ( WorkDescriptor * p );
 
          WDPool * getMyQueue();
@@ -392,6 +432,9 @@ typedef std::set<const Device *>  DeviceList;
 
          bool isTied() const;
 
+         //! \brief Returns whether the WD is tied to a thread or will be tied to the first one executing it
+         bool isToBeTied() const;
+
          bool isTiedLocation() const;
 
          BaseThread * isTiedTo() const;
@@ -585,6 +628,10 @@ typedef std::set<const Device *>  DeviceList;
           */
          DOSubmit * getDOSubmit();
 
+         /*! \brief Creates the DOSubmit of the WD, to be linked outside any dependencies domain
+          */
+         DOSubmit * initDOSubmit();
+
          /*! \brief Returns DOSubmit's number of predecessors
           */
          int getNumDepsPredecessors();
@@ -620,7 +667,11 @@ typedef std::set<const Device *>  DeviceList;
           */
          void releaseInputDependencies();
 
-         /*! \brief Returns the DependenciesDomain object.
+         /*! \brief Early-release the dependencies of this WD matching the given data accesses
+          */
+         void releaseDependencies( size_t numDataAccesses, DataAccess const *dataAccesses );
+
+         /*! \brief Returns the DependenciesDomain object, creating it on first use.
           */
          DependenciesDomain & getDependenciesDomain();
 
@@ -661,10 +712,16 @@ typedef std::set<const Device *>  DeviceList;
           */
          void initCommutativeAccesses( WorkDescriptor &wd, size_t numDeps, DataAccess* deps );
          /*! \brief Try to take ownership of all commutative targets for exclusive access.
-          *  Called when a task is invoked.
+          *  Called when a task is invoked. Either all the targets are taken or none of them.
           */
          bool tryAcquireCommutativeAccesses();
-         /*! \brief Release ownership of commutative targets.
+         /*! \brief Take ownership of the commutative targets, waiting in the first one owned by
+          *  another task. Called when a task becomes ready.
+          *  \return false if the task has been left waiting: it will be submitted again by the
+          *  task that hands it the last target.
+          */
+         bool acquireCommutativeAccesses();
+         /*! \brief Release ownership of commutative targets, handing them to waiting tasks.
           *  Called when a task is finished.
           */
          void releaseCommutativeAccesses();
@@ -694,6 +751,9 @@ typedef std::set<const Device *>  DeviceList;
          //! \brief Adding work to current WorkDescriptor
          void addWork( WorkDescriptor &work );
 
+         //! \brief Adding several works to current WorkDescriptor, updating the number of components once
+         void addWork( size_t numWorks, WorkDescriptor **works );
+
          //! \brief Get related slicer
          Slicer * getSlicer ( void ) const;
 
@@ -732,6 +792,12 @@ typedef std::set<const Device *>  DeviceList;
          void setRemoteAddr( void const *addr );
          void const *getRemoteAddr() const;
 
+         //! \brief Sets the task graph recording the WorkDescriptors submitted by this one (NULL to stop)
+         void setTaskGraph( TaskGraph *graph );
+
+         //! \brief Returns the task graph recording the WorkDescriptors submitted by this one (if any)
+         TaskGraph * getTaskGraph() const;
+
          /*! \brief Sets a WorkDescriptor to an invalid state or not depending on the flag value.
              If invalid (flag = true) it propagates upwards to the ancestors until
              no more ancestors exist or a recoverable task is found.
@@ -757,7 +823,7 @@ typedef std::set<const Device *>  DeviceList;
 
          //! \brief Returns the concurrency level of the WD considering
          //         the commutative access map that the caller provides.
-         int getConcurrencyLevel( std::map<WD**, WD*> &comm_accesses ) const;
+         int getConcurrencyLevel( std::map<CommutativeGroup*, WD*> &comm_accesses ) const;
          void addPresubmittedWDs( unsigned int numWDs, WD **wds );
 
          //! \brief Returns whether a WorkDescriptor is executed (done or setDone have been called) or not.
@@ -771,6 +837,24 @@ typedef std::set<const Device *>  DeviceList;
 
          //! \breif Sets the outlined WorkDescriptor flag
          void setOutlined ( bool flag );
+
+         //! \brief Returns whether the WorkDescriptor chunk comes from the WDChunkPool (see System::destroyWD)
+         bool isInChunkPool ( void ) const;
+
+         //! \brief Flags the WorkDescriptor as placed at the start of a WDChunkPool chunk
+         void setInChunkPool ( void );
+
+         //! \brief Returns the chunk the WorkDescriptor shares with its siblings, NULL if none (see System::destroyWD)
+         WDBatch * getBatch ( void ) const;
+
+         //! \brief Sets the chunk the WorkDescriptor shares with its siblings
+         void setBatch ( WDBatch *batch );
+
+         //! \brief Returns whether the WorkDescriptor runs inline on the stack of its thread, so it cannot be suspended
+         bool isStackless ( void ) const;
+
+         //! \brief Flags the WorkDescriptor as running inline on the stack of its thread
+         void setStackless ( void );
    };
 
    typedef class WorkDescriptor WD;
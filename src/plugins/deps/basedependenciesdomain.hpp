@@ -56,8 +56,13 @@ inline void BaseDependenciesDomain::dependOnLastWriter ( DependableObject &depOb
    if ( lastWriter == &depObj) return;
 
    if ( lastWriter != NULL ) {
-      SyncLockBlock lck( lastWriter->getLock() );
+      // While the writer lock is held lastWriter cannot be removed from status, and thus it cannot
+      // finish and be deleted. Once it is locked, DependableObject::finished waits for us.
+      Lock &writerLock = status.getWriterLock();
+      writerLock.acquire();
       if ( status.getLastWriter() == lastWriter ) {
+         SyncLockBlock lck( lastWriter->getLock() );
+         writerLock.release();
 
          // new instrument event: dependence lastWriter -> depObj
          NANOS_INSTRUMENT ( WorkDescriptor *wd_sender = (WorkDescriptor *) lastWriter->getRelatedObject(); )
@@ -109,6 +114,8 @@ inline void BaseDependenciesDomain::dependOnLastWriter ( DependableObject &depOb
                ( *callback )( lastWriter, &depObj );
             }
          }
+      } else {
+         writerLock.release();
       }
    }
 }
@@ -21,6 +21,7 @@
 #define _NANOS_BASE_DEPENDENCIES_DOMAIN_DECL
 
 #include "dependenciesdomain_decl.hpp"
+#include "atomic_decl.hpp"
 #include "instrumentation_decl.hpp"
 #include "system.hpp"
 
@@ -35,7 +36,7 @@ namespace nanos {
    class BaseDependenciesDomain : public DependenciesDomain
    {
       protected:
-         unsigned int _lastDepObjId;         /**< Id to be given to the next submitted DependableObject */
+         Atomic<unsigned int> _lastDepObjId; /**< Id to be given to the next submitted DependableObject */
       private:
          /*! \brief Creates a CommutationDO and attaches it to the trackable object.
           *  \param target accessed base address/region
@@ -25,162 +25,184 @@
 #include "compatibility.hpp"
 #include <vector>
 #include <map>
+#include <algorithm>
 
 namespace nanos {
    namespace ext {
        
        
-      class CRegionsPair {
-          private:
-          
-            std::vector< TrackableObject* > * _trackableObjs;
-            unsigned int _itNum;
-          
-          public:
+      /*! \brief Spatial index of the regions tracked by a CRegionsDependenciesDomain.
+       *
+       *  Regions are bucketed by size class (the bit length of their extent) and, inside
+       *  each bucket, ordered by start address. A region of class c spans at most 2^c-1
+       *  bytes past its start, so every region of that class overlapping a target starts
+       *  within [target.start - (2^c-1), target.end]: one range scan per populated class
+       *  finds all the overlaps in O(C log n + k) instead of scanning every live region.
+       *  The index holds a reference on every TrackableObject it tracks; the targets of the
+       *  submitted DependableObjects hold the others (see DepsRegion::setTrackable). Regions
+       *  left with no reader, writer or commutation object are swept out of the index once
+       *  it doubles in size, and their status is deleted by whoever drops the last reference.
+       */
+      class CRegionsIndex {
+         private:
+            typedef std::pair< uintptr_t, TrackableObject* > Entry; /**< End address and status of a region */
+            typedef std::multimap< uintptr_t, Entry > Bucket; /**< Regions of one size class keyed by start address */
+            enum { NumClasses = 65 };
+            enum { MinSweepThreshold = 1024 };
+
+            Bucket      _buckets[NumClasses]; /**< One bucket per size class */
+            size_t      _numRegions;          /**< Number of regions in the index */
+            size_t      _sweepThreshold;      /**< Number of regions that triggers the next sweep */
 
-            CRegionsPair(std::vector< TrackableObject* > * trackableObjs, unsigned int itNum):
-             _trackableObjs(trackableObjs) , _itNum(itNum){}
-              
-            unsigned int getItNum() const {
-                return _itNum;
+         private:
+            static int sizeClass ( uintptr_t extent )
+            {
+               return extent == 0 ? 0 : 64 - __builtin_clzll( (unsigned long long) extent );
             }
 
-            void setItNum(unsigned int itNum) {
-                this->_itNum = itNum;
+            static uintptr_t maxExtent ( int sizeClass )
+            {
+               return sizeClass == 64 ? ~( (uintptr_t) 0 ) : ( ( (uintptr_t) 1 ) << sizeClass ) - 1;
             }
 
-            std::vector<TrackableObject*>* getTrackableObjs() const {
-                return _trackableObjs;
+            static void releaseStatus ( TrackableObject* status )
+            {
+               if ( status->release() ) delete status;
             }
 
-            void setTrackableObjs(std::vector<TrackableObject*>* trackableObjs) {
-                this->_trackableObjs = trackableObjs;
-            } 
+         public:
+            CRegionsIndex () : _numRegions( 0 ), _sweepThreshold( MinSweepThreshold ) {}
+
+            ~CRegionsIndex ()
+            {
+               clear();
+            }
+
+            size_t size () const
+            {
+               return _numRegions;
+            }
+
+            /*! \brief Returns the status of exactly this region, or NULL if it is not tracked.
+             */
+            TrackableObject* find ( const DepsRegion& target ) const
+            {
+               uintptr_t start = (uintptr_t) target.getAddress();
+               uintptr_t end = (uintptr_t) target.getEndAddress();
+               const Bucket &bucket = _buckets[sizeClass( end - start )];
+               std::pair< Bucket::const_iterator, Bucket::const_iterator > range = bucket.equal_range( start );
+               for ( Bucket::const_iterator it = range.first; it != range.second; ++it ) {
+                  if ( it->second.first == end ) return it->second.second;
+               }
+               return NULL;
+            }
+
+            /*! \brief Adds a region, which must not be already tracked, and its status.
+             */
+            void insert ( const DepsRegion& target, TrackableObject* status )
+            {
+               uintptr_t start = (uintptr_t) target.getAddress();
+               uintptr_t end = (uintptr_t) target.getEndAddress();
+               status->retain();
+               _buckets[sizeClass( end - start )].insert( std::make_pair( start, std::make_pair( end, status ) ) );
+               _numRegions++;
+            }
+
+            /*! \brief Removes the regions that no DependableObject is using any more.
+             *
+             *  Only submissions add readers or writers to a status, and they are serialized
+             *  with the sweep, so an empty status cannot be refilled while being swept.
+             *  Finished DependableObjects still pointing to it keep it alive until they go.
+             *  The sweep is amortized: it only runs once the index has grown past the
+             *  threshold, which is then set to twice the surviving regions.
+             */
+            void sweep ()
+            {
+               if ( _numRegions < _sweepThreshold ) return;
+               for ( int c = 0; c < NumClasses; c++ ) {
+                  Bucket &bucket = _buckets[c];
+                  for ( Bucket::iterator it = bucket.begin(); it != bucket.end(); ) {
+                     TrackableObject* status = it->second.second;
+                     if ( status->isEmpty() && !status->isOnHold() ) {
+                        bucket.erase( it++ );
+                        _numRegions--;
+                        releaseStatus( status );
+                     } else {
+                        ++it;
+                     }
+                  }
+               }
+               _sweepThreshold = std::max( 2 * _numRegions, (size_t) MinSweepThreshold );
+            }
+
+            /*! \brief Appends to result the status of every tracked region overlapping target, except exclude.
+             */
+            void findOverlapping ( const DepsRegion& target, TrackableObject* exclude, std::vector<TrackableObject*> &result ) const
+            {
+               uintptr_t start = (uintptr_t) target.getAddress();
+               uintptr_t end = (uintptr_t) target.getEndAddress();
+               for ( int c = 0; c < NumClasses; c++ ) {
+                  const Bucket &bucket = _buckets[c];
+                  if ( bucket.empty() ) continue;
+
+                  uintptr_t extent = maxExtent( c );
+                  Bucket::const_iterator it = bucket.lower_bound( start > extent ? start - extent : 0 );
+                  for ( ; it != bucket.end() && it->first <= end; ++it ) {
+                     if ( it->second.first >= start && it->second.second != exclude ) {
+                        result.push_back( it->second.second );
+                     }
+                  }
+               }
+            }
 
-          
+            /*! \brief Removes every region and drops the reference on their status.
+             */
+            void clear ()
+            {
+               if ( _numRegions == 0 ) return;
+               for ( int c = 0; c < NumClasses; c++ ) {
+                  for ( Bucket::iterator it = _buckets[c].begin(); it != _buckets[c].end(); ++it ) {
+                     releaseStatus( it->second.second );
+                  }
+                  _buckets[c].clear();
+               }
+               _numRegions = 0;
+               _sweepThreshold = MinSweepThreshold;
+            }
       };
 
       class CRegionsDependenciesDomain : public BaseDependenciesDomain
       {
          private:
-            typedef std::vector< std::pair < DepsRegion, TrackableObject*> > DepsVector; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, CRegionsPair* > DepsCacheMap; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, TrackableObject* > TrackablesMap; /**< Maps addresses to Trackable objects */
-            typedef std::map< DepsRegion, TrackableObject* > SizesMap; /**< Maps addresses to Trackable objects */
-
-         private:
-            DepsVector _addressDependencyVector; /**< Used to track dependencies between DependableObject */
-            DepsCacheMap _addressDependencyCache; /**< Used to track dependencies between DependableObject */
-            SizesMap _addressDependencySmall;
-            SizesMap _addressDependencyMid;
-            const size_t _sizeThresholdSmall;
-            const size_t _sizeThresholdMid;
+            CRegionsIndex _regions; /**< Used to track dependencies between DependableObject */
          private:
-            /*! \brief Looks for the dependency's address in the domain and returns the trackableObject associated.
-             *  \param dep Dependency to be checked.
+            /*! \brief Looks for the dependency's region in the domain and returns the trackableObjects associated.
+             *
+             *  The first element of result is the status of the exact region, created if needed,
+             *  followed by the status of every other tracked region overlapping it.
+             *  \param target Region to be checked.
+             *  \param result Vector where the TrackableObjects are appended.
              *  \sa Dependency TrackableObject
              */
             void lookupDependency ( const DepsRegion& target, std::vector<TrackableObject* > * result  )
             {
-               
-//               DepsMap::iterator it = _addressDependencyMap.find( target ); 
-//               if ( it == _addressDependencyMap.end() ) {
-//               } else {
-//                  status = it->second;
-//               }               unsigned int vectorIdx = 0;
-               unsigned int vectorIdx = 0;
-               
-               DepsCacheMap::iterator itCache = _addressDependencyCache.find( target ); 
-               std::vector<TrackableObject* > * objs;
-               unsigned int vectorEnd=_addressDependencyVector.size();
-               //If object not in cache, its new, initialize empty cache
-               //And address Maps
-               TrackableObject* currStatus = NULL;
-               bool hasToInsert=itCache == _addressDependencyCache.end();
-               if ( hasToInsert ) { 
-                   std::vector<TrackableObject*>* new_objs=NEW std::vector<TrackableObject*>();
-                   currStatus = NEW TrackableObject();
-                   new_objs->push_back(currStatus);
-                   if (target.getSize() > _sizeThresholdMid ) {
-                      _addressDependencyVector.push_back( std::make_pair( target, currStatus ) );
-                   }
-                   CRegionsPair* pair=NEW CRegionsPair(new_objs, 0);
-                   itCache=_addressDependencyCache.insert( std::make_pair( target, pair ) ).first;
-               }
-               CRegionsPair* cacheItem= itCache->second;
-               objs=cacheItem->getTrackableObjs();
-               vectorIdx=cacheItem->getItNum();
-               //Update cache position marker to the end of the vector
-               cacheItem->setItNum(_addressDependencyVector.size());
-               
-               //Search in dependency vector
-               for ( ; vectorIdx < vectorEnd ; ++vectorIdx ) {
-                   std::pair < DepsRegion, TrackableObject*> item=_addressDependencyVector.at(vectorIdx);
-                   if ( item.first.overlap(target) ) {
-                        objs->push_back(item.second); 
-                   } 
+               _regions.sweep();
+               TrackableObject* status = _regions.find( target );
+               if ( status == NULL ) {
+                  status = NEW TrackableObject();
+                  _regions.insert( target, status );
                }
-               (*result)=*objs;
-               //std::cout << _addressDependencyVector.size() << "," << target.getSize() << "\n";
-               
-               //return *objs;
-                if (target.getSize() <= _sizeThresholdSmall ) {
-                    if ( hasToInsert ){
-                       _addressDependencySmall.insert( std::make_pair( target, currStatus ) );
-                    }
-                }
-
-                if (target.getSize() > _sizeThresholdSmall && target.getSize() <= _sizeThresholdMid ) {
-                    if ( hasToInsert ){
-                       _addressDependencyMid.insert( std::make_pair( target, currStatus ) );
-                    }
-                }
-                
-                {
-                    
-                    //result contains the matches with the "big "arrays"
-                    //Now deal with the small ones
-                    //All the addresses starting lower than startAddr-threshold do not collide
-                    void* startAddress=(void*)(((uint64_t)target.getAddress())-(_sizeThresholdSmall+1));
-                    DepsRegion startAddr(startAddress,startAddress);
-                    //All the addresses starting higher than endAddr do not collide
-                    DepsRegion finalAddr(target.getEndAddress(),target.getEndAddress());
-                    SizesMap::iterator startingIter=_addressDependencySmall.lower_bound(startAddr);
-                    SizesMap::iterator endIter=_addressDependencySmall.upper_bound(finalAddr);
-                    for ( ; startingIter!=_addressDependencySmall.end() && startingIter != endIter; ++startingIter ) {
-                        if ( startingIter->first.overlap(target) ) {
-                             result->push_back(startingIter->second); 
-                        } 
-                    }
-                }
-
-                {
-                    //result contains the matches with the "small and big "arrays"
-                    //Now deal with the mid ones
-                    //All the addresses starting lower than startAddr-threshold do not collide
-                    void* startAddress=(void*)(((uint64_t)target.getAddress())-(_sizeThresholdMid+1));
-                    DepsRegion startAddr(startAddress,startAddress);
-                    //All the addresses starting higher than endAddr do not collide
-                    DepsRegion finalAddr(target.getEndAddress(),target.getEndAddress());
-                    SizesMap::iterator startingIter=_addressDependencyMid.lower_bound(startAddr);
-                    SizesMap::iterator endIter=_addressDependencyMid.upper_bound(finalAddr);
-                    for ( ; startingIter!=_addressDependencyMid.end() && startingIter != endIter; ++startingIter ) {
-                        if ( startingIter->first.overlap(target) ) {
-                             result->push_back(startingIter->second); 
-                        } 
-                    }
-                }
+               result->push_back( status );
+               _regions.findOverlapping( target, status, *result );
             }
-            /**
-             * Iterate over addresses... this method is rarely used
-             * @param target
-             * @return 
-             */
-            DepsVector::iterator findAddrInAddressDependencyMap( const DepsRegion& target ) {   
-               for ( DepsVector::iterator it = _addressDependencyVector.begin(); it != _addressDependencyVector.end(); ++it ) {
-                   if (it->first==target) return it;
-               }
-               return _addressDependencyVector.end();
+
+            //! \brief Clear current dependencies domain
+            //!
+            //! This function should be called withing a thread safe area. It is, when other
+            //! tasks can not update the domain: after a taskwait and before any task submission.
+            void clearDependenciesDomain ( void )
+            {
+               _regions.clear();
             }
             
          protected:
@@ -362,27 +384,9 @@ namespace nanos {
             }
 
          public: 
-            CRegionsDependenciesDomain() : BaseDependenciesDomain(), _addressDependencyVector(), _addressDependencyCache(),
-                    _addressDependencySmall(), _addressDependencyMid() ,_sizeThresholdSmall( 500 ),
-            _sizeThresholdMid( 200000 ){
-                _addressDependencyVector.reserve(5000);
-            }
-            CRegionsDependenciesDomain ( const CRegionsDependenciesDomain &depDomain )
-               : BaseDependenciesDomain( depDomain ),
-               _addressDependencyVector ( depDomain._addressDependencyVector ), _addressDependencyCache( depDomain._addressDependencyCache ),
-               _addressDependencySmall( depDomain._addressDependencySmall ), _addressDependencyMid( depDomain._addressDependencyMid ),
-               _sizeThresholdSmall ( depDomain._sizeThresholdSmall ),_sizeThresholdMid ( depDomain._sizeThresholdMid ) {}
-            
-            ~CRegionsDependenciesDomain()
-            {
-               for ( DepsCacheMap::iterator it = _addressDependencyCache.begin(); it != _addressDependencyCache.end(); it++ ) {
-                  delete it->second->getTrackableObjs();
-                  delete it->second;
-               }
-               for ( DepsVector::iterator it = _addressDependencyVector.begin(); it != _addressDependencyVector.end(); it++ ) {
-                  delete it->second;
-               }
-            }
+            CRegionsDependenciesDomain() : BaseDependenciesDomain(), _regions() {}
+
+            ~CRegionsDependenciesDomain() {}
             
             /*!
              *  \note This function cannot be implemented in
@@ -408,17 +412,13 @@ namespace nanos {
             {
                SyncRecursiveLockBlock lock1( getInstanceLock() );                
                DepsRegion address( addr, addr );
-               DepsVector::iterator it = findAddrInAddressDependencyMap( address );
-               if ( it == _addressDependencyVector.end() ) {
-                  return false;
-               } else {
-                  TrackableObject* status = it->second;
-                  DependableObject *lastWriter = status->getLastWriter();
-                  return (lastWriter != NULL);
+               std::vector<TrackableObject*> objs;
+               _regions.findOverlapping( address, NULL, objs );
+               for ( std::vector<TrackableObject*>::iterator it = objs.begin(); it != objs.end(); ++it ) {
+                  if ( (*it)->getLastWriter() != NULL ) return true;
                }
+               return false;
             }
-            
-         
       };
       
       template void CRegionsDependenciesDomain::submitDependableObjectInternal ( DependableObject &depObj, DataAccess* begin, DataAccess* end, SchedulePolicySuccessorFunctor* callback );
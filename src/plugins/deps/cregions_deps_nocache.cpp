@@ -95,6 +95,8 @@ namespace nanos {
                if ( itCache == _addressDependencyCache.end() ) { 
                    std::vector<TrackableObject*>* new_objs=NEW std::vector<TrackableObject*>();
                    TrackableObject* status = NEW TrackableObject();
+                   // The vector keeps a reference, the submitted targets hold the others
+                   status->retain();
                    _addressDependencyVector.push_back( std::make_pair( target, status ) );
                    new_objs->push_back(status);
                    CRegionsPair* pair=NEW CRegionsPair(new_objs, 0);
@@ -368,7 +370,7 @@ namespace nanos {
                   delete it->second;
                }
                for ( DepsVector::iterator it = _addressDependencyVector.begin(); it != _addressDependencyVector.end(); it++ ) {
-                  delete it->second;
+                  if ( it->second->release() ) delete it->second;
                }
             }
             
@@ -0,0 +1,497 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "basedependenciesdomain.hpp"
+#include "plugin.hpp"
+#include "system.hpp"
+#include "config.hpp"
+#include "depsregion.hpp"
+#include "trackableobject.hpp"
+#include "compatibility.hpp"
+#include <algorithm>
+#include <vector>
+#include <map>
+
+namespace nanos {
+   namespace ext {
+
+      /*! \brief Dependencies domain that tracks the accessed address ranges in an interval map
+       *
+       *  Every access is handled as the contiguous range [address, address+size) covering it. The
+       *  tracked ranges are kept disjoint: a new access splits the ranges it partially overlaps, so
+       *  each range has its own TrackableObject with plain dependencies semantics. Being disjoint,
+       *  an ordered map by first address is enough to answer overlap queries in O(log n + k), with
+       *  no need to augment the tree with the maximum end of each subtree. Ranges fully written by
+       *  a task are merged again to keep the map from fragmenting.
+       */
+      class IntervalDependenciesDomain : public BaseDependenciesDomain
+      {
+         private:
+            /*! \brief Tracked range of the address space
+             */
+            struct Interval {
+               uintptr_t         _last;      /**< Last address of the range (inclusive) */
+               TrackableObject  *_status;    /**< Status of the range */
+
+               Interval ( uintptr_t last, TrackableObject *status ) : _last( last ), _status( status ) {}
+            };
+
+            /*! \brief Access of the submitted DependableObject, once coalesced
+             */
+            struct Access {
+               uintptr_t         _first;     /**< First address of the access */
+               uintptr_t         _last;      /**< Last address of the access (inclusive) */
+               AccessType        _type;      /**< Kind of access */
+
+               Access ( uintptr_t first, uintptr_t last, AccessType const &type ) : _first( first ), _last( last ), _type( type ) {}
+            };
+
+            typedef std::map<uintptr_t, Interval> IntervalMap; /**< Maps the first address of each range to its status */
+            typedef std::vector<Access> AccessList;
+
+         private:
+            IntervalMap _intervals; /**< Used to track dependencies between DependableObject */
+
+         private:
+            /*! \brief Returns the first range ending at or after address
+             */
+            IntervalMap::iterator firstOverlapping ( uintptr_t address )
+            {
+               IntervalMap::iterator it = _intervals.upper_bound( address );
+               if ( it != _intervals.begin() ) {
+                  IntervalMap::iterator prev = it;
+                  --prev;
+                  if ( prev->second._last >= address ) return prev;
+               }
+               return it;
+            }
+
+            /*! \brief Splits a range so that a new one starts at address, returns the new range
+             *
+             *  The new range gets a copy of the status. Active reductions are finalized first, as
+             *  a CommutationDO can only be attached to one status.
+             */
+            IntervalMap::iterator split ( IntervalMap::iterator it, uintptr_t address )
+            {
+               TrackableObject &status = *it->second._status;
+               status.hold(); // Finalizing the reduction may try to remove the range
+               finalizeReduction( status, DepsRegion( (void *) it->first, (void *) it->second._last ) );
+               status.unhold();
+
+               TrackableObject *upper = NEW TrackableObject();
+               if ( status.getLastWriter() != NULL ) upper->setLastWriter( *status.getLastWriter() );
+               {
+                  SyncLockBlock lock( status.getReadersLock() );
+                  TrackableObject::DependableObjectList &readers = status.getReaders();
+                  for ( TrackableObject::DependableObjectList::iterator r = readers.begin(); r != readers.end(); r++ ) {
+                     upper->setReader( **r );
+                  }
+               }
+
+               Interval upperInterval( it->second._last, upper );
+               it->second._last = address - 1;
+               return _intervals.insert( it, std::make_pair( address, upperInterval ) );
+            }
+
+            /*! \brief Removes a range if it does not track anything, returns the next one
+             */
+            IntervalMap::iterator eraseIfEmpty ( IntervalMap::iterator it )
+            {
+               TrackableObject *status = it->second._status;
+               if ( status->isEmpty() && !status->isOnHold() ) {
+                  delete status;
+                  _intervals.erase( it++ );
+               } else {
+                  it++;
+               }
+               return it;
+            }
+
+            /*! \brief Returns whether two access types are equivalent
+             */
+            static bool sameAccessType ( AccessType const &a, AccessType const &b )
+            {
+               return a.input == b.input && a.output == b.output && a.can_rename == b.can_rename &&
+                      a.concurrent == b.concurrent && a.commutative == b.commutative;
+            }
+
+            /*! \brief Converts the accesses of a DependableObject into a sorted list of disjoint ranges
+             *
+             *  Overlapping accesses of the same object are combined, so that the object never depends
+             *  on itself and the map can be updated in a single ordered pass.
+             */
+            template<typename iterator>
+            void coalesceAccesses ( iterator begin, iterator end, AccessList &accesses )
+            {
+               AccessList raw;
+               std::vector<uintptr_t> bounds;
+
+               for ( iterator it = begin; it != end; it++ ) {
+                  DataAccess const &dep = *it;
+
+                  // if address == NULL, just ignore it
+                  if ( dep.getDepAddress() == NULL ) continue;
+
+                  size_t size = dep.getSize();
+                  uintptr_t first = (uintptr_t) dep.getDepAddress();
+                  uintptr_t last = first + ( size > 0 ? size - 1 : 0 );
+
+                  raw.push_back( Access( first, last, AccessType( dep.flags ) ) );
+                  bounds.push_back( first );
+                  bounds.push_back( last + 1 );
+               }
+
+               if ( raw.size() <= 1 ) {
+                  accesses.swap( raw );
+                  return;
+               }
+
+               std::sort( bounds.begin(), bounds.end() );
+               bounds.erase( std::unique( bounds.begin(), bounds.end() ), bounds.end() );
+
+               for ( size_t i = 0; i + 1 < bounds.size(); i++ ) {
+                  uintptr_t first = bounds[i];
+                  uintptr_t last = bounds[i+1] - 1;
+
+                  AccessType type;
+                  bool covered = false;
+                  for ( AccessList::iterator r = raw.begin(); r != raw.end(); r++ ) {
+                     if ( r->_first <= first && r->_last >= last ) {
+                        type |= r->_type;
+                        covered = true;
+                     }
+                  }
+                  if ( !covered ) continue;
+
+                  if ( !accesses.empty() && accesses.back()._last + 1 == first && sameAccessType( accesses.back()._type, type ) ) {
+                     accesses.back()._last = last;
+                  } else {
+                     accesses.push_back( Access( first, last, type ) );
+                  }
+               }
+            }
+
+            /*! \brief Adds the access of a DependableObject to a single range, with plain dependencies semantics
+             */
+            void submitIntervalDataAccess ( DependableObject &depObj, IntervalMap::iterator it, AccessType const &accessType,
+                                            SchedulePolicySuccessorFunctor* callback )
+            {
+               DepsRegion target( (void *) it->first, (void *) it->second._last );
+               TrackableObject &status = *it->second._status;
+
+               if ( accessType.concurrent || accessType.commutative ) {
+                  submitDependableObjectCommutativeDataAccess( depObj, target, accessType, status, callback );
+               } else if ( accessType.input && accessType.output ) {
+                  submitDependableObjectInoutDataAccess( depObj, target, accessType, status, callback );
+               } else if ( accessType.input ) {
+                  submitDependableObjectInputDataAccess( depObj, target, accessType, status, callback );
+               } else if ( accessType.output ) {
+                  submitDependableObjectOutputDataAccess( depObj, target, accessType, status, callback );
+               } else {
+                  fatal( "Invalid data access" );
+               }
+            }
+
+         protected:
+            /*! \brief Assigns the DependableObject depObj an id in this domain and adds it to the domains dependency system.
+             *  \param depObj DependableObject to be added to the domain.
+             *  \param begin Iterator to the start of the list of dependencies to be associated to the Dependable Object.
+             *  \param end Iterator to the end of the mentioned list.
+             *  \param callback A function to call when a WD has a successor [Optional].
+             *  \sa Dependency DependableObject TrackableObject
+             */
+            template<typename const_iterator>
+            void submitDependableObjectInternal ( DependableObject &depObj, const_iterator begin, const_iterator end, SchedulePolicySuccessorFunctor* callback )
+            {
+               depObj.setId ( _lastDepObjId++ );
+               depObj.init();
+               depObj.setDependenciesDomain( this );
+
+               // Object is not ready to get its dependencies satisfied
+               // so we increase the number of predecessors to permit other dependableObjects to free some of
+               // its dependencies without triggering the "dependenciesSatisfied" method
+               depObj.increasePredecessors();
+
+               AccessList accesses;
+               coalesceAccesses( begin, end, accesses );
+
+               // This list is needed for waiting
+               std::list<uint64_t> flushDeps;
+
+               {
+                  // All the accesses are resolved at once, in address order
+                  SyncRecursiveLockBlock lock1( getInstanceLock() );
+                  for ( AccessList::iterator it = accesses.begin(); it != accesses.end(); it++ ) {
+                     submitDependableObjectDataAccess( depObj, *it, callback );
+                     flushDeps.push_back( (uint64_t) it->_first );
+                  }
+               }
+
+               sys.getDefaultSchedulePolicy()->atCreate( depObj );
+
+               // To keep the count consistent we have to increase the number of tasks in the graph before releasing the fake dependency
+               increaseTasksInGraph();
+
+               depObj.submitted();
+
+               // now everything is ready
+               depObj.decreasePredecessors( &flushDeps, NULL, false, true );
+            }
+
+            /*! \brief Adds a range access of a DependableObject to the domains dependency system.
+             *  \param depObj target DependableObject
+             *  \param access accessed range and kind of access
+             *  \param callback Function to call if an immediate predecessor is found.
+             */
+            void submitDependableObjectDataAccess( DependableObject &depObj, Access const &access, SchedulePolicySuccessorFunctor* callback )
+            {
+               AccessType const &accessType = access._type;
+
+               if ( accessType.concurrent || accessType.commutative ) {
+                  if ( !( accessType.input && accessType.output ) || depObj.waits() ) {
+                     fatal( "Commutation/concurrent task must be inout" );
+                  }
+               }
+
+               if ( accessType.concurrent && accessType.commutative ) {
+                  fatal( "Task cannot be concurrent AND commutative" );
+               }
+
+               bool write = accessType.output && !accessType.concurrent && !accessType.commutative && !depObj.waits();
+
+               // Make the ranges match the access bounds, filling the gaps with new ones
+               IntervalMap::iterator it = firstOverlapping( access._first );
+               if ( it != _intervals.end() && it->first < access._first ) it = split( it, access._first );
+
+               IntervalMap::iterator firstInterval = _intervals.end();
+               uintptr_t cursor = access._first;
+               while ( true ) {
+                  if ( it == _intervals.end() || it->first > cursor ) {
+                     uintptr_t last = ( it == _intervals.end() || it->first > access._last ) ? access._last : it->first - 1;
+                     it = _intervals.insert( it, std::make_pair( cursor, Interval( last, NEW TrackableObject() ) ) );
+                  } else if ( it->second._last > access._last ) {
+                     split( it, access._last + 1 );
+                  }
+                  if ( firstInterval == _intervals.end() ) firstInterval = it;
+
+                  TrackableObject &status = *it->second._status;
+                  status.hold(); // This is necessary since we may trigger a removal in finalizeReduction
+                  if ( write ) {
+                     // The write target is set once for the whole access, see below
+                     DepsRegion target( (void *) it->first, (void *) it->second._last );
+                     finalizeReduction( status, target );
+                     if ( accessType.input || !status.hasReaders() ) {
+                        dependOnLastWriter( depObj, status, target, callback, accessType );
+                     }
+                     dependOnReaders( depObj, status, target, callback, accessType );
+                  } else {
+                     submitIntervalDataAccess( depObj, it, accessType, callback );
+                  }
+                  status.unhold();
+
+                  if ( it->second._last == access._last ) break;
+                  cursor = it->second._last + 1;
+                  it++;
+               }
+
+               DepsRegion target( (void *) access._first, (void *) access._last );
+               if ( write ) {
+                  // All the ranges now have the same status: merge them into the first one.
+                  // The readers of the merged ranges are unlisted as setAsWriter does for the first
+                  IntervalMap::iterator next = firstInterval;
+                  for ( ++next; next != _intervals.end() && next->first <= access._last; ) {
+                     TrackableObject *status = next->second._status;
+                     ensure( status->getCommDO() == NULL, "Merging a range with a pending commutation" );
+                     {
+                        SyncLockBlock lock2( status->getReadersLock() );
+                        status->flushReaders();
+                     }
+                     delete status;
+                     _intervals.erase( next++ );
+                  }
+                  firstInterval->second._last = access._last;
+                  setAsWriter( depObj, *firstInterval->second._status, target );
+               } else if ( depObj.waits() ) {
+                  // Waiting objects are not tracked, remove the ranges created for them
+                  for ( it = firstInterval; it != _intervals.end() && it->first <= access._last; ) {
+                     it = eraseIfEmpty( it );
+                  }
+               } else if ( accessType.input && !accessType.output ) {
+                  depObj.addReadTarget( target );
+               }
+            }
+
+            void deleteLastWriter ( DependableObject &depObj, BaseDependency const &target )
+            {
+               const DepsRegion& region( static_cast<const DepsRegion&>( target ) );
+               uintptr_t last = (uintptr_t) region.getEndAddress();
+
+               SyncRecursiveLockBlock lock1( getInstanceLock() );
+               IntervalMap::iterator it = firstOverlapping( (uintptr_t) region.getAddress() );
+               while ( it != _intervals.end() && it->first <= last ) {
+                  it->second._status->deleteLastWriter( depObj );
+                  it = eraseIfEmpty( it );
+               }
+            }
+
+            void deleteReader ( DependableObject &depObj, BaseDependency const &target )
+            {
+               const DepsRegion& region( static_cast<const DepsRegion&>( target ) );
+               uintptr_t last = (uintptr_t) region.getEndAddress();
+
+               SyncRecursiveLockBlock lock1( getInstanceLock() );
+               IntervalMap::iterator it = firstOverlapping( (uintptr_t) region.getAddress() );
+               while ( it != _intervals.end() && it->first <= last ) {
+                  TrackableObject &status = *it->second._status;
+                  {
+                     SyncLockBlock lock2( status.getReadersLock() );
+                     status.deleteReader( depObj );
+                  }
+                  it = eraseIfEmpty( it );
+               }
+            }
+
+            void removeCommDO ( CommutationDO *commDO, BaseDependency const &target )
+            {
+               const DepsRegion& region( static_cast<const DepsRegion&>( target ) );
+               uintptr_t last = (uintptr_t) region.getEndAddress();
+
+               SyncRecursiveLockBlock lock1( getInstanceLock() );
+               IntervalMap::iterator it = firstOverlapping( (uintptr_t) region.getAddress() );
+               while ( it != _intervals.end() && it->first <= last ) {
+                  TrackableObject &status = *it->second._status;
+                  if ( status.getCommDO() == commDO ) {
+                     status.setCommDO( 0 );
+                  }
+                  it = eraseIfEmpty( it );
+               }
+            }
+
+            //! \brief Clear current dependencies domain
+            //!
+            //! This function should be called withing a thread safe area. It is, when other
+            //! tasks can not update the domain: after a taskwait and before any task submission.
+            void clearDependenciesDomain ( void )
+            {
+               for ( IntervalMap::iterator it = _intervals.begin(); it != _intervals.end(); it++ ) {
+                  delete it->second._status;
+               }
+               _intervals.clear();
+            }
+
+         public:
+            IntervalDependenciesDomain() : BaseDependenciesDomain(), _intervals() {}
+
+            ~IntervalDependenciesDomain()
+            {
+               clearDependenciesDomain();
+            }
+
+            /*!
+             *  \note This function cannot be implemented in
+             *  BaseDependenciesDomain since it calls a template function,
+             *  and they cannot be virtual.
+             */
+            inline void submitDependableObject ( DependableObject &depObj, std::vector<DataAccess> &deps, SchedulePolicySuccessorFunctor* callback )
+            {
+               submitDependableObjectInternal ( depObj, deps.begin(), deps.end(), callback );
+            }
+
+            /*!
+             *  \note This function cannot be implemented in
+             *  BaseDependenciesDomain since it calls a template function,
+             *  and they cannot be virtual.
+             */
+            inline void submitDependableObject ( DependableObject &depObj, size_t numDeps, DataAccess* deps, SchedulePolicySuccessorFunctor* callback )
+            {
+               submitDependableObjectInternal ( depObj, deps, deps+numDeps, callback );
+            }
+
+            bool haveDependencePendantWrites ( void *addr )
+            {
+               SyncRecursiveLockBlock lock1( getInstanceLock() );
+               IntervalMap::iterator it = firstOverlapping( (uintptr_t) addr );
+               return it != _intervals.end() && it->first <= (uintptr_t) addr && it->second._status->getLastWriter() != NULL;
+            }
+
+            void finalizeAllReductions ( void )
+            {
+               SyncRecursiveLockBlock lock1( getInstanceLock() );
+
+               // Finalizing a reduction may release tasks that update the map, so
+               // the ranges are looked up again before finalizing each one
+               std::vector<uintptr_t> reductions;
+               for ( IntervalMap::iterator it = _intervals.begin(); it != _intervals.end(); it++ ) {
+                  if ( it->second._status->getCommDO() != NULL ) reductions.push_back( it->first );
+               }
+
+               for ( std::vector<uintptr_t>::iterator r = reductions.begin(); r != reductions.end(); r++ ) {
+                  IntervalMap::iterator it = _intervals.find( *r );
+                  if ( it == _intervals.end() ) continue;
+
+                  TrackableObject &status = *it->second._status;
+                  status.hold();
+                  finalizeReduction( status, DepsRegion( (void *) it->first, (void *) it->second._last ) );
+                  status.unhold();
+                  eraseIfEmpty( it );
+               }
+            }
+      };
+
+      template void IntervalDependenciesDomain::submitDependableObjectInternal ( DependableObject &depObj, DataAccess* begin, DataAccess* end, SchedulePolicySuccessorFunctor* callback );
+      template void IntervalDependenciesDomain::submitDependableObjectInternal ( DependableObject &depObj, std::vector<DataAccess>::iterator begin, std::vector<DataAccess>::iterator end, SchedulePolicySuccessorFunctor* callback );
+
+      /*! \brief Default plugin implementation.
+       */
+      class IntervalDependenciesManager : public DependenciesManager
+      {
+         public:
+            IntervalDependenciesManager() : DependenciesManager("Nanos intervals dependencies domain") {}
+            virtual ~IntervalDependenciesManager () {}
+
+            /*! \brief Creates a default dependencies domain.
+             */
+            DependenciesDomain* createDependenciesDomain () const
+            {
+               return NEW IntervalDependenciesDomain();
+            }
+      };
+
+      class IntervalDepsPlugin : public Plugin
+      {
+
+         public:
+            IntervalDepsPlugin() : Plugin( "Nanos++ interval map dependency management plugin",1 )
+            {
+            }
+
+            virtual void config ( Config &cfg )
+            {
+            }
+
+            virtual void init()
+            {
+               sys.setDependenciesManager(NEW IntervalDependenciesManager());
+            }
+      };
+
+   }
+}
+
+DECLARE_PLUGIN("deps-intervals",nanos::ext::IntervalDepsPlugin);
@@ -23,15 +23,23 @@
 #include "config.hpp"
 #include "address.hpp"
 #include "compatibility.hpp"
+#include "shardedhashmap.hpp"
 
 namespace nanos {
    namespace ext {
 
+      /*! \brief Dependencies domain tracking accesses by their base address
+       *
+       *  Several threads may submit objects to the domain at the same time: the addresses are
+       *  kept in a ShardedHashMap and ids are atomic. Submissions that access the same address
+       *  must not overlap though, the dependences between them would have no defined order and
+       *  the per-address paths below assume that no other submitter changes the address.
+       */
       class PlainDependenciesDomain : public BaseDependenciesDomain
       {
          private:
-            typedef TR1::unordered_map<Address::TargetType, TrackableObject*> DepsMap; /**< Maps addresses to Trackable objects */
-            
+            typedef ShardedHashMap<Address::TargetType, TrackableObject> DepsMap; /**< Maps addresses to Trackable objects */
+
          private:
             DepsMap _addressDependencyMap; /**< Used to track dependencies between DependableObject */
          private:
@@ -46,27 +54,20 @@ namespace nanos {
             }
 
             //! \brief Looks for the dependency's address, returns the trackableObject associated
+            //!
+            //! The trackableObject is created if needed and it is kept in the map, even if it
+            //! becomes empty, until releaseDependency is called.
             //! \param dep Dependency to be checked.
             //! \sa Dependency TrackableObject
             TrackableObject* lookupDependency ( const Address& target )
             {
-               TrackableObject* status = NULL;
-               
-               DepsMap::iterator it = _addressDependencyMap.find( target() ); 
+               return _addressDependencyMap.acquire( target() );
+            }
 
-               if ( it == _addressDependencyMap.end() ) {
-                   status = NEW TrackableObject();
-                   {
-                      // Lock this so we avoid problems when concurrently calling deleteLastWriter
-                      // due this function will also chase also the map
-                      SyncRecursiveLockBlock lock1( getInstanceLock() );
-                      _addressDependencyMap.insert( std::make_pair( target(), status ) );
-                   }
-               } else {
-                  status = it->second;
-               }
-               
-               return status;
+            //! \brief Releases a trackableObject got from lookupDependency, removing it if empty
+            void releaseDependency ( const Address& target )
+            {
+               _addressDependencyMap.release( target() );
             }
          protected:
             //! \brief Assigns the DependableObject depObj an id in this domain and adds it to the domains dependency system.
@@ -89,8 +90,10 @@ namespace nanos {
                // its dependencies without triggering the "dependenciesSatisfied" method.
                depObj.increasePredecessors();
             
-               // flushDeps will be needed for waiting (see decreasePredecessors)
+               // flushDeps will be needed for waiting (see decreasePredecessors), other objects
+               // do not need to build it
                std::list<uint64_t> flushDeps;
+               bool waits = depObj.waits();
 
                // Iterate from begin to end, just to handle each data access
                for ( iterator it = begin; it != end; it++ ) {
@@ -102,7 +105,7 @@ namespace nanos {
                   AccessType const &accessType = dep.flags;
 
                   submitDependableObjectDataAccess( depObj, target, accessType, callback );
-                  flushDeps.push_back( (uint64_t) target() );
+                  if ( waits ) flushDeps.push_back( (uint64_t) target() );
                }
                
                // Calling scheduler policy "atCreate"
@@ -130,7 +133,16 @@ namespace nanos {
 
                TrackableObject &status = *lookupDependency( target );
 
-               if ( status.getLastWriter() == &depObj ) return;
+               if ( status.getLastWriter() == &depObj ) {
+                  releaseDependency( target );
+                  return;
+               }
+
+               if ( !accessType.concurrent && !accessType.commutative && !depObj.waits() &&
+                    submitDependableObjectFreshDataAccess( depObj, target, accessType, status ) ) {
+                  releaseDependency( target );
+                  return;
+               }
 
                if ( accessType.concurrent || accessType.commutative ) {
                   ensure(accessType.input && accessType.output,"Commutative & concurrent must be inout");
@@ -152,18 +164,46 @@ namespace nanos {
                   fatal( "Invalid data access" );
                }
 
+               releaseDependency( target );
             }
             
+            //! \brief Records an access to a target without live conflicting accessors.
+            //!
+            //! When the target has no last writer nor pending commutation, and no readers if it is
+            //! written, depObj has nothing to depend on: the access is recorded for later objects
+            //! without looking for predecessors. The target is checked again and the access is
+            //! recorded under the readers lock, so two fast path submitters never both see it free;
+            //! finishing objects only remove accessors. Other submitters of the same address are
+            //! not expected meanwhile (see PlainDependenciesDomain).
+            //! \return false, having done nothing, if the full submission path is needed.
+            bool submitDependableObjectFreshDataAccess( DependableObject &depObj, Address const &target,
+                                                        AccessType const &accessType, TrackableObject &status )
+            {
+               if ( !accessType.input && !accessType.output ) return false;
+               if ( status.getLastWriter() != NULL || status.getCommDO() != NULL ) return false;
+
+               SyncLockBlock lock( status.getReadersLock() );
+               if ( status.getLastWriter() != NULL || status.getCommDO() != NULL ) return false;
+
+               if ( accessType.output ) {
+                  if ( status.hasReaders() ) return false;
+                  depObj.addWriteTarget( target );
+                  status.setLastWriter( depObj );
+                  if ( accessType.input ) depObj.addReadTarget( target );
+               } else {
+                  status.setReader( depObj );
+                  depObj.addReadTarget( target );
+               }
+               return true;
+            }
+
             inline void deleteLastWriter ( DependableObject &depObj, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
+               DepsMap::Accessor status( _addressDependencyMap, address() );
                
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  status.deleteLastWriter(depObj);
+               if ( status.found() ) {
+                  status->deleteLastWriter(depObj);
                }
             }
             
@@ -171,30 +211,22 @@ namespace nanos {
             inline void deleteReader ( DependableObject &depObj, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
+               DepsMap::Accessor status( _addressDependencyMap, address() );
                
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  {
-                     SyncLockBlock lock2( status.getReadersLock() );
-                     status.deleteReader(depObj);
-                  }
+               if ( status.found() ) {
+                  SyncLockBlock lock2( status->getReadersLock() );
+                  status->deleteReader(depObj);
                }
             }
             
             inline void removeCommDO ( CommutationDO *commDO, BaseDependency const &target )
             {
                const Address& address( static_cast<const Address&>( target ) );
-               SyncRecursiveLockBlock lock1( getInstanceLock() );
-               DepsMap::iterator it = _addressDependencyMap.find( address() );
+               DepsMap::Accessor status( _addressDependencyMap, address() );
                
-               if ( it != _addressDependencyMap.end() ) {
-                  TrackableObject &status = *it->second;
-                  
-                  if ( status.getCommDO ( ) == commDO ) {
-                     status.setCommDO ( 0 );
+               if ( status.found() ) {
+                  if ( status->getCommDO ( ) == commDO ) {
+                     status->setCommDO ( 0 );
                   }
                }
             }
@@ -205,12 +237,7 @@ namespace nanos {
                : BaseDependenciesDomain( depDomain ),
                _addressDependencyMap ( depDomain._addressDependencyMap ) {}
             
-            ~PlainDependenciesDomain()
-            {
-               for ( DepsMap::iterator it = _addressDependencyMap.begin(); it != _addressDependencyMap.end(); it++ ) {
-                  delete it->second;
-               }
-            }
+            ~PlainDependenciesDomain() {}
             
             /*!
              *  \note This function cannot be implemented in
@@ -234,19 +261,17 @@ namespace nanos {
 
             bool haveDependencePendantWrites ( void *addr )
             {
-               DepsMap::iterator it = _addressDependencyMap.find( addr ); 
-               if ( it == _addressDependencyMap.end() ) {
-                  return false;
-               } else {
-                  TrackableObject* status = it->second;
-                  DependableObject *lastWriter = status->getLastWriter();
-                  return (lastWriter != NULL);
-               }
+               DepsMap::Accessor status( _addressDependencyMap, addr );
+               return status.found() && status->getLastWriter() != NULL;
             }
             void finalizeAllReductions ( void )
             {
-               DepsMap::iterator it; 
-               for ( it = _addressDependencyMap.begin(); it != _addressDependencyMap.end(); it++ ) {
+               // Entries are pinned so that no shard is locked while the reductions
+               // are finalized, as this may release tasks that access the map
+               DepsMap::EntryList entries;
+               _addressDependencyMap.acquireAll( entries );
+
+               for ( DepsMap::EntryList::iterator it = entries.begin(); it != entries.end(); it++ ) {
                   TrackableObject& status = *( it->second );
                   Address::TargetType target = it->first;
                   CommutationDO *commDO = status.getCommDO();
@@ -266,6 +291,7 @@ namespace nanos {
                      std::list<uint64_t> flushDeps;
                      commDO->decreasePredecessors( &flushDeps, NULL, false, false ); 
                   }
+                  _addressDependencyMap.release( target );
                }
             }
       };
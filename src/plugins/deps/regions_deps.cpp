@@ -156,10 +156,12 @@ namespace nanos {
                typedef RegionMap::iterator_list_t subregion_set_t;
                subregion_set_t subregions;
                RegionMap::iterator wholeRegion = _regionMap.findExactAndMatching( target, /* out */subregions );
+               bool addedRegion = false;
                if ( !wholeRegion.isEmpty() ) {
                   subregions.push_back(wholeRegion);
                } else {
                   wholeRegion = _regionMap.addOverlapping( target );
+                  addedRegion = true;
                }
                
                for (
@@ -201,6 +203,11 @@ namespace nanos {
                   }
                }
                
+               // Accesses that only wait do not stay in the region they added
+               if ( addedRegion && (*wholeRegion).isEmpty() ) {
+                  wholeRegion.erase();
+               }
+               
                if ( !depObj.waits() && !accessType.concurrent && !accessType.commutative ) {
                   if ( accessType.output ) {
                      depObj.addWriteTarget( target );
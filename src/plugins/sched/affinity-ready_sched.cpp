@@ -181,9 +181,11 @@ namespace nanos {
 #endif
 
                public:
-                  SchedQueuesWDPQ( int memSpaces ) : SchedQueues(), _globalReadyQueue( /* optimise option */ true )
+                  SchedQueuesWDPQ( int memSpaces, WDPQ::ContainerType container ) : SchedQueues(), _globalReadyQueue( /* optimise option */ true )
                   {
+                     _globalReadyQueue.setContainer( container );
                      _readyQueues = NEW WDPriorityQueue<>[memSpaces];
+                     for ( int i = 0; i < memSpaces; i++ ) _readyQueues[i].setContainer( container );
 
 #ifdef EXTRA_QUEUE_DEBUG
                      _pes = NEW PE*[memSpaces];
@@ -301,7 +303,7 @@ namespace nanos {
                   // +1 to count the host memory space as well
                   _numMemSpaces = sys.getSeparateMemoryAddressSpacesCount() + 1;
 
-                  if ( _usePriority ) _queues = NEW SchedQueuesWDPQ( _numMemSpaces );
+                  if ( _usePriority ) _queues = NEW SchedQueuesWDPQ( _numMemSpaces, _priorityContainer );
                   else _queues = NEW SchedQueuesWDQ( _numMemSpaces );
 
                   if ( _numMemSpaces > 1 ) {
@@ -455,6 +457,7 @@ namespace nanos {
             // -1 means no depth limit
             //  0 means no propagation
             static int _priorityPropagation;
+            static WDPQ::ContainerType _priorityContainer;
 
             static bool _noSteal;
             static bool _noInvalAware;
@@ -728,7 +731,7 @@ namespace nanos {
                DependableObject::DependableObjectVector & predecessors = successor.getPredecessors();
                for ( DependableObject::DependableObjectVector::iterator it = predecessors.begin();
                      it != predecessors.end(); it++ ) {
-                  DependableObject * obj = it->second;
+                  DependableObject * obj = *it;
                   WD * pred = ( WD * ) obj->getRelatedObject();
                   if ( pred == NULL ) continue;
 
@@ -963,6 +966,7 @@ namespace nanos {
 
       bool ReadyCacheSchedPolicy::_usePriority = true;
       int ReadyCacheSchedPolicy::_priorityPropagation = 5;
+      WDPQ::ContainerType ReadyCacheSchedPolicy::_priorityContainer = WDPQ::SORTED_LIST;
       bool ReadyCacheSchedPolicy::_noSteal = false;
       bool ReadyCacheSchedPolicy::_noInvalAware = false;
       bool ReadyCacheSchedPolicy::_affinityInout = false;
@@ -984,6 +988,8 @@ namespace nanos {
                cfg.registerConfigOption ( "affinity-priority-depth", NEW Config::IntegerVar( ReadyCacheSchedPolicy::_priorityPropagation ), "Number of levels to propagate priority upwards in the task graph (0 = no propagation, -1 = no depth limit)");
                cfg.registerArgOption( "affinity-priority-depth", "affinity-priority-depth" );
 
+               WDPQ::registerContainerOption( cfg, ReadyCacheSchedPolicy::_priorityContainer );
+
                cfg.registerConfigOption ( "affinity-no-steal", NEW Config::FlagOption( ReadyCacheSchedPolicy::_noSteal ), "Steal tasks from other threads");
                cfg.registerArgOption( "affinity-no-steal", "affinity-no-steal" );
 
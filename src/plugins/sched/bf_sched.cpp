@@ -35,7 +35,11 @@ namespace nanos {
 
               TeamData () : ScheduleTeamData(), _readyQueue( NULL )
               {
-                if ( _usePriority || _useSmartPriority ) _readyQueue = NEW WDPriorityQueue<>( true /* enableDeviceCounter */, true /* optimise option */ );
+                if ( _usePriority || _useSmartPriority ) {
+                   WDPriorityQueue<> *pq = NEW WDPriorityQueue<>( true /* enableDeviceCounter */, true /* optimise option */ );
+                   pq->setContainer( _priorityContainer );
+                   _readyQueue = pq;
+                }
                 else _readyQueue = NEW WDDeque( true /* enableDeviceCounter */ );
               }
               ~TeamData () { delete _readyQueue; }
@@ -45,6 +49,7 @@ namespace nanos {
            static bool       _useStack;
            static bool       _usePriority;
            static bool       _useSmartPriority;
+           static WDPQ::ContainerType _priorityContainer;
 
            BreadthFirst() : SchedulePolicy("Breadth First")
            {
@@ -230,6 +235,7 @@ namespace nanos {
       bool BreadthFirst::_useStack = false;
       bool BreadthFirst::_usePriority = true;
       bool BreadthFirst::_useSmartPriority = false;
+      WDPQ::ContainerType BreadthFirst::_priorityContainer = WDPQ::SORTED_LIST;
 
       class BFSchedPlugin : public Plugin
       {
@@ -252,6 +258,8 @@ namespace nanos {
                cfg.registerConfigOption ( "schedule-smart-priority", NEW Config::FlagOption( BreadthFirst::_useSmartPriority ), "Smart priority queue propagates high priorities to predecessors");
                cfg.registerArgOption( "schedule-smart-priority", "schedule-smart-priority" );
 
+               WDPQ::registerContainerOption( cfg, BreadthFirst::_priorityContainer );
+
             }
 
             virtual void init() {
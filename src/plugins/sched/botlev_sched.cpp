@@ -42,6 +42,7 @@ namespace nanos {
             static int   hpTo;
             static int   hpSingle;
             static int   steal;
+            static WDPQ::ContainerType priorityContainer;
             static int   maxBL;
             static int   strict;
             static int   taskNumber;
@@ -55,6 +56,7 @@ namespace nanos {
       int BotLevCfg::hpTo = 0;
       int BotLevCfg::hpSingle = 0;
       int BotLevCfg::steal = 0;
+      WDPQ::ContainerType BotLevCfg::priorityContainer = WDPQ::SORTED_LIST;
       int BotLevCfg::maxBL = 1;
       int BotLevCfg::strict = 0;
       int BotLevCfg::taskNumber = 0;
@@ -115,7 +117,7 @@ namespace nanos {
          public:
             using SchedulePolicy::queue;
             typedef std::stack<BotLevDOData *>   bot_lev_dos_t;
-            typedef std::set<std::pair< unsigned int, DependableObject * > > DepObjVector; /**< Type vector of successors  */
+            typedef DependableObject::DependableObjectVector DepObjVector; /**< Type vector of successors  */
 
          private:
             bot_lev_dos_t     _blStack;       //! tasks added, pending having their bottom level updated
@@ -132,6 +134,7 @@ namespace nanos {
                TeamData () : ScheduleTeamData()
                {
                   _readyQueues = NEW WDPriorityQueue<>[3];
+                  for ( int i = 0; i < 3; i++ ) _readyQueues[i].setContainer( BotLevCfg::priorityContainer );
                }
                virtual ~TeamData () { delete[] _readyQueues; }
             };
@@ -246,7 +249,7 @@ namespace nanos {
                    qId = 1;
                    NANOS_INSTRUMENT ( criticality = 1; )
                 }
-                else if( ((_topSuccesors.find( std::make_pair( wd.getId(), dos ) )) != (_topSuccesors.end()))
+                else if( ((_topSuccesors.find( dos )) != (_topSuccesors.end()))
                          && wd.getPriority() >= _currMax-1 ) {
                    //The task is critical
                    {
@@ -361,7 +364,7 @@ namespace nanos {
                   predecessors = depObj.getPredecessors();
                }
                for ( DepObjVector::iterator it = predecessors.begin(); it != predecessors.end(); it++ ) {
-                  DependableObject *pred = it->second;
+                  DependableObject *pred = *it;
                   if (pred) {
                      BotLevDOData *predObj = (BotLevDOData *)pred->getSchedulerData();
                      if (predObj) {
@@ -558,6 +561,8 @@ namespace nanos {
                 config_.registerConfigOption ( "steal", new Config::IntegerVar( BotLevCfg::steal ), "Defines if we use bi-directional work stealing fast <--> slow" );
                 config_.registerArgOption ( "steal", "steal" );
                 config_.registerEnvOption ( "steal", "NX_STEALB" );
+
+                WDPQ::registerContainerOption( config_, BotLevCfg::priorityContainer );
             }
 
             virtual void init() {
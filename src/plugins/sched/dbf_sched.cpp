@@ -20,6 +20,7 @@
 #include "schedule.hpp"
 #include "wddeque.hpp"
 #include "plugin.hpp"
+#include "stealorder.hpp"
 #include "system.hpp"
 
 namespace nanos {
@@ -31,6 +32,8 @@ namespace nanos {
             using SchedulePolicy::queue;
             static bool       _usePriority;
             static bool       _useSmartPriority;
+            static WDPQ::ContainerType _priorityContainer;
+            static int        _batchChunk;
          private:
             /** \brief DistributedBF Scheduler data associated to each thread
               *
@@ -39,15 +42,30 @@ namespace nanos {
             {
                /*! queue of ready tasks to be executed */
                WDPool *_readyQueue;
+               /*! order in which the other queues are robbed */
+               StealOrder _stealOrder;
 
-               ThreadData () : ScheduleThreadData(), _readyQueue( NULL )
+               ThreadData () : ScheduleThreadData(), _readyQueue( NULL ), _stealOrder()
                {
-                 if ( _usePriority || _useSmartPriority ) _readyQueue = NEW WDPriorityQueue<>( true /* enableDeviceCounter */, true /* optimise option */ );
+                 if ( _usePriority || _useSmartPriority ) {
+                    WDPriorityQueue<> *pq = NEW WDPriorityQueue<>( true /* enableDeviceCounter */, true /* optimise option */ );
+                    pq->setContainer( _priorityContainer );
+                    _readyQueue = pq;
+                 }
                  else _readyQueue = NEW WDDeque( true /* enableDeviceCounter */ );
                }
                virtual ~ThreadData () { delete _readyQueue; }
             };
 
+            /*! \brief Steals the last WD of the queue of a victim */
+            struct StealLast
+            {
+               WD * operator() ( BaseThread *thread, BaseThread &victim )
+               {
+                  return ( ( ThreadData & ) *victim.getTeamData()->getScheduleData() )._readyQueue->pop_back( thread );
+               }
+            };
+
             /* disable copy and assigment */
             explicit DistributedBFPolicy ( const DistributedBFPolicy & );
             const DistributedBFPolicy & operator= ( const DistributedBFPolicy & );
@@ -137,6 +155,56 @@ namespace nanos {
                }
             }
 
+            /*!
+            *  \brief Enqueues a batch of work descriptors (e.g. the successors released by
+            *          a task), spreading the untied ones among the queues of the team so
+            *          that the other threads do not need to steal them one by one
+            *  \param threads threads to which each task would be queued
+            *  \param wds the work descriptors to be enqueued
+            *  \param numElems number of work descriptors
+            */
+            virtual void queue ( BaseThread ** threads, WD ** wds, size_t numElems )
+            {
+               BaseThread *self = myThread;
+               ThreadTeam *team = self->getTeam();
+
+               size_t numUntied = 0;
+               for ( size_t i = 0; i < numElems; i++ ) {
+                  if ( threads[i] != self || wds[i]->isTiedTo() ) queue( threads[i], *wds[i] );
+                  else wds[numUntied++] = wds[i];
+               }
+               if ( numUntied == 0 ) return;
+
+               // One chunk per thread, but small batches are kept in our queue
+               int size = team->getFinalSize();
+               size_t chunk = std::max( ( numUntied + size - 1 ) / size, (size_t) _batchChunk );
+
+               size_t first = 0;
+               int thid = self->getTeamId();
+               for ( int count = 0; count < size && first < numUntied; count++, thid = ( thid + 1 ) % size ) {
+                  BaseThread &target = team->getThread( thid );
+                  if ( target.getTeam() != team ) continue;
+
+                  size_t n = std::min( chunk, numUntied - first );
+                  ThreadData &data = ( ThreadData & ) *target.getTeamData()->getScheduleData();
+                  data._readyQueue->push_front( &wds[first], n );
+                  sys.getThreadManager()->unblockThread( &target );
+                  first += n;
+               }
+
+               // Threads may have left the team meanwhile
+               if ( first < numUntied ) {
+                  ThreadData &data = ( ThreadData & ) *self->getTeamData()->getScheduleData();
+                  data._readyQueue->push_front( &wds[first], numUntied - first );
+               }
+            }
+
+            /*! This scheduling policy supports all WDs, no restrictions. */
+            bool isValidForBatch ( const WD * wd ) const
+            {
+               return true;
+            }
+
             /*!
             *  \brief Function called when a new task must be created: the new created task
             *          is directly queued (Breadth-First policy)
@@ -209,33 +277,16 @@ namespace nanos {
             }
 
             //! If also the parent is NULL or if someone moved it to another queue while was trying to steal it, 
-            //! try to steal tasks from other queues
-            //! \warning other queues are checked cyclically: should be random
-            int size = thread->getTeam()->getFinalSize();
-            int thid = rand() % size;
-            int count = 0;
-            wd = NULL;
-
-            do {
-               thid = ( thid + 1 ) % size;
-
-               BaseThread &victim = thread->getTeam()->getThread(thid);
-
-               if ( victim.getTeam() != NULL ) {
-                 ThreadData &tdata = ( ThreadData & ) *victim.getTeamData()->getScheduleData();
-                 wd = tdata._readyQueue->pop_back ( thread );
-               }
-
-               count++;
-
-            } while ( wd == NULL && count < size );
-
-            return wd;
+            //! try to steal tasks from other queues, closer ones first
+            StealLast stealLast;
+            return data._stealOrder.steal( thread, numSteal, stealLast );
          }
       }
 
       bool DistributedBFPolicy::_usePriority = true;
       bool DistributedBFPolicy::_useSmartPriority = false;
+      WDPQ::ContainerType DistributedBFPolicy::_priorityContainer = WDPQ::SORTED_LIST;
+      int DistributedBFPolicy::_batchChunk = 8;
 
       class DistributedBFSchedPlugin : public Plugin
       {
@@ -253,6 +304,11 @@ namespace nanos {
                cfg.registerConfigOption ( "schedule-smart-priority", NEW Config::FlagOption( DistributedBFPolicy::_useSmartPriority ), "Smart priority queue propagates high priorities to predecessors");
                cfg.registerArgOption( "schedule-smart-priority", "schedule-smart-priority" );
 
+               WDPQ::registerContainerOption( cfg, DistributedBFPolicy::_priorityContainer );
+
+               cfg.registerConfigOption ( "schedule-batch-chunk", NEW Config::PositiveVar( DistributedBFPolicy::_batchChunk ), "Minimum number of tasks of a batch (e.g. released successors) queued to each thread (default = 8)" );
+               cfg.registerArgOption( "schedule-batch-chunk", "schedule-batch-chunk" );
+
                
             }
 
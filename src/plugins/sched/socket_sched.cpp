@@ -47,8 +47,10 @@ namespace nanos {
       {
          //! \brief Limit stealing to adjacent nodes (1 hop away)
          bool stealFromAdjacent;
+         //! \brief Container used by the ready queues
+         WDPQ::ContainerType priorityContainer;
          
-         SocketSchedConfig() : stealFromAdjacent( true ) {}
+         SocketSchedConfig() : stealFromAdjacent( true ), priorityContainer( WDPQ::SORTED_LIST ) {}
       };
 
       class SocketSchedPolicy : public SchedulePolicy
@@ -105,9 +107,12 @@ namespace nanos {
                Atomic<unsigned>           _next; //!< Next queue to insert to (round robin scheduling) TODO remove this since we don't use it
                Atomic<bool>*              _activeMasters; //!< If there is an active "master" thread, for every socket
  
-               TeamData ( unsigned int sockets ) : ScheduleTeamData(), _next( 0 )
+               TeamData ( unsigned int sockets, WDPQ::ContainerType container ) : ScheduleTeamData(), _next( 0 )
                {
                   _readyQueues = NEW WDPriorityQueue<>[ sockets*2 + 1 ];
+                  for ( unsigned int i = 0; i < sockets*2 + 1; ++i ) {
+                     _readyQueues[i].setContainer( container );
+                  }
                   _activeMasters = NEW Atomic<bool>[ sockets ];
                }
 
@@ -484,7 +489,7 @@ namespace nanos {
                computeDistanceInfo();
 
                // Create 2 queues per socket plus one for the global queue.
-               return NEW TeamData( sys.getNumNumaNodes() );
+               return NEW TeamData( sys.getNumNumaNodes(), _config.priorityContainer );
             }
 
             virtual std::string getSummary() const
@@ -919,6 +924,8 @@ namespace nanos {
 
                cfg.registerConfigOption( "socket-steal-adjacent", NEW Config::FlagOption( _schedConfig.stealFromAdjacent ), "Limit stealing to adjacent nodes (default)");
                cfg.registerArgOption( "socket-steal-adjacent", "socket-steal-adjacent" );
+
+               WDPQ::registerContainerOption( cfg, _schedConfig.priorityContainer );
             }
 
             virtual void init() {
@@ -25,9 +25,16 @@
 #include "os.hpp"
 #include "config.hpp"
 #include "hashmap.hpp"
+#ifdef HAVE_SQLITE3
+#include "dbmanager_sqlite3.hpp"
+#endif
 
 #include <math.h>
 #include <limits>
+#include <algorithm>
+#include <map>
+#include <string.h>
+#include <dlfcn.h>
 
 
 namespace nanos {
@@ -254,6 +261,158 @@ namespace ext
    typedef TR1::unordered_map<const PE *, ResourceExecPlan *> ResourceMap;
 
 
+   /*
+    * Execution times recorded by previous runs, so that the scheduler does not need to try again
+    * all the versions of a task every time the application runs.
+    *
+    * Records are kept in a SQLite3 database (see DbManager), keyed by task version group and a
+    * power of two bucket of the task data size. Version groups are identified at runtime by the
+    * address of their devices array, which changes from run to run, so the persistent key uses
+    * its offset inside the binary object that contains it.
+    *
+    * Records that are not measured again age one run each time the history is saved. Loaded records
+    * lose weight for each run since they were saved, including the one loading them, so records kept
+    * measuring converge to a bounded number of samples. They are discarded at the maximum age.
+    */
+   class VersioningHistory
+   {
+      public:
+         struct Record {
+            double   _elapsedTime;
+            int      _numRecords;
+         };
+
+         typedef std::pair< long long, int > Key;                 // < persistent group id, size bucket >
+         typedef std::map< unsigned int, Record > Versions;       // versionId -> record
+         typedef std::map< Key, Versions > Records;
+
+      private:
+         std::string       _file;
+         int               _decay;     /**< Weight (percentage) a record keeps for each run since it was saved */
+         int               _maxAge;    /**< Records this old (in runs) are discarded */
+         Records           _records;   /**< Records loaded from the database */
+
+         /*! \brief VersioningHistory copy constructor (private)
+          */
+         VersioningHistory ( const VersioningHistory & );
+
+         /*! \brief VersioningHistory copy assignment operator (private)
+          */
+         const VersioningHistory & operator= ( const VersioningHistory & );
+
+#ifdef HAVE_SQLITE3
+         static void execute ( SQLite3DbManager &db, const std::string &stmt )
+         {
+            db.doStep( db.prepareStmt( stmt ) );
+         }
+
+         static void open ( SQLite3DbManager &db, const std::string &file )
+         {
+            db.openConnection( file );
+            execute( db, "CREATE TABLE IF NOT EXISTS versioning_history ( group_id INTEGER, size_bucket INTEGER, "
+                  "version INTEGER, elapsed_time REAL, records INTEGER, age INTEGER, "
+                  "PRIMARY KEY ( group_id, size_bucket, version ) )" );
+         }
+#endif
+
+      public:
+         VersioningHistory ( const std::string &file, int decay, int maxAge ) : _file( file ), _decay( decay ),
+            _maxAge( maxAge ), _records() {}
+
+         ~VersioningHistory () {}
+
+         static Key getKey ( unsigned long versionGroupId, size_t paramsSize )
+         {
+            long long group = ( long long ) versionGroupId;
+            Dl_info info;
+            if ( dladdr( ( void * ) versionGroupId, &info ) != 0 && info.dli_fname != NULL ) {
+               // Offset in the binary object, tagged with a hash of the object name
+               const char *name = strrchr( info.dli_fname, '/' );
+               name = ( name == NULL ) ? info.dli_fname : name + 1;
+               unsigned long long hash = 5381;
+               for ( ; *name != '\0'; name++ ) hash = hash * 33 + ( unsigned char ) *name;
+               group = ( long long ) ( ( hash << 32 ) ^ ( versionGroupId - ( unsigned long ) info.dli_fbase ) );
+            }
+
+            int bucket = 0;
+            while ( paramsSize >>= 1 ) bucket++;
+
+            return std::make_pair( group, bucket );
+         }
+
+         /*! \brief Returns the records of previous runs for the given version group, or NULL
+          */
+         const Versions * find ( unsigned long versionGroupId, size_t paramsSize ) const
+         {
+            Records::const_iterator it = _records.find( getKey( versionGroupId, paramsSize ) );
+            return it == _records.end() ? NULL : &it->second;
+         }
+
+         /*! \brief Loads the records of previous runs, applying their decay
+          */
+         void load ()
+         {
+#ifdef HAVE_SQLITE3
+            SQLite3DbManager db;
+            open( db, _file );
+
+            unsigned int select = db.prepareStmt( "SELECT group_id, size_bucket, version, elapsed_time, records, age "
+                  "FROM versioning_history" );
+            while ( db.doStep( select ) ) {
+               int age = db.getIntColumnValue( select, 5 );
+               if ( age >= _maxAge ) continue;
+
+               // The records saved by the last run have age 0, but they still decay once for this run
+               double weight = db.getIntColumnValue( select, 4 ) * pow( _decay / 100.0, age + 1 );
+               if ( weight < 1.0 ) continue;
+
+               Key key = std::make_pair( db.getInt64ColumnValue( select, 0 ), db.getIntColumnValue( select, 1 ) );
+               Record &record = _records[key][db.getIntColumnValue( select, 2 )];
+               record._elapsedTime = db.getDoubleColumnValue( select, 3 );
+               record._numRecords = ( int ) weight;
+            }
+
+            verbose0( "[versioning] Loaded history of " << _records.size() << " task version groups from " << _file );
+#endif
+         }
+
+         /*! \brief Saves the records measured in this run and ages the rest
+          */
+         void save ( const Records &measured )
+         {
+#ifdef HAVE_SQLITE3
+            SQLite3DbManager db;
+            open( db, _file );
+
+            execute( db, "BEGIN TRANSACTION" );
+            execute( db, "UPDATE versioning_history SET age = age + 1" );
+
+            unsigned int insert = db.prepareStmt( "INSERT OR REPLACE INTO versioning_history "
+                  "( group_id, size_bucket, version, elapsed_time, records, age ) VALUES ( ?, ?, ?, ?, ?, 0 )" );
+            for ( Records::const_iterator it = measured.begin(); it != measured.end(); ++it ) {
+               for ( Versions::const_iterator vit = it->second.begin(); vit != it->second.end(); ++vit ) {
+                  db.bindInt64Parameter( insert, 1, it->first.first );
+                  db.bindIntParameter( insert, 2, it->first.second );
+                  db.bindIntParameter( insert, 3, vit->first );
+                  db.bindDoubleParameter( insert, 4, vit->second._elapsedTime );
+                  db.bindIntParameter( insert, 5, vit->second._numRecords );
+                  db.doStep( insert );
+                  db.resetStmt( insert );
+               }
+            }
+
+            unsigned int remove = db.prepareStmt( "DELETE FROM versioning_history WHERE age >= ?" );
+            db.bindIntParameter( remove, 1, _maxAge );
+            db.doStep( remove );
+
+            execute( db, "COMMIT" );
+
+            verbose0( "[versioning] Saved history of " << measured.size() << " task version groups to " << _file );
+#endif
+         }
+   };
+
+
    class Versioning : public SchedulePolicy
    {
       public:
@@ -293,7 +452,10 @@ namespace ext
                }
 
 
-               void initExecInfoData ( WDExecInfoData & data, WD * wd )
+               /*
+                * Returns whether the records were loaded from the history of previous runs
+                */
+               bool initExecInfoData ( WDExecInfoData & data, WD * wd )
                {
                   unsigned int numVersions = wd->getNumDevices();
 
@@ -328,6 +490,8 @@ namespace ext
                      }
                   }
 
+                  bool fromHistory = ( _history != NULL ) && loadHistory( data, wd );
+
                   _statsLock.release();
 
                   WDExecInfoKey key = std::make_pair( wd->getVersionGroupId(), wd->getParamsSize() );
@@ -335,6 +499,85 @@ namespace ext
 
                   fatal_cond( !compatible, "Error: there is no suitable device in the system to run the submitted task.");
 
+                  return fromHistory;
+               }
+
+
+               /*
+                * Fills the records of a task version group seen for the first time with the ones of
+                * previous runs. Returns whether any version was found, then the scheduler does not need
+                * to try the versions again.
+                * Must be called with _statsLock acquired.
+                */
+               bool loadHistory ( WDExecInfoData & data, WD * wd )
+               {
+                  const VersioningHistory::Versions *versions = _history->find( wd->getVersionGroupId(), wd->getParamsSize() );
+                  if ( versions == NULL ) return false;
+
+                  bool found = false;
+                  for ( VersioningHistory::Versions::const_iterator it = versions->begin(); it != versions->end(); ++it ) {
+                     unsigned int i = it->first;
+                     // Skip versions that do not exist anymore, or whose device is not present
+                     if ( i >= data.size() || data[i]._numRecords != -1 ) continue;
+
+                     const Device *device = wd->getDevices()[i]->getDevice();
+                     const PE *pe = NULL;
+                     for ( ResourceMap::iterator pit = _executionMap.begin(); pit != _executionMap.end() && pe == NULL; ++pit ) {
+                        if ( pit->first->getDeviceTypes()[0] == device ) pe = pit->first;
+                     }
+                     if ( pe == NULL ) continue;
+
+                     WDExecRecord &record = data[i];
+                     record._pe = const_cast<PE *>( pe );
+                     record._elapsedTime = it->second._elapsedTime;
+                     record._lastElapsedTime = it->second._elapsedTime;
+                     record._numRecords = it->second._numRecords;
+                     // The version already went through its trials in a previous run, but not all of them
+                     // were recorded (the first execution is discarded), so do not try it again
+                     record._numAssigned = std::max( record._numRecords, _minRecordTrial );
+                     found = true;
+
+                     _bestLock.acquire();
+                     WDBestRecordData &best = getWDBestRecord( wd );
+                     if ( best._pe == NULL || best._elapsedTime > record._elapsedTime ) {
+                        best._versionId = i;
+                        best._pe = record._pe;
+                        best._elapsedTime = record._elapsedTime;
+                     }
+                     _bestLock.release();
+
+                     debug( "[versioning] History record for key ("
+                           + toString<unsigned long>( wd->getVersionGroupId() )
+                           + ", " + toString<size_t>( wd->getParamsSize() ) + ") vId "
+                           + toString<unsigned int>( i ) + " {#=" + toString<int>( record._numRecords )
+                           + ", T=" + toString<double>( record._elapsedTime ) + "}" );
+                  }
+
+                  return found;
+               }
+
+
+               /*
+                * Collects the records measured (or loaded) in this run, merging the versions whose
+                * data sizes fall in the same history bucket
+                */
+               void getHistoryRecords ( VersioningHistory::Records &records )
+               {
+                  for ( std::set<WDExecInfoKey>::iterator it = _wdExecStatsKeys.begin(); it != _wdExecStatsKeys.end(); it++ ) {
+                     WDExecInfoData &data = _wdExecStats[*it];
+                     VersioningHistory::Versions &versions = records[VersioningHistory::getKey( it->first, it->second )];
+
+                     for ( unsigned int i = 0; i < data.size(); i++ ) {
+                        WDExecRecord &record = data[i];
+                        if ( record._pe == NULL || record._numRecords <= 0 ) continue;
+
+                        VersioningHistory::Record &merged = versions[i];
+                        int numRecords = merged._numRecords + record._numRecords;
+                        merged._elapsedTime = ( merged._elapsedTime * merged._numRecords
+                              + record._elapsedTime * record._numRecords ) / numRecords;
+                        merged._numRecords = numRecords;
+                     }
+                  }
                }
 
 
@@ -401,11 +644,30 @@ namespace ext
          };
 
       public:
-         static bool       _useStack;
-         static int        _minRecordTrial;
+         static bool                _useStack;
+         static int                 _minRecordTrial;
+         static std::string         _historyFile;
+         static int                 _historyDecay;
+         static int                 _historyMaxAge;
+         static VersioningHistory * _history;
+
+         Versioning() : SchedulePolicy( "Versioning" )
+         {
+            if ( !_historyFile.empty() ) {
+#ifdef HAVE_SQLITE3
+               _history = NEW VersioningHistory( _historyFile, _historyDecay, _historyMaxAge );
+               _history->load();
+#else
+               warning0( "Versioning history needs SQLite3 support, ignoring " << _historyFile );
+#endif
+            }
+         }
 
-         Versioning() : SchedulePolicy( "Versioning" ) {}
-         virtual ~Versioning () {}
+         virtual ~Versioning ()
+         {
+            delete _history;
+            _history = NULL;
+         }
 
       private:
          virtual size_t getTeamDataSize () const { return sizeof( TeamData ); }
@@ -438,6 +700,19 @@ namespace ext
             return true;
          }
 
+         virtual void atShutdown ( void )
+         {
+            if ( _history == NULL ) return;
+
+            TeamData &tdata = ( TeamData & ) *myThread->getTeam()->getScheduleData();
+            VersioningHistory::Records records;
+            tdata._statsLock.acquire();
+            tdata.getHistoryRecords( records );
+            tdata._statsLock.release();
+
+            _history->save( records );
+         }
+
          /*
           * Activate the device for the given WD.
           * If the current thread can run it, add it to its queue, otherwise, enqueue the task again (and it will
@@ -775,10 +1050,8 @@ namespace ext
             unsigned int numVersions = next->getNumDevices();
             DeviceData **devices = next->getDevices();
 
-            // First record for the given { wdId, paramsSize }
-            if ( data.empty() ) {
-
-               tdata.initExecInfoData( data, next );
+            // First record for the given { wdId, paramsSize }, unless previous runs recorded enough of them
+            if ( data.empty() && !tdata.initExecInfoData( data, next ) ) {
 
                tdata._statsLock.acquire();
 
@@ -1199,6 +1472,10 @@ namespace ext
 
    bool Versioning::_useStack = false;
    int Versioning::_minRecordTrial = MIN_RECORDS;
+   std::string Versioning::_historyFile;
+   int Versioning::_historyDecay = 50;
+   int Versioning::_historyMaxAge = 8;
+   VersioningHistory * Versioning::_history = NULL;
    Lock Versioning::TeamData::_bestLock;
    Lock Versioning::TeamData::_statsLock;
 
@@ -1229,6 +1506,22 @@ namespace ext
                   NEW Config::IntegerVar( Versioning::_minRecordTrial ),
                   "Minimum number of task version trials for the versioning policy" );
             cfg.registerArgOption( "versioning-min-trials", "versioning-min-trials" );
+
+            // Keep the task version statistics between runs
+            cfg.registerConfigOption ( "versioning-history",
+                  NEW Config::StringVar( Versioning::_historyFile ),
+                  "SQLite3 database where the versioning policy keeps its statistics between runs (disabled)" );
+            cfg.registerArgOption( "versioning-history", "versioning-history" );
+
+            cfg.registerConfigOption ( "versioning-history-decay",
+                  NEW Config::PositiveVar( Versioning::_historyDecay ),
+                  "Weight (percentage) kept by history records for each run since they were saved (50)" );
+            cfg.registerArgOption( "versioning-history-decay", "versioning-history-decay" );
+
+            cfg.registerConfigOption ( "versioning-history-max-age",
+                  NEW Config::PositiveVar( Versioning::_historyMaxAge ),
+                  "Number of runs without being measured after which history records are discarded (8)" );
+            cfg.registerArgOption( "versioning-history-max-age", "versioning-history-max-age" );
          }
 
          virtual void init()
@@ -0,0 +1,194 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "schedule.hpp"
+#include "wddeque.hpp"
+#include "plugin.hpp"
+#include "stealorder.hpp"
+#include "system.hpp"
+#include "config.hpp"
+
+namespace nanos {
+   namespace ext {
+
+      class WorkStealing : public SchedulePolicy
+      {
+         public:
+            using SchedulePolicy::queue;
+         private:
+            struct ThreadData : public ScheduleThreadData
+            {
+               /*! lock-free queue of ready tasks, owned by the thread */
+               WDChaseLevDeque _readyQueue;
+               /*! order in which the other threads are robbed */
+               StealOrder      _stealOrder;
+
+               ThreadData () : _readyQueue( WorkStealing::_initialSize ), _stealOrder() {}
+               virtual ~ThreadData () {
+                  ensure(_readyQueue.empty(),"Destroying non-empty queue");
+               }
+            };
+
+            /*! \brief Steals the oldest WD of the deque of a victim */
+            struct StealOldest
+            {
+               WD * operator() ( BaseThread *thread, BaseThread &victim )
+               {
+                  WDChaseLevDeque &queue = ( ( ThreadData & ) *victim.getTeamData()->getScheduleData() )._readyQueue;
+                  if ( queue.empty() ) return NULL;
+                  return queue.pop_back( thread );
+               }
+            };
+
+            WorkStealing ( const WorkStealing & );
+            const WorkStealing operator= ( const WorkStealing & );
+
+         public:
+            static int     _initialSize;
+            static bool    _stealParent;
+
+            // constructor
+            WorkStealing() : SchedulePolicy( "Work Stealing" ) {}
+            virtual ~WorkStealing() {}
+
+            virtual size_t getTeamDataSize () const { return 0; }
+            virtual size_t getThreadDataSize () const { return sizeof(ThreadData); }
+
+            virtual ScheduleTeamData * createTeamData ()
+            {
+               return 0;
+            }
+
+            virtual ScheduleThreadData * createThreadData ()
+            {
+               return NEW ThreadData();
+            }
+
+            /*!
+             *  \brief Returns the scheduling data of a thread, binding the
+             *  queue to it the first time the thread itself gets there
+             */
+            ThreadData & getThreadData ( BaseThread *thread )
+            {
+               ThreadData &data = ( ThreadData & ) *thread->getTeamData()->getScheduleData();
+               if ( data._readyQueue.getOwner() == NULL && thread == myThread ) {
+                  data._readyQueue.setOwner( thread );
+               }
+               return data;
+            }
+
+            /*!
+             *  \brief Enqueues a work descriptor at the bottom of the deque of thread.
+             *  Tied WDs go straight to the thread they are tied to.
+             */
+            virtual void queue ( BaseThread *thread, WD &wd )
+            {
+               BaseThread *targetThread = wd.isTiedTo();
+               if ( targetThread && targetThread != thread ) {
+                  targetThread->addNextWD( &wd );
+                  return;
+               }
+
+               ThreadData &data = getThreadData( thread );
+               data._readyQueue.push_front( &wd );
+            }
+
+            virtual WD * atSubmit ( BaseThread *thread, WD &newWD )
+            {
+               queue( thread, newWD );
+               return 0;
+            }
+
+            /*! Batches are pushed one by one to the deque of the submitting thread. */
+            bool isValidForBatch ( const WD * wd ) const
+            {
+               return true;
+            }
+
+            virtual WD * atIdle ( BaseThread *thread, int numSteal );
+
+            virtual bool testDequeue()
+            {
+               BaseThread *thread = myThread;
+               if ( thread->getTeam() == NULL ) return false;
+               ThreadData &data = getThreadData( thread );
+               return data._readyQueue.testDequeue();
+            }
+      };
+
+      int WorkStealing::_initialSize = 256;
+      bool WorkStealing::_stealParent = false;
+
+      /*!
+       *  \brief Function called by the scheduler when a thread becomes idle to schedule it
+       *
+       *  The thread first pops the most recent WD from its own deque and, if it
+       *  is empty, steals the oldest WD from other threads, closer ones first
+       *  (see StealOrder).
+       *  \param thread pointer to the thread to be scheduled
+       *  \sa BaseThread
+       */
+      WD * WorkStealing::atIdle ( BaseThread *thread, int numSteal )
+      {
+         WorkDescriptor * wd = thread->getNextWD();
+
+         if ( wd ) return wd;
+
+         ThreadData &data = getThreadData( thread );
+
+         if ( ( wd = data._readyQueue.pop_front( thread ) ) != NULL ) return wd;
+
+         if ( _stealParent && ( wd = thread->getCurrentWD()->getParent() ) != NULL ) {
+            WorkDescriptor * next = NULL;
+            WDPool *q = wd->getMyQueue();
+            if ( q != NULL && q->removeWD( thread, wd, &next ) ) return next;
+         }
+
+         StealOldest stealOldest;
+         return data._stealOrder.steal( thread, numSteal, stealOldest );
+      }
+
+      class WSSchedPlugin : public Plugin
+      {
+
+         public:
+            WSSchedPlugin() : Plugin( "WS scheduling Plugin",1 ) {}
+
+            virtual void config( Config& cfg )
+            {
+               cfg.setOptionsSection( "WS module", "Lock-free work-stealing scheduling module" );
+
+               cfg.registerConfigOption ( "ws-initial-size", NEW Config::PositiveVar( WorkStealing::_initialSize ),
+                                             "Initial capacity of the per-thread deques (grows on demand)" );
+               cfg.registerArgOption ( "ws-initial-size", "ws-initial-size" );
+
+               cfg.registerConfigOption ( "ws-steal-parent", NEW Config::FlagOption( WorkStealing::_stealParent ),
+                                             "Defines if tries to steal the parent" );
+               cfg.registerArgOption ( "ws-steal-parent", "ws-steal-parent" );
+            }
+
+            virtual void init() {
+               sys.setDefaultSchedulePolicy(NEW WorkStealing());
+            }
+      };
+
+   }
+}
+
+DECLARE_PLUGIN("sched-ws",nanos::ext::WSSchedPlugin);
@@ -98,8 +98,8 @@ bool SlicerCompoundWD::dequeue ( WorkDescriptor *wd, WorkDescriptor **slice )
    bool all_threads_running = true; /* If (and only if) all threads are running allow to serialize */
 
    if ( _modAllThreadsRunning ) {
-      if ( (myThread->isIdle() == false) && (ss._idleThreads != 0) ) all_threads_running = false;
-      else if ( (myThread->isIdle() == true) && (ss._idleThreads != 1) ) all_threads_running = false;
+      if ( (myThread->isIdle() == false) && (ss._idleThreads.value() != 0) ) all_threads_running = false;
+      else if ( (myThread->isIdle() == true) && (ss._idleThreads.value() != 1) ) all_threads_running = false;
    }
 
    bool modifiers = all_threads_running; /* Sumarizes all modifiers */
@@ -109,10 +109,10 @@ bool SlicerCompoundWD::dequeue ( WorkDescriptor *wd, WorkDescriptor **slice )
 
    if ( modifiers == true ) {
       if ( _serializeAll ) serialize = true ;
-      if ( _totalTasks != 0) serialize = serialize || (ss._totalTasks > _totalTasks );
-      if ( _totalTasksPerThread != 0) serialize = serialize || ( ss._totalTasks > ( nthreads * _totalTasksPerThread) );
-      if ( _readyTasks != 0) serialize = serialize || (ss._readyTasks > _readyTasks );
-      if ( _readyTasksPerThread != 0) serialize = serialize || (ss._readyTasks > ( nthreads * _readyTasksPerThread) );
+      if ( _totalTasks != 0) serialize = serialize || (ss._totalTasks.value() > _totalTasks );
+      if ( _totalTasksPerThread != 0) serialize = serialize || ( ss._totalTasks.value() > ( nthreads * _totalTasksPerThread) );
+      if ( _readyTasks != 0) serialize = serialize || (ss._readyTasks.value() > _readyTasks );
+      if ( _readyTasksPerThread != 0) serialize = serialize || (ss._readyTasks.value() > ( nthreads * _readyTasksPerThread) );
       if ( _depthOfTask != 0) {} //! \todo depthOfTask is not involved in serialize flag
    }
    
@@ -145,8 +145,7 @@ void SlicerCompoundWD::executeWDs ( nanos_compound_wd_data_t *data )
    for ( int i = 0; i < data->nsect; i++ ) {
       slice = (WorkDescriptor*)data->lwd[i];
       Scheduler::inlineWork( slice, /*schedule*/ false );
-      slice->~WorkDescriptor();
-      delete[] (char *)slice;
+      sys.destroyWD( slice );
    }
 
 }
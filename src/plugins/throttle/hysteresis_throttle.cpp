@@ -26,10 +26,34 @@
 namespace nanos {
    namespace ext {
 
+      typedef int (*ntask_getter_t)( void ) ;
+
+      /*! \brief Checks that the number of tasks returned by a getter is at most a given value.
+       *
+       *  Scheduler counters are sharded, so they can only be read through their getters.
+       */
+      class NumTasksConditionChecker : public ConditionChecker
+      {
+         private:
+            ntask_getter_t _getter;
+            int            _condition;
+         public:
+            NumTasksConditionChecker( ntask_getter_t getter, int condition ) : ConditionChecker(), _getter( getter ), _condition( condition ) {}
+            NumTasksConditionChecker ( const NumTasksConditionChecker & cc ) : ConditionChecker( cc ), _getter( cc._getter ), _condition( cc._condition ) {}
+            NumTasksConditionChecker& operator=( const NumTasksConditionChecker & cc )
+            {
+               _getter = cc._getter;
+               _condition = cc._condition;
+               return *this;
+            }
+            virtual ~NumTasksConditionChecker() {}
+
+            virtual bool checkCondition() { return _getter() <= _condition; }
+      };
+
       class HysteresisThrottle: public ThrottlePolicy
       {
          private:
-            typedef int (*ntask_getter_t)( void ) ;
             static int get_total_tasks (void) { return sys.getTaskNum(); }
             static int get_ready_tasks (void) { return sys.getReadyNum(); }
          private:
@@ -37,7 +61,7 @@ namespace nanos {
             int                                                  _lower;
             int                                                  _depth;
             std::string                                          _type;
-            MultipleSyncCond<LessOrEqualConditionChecker<int> > *_syncCond;
+            MultipleSyncCond<NumTasksConditionChecker>          *_syncCond;
             ntask_getter_t                                       _get_num_tasks;
 
             HysteresisThrottle ( const HysteresisThrottle & );
@@ -52,12 +76,11 @@ namespace nanos {
                _syncCond( NULL )
             {
                if ( _type == "total" ) {
-                  _syncCond = (MultipleSyncCond< LessOrEqualConditionChecker<int> >*) new MultipleSyncCond< LessOrEqualConditionChecker<int> >(LessOrEqualConditionChecker<int>(sys.getSchedulerStats().getTotalTasksAddr(), lower * sys.getNumThreads())) ;
                   _get_num_tasks = &get_total_tasks;
                } else if ( _type == "ready" ) {
-                  _syncCond = (MultipleSyncCond< LessOrEqualConditionChecker<int> >*) new MultipleSyncCond< LessOrEqualConditionChecker<int> >(LessOrEqualConditionChecker<int>(sys.getSchedulerStats().getReadyTasksAddr(), lower * sys.getNumThreads())) ;
                   _get_num_tasks = &get_ready_tasks;
                } else fatal0("Unknow throttle type");
+               _syncCond = NEW MultipleSyncCond<NumTasksConditionChecker>( NumTasksConditionChecker( _get_num_tasks, _lower ) );
 
                verbose0( "Throttle hysteresis created");
                verbose0( "   type of tasks: " << _type );
@@ -25,6 +25,7 @@ using namespace nanos;
 Allocator *nanos::allocator;
 
 size_t Allocator::_headerSize = NANOS_ALIGNED_MEMORY_OFFSET( 0, sizeof(Allocator::ObjectHeader), 16 );
+__thread char Allocator::_threadTag;
 
 Allocator & nanos::getAllocator ( void )
 {
@@ -39,24 +40,31 @@ Allocator & nanos::getAllocator ( void )
    else return my_thread->getAllocator();
 }
 
-void * Allocator::Arena::allocate ( void )
+Allocator::Arena::Arena ( size_t objectSize, const void *owner ) : _objectSize( objectSize ),
+   _objectShift( __builtin_ctzl( objectSize ) ), _arena( NULL ), _next( NULL ), _prev( NULL ),
+   _first( this ), _spare( NULL ), _owner( owner ),
+   _numFree( numObjects ), _hint( 0 ), _remoteFree( NULL )
 {
-   unsigned int obj;
+   _arena = (char *) malloc( objectSize * numObjects );
+   if ( _arena == NULL ) throw ( NANOS_ENOMEM );
 
-   if ( !_free ) return NULL;
-
-   for ( obj = 0 ; obj < numObjects ; obj++ ) {
-      if ( _bitmap[obj]._bit ) break;
-   }
-
-   if (obj == numObjects) {
-      _free = false;
-      return NULL; 
+   for ( size_t i = 0; i < numWords; i++ ) _bitmap[i] = ~( (bitmap_word) 0 );
+   // Entries past numObjects in the last word are never handed out
+   if ( numObjects % bitsPerWord != 0 ) {
+      _bitmap[numWords - 1] = ( ( (bitmap_word) 1 ) << ( numObjects % bitsPerWord ) ) - 1;
    }
-
-   _bitmap[obj]._bit = false;
-
-   return (void *) &_arena[obj*_objectSize];
 }
 
+Allocator::Arena * Allocator::createArena ( size_t objectSize )
+{
+   Arena *arena = (Arena *) malloc( sizeof(Arena) );
+   if ( arena == NULL ) throw(NANOS_ENOMEM);
+   new ( arena ) Arena( objectSize, &_threadTag );
+   return arena;
+}
 
+void Allocator::destroyArena ( Arena *arena )
+{
+   arena->~Arena();
+   free( arena );
+}
@@ -20,6 +20,7 @@
 #ifndef _NANOS_ALLOCATOR_HPP
 #define _NANOS_ALLOCATOR_HPP
 #include "allocator_decl.hpp"
+#include "atomic.hpp"
 #include <vector>
 #include <cstdlib>
 #include <cstring>
@@ -34,17 +35,84 @@ inline size_t Allocator::Arena::getObjectSize () const
    return _objectSize;
 }
 
+inline const void * Allocator::Arena::getOwner () const
+{
+   return _owner;
+}
+
+inline void * Allocator::Arena::allocate ( void )
+{
+   if ( _numFree == 0 ) {
+      drainRemote();
+      if ( _numFree == 0 ) return NULL;
+   }
+
+   // Words below _hint are known to be full, and _numFree guarantees a set bit from there on
+   size_t word = _hint;
+   while ( _bitmap[word] == 0 ) word++;
+
+   unsigned int bit = __builtin_ctzll( _bitmap[word] );
+   _bitmap[word] &= _bitmap[word] - 1;
+   _hint = word;
+   _numFree--;
+
+   return (void *) &_arena[( word * bitsPerWord + bit ) << _objectShift];
+}
+
+inline void Allocator::Arena::release ( void *object )
+{
+   size_t index = ( (char *) object - _arena ) >> _objectShift;
+   size_t word = index / bitsPerWord;
+
+   _bitmap[word] |= ( (bitmap_word) 1 ) << ( index % bitsPerWord );
+   if ( word < _hint ) _hint = word;
+   _numFree++;
+}
+
 inline void Allocator::Arena::deallocate ( void *object )
 {
-   unsigned long offset = ((char *) object - _arena);
-   unsigned long index = offset / _objectSize;
+   release( object );
+   if ( _remoteFree != NULL ) drainRemote();
+}
+
+inline void Allocator::Arena::deallocateRemote ( ObjectHeader *object )
+{
+   ObjectHeader *head;
+   do {
+      head = _remoteFree;
+      object->_nextFree = head;
+   } while ( !compareAndSwap( &_remoteFree, head, object ) );
+}
+
+inline void Allocator::Arena::drainRemote ( void )
+{
+   ObjectHeader *list;
+   do {
+      list = _remoteFree;
+      if ( list == NULL ) return;
+   } while ( !compareAndSwap( &_remoteFree, list, (ObjectHeader *) NULL ) );
+
+   while ( list != NULL ) {
+      ObjectHeader *next = list->_nextFree;
+      release( list );
+      list = next;
+   }
+}
+
+inline bool Allocator::Arena::isReleasable ( void ) const
+{
+   // An arena with no object in use cannot receive remote releases, so the check is safe for the owner
+   return _prev != NULL && _numFree == numObjects;
+}
 
-   //if (sys.getNetwork()->getNodeNum() == 0 && _objectSize > 32768) std::cerr << "Free object size " << _objectSize << " : " << (void *) _objectSize << " addr range is " << (void *) object << ":" << ((void *) (((char*)object)+_objectSize)) << " this is arena " << (void*) this << std::endl;
-   _free = true;
-   _bitmap[index]._bit = true;
+inline bool Allocator::Arena::keepAsSpare ( void )
+{
+   // The current spare may be in use again, then this one replaces it
+   Arena *spare = _first->_spare;
+   if ( spare != NULL && spare != this && spare->_numFree == numObjects ) return false;
 
-   //if (sys.getNetwork()->getNodeNum() == 0 && _objectSize > 32768) std::cerr << "memset from " << (void *) &_arena[index*_objectSize] << " to " << (void*) (&_arena[index*_objectSize+_objectSize]) << std::endl;
-   //memset( &_arena[index*_objectSize], 0, _objectSize );
+   _first->_spare = this;
+   return true;
 }
 
 inline Allocator::Arena * Allocator::Arena::getNext ( void ) const
@@ -55,6 +123,17 @@ inline Allocator::Arena * Allocator::Arena::getNext ( void ) const
 inline void Allocator::Arena::setNext ( Arena * a )
 {
    _next = a;
+   if ( a != NULL ) {
+      a->_prev = this;
+      a->_first = _first;
+   }
+}
+
+inline void Allocator::Arena::unlink ( void )
+{
+   if ( _prev != NULL ) _prev->_next = _next;
+   if ( _next != NULL ) _next->_prev = _prev;
+   _prev = _next = NULL;
 }
 
 inline void * Allocator::allocateBigObject ( size_t size )
@@ -91,9 +170,7 @@ inline void * Allocator::allocate ( size_t size, const char* file, int line )
 
    if ( it == _arenas.end() ) {
       // no arena found for that size, create a new one
-      arena = (Arena *) malloc ( sizeof(Arena) );
-      if ( arena == NULL ) throw(NANOS_ENOMEM);
-      new ( arena ) Arena( realSize );
+      arena = createArena( realSize );
       _arenas.push_back( arena );
    }
    else arena = *it;
@@ -105,17 +182,13 @@ inline void * Allocator::allocate ( size_t size, const char* file, int line )
       ptr = (ObjectHeader *) arena->allocate();
       if ( ptr == NULL ) { 
           if ( arena->getNext() == NULL ) {
-             Arena *next = ( Arena *) malloc ( sizeof(Arena) );
-             if ( next == NULL ) throw(NANOS_ENOMEM);
-             new (next) Arena(realSize);
-             arena->setNext( next );
+             arena->setNext( createArena( realSize ) );
           }
           arena = arena->getNext(); 
       }
    }
 
    ptr->_arena = arena;
-   //if (sys.getNetwork()->getNodeNum() == 0 && realSize > 32768) std::cerr << "Allocate object size " << realSize << " : " << (void *) realSize << " addr range is " << (void *) ptr << ":" << ((void *) (((char*)ptr)+realSize)) << " this is arena " << (void *) arena << std::endl;
 
    return  ((char *) ptr ) + _headerSize;
 }
@@ -129,10 +202,17 @@ inline void Allocator::deallocate ( void *object, const char *file, int line )
    Arena *arena = ptr->_arena;
 
    // If there is no arena then it was a big object that just needs to be freed
-   if ( arena == NULL )
-     free(ptr);
-   else
-     arena->deallocate(ptr);
+   if ( arena == NULL ) {
+      free(ptr);
+   } else if ( arena->getOwner() == &_threadTag ) {
+      arena->deallocate(ptr);
+      if ( arena->isReleasable() && !arena->keepAsSpare() ) {
+         arena->unlink();
+         destroyArena( arena );
+      }
+   } else {
+      arena->deallocateRemote(ptr);
+   }
 }
 
 inline size_t Allocator::getObjectSize ( void *object )
@@ -89,23 +89,36 @@ class InternalAllocator
 class Allocator
 {
    private:
+      struct ObjectHeader;
      /*! \class Arena
+      *
+      *  Objects of a single size carved from one memory region. Free entries are tracked in a packed
+      *  bitmap that only the owner thread touches; other threads hand objects back through a
+      *  lock-free list which the owner drains when it runs out of free entries.
       */
       class Arena
       {
          private: /* Arena data members and disabled constructors */
-            static const size_t numObjects = NANOS_OBJECTS_PER_ARENA;      /** Number of maximum objects allocated in this arena*/
+            typedef unsigned long long bitmap_word;
 
-            union bitmap_entry {
-               bool             _bit;
-               char             pad[NANOS_CACHELINE];
-            };                                         /**< bitmap_entry struct */
+            static const size_t numObjects = NANOS_OBJECTS_PER_ARENA;      /** Number of maximum objects allocated in this arena*/
+            static const size_t bitsPerWord = sizeof(bitmap_word) * 8;   /** Number of objects tracked by each bitmap word */
+            static const size_t numWords = ( numObjects + bitsPerWord - 1 ) / bitsPerWord; /** Number of bitmap words */
 
             size_t            _objectSize;            /**< Object size in current Arena  */
+            unsigned int      _objectShift;           /**< log2 of the object size */
             char             *_arena;                 /**< Memory region used by Arena */
-            bitmap_entry     *_bitmap;                /**< Bit map (free/busy) */
             Arena            *_next;                  /**< Next Arena in the list */
-            bool              _free;                  /**< Are there free entries */
+            Arena            *_prev;                  /**< Previous Arena in the list (NULL for the first one) */
+            Arena            *_first;                 /**< First Arena of the list */
+            Arena            *_spare;                 /**< Unused Arena kept in the list, only set in the first one */
+            const void       *_owner;                 /**< Thread that owns the Arena */
+            size_t            _numFree;               /**< Number of free entries in the bitmap */
+            size_t            _hint;                  /**< Lowest bitmap word that may have a free entry */
+            bitmap_word       _bitmap[numWords];      /**< Bit map, a set bit is a free entry */
+            char              _pad0[NANOS_CACHELINE];
+            ObjectHeader * volatile _remoteFree;      /**< Objects released by threads other than the owner */
+            char              _pad1[NANOS_CACHELINE - sizeof(ObjectHeader *)];
             /*! \brief Arena copy constructor (disabled)
              */
             Arena ( const Arena &a );
@@ -115,39 +128,52 @@ class Allocator
            /*! \brief Arena default constructor (disabled)
             */
             Arena ();
+           /*! \brief Marks the entry at 'object' as free in the bitmap
+            */
+            void release ( void *object ) ;
          public: /* Arena method members */
            /*! \brief Arena constructor
             */
-            Arena ( size_t objectSize ) : _objectSize(objectSize), _next (NULL), _free(true)
-            {
-               _arena = (char *) malloc( (objectSize + sizeof(bitmap_entry) ) * numObjects );
-               if ( _arena == NULL ) throw ( NANOS_ENOMEM );
-               _bitmap = (bitmap_entry *) (_arena + objectSize * numObjects);
-               for ( size_t i = 0; i < numObjects; i++ ) _bitmap[i]._bit = true;
-            }
+            Arena ( size_t objectSize, const void *owner );
            /*! \brief Arena destructor
             */
-            ~Arena ()
-            {
-               delete _next;
-               free(_arena);
-               free(_bitmap);
-            }
+            ~Arena () { free(_arena); }
            /*! \brief Returns the size of allocated object
             */
             size_t getObjectSize ( void ) const ; 
+           /*! \brief Returns the thread owning the arena
+            */
+            const void * getOwner ( void ) const ;
            /*! \brief Returns a free object address (and mark it as busy)
             */
             void * allocate ( void ) ;
-           /*! \brief Mark 'object' as free
+           /*! \brief Mark 'object' as free (only called by the owner)
             */
             void deallocate ( void *object ) ;
+           /*! \brief Hands 'object' back to the owner (called by any other thread)
+            */
+            void deallocateRemote ( ObjectHeader *object ) ;
+           /*! \brief Moves the objects released by other threads back to the bitmap
+            */
+            void drainRemote ( void ) ;
+           /*! \brief Whether the arena can be given back: it has no object in use and it is not the first one of its list
+            */
+            bool isReleasable ( void ) const ;
+           /*! \brief Whether a releasable arena stays in the list as its spare
+            *
+            *  Each list keeps one unused arena, so that a thread whose live objects oscillate around an
+            *  arena boundary does not create and destroy an arena every time.
+            */
+            bool keepAsSpare ( void ) ;
            /*! \brief Returns next Arena object in the list
             */
             Arena * getNext ( void ) const;
            /*! \brief Set as next Arena object 'a'
             */
             void setNext ( Arena * a );
+           /*! \brief Removes the arena from its list
+            */
+            void unlink ( void );
       };
       template<typename T>
       struct InternalCollection {
@@ -155,7 +181,10 @@ class Allocator
       };
 
       struct ObjectHeader {
-         Arena     *_arena;
+         union {
+            Arena        *_arena;                     /**< Arena of the object while it is in use */
+            ObjectHeader *_nextFree;                  /**< Next object in the remote free list */
+         };
       };
 
    private: /* Allocator data members */
@@ -166,6 +195,8 @@ class Allocator
 
       static const size_t                  _sizeOfBig = 1024*1024*10;
 
+      static __thread char          _threadTag;   /**< Its address identifies the calling thread */
+
      /*! \brief Allocator copy constructor (disabled)
       */
       Allocator ( const Allocator &a );
@@ -176,6 +207,10 @@ class Allocator
 
      /*! \brief Alternative allocation method for big objects */
       void * allocateBigObject ( size_t size ); 
+     /*! \brief Creates a new Arena owned by the calling thread */
+      static Arena * createArena ( size_t objectSize );
+     /*! \brief Gives back the memory of an Arena */
+      static void destroyArena ( Arena *arena );
 
    public: /* Allocator method members */
     /*! \brief Allocator default constructor 
@@ -194,6 +229,10 @@ class Allocator
      */
      void * allocate ( size_t size, const char *file = NULL, int line = 0 ) ;
     /*! \brief Deallocates 'object' (object has a header which identifies related Arena
+     *
+     *  The owner of the Arena marks the entry as free directly (and gives the Arena back once it
+     *  is completely unused, unless it is kept as spare), any other thread pushes the object to the
+     *  Arena remote free list.
      */
      static void deallocate ( void *object, const char *file = NULL, int line = 0 ) ;
     /*! \brief Get 'object' size for a given pointer
@@ -74,6 +74,14 @@ public:
     */
    virtual void bindInt64Parameter(const unsigned int stmtNumber, const unsigned int parameterIndex, long long int value) { fatal0("DbManager: bindInt64Parameter not implemented") };
 
+   /**
+    * @brief This function bind a double value to a prepared statement
+    * @param stmtNumber Parameter to reference the prepared statement
+    * @param parameterIndex Parameter to choose the parameter to reference
+    * @param value value to be set on the parameter
+    */
+   virtual void bindDoubleParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, double value) { fatal0("DbManager: bindDoubleParameter not implemented") };
+
    /**
     * @brief This function return the value of a given column
     * @param stmtNumber stmtNumber Parameter to reference the prepared statement
@@ -82,12 +90,34 @@ public:
     */
    virtual int getIntColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex) { fatal0("DbManager: getIntColumnValue not implemented") };
 
+   /**
+    * @brief This function return the integer64 value of a given column
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    * @param columnIndex Parameter to choose the column to reference
+    * @return The value of a given column
+    */
+   virtual long long int getInt64ColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex) { fatal0("DbManager: getInt64ColumnValue not implemented") };
+
+   /**
+    * @brief This function return the double value of a given column
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    * @param columnIndex Parameter to choose the column to reference
+    * @return The value of a given column
+    */
+   virtual double getDoubleColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex) { fatal0("DbManager: getDoubleColumnValue not implemented") };
+
    /**
     * @brief This function makes to ask for a row with the according statement
     * @param stmtNumber stmtNumber Parameter to reference the prepared statement
     */
    virtual bool doStep(const unsigned int stmtNumber) { fatal0("DbManager: doStep not implemented") };
 
+   /**
+    * @brief This function resets a prepared statement and its parameters, so it can be executed again
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    */
+   virtual void resetStmt(const unsigned int stmtNumber) { fatal0("DbManager: resetStmt not implemented") };
+
 private:
    /**
     * @brief Error check function
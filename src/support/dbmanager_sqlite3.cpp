@@ -92,11 +92,26 @@ void SQLite3DbManager::bindInt64Parameter(const unsigned int stmtNumber, const u
    sqlCheck(sqlite3_bind_int64(_stmtVector[stmtNumber], parameterIndex, value), "SQLite - Can't bind integer64 value: ");
 }
 
+void SQLite3DbManager::bindDoubleParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, double value)
+{
+   sqlCheck(sqlite3_bind_double(_stmtVector[stmtNumber], parameterIndex, value), "SQLite - Can't bind double value: ");
+}
+
 int SQLite3DbManager::getIntColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
 {
    return sqlite3_column_int(_stmtVector[stmtNumber], columnIndex);
 }
 
+long long int SQLite3DbManager::getInt64ColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
+{
+   return sqlite3_column_int64(_stmtVector[stmtNumber], columnIndex);
+}
+
+double SQLite3DbManager::getDoubleColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
+{
+   return sqlite3_column_double(_stmtVector[stmtNumber], columnIndex);
+}
+
 bool SQLite3DbManager::doStep(const unsigned int stmtNumber)
 {
    const int err = sqlite3_step(_stmtVector[stmtNumber]);
@@ -106,3 +121,9 @@ bool SQLite3DbManager::doStep(const unsigned int stmtNumber)
       return false;
    }
 }
+
+void SQLite3DbManager::resetStmt(const unsigned int stmtNumber)
+{
+   sqlCheck(sqlite3_reset(_stmtVector[stmtNumber]), "SQLite - Can't reset prepared statement: ");
+   sqlCheck(sqlite3_clear_bindings(_stmtVector[stmtNumber]), "SQLite - Can't clear prepared statement bindings: ");
+}
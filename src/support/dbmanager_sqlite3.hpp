@@ -77,6 +77,14 @@ public:
     */
    void bindInt64Parameter(const unsigned int stmtNumber, const unsigned int parameterIndex, long long int value);
 
+   /**
+    * @brief This function bind a double value to a prepared statement
+    * @param stmtNumber Parameter to reference the prepared statement
+    * @param parameterIndex Parameter to choose the parameter to reference
+    * @param value value to be set on the parameter
+    */
+   void bindDoubleParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, double value);
+
    /**
     * @brief This function return the value of a given column
     * @param stmtNumber stmtNumber Parameter to reference the prepared statement
@@ -85,12 +93,34 @@ public:
     */
    int getIntColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
 
+   /**
+    * @brief This function return the integer64 value of a given column
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    * @param columnIndex Parameter to choose the column to reference
+    * @return The value of a given column
+    */
+   long long int getInt64ColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
+
+   /**
+    * @brief This function return the double value of a given column
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    * @param columnIndex Parameter to choose the column to reference
+    * @return The value of a given column
+    */
+   double getDoubleColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
+
    /**
     * @brief This function makes to ask for a row with the according statement
     * @param stmtNumber stmtNumber Parameter to reference the prepared statement
     */
    bool doStep(const unsigned int stmtNumber);
 
+   /**
+    * @brief This function resets a prepared statement and its parameters, so it can be executed again
+    * @param stmtNumber stmtNumber Parameter to reference the prepared statement
+    */
+   void resetStmt(const unsigned int stmtNumber);
+
 private:
    /**
     * @brief SQLite3 error check function
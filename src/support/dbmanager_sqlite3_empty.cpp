@@ -71,13 +71,33 @@ void SQLite3DbManager::bindInt64Parameter(const unsigned int stmtNumber, const u
    fatal0("SQLite3DbManager: empty class compiled")
 }
 
+void SQLite3DbManager::bindDoubleParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, double value)
+{
+   fatal0("SQLite3DbManager: empty class compiled")
+}
+
 int SQLite3DbManager::getIntColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
 {
    fatal0("SQLite3DbManager: empty class compiled")
 }
 
+long long int SQLite3DbManager::getInt64ColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
+{
+   fatal0("SQLite3DbManager: empty class compiled")
+}
+
+double SQLite3DbManager::getDoubleColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex)
+{
+   fatal0("SQLite3DbManager: empty class compiled")
+}
+
 bool SQLite3DbManager::doStep(const unsigned int stmtNumber)
 {
    fatal0("SQLite3DbManager: empty class compiled")
    return false;
 }
+
+void SQLite3DbManager::resetStmt(const unsigned int stmtNumber)
+{
+   fatal0("SQLite3DbManager: empty class compiled")
+}
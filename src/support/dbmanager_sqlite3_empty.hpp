@@ -33,8 +33,12 @@ public:
    unsigned int prepareStmt(const std::string &stmt);
    void bindIntParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, int value);
    void bindInt64Parameter(const unsigned int stmtNumber, const unsigned int parameterIndex, long long int value);
+   void bindDoubleParameter(const unsigned int stmtNumber, const unsigned int parameterIndex, double value);
    int getIntColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
+   long long int getInt64ColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
+   double getDoubleColumnValue(const unsigned int stmtNumber, const unsigned int columnIndex);
    bool doStep(const unsigned int stmtNumber);
+   void resetStmt(const unsigned int stmtNumber);
 private:
    void sqlCheck(const int err, const std::string &msg);
    void cleanPreparedStmts();
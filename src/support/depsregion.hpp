@@ -21,14 +21,52 @@
 #define _NANOS_DEPSREGION_H
 
 #include "depsregion_decl.hpp"
+#include "trackableobject.hpp"
 
 namespace nanos {
 
+inline DepsRegion::DepsRegion ( TargetType address, TargetType endAddress, TrackableObject* trackable, short dimensionCount, const nanos_region_dimension_internal_t *dimensions )
+   : _address( address ) , _endAddress( endAddress ), _trackable(trackable), _dimensionCount(dimensionCount), _dimensions()
+{
+   if ( _trackable != NULL ) _trackable->retain();
+   if (_dimensionCount>0) {
+      _dimensions.reserve(_dimensionCount);
+      for (short i=0; i<dimensionCount; i++) {
+         _dimensions.push_back(dimensions[i]);
+      }
+   }
+}
+
+inline DepsRegion::DepsRegion ( const DepsRegion &obj )
+   :  BaseDependency(), _address ( obj._address ), _endAddress ( obj._endAddress ),  _trackable( obj._trackable ),
+   _dimensionCount( obj._dimensionCount ), _dimensions( obj._dimensions )
+{
+   if ( _trackable != NULL ) _trackable->retain();
+}
+
+inline DepsRegion::~DepsRegion ()
+{
+   releaseTrackable();
+}
+
+inline void DepsRegion::releaseTrackable ()
+{
+   if ( _trackable != NULL && _trackable->release() ) delete _trackable;
+   _trackable = NULL;
+}
+
+inline void DepsRegion::setTrackable ( TrackableObject* trackable )
+{
+   if ( trackable != NULL ) trackable->retain();
+   releaseTrackable();
+   _trackable = trackable;
+}
+
 inline const DepsRegion& DepsRegion::operator= ( const DepsRegion &obj )
 {
    _address = obj._address;
    _endAddress = obj._endAddress; 
-   _trackable = obj._trackable;
+   setTrackable( obj._trackable );
    return *this;
 }
 
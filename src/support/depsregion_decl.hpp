@@ -43,26 +43,17 @@ namespace nanos {
         /*! \brief DepsRegion default constructor
          *  Creates an DepsRegion with the given address associated.
          */
-         DepsRegion ( TargetType address = NULL, TargetType endAddress = NULL, TrackableObject* trackable = NULL, short dimensionCount=0, const nanos_region_dimension_internal_t *dimensions = NULL )
-            : _address( address ) , _endAddress( endAddress ), _trackable(trackable), _dimensionCount(dimensionCount), _dimensions() {
-            if (_dimensionCount>0) {
-                _dimensions.reserve(_dimensionCount);
-                for (short i=0; i<dimensionCount; i++) {
-                    _dimensions.push_back(dimensions[i]);
-                }
-            }
-        }
+         DepsRegion ( TargetType address = NULL, TargetType endAddress = NULL, TrackableObject* trackable = NULL, short dimensionCount=0, const nanos_region_dimension_internal_t *dimensions = NULL );
 
         /*! \brief DepsRegion copy constructor
          *  \param obj another DepsRegion
          */
-         DepsRegion ( const DepsRegion &obj ) 
-            :  BaseDependency(), _address ( obj._address ), _endAddress ( obj._endAddress ),  _trackable( obj._trackable ),
-            _dimensionCount( obj._dimensionCount ), _dimensions( obj._dimensions ) {}
+         DepsRegion ( const DepsRegion &obj );
 
         /*! \brief DepsRegion destructor
+         *  Drops the reference held on the associated trackable, if any.
          */
-         ~DepsRegion () {}
+         ~DepsRegion ();
 
         /*! \brief DepsRegion assignment operator, can be self-assigned.
          *  \param obj another DepsRegion
@@ -101,9 +92,12 @@ namespace nanos {
             return _trackable;
          }
 
-         void setTrackable(TrackableObject* trackable) {
-            _trackable = trackable;
-         }
+         //! \brief Associates a trackable to the region, holding a reference on it
+         void setTrackable(TrackableObject* trackable);
+
+      private:
+         //! \brief Drops the reference on the current trackable, deleting it if it was the last one
+         void releaseTrackable();
          
    };
 } // namespace nanos
@@ -113,6 +113,30 @@ unsigned int Hwloc::getNumaNodeOfCpu ( unsigned int cpu )
 #endif
 }
 
+unsigned int Hwloc::getCoreOfCpu ( unsigned int cpu )
+{
+#ifdef HWLOC
+   hwloc_obj_t pu = hwloc_get_pu_obj_by_os_index( _hwlocTopology, cpu );
+   hwloc_obj_t core = pu != NULL ? hwloc_get_ancestor_obj_by_type( _hwlocTopology, HWLOC_OBJ_CORE, pu ) : NULL;
+
+   // PUs not below a core are considered cores by themselves
+   if ( core != NULL ) return core->logical_index;
+#endif
+   return cpu;
+}
+
+unsigned int Hwloc::getSocketOfCpu ( unsigned int cpu )
+{
+   unsigned int socketId = 0;
+#ifdef HWLOC
+   hwloc_obj_t pu = hwloc_get_pu_obj_by_os_index( _hwlocTopology, cpu );
+   hwloc_obj_t socket = pu != NULL ? hwloc_get_ancestor_obj_by_type( _hwlocTopology, HWLOC_OBJ_SOCKET, pu ) : NULL;
+
+   if ( socket != NULL ) socketId = socket->logical_index;
+#endif
+   return socketId;
+}
+
 void Hwloc::getNumSockets(unsigned int &allowedNodes, int &numSockets, unsigned int &hwThreads) {
 #ifdef HWLOC
    numSockets = 0;
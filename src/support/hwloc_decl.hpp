@@ -51,6 +51,16 @@ class Hwloc {
       void unloadHwloc();
       unsigned int getNumaNodeOfCpu( unsigned int cpu );
       unsigned int getNumaNodeOfGpu( unsigned int gpu );
+      /*!
+       * \brief Returns the (logical) index of the core a CPU belongs to.
+       * If hwloc is not available, each CPU is considered a different core.
+       */
+      unsigned int getCoreOfCpu( unsigned int cpu );
+      /*!
+       * \brief Returns the (logical) index of the socket a CPU belongs to.
+       * If hwloc is not available, all CPUs are in socket 0.
+       */
+      unsigned int getSocketOfCpu( unsigned int cpu );
       void getNumSockets(unsigned int &allowedNodes, int &numSockets, unsigned int &hwThreads);
 
       /*!
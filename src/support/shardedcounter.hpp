@@ -0,0 +1,93 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDCOUNTER
+#define _NANOS_SHARDEDCOUNTER
+
+#include "shardedcounter_decl.hpp"
+#include "atomic.hpp"
+#include "malign.hpp"
+#include <new>
+
+namespace nanos {
+
+inline ShardedCounter::ShardedCounter ( int init )
+   : _shards( (Shard *) NANOS_ALIGNED_MEMORY_OFFSET( _storage, 0, NANOS_CACHELINE ) )
+{
+   for ( int i = 0; i < MAX_SHARDS; i++ ) new ( &_shards[i] ) Shard();
+   _shards[0]._value = init;
+}
+
+inline ShardedCounter::~ShardedCounter ()
+{
+   for ( int i = 0; i < MAX_SHARDS; i++ ) _shards[i].~Shard();
+}
+
+inline int ShardedCounter::myShardId ()
+{
+   if ( _myShard < 0 ) {
+      int id;
+      do {
+         id = _numThreads;
+      } while ( !compareAndSwap( &_numThreads, id, id + 1 ) );
+      _myShard = id & ( MAX_SHARDS - 1 );
+   }
+   return _myShard;
+}
+
+inline ShardedCounter::Shard & ShardedCounter::myShard ()
+{
+   return _shards[myShardId()];
+}
+
+inline int ShardedCounter::numShards ()
+{
+   int threads = _numThreads;
+   return threads < MAX_SHARDS ? threads : MAX_SHARDS;
+}
+
+inline void ShardedCounter::operator++ () { myShard()._value++; }
+inline void ShardedCounter::operator-- () { myShard()._value--; }
+inline void ShardedCounter::operator++ ( int ) { myShard()._value++; }
+inline void ShardedCounter::operator-- ( int ) { myShard()._value--; }
+inline void ShardedCounter::operator+= ( int val ) { myShard()._value += val; }
+inline void ShardedCounter::operator-= ( int val ) { myShard()._value -= val; }
+
+inline int ShardedCounter::value () const
+{
+   // Shard 0 holds the initial value even if no thread got a shard yet
+   int sum = _shards[0]._value.value();
+   for ( int i = 1, n = numShards(); i < n; i++ ) sum += _shards[i]._value.value();
+   return sum;
+}
+
+inline int ShardedCounter::approxValue () const
+{
+   // The snapshot lives in the shard of the reader, which only reads the other shards
+   Shard &shard = _shards[myShardId()];
+   if ( --shard._snapshotReads <= 0 ) {
+      shard._snapshotReads = SNAPSHOT_READS;
+      shard._snapshot = value();
+   }
+   return shard._snapshot;
+}
+
+} // namespace nanos
+
+#endif
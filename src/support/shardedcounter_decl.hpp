@@ -0,0 +1,109 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDCOUNTER_DECL
+#define _NANOS_SHARDEDCOUNTER_DECL
+
+#include "atomic_decl.hpp"
+#include "allocator_decl.hpp"
+
+namespace nanos {
+
+   /*! \brief Integer counter split in per-thread shards
+    *
+    *  Each thread updates its own shard, which sits in a cache line of its
+    *  own, so updates from different threads do not contend. The value of
+    *  the counter is the sum of the shards:
+    *  - value() sums them on demand and is exact, as far as concurrent
+    *    updates allow, which is what throttles and consistency checks need.
+    *  - approxValue() returns a snapshot of the sum kept in the shard of the
+    *    reader, which refreshes it every few reads, for hot paths that only
+    *    need a hint (e.g. idle threads checking for ready tasks on every spin).
+    *    Readers never write to the cache lines of other threads.
+    *
+    *  Threads get their shard the first time they update or read any
+    *  sharded counter. Shards are reused once there are more threads than
+    *  shards, so the counters stay correct for any number of threads.
+    */
+   class ShardedCounter
+   {
+      public:
+         enum {
+            MAX_SHARDS = 64,        /**< Maximum number of shards (a power of two) */
+            SNAPSHOT_READS = 16     /**< Approximate reads before a thread refreshes the snapshot */
+         };
+
+      private:
+         struct Shard {
+            Atomic<int> _value;
+            mutable int _snapshot;        /**< Sum last computed by the owner of the shard, see approxValue() */
+            mutable int _snapshotReads;   /**< Approximate reads left before the owner refreshes _snapshot */
+            char        _pad[NANOS_CACHELINE - sizeof(Atomic<int>) - 2 * sizeof(int)];
+
+            Shard () : _value( 0 ), _snapshot( 0 ), _snapshotReads( 0 ) {}
+         };
+
+         Shard                   *_shards;             /**< Shards, at the first cache line boundary of _storage */
+         char                     _storage[( MAX_SHARDS + 1 ) * NANOS_CACHELINE];
+
+         /*! \brief Threads that got a shard so far
+          *  \note A plain integer, zero before any constructor runs: threads may get a shard
+          *  while static objects are still being constructed, and must not see it reset.
+          */
+         static volatile int      _numThreads;
+         static __thread int      _myShard;            /**< Shard of the current thread, -1 if none yet */
+
+         /*! \brief ShardedCounter copy constructor (private)
+          */
+         ShardedCounter ( const ShardedCounter & );
+         /*! \brief ShardedCounter copy assignment operator (private)
+          */
+         const ShardedCounter & operator= ( const ShardedCounter & );
+
+         /*! \brief Returns the index of the shard of the current thread */
+         static int myShardId ();
+         /*! \brief Returns the shard of the current thread */
+         Shard & myShard ();
+         /*! \brief Returns the number of shards in use */
+         static int numShards ();
+
+      public:
+         /*! \brief ShardedCounter constructor
+          */
+         ShardedCounter ( int init = 0 );
+         /*! \brief ShardedCounter destructor
+          */
+         ~ShardedCounter ();
+
+         void operator++ ();
+         void operator-- ();
+         void operator++ ( int );
+         void operator-- ( int );
+         void operator+= ( int val );
+         void operator-= ( int val );
+
+         /*! \brief Exact value of the counter */
+         int value () const;
+         /*! \brief Possibly outdated value of the counter, much cheaper than value() */
+         int approxValue () const;
+   };
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,192 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDHASHMAP
+#define _NANOS_SHARDEDHASHMAP
+
+#include "shardedhashmap_decl.hpp"
+#include "atomic.hpp"
+#include "lock.hpp"
+#include "debug.hpp"
+#include "malign.hpp"
+#include <new>
+
+namespace nanos {
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline ShardedHashMap<_KeyType,_T,_Hash>::ShardedHashMap ( size_t numShards ) : _numShards( 1 ), _shards( NULL ), _hash()
+{
+   while ( _numShards < numShards ) _numShards <<= 1;
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline ShardedHashMap<_KeyType,_T,_Hash>::ShardedHashMap ( const ShardedHashMap &map ) : _numShards( map._numShards ), _shards( NULL ), _hash()
+{
+   if ( map._shards == NULL ) return;
+
+   Shard *shards = getShards();
+   for ( size_t i = 0; i < _numShards; i++ ) {
+      ShardMap const &from = map._shards[i]._map;
+      for ( typename ShardMap::const_iterator it = from.begin(); it != from.end(); it++ ) {
+         shards[i]._map.insert( std::make_pair( it->first, Entry( NEW _T( *it->second._value ) ) ) );
+      }
+   }
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline ShardedHashMap<_KeyType,_T,_Hash>::~ShardedHashMap ()
+{
+   clear();
+   if ( _shards != NULL ) deleteShards( _shards, _numShards );
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline size_t ShardedHashMap<_KeyType,_T,_Hash>::shardIndex ( const _KeyType &key ) const
+{
+   // Keys such as addresses share their low bits, so mix the high ones in
+   size_t h = _hash( key );
+   h ^= ( h >> 16 ) ^ ( h >> 8 );
+   return ( h >> 4 ) & ( _numShards - 1 );
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline typename ShardedHashMap<_KeyType,_T,_Hash>::Shard * ShardedHashMap<_KeyType,_T,_Hash>::getShards ()
+{
+   Shard *shards = _shards;
+   if ( shards == NULL ) {
+      shards = allocateShards( _numShards );
+      if ( !compareAndSwap( &_shards, (Shard *) NULL, shards ) ) {
+         deleteShards( shards, _numShards );
+         shards = _shards;
+      }
+   }
+   return shards;
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline typename ShardedHashMap<_KeyType,_T,_Hash>::Shard * ShardedHashMap<_KeyType,_T,_Hash>::allocateShards ( size_t numShards )
+{
+   // The address of the allocated chunk is kept just before the first shard
+   char *chunk = NEW char[sizeof(char *) + NANOS_CACHELINE - 1 + numShards * sizeof(Shard)];
+   char *base = (char *) NANOS_ALIGNED_MEMORY_OFFSET( chunk, sizeof(char *), NANOS_CACHELINE );
+   ( (char **) base )[-1] = chunk;
+
+   Shard *shards = (Shard *) base;
+   for ( size_t i = 0; i < numShards; i++ ) new ( &shards[i] ) Shard();
+   return shards;
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline void ShardedHashMap<_KeyType,_T,_Hash>::deleteShards ( Shard *shards, size_t numShards )
+{
+   for ( size_t i = 0; i < numShards; i++ ) shards[i].~Shard();
+   delete[] ( (char **) shards )[-1];
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline void ShardedHashMap<_KeyType,_T,_Hash>::eraseIfUnused ( ShardMap &map, typename ShardMap::iterator it )
+{
+   Entry &entry = it->second;
+   if ( entry._pins == 0 && entry._value->isEmpty() ) {
+      delete entry._value;
+      map.erase( it );
+   }
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline _T * ShardedHashMap<_KeyType,_T,_Hash>::acquire ( const _KeyType &key )
+{
+   Shard &shard = getShards()[shardIndex( key )];
+   SyncLockBlock lock( shard._lock );
+
+   typename ShardMap::iterator it = shard._map.find( key );
+   if ( it == shard._map.end() ) {
+      it = shard._map.insert( std::make_pair( key, Entry( NEW _T() ) ) ).first;
+   }
+   it->second._pins++;
+   return it->second._value;
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline void ShardedHashMap<_KeyType,_T,_Hash>::release ( const _KeyType &key )
+{
+   Shard &shard = _shards[shardIndex( key )];
+   SyncLockBlock lock( shard._lock );
+
+   typename ShardMap::iterator it = shard._map.find( key );
+   ensure( it != shard._map.end() && it->second._pins > 0, "Releasing a key that was not acquired" );
+   it->second._pins--;
+   eraseIfUnused( shard._map, it );
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline void ShardedHashMap<_KeyType,_T,_Hash>::acquireAll ( EntryList &entries )
+{
+   if ( _shards == NULL ) return;
+
+   for ( size_t i = 0; i < _numShards; i++ ) {
+      Shard &shard = _shards[i];
+      SyncLockBlock lock( shard._lock );
+      for ( typename ShardMap::iterator it = shard._map.begin(); it != shard._map.end(); it++ ) {
+         it->second._pins++;
+         entries.push_back( std::make_pair( it->first, it->second._value ) );
+      }
+   }
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline void ShardedHashMap<_KeyType,_T,_Hash>::clear ()
+{
+   if ( _shards == NULL ) return;
+
+   for ( size_t i = 0; i < _numShards; i++ ) {
+      Shard &shard = _shards[i];
+      SyncLockBlock lock( shard._lock );
+      for ( typename ShardMap::iterator it = shard._map.begin(); it != shard._map.end(); it++ ) {
+         ensure( it->second._pins == 0, "Clearing a map with acquired keys" );
+         delete it->second._value;
+      }
+      shard._map.clear();
+   }
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline ShardedHashMap<_KeyType,_T,_Hash>::Accessor::Accessor ( ShardedHashMap &map, const _KeyType &key )
+   : _shard( NULL ), _it(), _found( false )
+{
+   if ( map._shards == NULL ) return;
+
+   _shard = &map._shards[map.shardIndex( key )];
+   _shard->_lock.acquire();
+   _it = _shard->_map.find( key );
+   _found = _it != _shard->_map.end();
+}
+
+template <typename _KeyType, typename _T, typename _Hash>
+inline ShardedHashMap<_KeyType,_T,_Hash>::Accessor::~Accessor ()
+{
+   if ( _shard == NULL ) return;
+
+   if ( _found ) eraseIfUnused( _shard->_map, _it );
+   _shard->_lock.release();
+}
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,161 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SHARDEDHASHMAP_DECL
+#define _NANOS_SHARDEDHASHMAP_DECL
+
+#include <vector>
+#include <utility>
+#include "compatibility.hpp"
+#include "lock_decl.hpp"
+#include "allocator_decl.hpp"
+
+namespace nanos {
+
+   /*! \brief Hash map split in independently locked shards
+    *
+    *  Keys are spread over a fixed number of shards, each one being an
+    *  unordered map protected by its own lock, so threads working on keys
+    *  of different shards do not contend. The map owns its values, which
+    *  are created on first access and deleted once they become empty:
+    *  - acquire() looks up or inserts the value of a key and pins it. A
+    *    pinned value is never removed, so it can be used without holding
+    *    any lock until release() unpins it.
+    *  - Accessor gives access to an existing value with its shard locked.
+    *
+    *  Whenever a value is unpinned and empty (_T::isEmpty()) on release()
+    *  or when an Accessor goes out of scope, it is removed from the map.
+    *  The shard array is only allocated on the first insertion, as most
+    *  maps of short lived objects are never used.
+    */
+   template <typename _KeyType, typename _T, typename _Hash = TR1::hash<_KeyType> >
+   class ShardedHashMap
+   {
+      public:
+         enum {
+            DEFAULT_SHARDS = 64     /**< Default number of shards */
+         };
+
+         typedef std::vector< std::pair<_KeyType, _T*> > EntryList; /**< List of pinned entries, see acquireAll() */
+
+      private:
+         struct Entry {
+            _T             *_value;
+            unsigned int    _pins;  /**< Number of acquire() not yet released */
+
+            Entry ( _T *value ) : _value( value ), _pins( 0 ) {}
+         };
+
+         typedef TR1::unordered_map<_KeyType, Entry, _Hash> ShardMap;
+
+         struct Shard {
+            Lock        _lock;
+            ShardMap    _map;
+            char        _pad[NANOS_CACHELINE - ( sizeof(Lock) + sizeof(ShardMap) ) % NANOS_CACHELINE];
+
+            Shard () : _lock(), _map() {}
+         };
+
+         size_t            _numShards;  /**< Number of shards (a power of two) */
+         Shard * volatile  _shards;     /**< Cache line aligned shards, NULL until the first insertion */
+         _Hash             _hash;
+
+         /*! \brief ShardedHashMap copy assignment operator (private)
+          */
+         const ShardedHashMap & operator= ( const ShardedHashMap & );
+
+         /*! \brief Returns the index of the shard holding key */
+         size_t shardIndex ( const _KeyType &key ) const;
+         /*! \brief Returns the shards, allocating them if needed */
+         Shard * getShards ();
+         /*! \brief Allocates numShards shards starting at a cache line boundary */
+         static Shard * allocateShards ( size_t numShards );
+         /*! \brief Deletes shards got from allocateShards */
+         static void deleteShards ( Shard *shards, size_t numShards );
+         /*! \brief Removes the entry if it is no longer pinned nor used, shard lock must be held */
+         static void eraseIfUnused ( ShardMap &map, typename ShardMap::iterator it );
+
+      public:
+         /*! \brief Gives locked access to the value of an existing key
+          *
+          *  The shard of the key stays locked while the Accessor is alive, so
+          *  it must not be kept across calls that may access the same map.
+          */
+         class Accessor
+         {
+            private:
+               Shard                        *_shard;
+               typename ShardMap::iterator   _it;
+               bool                          _found;
+
+               /*! \brief Accessor copy constructor (private)
+                */
+               Accessor ( const Accessor & );
+               /*! \brief Accessor copy assignment operator (private)
+                */
+               const Accessor & operator= ( const Accessor & );
+
+            public:
+               /*! \brief Locks the shard of key and looks it up
+                */
+               Accessor ( ShardedHashMap &map, const _KeyType &key );
+               /*! \brief Removes the value if it is empty and unlocks the shard
+                */
+               ~Accessor ();
+
+               /*! \brief Returns whether the key is in the map */
+               bool found () const { return _found; }
+
+               _T & operator* () const { return *_it->second._value; }
+               _T * operator-> () const { return _it->second._value; }
+         };
+
+         /*! \brief ShardedHashMap constructor
+          *  \param numShards Number of shards, rounded up to a power of two
+          */
+         ShardedHashMap ( size_t numShards = DEFAULT_SHARDS );
+         /*! \brief ShardedHashMap copy constructor, copying the values
+          */
+         ShardedHashMap ( const ShardedHashMap &map );
+         /*! \brief ShardedHashMap destructor, deleting the values
+          */
+         ~ShardedHashMap ();
+
+         /*! \brief Returns the value of key, inserting a new one if needed, and pins it */
+         _T * acquire ( const _KeyType &key );
+         /*! \brief Unpins the value of key, removing it if it is empty */
+         void release ( const _KeyType &key );
+
+         /*! \brief Pins all the values in the map and appends them to entries
+          *
+          *  No shard lock is held on return, so the values may be used to call
+          *  code that accesses the map again. Each entry must be released.
+          */
+         void acquireAll ( EntryList &entries );
+
+         /*! \brief Deletes all the values in the map
+          *
+          *  Must not be called while any value is pinned.
+          */
+         void clear ();
+   };
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,202 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMALLSET
+#define _NANOS_SMALLSET
+
+#include "smallset_decl.hpp"
+#include "new_decl.hpp"
+#include <string.h>
+
+namespace nanos {
+
+template <typename _T, size_t _N, typename _Hash>
+inline SmallSet<_T,_N,_Hash>::SmallSet ( const SmallSet &set ) : _data( _inline ), _size( 0 ), _capacity( _N )
+{
+   *this = set;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline const SmallSet<_T,_N,_Hash> & SmallSet<_T,_N,_Hash>::operator= ( const SmallSet &set )
+{
+   if ( this == &set ) return *this;
+
+   _size = 0;
+   if ( set._size > _capacity ) {
+      unsigned int capacity = MIN_HEAP_CAPACITY;
+      while ( capacity < set._size ) capacity <<= 1;
+      grow( capacity );
+   }
+   for ( unsigned int i = 0; i < set._size; i++ ) _data[i] = set._data[i];
+   _size = set._size;
+   buildIndex();
+   return *this;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline SmallSet<_T,_N,_Hash>::~SmallSet ()
+{
+   if ( isSpilled() ) delete[] (char *) _data;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline unsigned int * SmallSet<_T,_N,_Hash>::getIndex () const
+{
+   if ( !isSpilled() || _capacity < INDEX_THRESHOLD ) return NULL;
+   return (unsigned int *) ( _data + _capacity );
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline unsigned int SmallSet<_T,_N,_Hash>::hashSlot ( _T const &value ) const
+{
+   // The index has 2 * _capacity slots; mix the hash as pointers share their low bits
+   size_t h = _Hash()( value );
+   h ^= h >> 16;
+   h *= 0x45d9f3b;
+   h ^= h >> 16;
+   return h & ( 2 * _capacity - 1 );
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline unsigned int SmallSet<_T,_N,_Hash>::findSlot ( unsigned int *index, _T const &value ) const
+{
+   // Index entries hold the position of the value plus one, 0 being an empty slot
+   unsigned int mask = 2 * _capacity - 1;
+   unsigned int slot = hashSlot( value );
+   while ( index[slot] != 0 && !( _data[index[slot] - 1] == value ) ) slot = ( slot + 1 ) & mask;
+   return slot;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline void SmallSet<_T,_N,_Hash>::buildIndex ()
+{
+   unsigned int *index = getIndex();
+   if ( index == NULL ) return;
+
+   memset( index, 0, 2 * _capacity * sizeof(unsigned int) );
+   for ( unsigned int i = 0; i < _size; i++ ) index[findSlot( index, _data[i] )] = i + 1;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline void SmallSet<_T,_N,_Hash>::grow ( unsigned int capacity )
+{
+   size_t bytes = capacity * sizeof(_T);
+   if ( capacity >= INDEX_THRESHOLD ) bytes += 2 * capacity * sizeof(unsigned int);
+
+   _T *data = (_T *) NEW char[bytes];
+   for ( unsigned int i = 0; i < _size; i++ ) data[i] = _data[i];
+   if ( isSpilled() ) delete[] (char *) _data;
+
+   _data = data;
+   _capacity = capacity;
+   buildIndex();
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline void SmallSet<_T,_N,_Hash>::eraseSlot ( unsigned int *index, unsigned int slot )
+{
+   // Backward shift deletion: move up the entries whose probe sequence crosses the hole
+   unsigned int mask = 2 * _capacity - 1;
+   unsigned int next = slot;
+   while ( true ) {
+      next = ( next + 1 ) & mask;
+      if ( index[next] == 0 ) break;
+      unsigned int home = hashSlot( _data[index[next] - 1] );
+      bool movable = slot <= next ? ( home <= slot || home > next ) : ( home <= slot && home > next );
+      if ( movable ) {
+         index[slot] = index[next];
+         slot = next;
+      }
+   }
+   index[slot] = 0;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline typename SmallSet<_T,_N,_Hash>::iterator SmallSet<_T,_N,_Hash>::find ( _T const &value )
+{
+   unsigned int *index = getIndex();
+   if ( index != NULL ) {
+      unsigned int pos = index[findSlot( index, value )];
+      return pos == 0 ? end() : _data + pos - 1;
+   }
+   for ( unsigned int i = 0; i < _size; i++ ) {
+      if ( _data[i] == value ) return _data + i;
+   }
+   return end();
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline typename SmallSet<_T,_N,_Hash>::const_iterator SmallSet<_T,_N,_Hash>::find ( _T const &value ) const
+{
+   return const_cast<SmallSet *>( this )->find( value );
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline std::pair<typename SmallSet<_T,_N,_Hash>::iterator, bool> SmallSet<_T,_N,_Hash>::insert ( _T const &value )
+{
+   iterator it = find( value );
+   if ( it != end() ) return std::make_pair( it, false );
+
+   if ( _size == _capacity ) {
+      unsigned int capacity = MIN_HEAP_CAPACITY;
+      while ( capacity <= _capacity ) capacity <<= 1;
+      grow( capacity );
+   }
+
+   _data[_size] = value;
+   unsigned int *index = getIndex();
+   if ( index != NULL ) index[findSlot( index, value )] = _size + 1;
+   return std::make_pair( _data + _size++, true );
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline typename SmallSet<_T,_N,_Hash>::iterator SmallSet<_T,_N,_Hash>::erase ( iterator it )
+{
+   unsigned int pos = it - _data;
+   unsigned int last = _size - 1;
+   unsigned int *index = getIndex();
+
+   if ( index != NULL ) {
+      eraseSlot( index, findSlot( index, _data[pos] ) );
+      if ( pos != last ) index[findSlot( index, _data[last] )] = pos + 1;
+   }
+   _data[pos] = _data[last];
+   _size--;
+   return it;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline size_t SmallSet<_T,_N,_Hash>::erase ( _T const &value )
+{
+   iterator it = find( value );
+   if ( it == end() ) return 0;
+   erase( it );
+   return 1;
+}
+
+template <typename _T, size_t _N, typename _Hash>
+inline void SmallSet<_T,_N,_Hash>::clear ()
+{
+   _size = 0;
+   buildIndex();
+}
+
+} // namespace nanos
+
+#endif
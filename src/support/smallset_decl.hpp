@@ -0,0 +1,128 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#ifndef _NANOS_SMALLSET_DECL
+#define _NANOS_SMALLSET_DECL
+
+#include <utility>
+#include <stddef.h>
+#include "compatibility.hpp"
+
+namespace nanos {
+
+   /*! \brief Set of plain values kept in an array with inline storage
+    *
+    *  The first _N values are stored inside the object, so small sets need
+    *  no allocation at all. Bigger ones spill to a heap array, which grows
+    *  by doubling. Duplicates are detected by a linear scan while the set is
+    *  small, and through an open addressing index of the array, kept in the
+    *  same allocation, once it holds INDEX_THRESHOLD values or more.
+    *
+    *  Values are kept in insertion order until an erase, which moves the
+    *  last value into the erased position. Iterators are plain pointers and
+    *  are invalidated by insert() and erase(), except for the iterator
+    *  returned by erase() itself, so that erasing while iterating is:
+    *  \code
+    *  for ( it = set.begin(); it != set.end(); ) {
+    *     if ( ... ) it = set.erase( it );
+    *     else it++;
+    *  }
+    *  \endcode
+    *  _T must be a plain type (e.g. a pointer), as it is copied with
+    *  assignment into raw storage.
+    */
+   template <typename _T, size_t _N, typename _Hash = TR1::hash<_T> >
+   class SmallSet
+   {
+      public:
+         typedef _T           value_type;
+         typedef _T *         iterator;
+         typedef _T const *   const_iterator;
+
+         enum {
+            MIN_HEAP_CAPACITY = 8,  /**< Capacity of the first heap array (a power of two) */
+            INDEX_THRESHOLD = 16    /**< Heap capacity from which an index is kept */
+         };
+
+      private:
+         _T               *_data;       /**< Values, either _inline or a heap array */
+         unsigned int      _size;       /**< Number of values */
+         unsigned int      _capacity;   /**< Capacity of _data */
+         _T                _inline[_N]; /**< Inline storage */
+
+         /*! \brief Returns whether _data is a heap array */
+         bool isSpilled () const { return _data != _inline; }
+         /*! \brief Returns the index of a heap array, or NULL if it has none */
+         unsigned int * getIndex () const;
+         /*! \brief Returns the index slot where value is, or where it would be */
+         unsigned int findSlot ( unsigned int *index, _T const &value ) const;
+         /*! \brief Returns the first index slot for value */
+         unsigned int hashSlot ( _T const &value ) const;
+         /*! \brief Sets the index entries of all the values */
+         void buildIndex ();
+         /*! \brief Moves the values to a heap array of the given capacity */
+         void grow ( unsigned int capacity );
+         /*! \brief Removes the index entry at slot, keeping the probe sequences of the others */
+         void eraseSlot ( unsigned int *index, unsigned int slot );
+
+      public:
+         /*! \brief SmallSet default constructor
+          */
+         SmallSet () : _data( _inline ), _size( 0 ), _capacity( _N ) {}
+         /*! \brief SmallSet copy constructor
+          */
+         SmallSet ( const SmallSet &set );
+         /*! \brief SmallSet copy assignment operator
+          */
+         const SmallSet & operator= ( const SmallSet &set );
+         /*! \brief SmallSet destructor
+          */
+         ~SmallSet ();
+
+         iterator begin () { return _data; }
+         iterator end () { return _data + _size; }
+         const_iterator begin () const { return _data; }
+         const_iterator end () const { return _data + _size; }
+
+         size_t size () const { return _size; }
+         bool empty () const { return _size == 0; }
+
+         /*! \brief Returns an iterator to value, or end() if it is not in the set */
+         iterator find ( _T const &value );
+         const_iterator find ( _T const &value ) const;
+
+         /*! \brief Adds value unless already there
+          *  \return iterator to value and whether it was inserted
+          */
+         std::pair<iterator, bool> insert ( _T const &value );
+
+         /*! \brief Removes the value at it
+          *  \return iterator to the next value to visit (the same position)
+          */
+         iterator erase ( iterator it );
+         /*! \brief Removes value, returning the number of values removed (0 or 1) */
+         size_t erase ( _T const &value );
+
+         /*! \brief Removes all values, keeping the storage */
+         void clear ();
+   };
+
+} // namespace nanos
+
+#endif
@@ -0,0 +1,63 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking that Allocator keeps objects apart when they span several Arenas
+ * and that it can keep working after the extra Arenas have been completely freed.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator"
+</testinfo>*/
+
+#include <iostream>
+#include "allocator.hpp"
+
+using namespace nanos;
+
+#define NUM_OBJECTS 3500
+#define ROUNDS 4
+
+int *objects[NUM_OBJECTS];
+
+int main (int argc, char **argv)
+{
+   Allocator my_allocator;
+
+   for ( int r = 0; r < ROUNDS; r++ ) {
+      for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+         objects[i] = (int *) my_allocator.allocate( 4 * sizeof(int) );
+         if ( objects[i] == NULL ) return -1;
+         for ( int j = 0; j < 4; j++ ) objects[i][j] = i + r;
+      }
+
+      // Check no object has been handed out twice
+      for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+         for ( int j = 0; j < 4; j++ ) {
+            if ( objects[i][j] != i + r ) return -1;
+         }
+      }
+
+      // Odd rounds free in reverse order, so the first Arena is emptied last
+      for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+         Allocator::deallocate( objects[ r % 2 ? NUM_OBJECTS - 1 - i : i ] );
+      }
+   }
+
+   return 0;
+}
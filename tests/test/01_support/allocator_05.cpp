@@ -0,0 +1,162 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking Allocator when another thread frees the objects of an Allocator spanning
+ * several Arenas: the owner must get them back from the remote free lists when it runs out of
+ * entries, and keep a non-first Arena as spare once its last object is freed after draining it.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a --gpus=0,--smp-workers=2"
+</testinfo>*/
+
+#include <iostream>
+#include "config.hpp"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "allocator.hpp"
+
+using namespace std;
+using namespace nanos;
+using namespace nanos::ext;
+
+#define PER_ARENA NANOS_OBJECTS_PER_ARENA
+#define NUM_OBJECTS ( 2 * PER_ARENA + PER_ARENA / 2 )
+#define OBJECT_INTS 4
+
+int *objects[NUM_OBJECTS];
+int *reused[NUM_OBJECTS];
+int result = 0;
+
+void fill ( int *object, int value );
+bool holds ( int *object, int value );
+void remote_free ( void *args );
+void owner ( void *args );
+int check_allocator ( void );
+
+void fill ( int *object, int value )
+{
+   for ( int j = 0; j < OBJECT_INTS; j++ ) object[j] = value;
+}
+
+bool holds ( int *object, int value )
+{
+   for ( int j = 0; j < OBJECT_INTS; j++ ) {
+      if ( object[j] != value ) return false;
+   }
+   return true;
+}
+
+// Frees every object but the first one of the second Arena
+void remote_free ( void *args )
+{
+   for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+      if ( i != PER_ARENA ) Allocator::deallocate( objects[i] );
+   }
+}
+
+// Runs tied to the first thread, so that it is always the owner of the Arenas, and the second one frees them
+int check_allocator ( void )
+{
+   Allocator my_allocator;
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+
+   // Objects are handed out in order, so they fill three Arenas
+   for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+      objects[i] = (int *) my_allocator.allocate( OBJECT_INTS * sizeof(int) );
+      if ( objects[i] == NULL ) return -1;
+      fill( objects[i], i );
+   }
+
+   WD * wd = new WD( new SMPDD( remote_free ), 0, 1, NULL );
+   wg->addWork( *wd );
+   wd->tieTo( team[1] );
+   sys.submit( *wd );
+   wg->waitCompletion();
+
+   // The first Arena is full, so it must drain its remote free list to give these out
+   for ( int i = 0; i < PER_ARENA; i++ ) {
+      reused[i] = (int *) my_allocator.allocate( OBJECT_INTS * sizeof(int) );
+      if ( reused[i] == NULL ) return -1;
+      fill( reused[i], -i );
+   }
+   for ( int i = 0; i < PER_ARENA; i++ ) {
+      bool found = false;
+      for ( int j = 0; j < PER_ARENA && !found; j++ ) found = ( reused[i] == objects[j] );
+      if ( !found ) {
+         cerr << "Object " << i << " was not taken from the remote free list" << endl;
+         return -1;
+      }
+   }
+
+   // The second Arena drains the objects freed by the other thread and becomes unused
+   if ( !holds( objects[PER_ARENA], PER_ARENA ) ) return -1;
+   Allocator::deallocate( objects[PER_ARENA] );
+
+   // It is kept as spare and gives out its objects again, in order, before the third one drains its own
+   for ( int i = PER_ARENA; i < NUM_OBJECTS; i++ ) {
+      reused[i] = (int *) my_allocator.allocate( OBJECT_INTS * sizeof(int) );
+      if ( reused[i] == NULL ) return -1;
+      fill( reused[i], -i );
+   }
+   for ( int i = PER_ARENA; i < 2 * PER_ARENA; i++ ) {
+      if ( reused[i] != objects[i] ) {
+         cerr << "Object " << i << " was not taken from the spare Arena" << endl;
+         return -1;
+      }
+   }
+
+   // Check no object has been handed out twice
+   for ( int i = 0; i < NUM_OBJECTS; i++ ) {
+      if ( !holds( reused[i], -i ) ) {
+         cerr << "Object " << i << " was handed out twice" << endl;
+         return -1;
+      }
+   }
+
+   for ( int i = 0; i < NUM_OBJECTS; i++ ) Allocator::deallocate( reused[i] );
+
+   return 0;
+}
+
+void owner ( void *args )
+{
+   result = check_allocator();
+}
+
+int main ( int argc, char **argv )
+{
+   int num_pes = sys.getSMPPlugin()->getNumWorkers();
+   if ( num_pes < 2 ) {
+      cout << "Skipping " << argv[0] << " test, it needs two threads" << endl;
+      return 0;
+   }
+
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+
+   WD * wd = new WD( new SMPDD( owner ), 0, 1, NULL );
+   wg->addWork( *wd );
+   wd->tieTo( team[0] );
+   sys.submit( *wd );
+   wg->waitCompletion();
+
+   return result;
+}
@@ -0,0 +1,91 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking ShardedCounter updates from several threads, each thread
+ * adding and subtracting on its own shard, and the exact and approximate reads of
+ * the resulting value.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a \"--gpus=0\""
+</testinfo>*/
+
+#include <iostream>
+#include "config.hpp"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "shardedcounter.hpp"
+
+using namespace std;
+using namespace nanos;
+using namespace nanos::ext;
+
+#define TIMES 10000
+#define INIT_VALUE 7
+
+ShardedCounter counter( INIT_VALUE );
+
+void update( void *args );
+
+void update( void *args )
+{
+   int id = *((int *) args);
+
+   for ( int n = 0; n < TIMES; n++ ) {
+      counter++;
+      counter += id + 2;
+      --counter;
+      counter -= id + 1;
+   }
+}
+
+int main ( int argc, char **argv )
+{
+   int num_pes = sys.getSMPPlugin()->getNumWorkers();
+   int id[num_pes];
+
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+   for ( int i = 0; i < num_pes; i++ ) {
+      id[i] = i;
+      WD * wd = new WD( new SMPDD( update ), sizeof( int ), __alignof__( int ), &id[i]  );
+      wg->addWork( *wd );
+      wd->tieTo(team[i]);
+      sys.submit( *wd );
+   }
+
+   wg->waitCompletion();
+
+   int expected = INIT_VALUE + num_pes * TIMES;
+   if ( counter.value() != expected ) {
+      cout << "Wrong exact value: " << counter.value() << " (expected " << expected << ")" << endl;
+      return -1;
+   }
+
+   // The snapshot is refreshed at least once every SNAPSHOT_READS reads
+   int approx = 0;
+   for ( int i = 0; i < ShardedCounter::SNAPSHOT_READS; i++ ) approx = counter.approxValue();
+   if ( approx != expected ) {
+      cout << "Wrong approximate value: " << approx << " (expected " << expected << ")" << endl;
+      return -1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,128 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking ShardedHashMap from several threads acquiring and
+ * releasing the same keys, and the removal of values once they are empty and
+ * no longer acquired.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a \"--gpus=0\""
+</testinfo>*/
+
+#include <iostream>
+#include "config.hpp"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "shardedhashmap.hpp"
+
+using namespace std;
+using namespace nanos;
+using namespace nanos::ext;
+
+#define TIMES 10000
+#define NUM_KEYS 100
+
+class Value
+{
+   public:
+      static Atomic<int> _live;
+      Atomic<int> _users;
+
+      Value () : _users( 0 ) { _live++; }
+      Value ( const Value &v ) : _users( 0 ) { _live++; }
+      ~Value () { _live--; }
+
+      bool isEmpty () { return _users.value() == 0; }
+};
+
+Atomic<int> Value::_live( 0 );
+
+typedef ShardedHashMap<size_t, Value> Map;
+
+Map values;
+bool error = false;
+
+void update( void *args );
+
+void update( void *args )
+{
+   int id = *((int *) args);
+
+   for ( int n = 0; n < TIMES; n++ ) {
+      size_t key = ( ( n + id ) % NUM_KEYS ) * sizeof( double );
+      Value *value = values.acquire( key );
+      value->_users++;
+      if ( values.acquire( key ) != value ) error = true;
+      values.release( key );
+      value->_users--;
+      values.release( key );
+   }
+}
+
+int main ( int argc, char **argv )
+{
+   int num_pes = sys.getSMPPlugin()->getNumWorkers();
+   int id[num_pes];
+
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+   for ( int i = 0; i < num_pes; i++ ) {
+      id[i] = i;
+      WD * wd = new WD( new SMPDD( update ), sizeof( int ), __alignof__( int ), &id[i]  );
+      wg->addWork( *wd );
+      wd->tieTo(team[i]);
+      sys.submit( *wd );
+   }
+
+   wg->waitCompletion();
+
+   if ( error ) {
+      cout << "Acquiring a pinned key returned a different value" << endl;
+      return -1;
+   }
+
+   // Released values are empty, so they must have been removed
+   if ( Value::_live.value() != 0 ) {
+      cout << "Wrong number of live values: " << Value::_live.value() << " (expected 0)" << endl;
+      return -1;
+   }
+
+   // Values stay while they are not empty, even if no longer acquired
+   values.acquire( 1 )->_users++;
+   values.release( 1 );
+   {
+      Map::Accessor value( values, 1 );
+      if ( !value.found() ) {
+         cout << "Non empty value was removed" << endl;
+         return -1;
+      }
+      value->_users--;
+   }
+   {
+      Map::Accessor value( values, 1 );
+      if ( value.found() || Value::_live.value() != 0 ) {
+         cout << "Empty value was not removed" << endl;
+         return -1;
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,112 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking SmallSet insertion, lookup and removal, both with the
+ * values in the inline storage and spilled to a heap array with an index,
+ * against a std::set holding the same values.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a \"--gpus=0\""
+</testinfo>*/
+
+#include <iostream>
+#include <set>
+#include <stdlib.h>
+#include "smallset.hpp"
+
+using namespace std;
+using namespace nanos;
+
+#define NUM_VALUES 1000
+#define NUM_OPS 100000
+
+typedef SmallSet<int *, 4> Set;
+
+int values[NUM_VALUES];
+
+static bool check ( Set &set, std::set<int *> &reference )
+{
+   if ( set.size() != reference.size() ) {
+      cout << "Wrong size: " << set.size() << " (expected " << reference.size() << ")" << endl;
+      return false;
+   }
+   for ( Set::iterator it = set.begin(); it != set.end(); it++ ) {
+      if ( reference.find( *it ) == reference.end() ) {
+         cout << "Unexpected value in the set" << endl;
+         return false;
+      }
+   }
+   for ( std::set<int *>::iterator it = reference.begin(); it != reference.end(); it++ ) {
+      if ( set.find( *it ) == set.end() ) {
+         cout << "Missing value in the set" << endl;
+         return false;
+      }
+   }
+   return true;
+}
+
+int main ( int argc, char **argv )
+{
+   Set set;
+   std::set<int *> reference;
+
+   srand( 7 );
+
+   // Random inserts and erases over a growing range of values, so that
+   // the set goes through the inline storage and several heap arrays
+   for ( int n = 0; n < NUM_OPS; n++ ) {
+      int range = 8 + ( n * NUM_VALUES ) / NUM_OPS;
+      int *value = &values[rand() % range];
+      if ( rand() % 3 == 0 ) {
+         if ( set.erase( value ) != reference.erase( value ) ) {
+            cout << "Wrong erase result" << endl;
+            return -1;
+         }
+      } else {
+         if ( set.insert( value ).second != reference.insert( value ).second ) {
+            cout << "Wrong insert result" << endl;
+            return -1;
+         }
+      }
+      if ( n % 1000 == 0 && !check( set, reference ) ) return -1;
+   }
+   if ( !check( set, reference ) ) return -1;
+
+   // Copies hold the same values
+   Set copy( set );
+   if ( !check( copy, reference ) ) return -1;
+
+   // Erasing while iterating visits all the values
+   for ( Set::iterator it = set.begin(); it != set.end(); ) {
+      if ( ( *it - values ) % 2 == 0 ) {
+         reference.erase( *it );
+         it = set.erase( it );
+      } else {
+         it++;
+      }
+   }
+   if ( !check( set, reference ) ) return -1;
+
+   set.clear();
+   reference.clear();
+   if ( !check( set, reference ) ) return -1;
+
+   return 0;
+}
@@ -0,0 +1,142 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/core-generator -a --adaptive-idle,--enable-block|--adaptive-idle,--enable-sleep"
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include "atomic.hpp"
+#include <iostream>
+#include <unistd.h>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+// Short bursts of tiny tasks separated by serial phases much longer than a wake up
+#define NUM_BURSTS    20
+#define NUM_TASKS     500
+#define SERIAL_US     2000
+
+Atomic<int> A;
+
+bool checkAdaptation ( void );
+
+void task ( void *args );
+
+void task ( void *args )
+{
+   A++;
+}
+
+/*
+ * A tuner fed with known measurements must follow them: a longer wake up
+ * latency makes spinning cheaper than giving up the CPU for longer, and
+ * idle phases longer than a wake up make spinning useless.
+ */
+bool checkAdaptation ( void )
+{
+   bool check = true;
+   IdleTuner tuner;
+   double latency = tuner.getWakeLatency();
+   double spin = tuner.getSpinTime();
+
+   // Sleeps overshooting by ten times the latency
+   for ( int i = 0; i < 16; i++ ) tuner.slept( 0.0, latency * 10 );
+   if ( tuner.getWakeLatency() <= latency || tuner.getSpinTime() <= spin ) {
+      cerr << "Spin time " << tuner.getSpinTime() << " did not grow with wake latency "
+           << tuner.getWakeLatency() << endl;
+      check = false;
+   }
+
+   // Sleeps without overshoot
+   latency = tuner.getWakeLatency();
+   spin = tuner.getSpinTime();
+   for ( int i = 0; i < 16; i++ ) tuner.slept( 0.0, 0.0 );
+   if ( tuner.getWakeLatency() >= latency || tuner.getSpinTime() >= spin ) {
+      cerr << "Spin time " << tuner.getSpinTime() << " did not shrink with wake latency "
+           << tuner.getWakeLatency() << endl;
+      check = false;
+   }
+
+   // Idle phases much longer than a wake up, at a constant latency
+   spin = tuner.getSpinTime();
+   for ( int i = 0; i < 4; i++ ) {
+      tuner.beginIdle();
+      usleep( (useconds_t) ( tuner.getWakeLatency() * 1.0e6 * 4 ) + 1 );
+      tuner.endIdle();
+   }
+   if ( tuner.getSpinTime() >= spin ) {
+      cerr << "Spin time " << tuner.getSpinTime() << " did not shrink with long idle phases" << endl;
+      check = false;
+   }
+
+   return check;
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = checkAdaptation();
+
+   for ( int burst = 0; burst < NUM_BURSTS; ++burst ) {
+      A = 0;
+
+      WD *wg = getMyThreadSafe()->getCurrentWD();
+      for ( int i = 0; i < NUM_TASKS; i++ ) {
+         WD * wd = new WD( new SMPDD( task ), 0, 1, NULL );
+         wg->addWork( *wd );
+         sys.submit( *wd );
+      }
+      wg->waitCompletion();
+
+      if ( A.value() != NUM_TASKS ) check = false;
+
+      usleep( SERIAL_US );
+   }
+
+   /*
+    * Spin budgets must stay between the minimum and the cost of a wake up,
+    * whatever the threads measured.
+    */
+   for ( int i = 0; i < sys.getNumWorkers(); i++ ) {
+      IdleTuner &tuner = sys.getWorker( i )->getIdleTuner();
+      double latency = tuner.getWakeLatency();
+      double spin = tuner.getSpinTime();
+      if ( latency <= 0.0 || spin < latency / 16 * 0.99 || spin > latency * 1.01 ) {
+         cerr << "Thread " << i << " has spin time " << spin << " for wake latency " << latency << endl;
+         check = false;
+      }
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,64 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+#include <stdio.h>
+#include <sched.h>
+#include "system.hpp"
+#include "os.hpp"
+
+/*
+<testinfo>
+   test_generator="gens/core-generator -a --no-warmup-threads|--warmup-threads"
+   test_generator_ENV=( "NX_TEST_MAX_CPUS=4"
+                        "NX_TEST_SCHEDULE=bf"
+                        "NX_TEST_ARCH=smp")
+   test_exec_command="timeout 1m"
+</testinfo>
+*/
+
+/* Workers leave and rejoin the team over and over. The team keeps the TeamData of the
+ * threads that left it, and must give it back to them when they rejoin: once all of them
+ * are back in the team, it must not keep any */
+#define ITERS 1000
+
+using namespace nanos;
+
+int main ( int argc, char *argv[])
+{
+   int i, error = 0;
+   unsigned nths = 0;
+   int max_threads = sys.getNumThreads();
+   ThreadTeam *team = myThread->getTeam();
+
+   for ( i=0; i<ITERS; i++ ) {
+
+      nths = (nths % max_threads) + 1;
+
+      sys.updateActiveWorkers( nths );
+   }
+
+   sys.updateActiveWorkers( max_threads );
+   while ( team->size() != (size_t) max_threads ) sched_yield();
+
+   fprintf(stdout,"Team keeps %d TeamData of left threads and 0 are expected\n", (int) team->getNumLeftTeamData() );
+   if ( team->getNumLeftTeamData() != 0 ) error++;
+
+   fprintf(stdout,"Result is %s\n", error? "UNSUCCESSFUL":"successful");
+
+   return error;
+}
@@ -0,0 +1,159 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/api-generator
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* Every iteration of a loop is a task, created and submitted in batches of several sizes.
+ * Each task checks its own argument block and increments its element of the vector.
+ * Creating a batch with copies and submitting a NULL WD must be rejected. */
+#define VECTOR_SIZE 1000
+#define NUM_ITERS 10
+
+int A[VECTOR_SIZE];
+
+typedef struct {
+   int i;
+   int magic;
+} task_args_t;
+
+void increment( task_args_t *args );
+void increment( task_args_t *args )
+{
+   if ( args->magic != ~args->i ) {
+      printf("Error, task %d got the arguments of another task!\n", args->i);
+      abort();
+   }
+   A[args->i]++;
+}
+
+nanos_smp_args_t increment_arg = { (void(*)(void *))increment };
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 increment_data =
+{
+   {{
+      .mandatory_creation = false,
+      .tied = false},
+   __alignof__(task_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &increment_arg
+      }
+   }
+};
+
+struct nanos_const_wd_definition_1 copies_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(task_args_t),
+   1,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &increment_arg
+      }
+   }
+};
+
+static int check_invalid_params ( void )
+{
+   nanos_wd_t wds[2];
+   nanos_wd_t null_wds[2] = { 0, 0 };
+   nanos_wd_dyn_props_t dyn_props = {0};
+
+   if ( nanos_create_wds_compact( wds, 2, &copies_data.base, &dyn_props, sizeof(task_args_t),
+                                  NULL, nanos_current_wd() ) != NANOS_INVALID_PARAM ) {
+      printf("Error: a batch of WDs with copies was created\n");
+      return 1;
+   }
+   if ( nanos_submit_wds( null_wds, 2, 0 ) != NANOS_INVALID_PARAM ) {
+      printf("Error: a batch with NULL WDs was submitted\n");
+      return 1;
+   }
+   return 0;
+}
+
+static void submit_range ( int first, int last )
+{
+   int n = last - first, i;
+   nanos_wd_t wds[n];
+   task_args_t *args[n];
+   nanos_wd_dyn_props_t dyn_props = {0};
+
+   NANOS_SAFE( nanos_create_wds_compact( wds, n, &increment_data.base, &dyn_props, sizeof(task_args_t),
+                                         (void **) args, nanos_current_wd() ) );
+
+   if ( wds[0] == 0 ) {
+      // Creation throttled, run the iterations here
+      for ( i = first; i < last; i++ ) A[i]++;
+      return;
+   }
+
+   for ( i = 0; i < n; i++ ) {
+      args[i]->i = first + i;
+      args[i]->magic = ~( first + i );
+   }
+   NANOS_SAFE( nanos_submit_wds( wds, n, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int batch_sizes[] = { 1, 7, 64, VECTOR_SIZE };
+   int it, i, first;
+
+   if ( check_invalid_params() != 0 ) return 1;
+
+   for ( it = 0; it < NUM_ITERS; it++ ) {
+      int batch = batch_sizes[it % ( sizeof( batch_sizes ) / sizeof( int ) )];
+      for ( first = 0; first < VECTOR_SIZE; first += batch ) {
+         submit_range( first, first + batch < VECTOR_SIZE ? first + batch : VECTOR_SIZE );
+      }
+      NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+   }
+
+   for ( i = 0; i < VECTOR_SIZE; i++ ) {
+      if ( A[i] != NUM_ITERS ) {
+         printf("Error: A[%d] is %d instead of %d\n", i, A[i], NUM_ITERS);
+         return 1;
+      }
+   }
+
+   return 0;
+}
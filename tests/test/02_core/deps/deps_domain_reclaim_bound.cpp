@@ -0,0 +1,141 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+   test_generator="gens/core-generator -d plain,regions,perfect-regions,cregions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include "nanos.h"
+#include "dependenciesdomain.hpp"
+
+/* Same sliding window as test_deps_domain_reclaim.c, but without any taskwait until the end:
+ * only the elements left behind by the window are waited on. Nothing clears the domain then,
+ * so the live TrackableObjects only stay bounded if the domain reclaims the unused regions by
+ * itself, while the number of regions ever touched keeps growing with the rounds. */
+#define WINDOW       2048
+#define STRIDE       1024
+#define NUM_ROUNDS   48
+#define SIZE         ( WINDOW + STRIDE * NUM_ROUNDS )
+#define MAX_TRACKED  ( 4 * ( WINDOW + STRIDE ) )
+
+using namespace nanos;
+
+int v[SIZE];
+int expected[SIZE];
+
+typedef struct { int *elem; int round; } update_args_t;
+
+void update( void *ptr );
+void update( void *ptr )
+{
+   update_args_t *args = ( update_args_t * ) ptr;
+   *args->elem = *args->elem * 3 + args->round;
+}
+
+nanos_smp_args_t update_arg = { update };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 update_data =
+{
+   {{
+      true,  /* mandatory_creation */
+      false  /* tied */ },
+   __alignof__(update_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &update_arg
+      }
+   }
+};
+
+static void submit_update ( int elem, int round )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = nanos_wd_dyn_props_t();
+   update_args_t *args = NULL;
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+   nanos_data_access_t access[1] = {{&v[elem], {1,1,0,0,0}, 1, dimensions, 0}};
+
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &update_data.base, &dyn_props, sizeof(update_args_t), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   args->elem = &v[elem];
+   args->round = round;
+   NANOS_SAFE( nanos_submit( wd, 1, access, 0 ) );
+}
+
+static void wait_on ( int elem )
+{
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+   nanos_data_access_t access[1] = {{&v[elem], {1,0,0,0,0}, 1, dimensions, 0}};
+
+   NANOS_SAFE( nanos_wait_on( 1, access ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int round, i, max_tracked = 0;
+
+   for ( i = 0; i < SIZE; i++ ) v[i] = expected[i] = i;
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      for ( i = round * STRIDE; i < round * STRIDE + WINDOW; i++ ) {
+         submit_update( i, round );
+         expected[i] = expected[i] * 3 + round;
+      }
+
+      /* The window will not touch these elements again */
+      for ( i = round * STRIDE; i < ( round + 1 ) * STRIDE; i++ ) {
+         wait_on( i );
+      }
+
+      int tracked = DependenciesDomain::getNumTrackedObjects();
+      if ( tracked > max_tracked ) max_tracked = tracked;
+   }
+
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   fprintf( stdout, "At most %d TrackableObjects were alive and %d are allowed\n", max_tracked, MAX_TRACKED );
+   if ( max_tracked > MAX_TRACKED ) {
+      fprintf( stdout, "Error: the domain kept the regions of %d elements\n", SIZE );
+      return 1;
+   }
+
+   for ( i = 0; i < SIZE; i++ ) {
+      if ( v[i] != expected[i] ) {
+         printf("Error: v[%d] = %d but %d was expected.\n", i, v[i], expected[i]);
+         return 1;
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,130 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* Histogram updates where each task commutatively updates two bins: no two tasks may update
+ * the same bin at the same time, and every task must eventually run */
+#define NUM_BINS 8
+#define NUM_TASKS 400
+#define WORK 2000
+
+int bins[NUM_BINS];
+int busy[NUM_BINS];
+int expected[NUM_BINS];
+int errors = 0;
+
+nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+
+typedef struct {
+   int first;
+   int second;
+} task_args_t;
+
+static void update_bin ( int bin )
+{
+   volatile int i;
+   if ( __sync_fetch_and_add( &busy[bin], 1 ) != 0 ) {
+      printf("Error, bin %d is being updated by two tasks at the same time!\n", bin);
+      __sync_fetch_and_add( &errors, 1 );
+   }
+   for ( i = 0; i < WORK; i++ );
+   bins[bin]++;
+   __sync_fetch_and_sub( &busy[bin], 1 );
+}
+
+void update( task_args_t *args );
+void update( task_args_t *args )
+{
+   update_bin( args->first );
+   if ( args->second != args->first ) update_bin( args->second );
+}
+
+nanos_smp_args_t update_arg = { (void(*)(void *))update };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 update_data =
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(task_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &update_arg
+      }
+   }
+};
+
+int main ( int argc, char **argv )
+{
+   int i;
+
+   for ( i = 0; i < NUM_TASKS; i++ ) {
+      nanos_wd_t wd = 0;
+      nanos_wd_dyn_props_t dyn_props = {0};
+      task_args_t *args = NULL;
+      int first = i % NUM_BINS;
+      int second = ( i * 3 + 1 ) % NUM_BINS;
+      nanos_data_access_t accesses[2] = {
+         {&bins[first], {1,1,0,0,1}, 1, dimensions, 0},
+         {&bins[second], {1,1,0,0,1}, 1, dimensions, 0}
+      };
+
+      NANOS_SAFE( nanos_create_wd_compact ( &wd, &update_data.base, &dyn_props, sizeof(task_args_t), (void **) &args,
+                                            nanos_current_wd(), NULL, NULL ) );
+      args->first = first;
+      args->second = second;
+      NANOS_SAFE( nanos_submit( wd, first != second ? 2 : 1, accesses, 0 ) );
+
+      expected[first]++;
+      if ( second != first ) expected[second]++;
+   }
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   if ( errors != 0 ) return 1;
+
+   for ( i = 0; i < NUM_BINS; i++ ) {
+      if ( bins[i] != expected[i] ) {
+         printf("Error: bin %d is %d instead of %d\n", i, bins[i], expected[i]);
+         return 1;
+      }
+   }
+
+   return 0;
+}
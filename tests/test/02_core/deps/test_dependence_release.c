@@ -0,0 +1,161 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* Each producer writes a and b, but releases a as soon as it is written. The readers of a
+ * may run while the producer is still working on b, while the readers of b must not */
+#define NUM_ROUNDS 100
+#define MAX_SPINS 1000
+
+int a[NUM_ROUNDS];
+int b[NUM_ROUNDS];
+volatile int a_consumed[NUM_ROUNDS];
+int errors = 0;
+int overlapped = 0;
+
+nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+
+typedef struct {
+   int i;
+} task_args_t;
+
+void producer( task_args_t *args );
+void producer( task_args_t *args )
+{
+   int i = args->i, spins;
+   nanos_data_access_t release = {&a[i], {0,1,0,0,0}, 1, dimensions};
+
+   a[i] = i + 1;
+   NANOS_SAFE( nanos_dependence_release( 1, &release ) );
+
+   for ( spins = 0; spins < MAX_SPINS && !a_consumed[i]; spins++ ) {
+      NANOS_SAFE( nanos_yield() );
+   }
+   if ( a_consumed[i] ) __sync_fetch_and_add( &overlapped, 1 );
+
+   b[i] = i + 1;
+}
+
+void consumer_a( task_args_t *args );
+void consumer_a( task_args_t *args )
+{
+   int i = args->i;
+   if ( a[i] != i + 1 ) {
+      printf("Error, reader of a[%d] ran before it was written!\n", i);
+      __sync_fetch_and_add( &errors, 1 );
+   }
+   a_consumed[i] = 1;
+}
+
+void consumer_b( task_args_t *args );
+void consumer_b( task_args_t *args )
+{
+   int i = args->i;
+   if ( a[i] != i + 1 || b[i] != i + 1 ) {
+      printf("Error, reader of b[%d] ran before it was written!\n", i);
+      __sync_fetch_and_add( &errors, 1 );
+   }
+}
+
+nanos_smp_args_t producer_arg = { (void(*)(void *))producer };
+nanos_smp_args_t consumer_a_arg = { (void(*)(void *))consumer_a };
+nanos_smp_args_t consumer_b_arg = { (void(*)(void *))consumer_b };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+#define CONST_DATA(args) \
+{ \
+   {{ \
+      .mandatory_creation = true, \
+      .tied = false}, \
+   __alignof__(task_args_t), \
+   0, \
+   1, \
+   0,NULL}, \
+   { \
+      { \
+         nanos_smp_factory, \
+         &args \
+      } \
+   } \
+}
+
+struct nanos_const_wd_definition_1 producer_data = CONST_DATA(producer_arg);
+struct nanos_const_wd_definition_1 consumer_a_data = CONST_DATA(consumer_a_arg);
+struct nanos_const_wd_definition_1 consumer_b_data = CONST_DATA(consumer_b_arg);
+
+static void submit_task ( struct nanos_const_wd_definition_1 *data, int i, size_t num_accesses, nanos_data_access_t *accesses )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   task_args_t *args = NULL;
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &data->base, &dyn_props, sizeof(task_args_t), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   args->i = i;
+   NANOS_SAFE( nanos_submit( wd, num_accesses, accesses, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int i;
+
+   for ( i = 0; i < NUM_ROUNDS; i++ ) {
+      nanos_data_access_t out_a = {&a[i], {0,1,0,0,0}, 1, dimensions};
+      nanos_data_access_t out_b = {&b[i], {0,1,0,0,0}, 1, dimensions};
+      nanos_data_access_t in_a = {&a[i], {1,0,0,0,0}, 1, dimensions};
+      nanos_data_access_t in_b = {&b[i], {1,0,0,0,0}, 1, dimensions};
+      nanos_data_access_t accesses[2];
+
+      accesses[0] = out_a;
+      accesses[1] = out_b;
+      submit_task( &producer_data, i, 2, accesses );
+
+      accesses[0] = in_a;
+      submit_task( &consumer_a_data, i, 1, accesses );
+
+      accesses[0] = in_a;
+      accesses[1] = in_b;
+      submit_task( &consumer_b_data, i, 2, accesses );
+   }
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   if ( errors != 0 ) return 1;
+
+   printf("%d of %d readers of a ran before their producer finished\n", overlapped, NUM_ROUNDS);
+   if ( overlapped == 0 ) {
+      printf("Error, a was never released before its producer finished\n");
+      return 1;
+   }
+   return 0;
+}
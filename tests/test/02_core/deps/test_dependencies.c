@@ -19,7 +19,7 @@
 
 /*
 <testinfo>
-test_generator="gens/api-generator -d plain,regions,perfect-regions"
+test_generator="gens/api-generator -d plain,regions,perfect-regions,intervals"
 </testinfo>
 */
 
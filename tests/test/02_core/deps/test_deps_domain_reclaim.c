@@ -0,0 +1,120 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions,cregions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* Stresses the reclamation of the regions tracked by a dependencies domain. Every round updates
+ * a window of WINDOW elements that slides STRIDE elements per round, so half of the regions of a
+ * round are new to the domain and the ones left behind become unused while tasks are still in
+ * flight. Each task applies a non-commutative update to its element, so the final values only
+ * match the sequential ones if the accesses of consecutive rounds were ordered. */
+#define WINDOW       2048
+#define STRIDE       1024
+#define NUM_ROUNDS   24
+#define WAIT_EVERY   8
+#define SIZE         ( WINDOW + STRIDE * NUM_ROUNDS )
+
+int v[SIZE];
+int expected[SIZE];
+
+typedef struct { int *elem; int round; } update_args_t;
+
+void update( update_args_t *args );
+void update( update_args_t *args )
+{
+   *args->elem = *args->elem * 3 + args->round;
+}
+
+nanos_smp_args_t update_arg = { (void(*)(void *))update };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+struct nanos_const_wd_definition_1 update_data = 
+{
+   {{
+      .mandatory_creation = true,
+      .tied = false},
+   __alignof__(update_args_t),
+   0,
+   1,
+   0,NULL},
+   {
+      {
+         nanos_smp_factory,
+         &update_arg
+      }
+   }
+};
+
+static void submit_update ( int elem, int round )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   update_args_t *args = NULL;
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+   nanos_data_access_t access[1] = {{&v[elem], {1,1,0,0,0}, 1, dimensions}};
+
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &update_data.base, &dyn_props, sizeof(update_args_t), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   args->elem = &v[elem];
+   args->round = round;
+   NANOS_SAFE( nanos_submit( wd, 1, access, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int round, i;
+
+   for ( i = 0; i < SIZE; i++ ) v[i] = expected[i] = i;
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      for ( i = round * STRIDE; i < round * STRIDE + WINDOW; i++ ) {
+         submit_update( i, round );
+         expected[i] = expected[i] * 3 + round;
+      }
+
+      if ( ( round + 1 ) % WAIT_EVERY == 0 ) {
+         NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+      }
+   }
+
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   for ( i = 0; i < SIZE; i++ ) {
+      if ( v[i] != expected[i] ) {
+         printf("Error: v[%d] = %d but %d was expected.\n", i, v[i], expected[i]);
+         return 1;
+      }
+   }
+
+   return 0;
+}
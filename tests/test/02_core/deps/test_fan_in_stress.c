@@ -0,0 +1,161 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* Stresses the release of many readers followed by one writer. In every round, NUM_READERS tasks
+ * read a (half of them also read b) and then one task writes a and another one writes b, so the
+ * readers finish concurrently while a writer waits for all of them and the readers of both
+ * variables are flushed by two different writers. */
+#define NUM_ROUNDS   200
+#define NUM_READERS  64
+#define WAIT_EVERY   50
+
+int a = 0;
+int b = 0;
+int reads_a = 0;
+int reads_b = 0;
+
+typedef struct { int round; } round_args_t;
+
+void reader_a( round_args_t *args );
+void reader_a( round_args_t *args )
+{
+   if ( a != args->round ) {
+      printf("Error, reader of round %d found a = %d\n", args->round, a);
+      abort();
+   }
+   __sync_fetch_and_add( &reads_a, 1 );
+}
+
+void reader_ab( round_args_t *args );
+void reader_ab( round_args_t *args )
+{
+   if ( a != args->round || b != args->round ) {
+      printf("Error, reader of round %d found a = %d, b = %d\n", args->round, a, b);
+      abort();
+   }
+   __sync_fetch_and_add( &reads_a, 1 );
+   __sync_fetch_and_add( &reads_b, 1 );
+}
+
+void writer_a( round_args_t *args );
+void writer_a( round_args_t *args )
+{
+   if ( reads_a != ( args->round + 1 ) * NUM_READERS ) {
+      printf("Error, writer of round %d ran after %d reads of a\n", args->round, reads_a);
+      abort();
+   }
+   a = args->round + 1;
+}
+
+void writer_b( round_args_t *args );
+void writer_b( round_args_t *args )
+{
+   if ( reads_b != ( args->round + 1 ) * ( NUM_READERS / 2 ) ) {
+      printf("Error, writer of round %d ran after %d reads of b\n", args->round, reads_b);
+      abort();
+   }
+   b = args->round + 1;
+}
+
+nanos_smp_args_t reader_a_arg = { (void(*)(void *))reader_a };
+nanos_smp_args_t reader_ab_arg = { (void(*)(void *))reader_ab };
+nanos_smp_args_t writer_a_arg = { (void(*)(void *))writer_a };
+nanos_smp_args_t writer_b_arg = { (void(*)(void *))writer_b };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+#define CONST_DATA(args) \
+{ \
+   {{ \
+      .mandatory_creation = true, \
+      .tied = false}, \
+   __alignof__(round_args_t), \
+   0, \
+   1, \
+   0,NULL}, \
+   { \
+      { \
+         nanos_smp_factory, \
+         &args \
+      } \
+   } \
+}
+
+struct nanos_const_wd_definition_1 reader_a_data = CONST_DATA(reader_a_arg);
+struct nanos_const_wd_definition_1 reader_ab_data = CONST_DATA(reader_ab_arg);
+struct nanos_const_wd_definition_1 writer_a_data = CONST_DATA(writer_a_arg);
+struct nanos_const_wd_definition_1 writer_b_data = CONST_DATA(writer_b_arg);
+
+static void submit_task ( struct nanos_const_wd_definition_1 *data, int round, int num_accesses, nanos_data_access_t *accesses )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   round_args_t *args = NULL;
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &data->base, &dyn_props, sizeof(round_args_t), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   args->round = round;
+   NANOS_SAFE( nanos_submit( wd, num_accesses, accesses, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int round, i;
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+   nanos_data_access_t read_a[1] = {{&a, {1,0,0,0,0}, 1, dimensions}};
+   nanos_data_access_t read_ab[2] = {{&a, {1,0,0,0,0}, 1, dimensions}, {&b, {1,0,0,0,0}, 1, dimensions}};
+   nanos_data_access_t write_a[1] = {{&a, {1,1,0,0,0}, 1, dimensions}};
+   nanos_data_access_t write_b[1] = {{&b, {1,1,0,0,0}, 1, dimensions}};
+
+   for ( round = 0; round < NUM_ROUNDS; round++ ) {
+      for ( i = 0; i < NUM_READERS; i++ ) {
+         if ( i % 2 == 0 ) submit_task( &reader_a_data, round, 1, read_a );
+         else submit_task( &reader_ab_data, round, 2, read_ab );
+      }
+      submit_task( &writer_a_data, round, 1, write_a );
+      submit_task( &writer_b_data, round, 1, write_b );
+
+      if ( ( round + 1 ) % WAIT_EVERY == 0 ) {
+         NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+      }
+   }
+
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   if ( a != NUM_ROUNDS || b != NUM_ROUNDS || reads_a != NUM_ROUNDS * NUM_READERS || reads_b != NUM_ROUNDS * ( NUM_READERS / 2 ) ) {
+      printf("Error: Dependencies have not been respected or a task(s) has not been executed.\n");
+      return 1;
+   }
+
+   return 0;
+}
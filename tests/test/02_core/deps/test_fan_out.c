@@ -0,0 +1,126 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions,intervals"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <nanos.h>
+
+/* One producer releasing many consumers at once, then a task waiting for all of them */
+#define NUM_CONSUMERS 1000
+
+int produced = 0;
+int consumed = 0;
+int checked = 0;
+
+void producer();
+void producer()
+{
+   produced = 1;
+}
+
+void consumer();
+void consumer()
+{
+   if ( produced != 1 ) {
+      printf("Error, consumer ran before the producer!\n");
+      abort();
+   }
+   __sync_fetch_and_add( &consumed, 1 );
+}
+
+void checker();
+void checker()
+{
+   if ( consumed != NUM_CONSUMERS ) {
+      printf("Error, checker ran before all the consumers!\n");
+      abort();
+   }
+   checked = 1;
+}
+
+nanos_smp_args_t producer_arg = { (void(*)())producer };
+nanos_smp_args_t consumer_arg = { (void(*)())consumer };
+nanos_smp_args_t checker_arg = { (void(*)())checker };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+#define CONST_DATA(args) \
+{ \
+   {{ \
+      .mandatory_creation = true, \
+      .tied = false}, \
+   1, \
+   0, \
+   1, \
+   0,NULL}, \
+   { \
+      { \
+         nanos_smp_factory, \
+         &args \
+      } \
+   } \
+}
+
+struct nanos_const_wd_definition_1 producer_data = CONST_DATA(producer_arg);
+struct nanos_const_wd_definition_1 consumer_data = CONST_DATA(consumer_arg);
+struct nanos_const_wd_definition_1 checker_data = CONST_DATA(checker_arg);
+
+static void submit_task ( struct nanos_const_wd_definition_1 *data, nanos_data_access_t *access )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &data->base, &dyn_props, 0, NULL, nanos_current_wd(), NULL, NULL ) );
+   NANOS_SAFE( nanos_submit( wd, 1, access, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int dep;
+   int i;
+   nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+   nanos_data_access_t write_access[1] = {{&dep, {1,1,0,0,0}, 1, dimensions}};
+   nanos_data_access_t read_access[1] = {{&dep, {1,0,0,0,0}, 1, dimensions}};
+
+   submit_task( &producer_data, write_access );
+   for ( i = 0; i < NUM_CONSUMERS; i++ ) {
+      submit_task( &consumer_data, read_access );
+   }
+   submit_task( &checker_data, write_access );
+
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   if ( consumed != NUM_CONSUMERS || checked != 1 ) {
+      printf("Error: Dependencies have not been respected or a task(s) has not been executed.\n");
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,179 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <nanos.h>
+
+/* Every round accesses addresses never used before, so the first accesses to them take the
+ * fast path of the plain domain. The accesses submitted after them still have to wait:
+ * - a reader after a fresh out writer,
+ * - an inout and then a reader after a fresh inout writer,
+ * - a writer after fresh readers.
+ * The first tasks are slow, so running a later one too early is seen.
+ */
+#define ROUNDS 50
+#define NUM_READERS 8
+#define DELAY_US 200
+
+int out_data[ROUNDS];
+int inout_data[ROUNDS];
+int read_data[ROUNDS];
+int readers_done[ROUNDS];
+int errors = 0;
+
+typedef struct {
+   int *data;
+   int value;
+   int round;
+} task_args;
+
+void slow_write ( void *ptr );
+void slow_write ( void *ptr )
+{
+   task_args *args = ( task_args * ) ptr;
+   usleep( DELAY_US );
+   *args->data = args->value;
+}
+
+void slow_increment ( void *ptr );
+void slow_increment ( void *ptr )
+{
+   task_args *args = ( task_args * ) ptr;
+   usleep( DELAY_US );
+   if ( *args->data != args->value - 1 ) __sync_fetch_and_add( &errors, 1 );
+   *args->data = args->value;
+}
+
+void check_value ( void *ptr );
+void check_value ( void *ptr )
+{
+   task_args *args = ( task_args * ) ptr;
+   if ( *args->data != args->value ) __sync_fetch_and_add( &errors, 1 );
+}
+
+void slow_read ( void *ptr );
+void slow_read ( void *ptr )
+{
+   task_args *args = ( task_args * ) ptr;
+   usleep( DELAY_US );
+   if ( *args->data != 0 ) __sync_fetch_and_add( &errors, 1 );
+   __sync_fetch_and_add( &readers_done[args->round], 1 );
+}
+
+void write_after_readers ( void *ptr );
+void write_after_readers ( void *ptr )
+{
+   task_args *args = ( task_args * ) ptr;
+   if ( readers_done[args->round] != NUM_READERS ) __sync_fetch_and_add( &errors, 1 );
+   *args->data = args->value;
+}
+
+nanos_smp_args_t slow_write_arg = { slow_write };
+nanos_smp_args_t slow_increment_arg = { slow_increment };
+nanos_smp_args_t check_value_arg = { check_value };
+nanos_smp_args_t slow_read_arg = { slow_read };
+nanos_smp_args_t write_after_readers_arg = { write_after_readers };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+#define CONST_DATA(args) \
+{ \
+   {{ \
+      .mandatory_creation = true, \
+      .tied = false}, \
+   __alignof__(task_args), \
+   0, \
+   1, \
+   0,NULL}, \
+   { \
+      { \
+         nanos_smp_factory, \
+         &args \
+      } \
+   } \
+}
+
+struct nanos_const_wd_definition_1 slow_write_data = CONST_DATA(slow_write_arg);
+struct nanos_const_wd_definition_1 slow_increment_data = CONST_DATA(slow_increment_arg);
+struct nanos_const_wd_definition_1 check_value_data = CONST_DATA(check_value_arg);
+struct nanos_const_wd_definition_1 slow_read_data = CONST_DATA(slow_read_arg);
+struct nanos_const_wd_definition_1 write_after_readers_data = CONST_DATA(write_after_readers_arg);
+
+static nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+
+static void submit_task ( struct nanos_const_wd_definition_1 *data, int *addr, int input, int output, int value, int round )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   task_args *args = NULL;
+   nanos_data_access_t access[1] = {{addr, {input, output, 0, 0, 0}, 1, dimensions}};
+
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &data->base, &dyn_props, sizeof(task_args), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   args->data = addr;
+   args->value = value;
+   args->round = round;
+   NANOS_SAFE( nanos_submit( wd, 1, access, 0 ) );
+}
+
+int main ( int argc, char **argv )
+{
+   int r, i;
+
+   for ( r = 0; r < ROUNDS; r++ ) {
+      submit_task( &slow_write_data, &out_data[r], 0, 1, 1, r );
+      submit_task( &check_value_data, &out_data[r], 1, 0, 1, r );
+
+      submit_task( &slow_increment_data, &inout_data[r], 1, 1, 1, r );
+      submit_task( &slow_increment_data, &inout_data[r], 1, 1, 2, r );
+      submit_task( &check_value_data, &inout_data[r], 1, 0, 2, r );
+
+      for ( i = 0; i < NUM_READERS; i++ ) {
+         submit_task( &slow_read_data, &read_data[r], 1, 0, 0, r );
+      }
+      submit_task( &write_after_readers_data, &read_data[r], 0, 1, 1, r );
+   }
+
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+
+   for ( r = 0; r < ROUNDS; r++ ) {
+      if ( out_data[r] != 1 || inout_data[r] != 2 || read_data[r] != 1 ) errors++;
+   }
+
+   if ( errors != 0 ) {
+      printf( "Error: %d accesses did not wait for the fast path accesses before them\n", errors );
+      return 1;
+   }
+
+   return 0;
+}
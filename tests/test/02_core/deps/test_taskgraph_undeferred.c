@@ -0,0 +1,192 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+/*
+<testinfo>
+test_generator="gens/api-generator -d plain,regions,perfect-regions"
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <nanos.h>
+
+/* A graph with undeferred tasks recorded on the first iteration and replayed on the
+ * following ones: each element is incremented by a deferred task, doubled by an
+ * undeferred one that depends on it and finally all of them are accumulated. The
+ * undeferred tasks must see their predecessors finished and run in recording order */
+#define NUM_ELEMS 16
+#define NUM_ITERS 10
+
+int a[NUM_ELEMS];
+int b[NUM_ELEMS];
+int total = 0;
+int iteration = 0;
+int next_doubler = 0;
+
+typedef struct {
+   int i;
+} task_args_t;
+
+void increment( task_args_t *args );
+void increment( task_args_t *args )
+{
+   usleep( 100 );
+   a[args->i]++;
+}
+
+void doubler( task_args_t *args );
+void doubler( task_args_t *args )
+{
+   if ( a[args->i] != iteration + 1 ) {
+      printf("Error, undeferred doubler %d ran before its increment!\n", args->i);
+      abort();
+   }
+   if ( next_doubler != args->i ) {
+      printf("Error, undeferred doubler %d ran out of order!\n", args->i);
+      abort();
+   }
+   next_doubler = ( next_doubler + 1 ) % NUM_ELEMS;
+   b[args->i] = 2 * a[args->i];
+}
+
+void accumulate( task_args_t *args );
+void accumulate( task_args_t *args )
+{
+   int i;
+   for ( i = 0; i < NUM_ELEMS; i++ ) {
+      if ( b[i] != 2 * ( iteration + 1 ) ) {
+         printf("Error, accumulate ran before doubler %d!\n", i);
+         abort();
+      }
+      total += b[i];
+   }
+}
+
+nanos_smp_args_t increment_arg = { (void(*)(void *))increment };
+nanos_smp_args_t doubler_arg = { (void(*)(void *))doubler };
+nanos_smp_args_t accumulate_arg = { (void(*)(void *))accumulate };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_1
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[1];
+};
+
+#define CONST_DATA(args) \
+{ \
+   {{ \
+      .mandatory_creation = false, \
+      .tied = false}, \
+   __alignof__(task_args_t), \
+   0, \
+   1, \
+   0,NULL}, \
+   { \
+      { \
+         nanos_smp_factory, \
+         &args \
+      } \
+   } \
+}
+
+struct nanos_const_wd_definition_1 increment_data = CONST_DATA(increment_arg);
+struct nanos_const_wd_definition_1 doubler_data = CONST_DATA(doubler_arg);
+struct nanos_const_wd_definition_1 accumulate_data = CONST_DATA(accumulate_arg);
+
+nanos_region_dimension_t dimensions[1] = {{sizeof(int), 0, sizeof(int)}};
+
+static void submit_task ( struct nanos_const_wd_definition_1 *data, int i, size_t num_accesses, nanos_data_access_t *accesses )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   task_args_t *args = NULL;
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &data->base, &dyn_props, sizeof(task_args_t), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   if ( wd == 0 ) {
+      printf("Error, task was not created while recording the graph\n");
+      abort();
+   }
+   args->i = i;
+   NANOS_SAFE( nanos_submit( wd, num_accesses, accesses, 0 ) );
+}
+
+static void run_task ( struct nanos_const_wd_definition_1 *data, int i, size_t num_accesses, nanos_data_access_t *accesses )
+{
+   nanos_wd_dyn_props_t dyn_props = {0};
+   task_args_t args = { i };
+   NANOS_SAFE( nanos_create_wd_and_run_compact( &data->base, &dyn_props, sizeof(task_args_t), &args,
+                                                num_accesses, accesses, NULL, NULL, NULL ) );
+}
+
+static void submit_iteration ( void )
+{
+   int i;
+   nanos_data_access_t accesses[NUM_ELEMS + 1];
+
+   for ( i = 0; i < NUM_ELEMS; i++ ) {
+      nanos_data_access_t inout = {&a[i], {1,1,0,0,0}, 1, dimensions};
+      accesses[0] = inout;
+      submit_task( &increment_data, i, 1, accesses );
+   }
+   for ( i = 0; i < NUM_ELEMS; i++ ) {
+      nanos_data_access_t in = {&a[i], {1,0,0,0,0}, 1, dimensions};
+      nanos_data_access_t out = {&b[i], {0,1,0,0,0}, 1, dimensions};
+      accesses[0] = in;
+      accesses[1] = out;
+      run_task( &doubler_data, i, 2, accesses );
+   }
+   for ( i = 0; i < NUM_ELEMS; i++ ) {
+      nanos_data_access_t in = {&b[i], {1,0,0,0,0}, 1, dimensions};
+      accesses[i] = in;
+   }
+   {
+      nanos_data_access_t inout = {&total, {1,1,0,0,0}, 1, dimensions};
+      accesses[NUM_ELEMS] = inout;
+   }
+   submit_task( &accumulate_data, 0, NUM_ELEMS + 1, accesses );
+}
+
+int main ( int argc, char **argv )
+{
+   nanos_taskgraph_t graph;
+   int expected, it;
+
+   NANOS_SAFE( nanos_taskgraph_begin( &graph ) );
+   submit_iteration();
+   NANOS_SAFE( nanos_taskgraph_end( graph ) );
+
+   for ( it = 1; it < NUM_ITERS; it++ ) {
+      NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+      iteration = it;
+      NANOS_SAFE( nanos_taskgraph_replay( graph ) );
+   }
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+   NANOS_SAFE( nanos_taskgraph_delete( graph ) );
+
+   expected = NUM_ELEMS * NUM_ITERS * ( NUM_ITERS + 1 );
+   if ( total != expected ) {
+      printf("Error: total is %d instead of %d, the undeferred tasks were not replayed.\n", total, expected);
+      return 1;
+   }
+
+   return 0;
+}
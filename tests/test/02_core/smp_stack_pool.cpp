@@ -0,0 +1,152 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking the SMP stack pool: stacks of two different sizes are allocated
+ * by every thread and released by the next one, so caches overflow into the reservoirs.
+ * Every live stack is filled with its own pattern, so a stack handed out twice (or with
+ * the wrong size) is detected. Last, every thread checks that a stack released to a pool
+ * of its own is not handed out by the pool of the device.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a \"--gpus=0\""
+</testinfo>*/
+
+#include <iostream>
+#include <string.h>
+#include "config.hpp"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "smpstackpool.hpp"
+
+using namespace std;
+using namespace nanos;
+using namespace nanos::ext;
+
+#define STACKS_PER_THREAD 48
+#define MAX_THREADS 64
+#define ROUNDS 6
+
+static size_t stackSize ( int i )
+{
+   return i % 2 ? 64 * 1024 : 96 * 1024 + 512;
+}
+
+static void fill ( void *stack, int i )
+{
+   memset( stack, i & 0xff, stackSize( i ) );
+}
+
+static bool check ( void *stack, int i )
+{
+   unsigned char *bytes = ( unsigned char * ) stack;
+   for ( size_t b = 0; b < stackSize( i ); b++ ) {
+      if ( bytes[b] != ( i & 0xff ) ) return false;
+   }
+   return true;
+}
+
+void *stacks[MAX_THREADS * STACKS_PER_THREAD];
+Atomic<int> errors( 0 );
+
+typedef struct { int first; int last; } range_t;
+
+void allocate_stacks( void *args );
+void release_stacks( void *args );
+void private_pool( void *args );
+
+void allocate_stacks( void *args )
+{
+   range_t *range = ( range_t * ) args;
+   SMPStackPool &pool = getSMPDevice().getStackPool();
+
+   for ( int i = range->first; i < range->last; i++ ) {
+      stacks[i] = pool.allocate( stackSize( i ) );
+      fill( stacks[i], i );
+   }
+}
+
+void release_stacks( void *args )
+{
+   range_t *range = ( range_t * ) args;
+   SMPStackPool &pool = getSMPDevice().getStackPool();
+
+   for ( int i = range->first; i < range->last; i++ ) {
+      if ( !check( stacks[i], i ) ) errors++;
+      pool.release( stacks[i], stackSize( i ) );
+   }
+}
+
+void private_pool( void *args )
+{
+   SMPStackPool &shared = getSMPDevice().getStackPool();
+   SMPStackPool pool;
+
+   void *mine = pool.allocate( stackSize( 0 ) );
+   pool.release( mine, stackSize( 0 ) );
+
+   void *stack = shared.allocate( stackSize( 0 ) );
+   if ( stack == mine ) errors++;
+   shared.release( stack, stackSize( 0 ) );
+}
+
+static void run_on_every_thread ( void (*work)( void * ), range_t *ranges, int num_pes, int shift )
+{
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+
+   for ( int t = 0; t < num_pes; t++ ) {
+      WD * wd = new WD( new SMPDD( work ), sizeof( range_t ), __alignof__( range_t ), &ranges[t] );
+      wg->addWork( *wd );
+      wd->tieTo( team[( t + shift ) % num_pes] );
+      sys.submit( *wd );
+   }
+   wg->waitCompletion();
+}
+
+int main ( int argc, char **argv )
+{
+   int num_pes = sys.getSMPPlugin()->getNumWorkers();
+   if ( num_pes > MAX_THREADS ) num_pes = MAX_THREADS;
+   range_t ranges[MAX_THREADS];
+
+   for ( int t = 0; t < num_pes; t++ ) {
+      ranges[t].first = t * STACKS_PER_THREAD;
+      ranges[t].last = ( t + 1 ) * STACKS_PER_THREAD;
+   }
+
+   for ( int round = 0; round < ROUNDS; round++ ) {
+      run_on_every_thread( allocate_stacks, ranges, num_pes, 0 );
+      run_on_every_thread( release_stacks, ranges, num_pes, round + 1 );
+   }
+
+   if ( errors.value() != 0 ) {
+      cout << errors.value() << " stacks were overwritten while in use" << endl;
+      return -1;
+   }
+
+   run_on_every_thread( private_pool, ranges, num_pes, 0 );
+
+   if ( errors.value() != 0 ) {
+      cout << errors.value() << " stacks were shared by two pools" << endl;
+      return -1;
+   }
+
+   return 0;
+}
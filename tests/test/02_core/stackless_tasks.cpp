@@ -0,0 +1,193 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/core-generator -a --gpus=0,--stackless-tasks,--smp-workers=2"
+</testinfo>
+*/
+
+/* DESCRIPTION: Checking --stackless-tasks: a tree of tied tasks must run entirely stackless,
+ * nested on the stacks of the threads. Then, a stackless task yielding while the only ready task
+ * is an untied one already started (and suspended) on the other thread must put it back in the
+ * queue instead of resuming it, and still run its own child inline.
+ */
+
+#include "config.hpp"
+#include "nanos.h"
+#include "atomic.hpp"
+#include <iostream>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+#define DEPTH 10
+
+Atomic<int> numTasks;
+Atomic<int> notStackless;
+
+bool runningStackless ( void );
+bool runningStackless ( void )
+{
+   return getMyThreadSafe()->getCurrentWD()->isStackless();
+}
+
+void submitTask ( void ( *task )( void * ), void *args, size_t size, bool tied, BaseThread *thread );
+void submitTask ( void ( *task )( void * ), void *args, size_t size, bool tied, BaseThread *thread )
+{
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   WD *wd = new WD( new SMPDD( task ), size, 1, args );
+   if ( thread != NULL ) wd->tieTo( *thread );
+   else if ( tied ) wd->tied();
+   wg->addWork( *wd );
+   sys.submit( *wd );
+}
+
+/* ************** TREE OF TIED TASKS ******************** */
+
+int depths[DEPTH + 1];
+
+void treeTask ( void *args );
+void treeTask ( void *args )
+{
+   int depth = *(int *) args;
+
+   numTasks++;
+   if ( !runningStackless() ) notStackless++;
+
+   if ( depth < DEPTH ) {
+      submitTask( treeTask, &depths[depth + 1], sizeof(int), true, NULL );
+      submitTask( treeTask, &depths[depth + 1], sizeof(int), true, NULL );
+      getMyThreadSafe()->getCurrentWD()->waitCompletion();
+   }
+}
+
+/* ************** STARTED TASK GIVEN TO A STACKLESS TASK ******************** */
+
+volatile int startedState = 0;
+BaseThread * volatile startedThread = NULL;
+volatile bool blockerRunning = false;
+volatile bool releaseBlocker = false;
+volatile bool startedResumed = false;
+volatile bool resumedBeforeYield = false;
+volatile bool waiterStackless = false;
+volatile bool childStackless = false;
+
+void startedTask ( void *args );
+void startedTask ( void *args )
+{
+   startedThread = getMyThreadSafe();
+   startedState = 1;
+   while ( startedState != 2 ) {}
+   // Suspends this task and runs the blocker on this thread
+   Scheduler::yield();
+   startedResumed = true;
+}
+
+void blockerTask ( void *args );
+void blockerTask ( void *args )
+{
+   blockerRunning = true;
+   while ( !releaseBlocker ) {}
+}
+
+void waiterChild ( void *args );
+void waiterChild ( void *args )
+{
+   childStackless = runningStackless();
+}
+
+void waiterTask ( void *args );
+void waiterTask ( void *args )
+{
+   waiterStackless = runningStackless();
+
+   // The started task is the only ready one, the waiter cannot resume it on top of itself
+   Scheduler::yield();
+   resumedBeforeYield = startedResumed;
+
+   releaseBlocker = true;
+   submitTask( waiterChild, NULL, 0, true, NULL );
+   getMyThreadSafe()->getCurrentWD()->waitCompletion();
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+
+   if ( !sys.getSchedulerConf().getStacklessTasksEnabled() ) {
+      cout << "Skipping " << argv[0] << " test, it needs --stackless-tasks" << endl;
+      return 0;
+   }
+   if ( sys.getSMPPlugin()->getNumWorkers() < 2 ) {
+      cout << "Skipping " << argv[0] << " test, it needs two threads" << endl;
+      return 0;
+   }
+
+   for ( int i = 0; i <= DEPTH; i++ ) depths[i] = i;
+
+   submitTask( treeTask, &depths[0], sizeof(int), true, NULL );
+   getMyThreadSafe()->getCurrentWD()->waitCompletion();
+
+   if ( numTasks.value() != ( 1 << ( DEPTH + 1 ) ) - 1 ) {
+      cerr << "Only " << numTasks.value() << " tasks were run" << endl;
+      check = false;
+   }
+   if ( notStackless.value() != 0 ) {
+      cerr << notStackless.value() << " tied tasks were not run stackless" << endl;
+      check = false;
+   }
+
+   // The other thread starts an untied task, which yields to the blocker and stays in the queue.
+   // The blocker is tied to that thread and the waiter to this one, whatever the order of the queues
+   submitTask( startedTask, NULL, 0, false, NULL );
+   while ( startedState != 1 ) {}
+   submitTask( blockerTask, NULL, 0, false, startedThread );
+   submitTask( waiterTask, NULL, 0, true, getMyThreadSafe() );
+   startedState = 2;
+   while ( !blockerRunning ) {}
+
+   getMyThreadSafe()->getCurrentWD()->waitCompletion();
+
+   if ( !waiterStackless || !childStackless ) {
+      cerr << "The waiting task or its child were not run stackless" << endl;
+      check = false;
+   }
+   if ( resumedBeforeYield ) {
+      cerr << "The started task was resumed on top of a stackless task" << endl;
+      check = false;
+   }
+   if ( !startedResumed ) {
+      cerr << "The started task was not resumed" << endl;
+      check = false;
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,177 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/core-generator -a --gpus=0,--stackless-tasks,--smp-workers=2"
+</testinfo>
+*/
+
+/* DESCRIPTION: Checking --stackless-tasks: a stackless task waits for a producer suspended as a
+ * ULT and tied to the same thread. The producer cannot run on top of the waiter, so the waiter
+ * keeps the stack of the thread and the scheduling loop moves to a new one to resume the producer.
+ * The producer then blocks too, and the moved loop must run until it is woken up by the other
+ * thread.
+ */
+
+#include "config.hpp"
+#include "nanos.h"
+#include <iostream>
+#include <unistd.h>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "synchronizedcondition.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+int producerReady = 0;
+int waiterReady = 0;
+int helperReady = 0;
+
+SingleSyncCond<EqualConditionChecker<int> > producerCond( EqualConditionChecker<int>( &producerReady, 1 ) );
+SingleSyncCond<EqualConditionChecker<int> > waiterCond( EqualConditionChecker<int>( &waiterReady, 1 ) );
+SingleSyncCond<EqualConditionChecker<int> > helperCond( EqualConditionChecker<int>( &helperReady, 1 ) );
+
+volatile bool helperRunning = false;
+volatile bool producerStarted = false;
+volatile bool producerWaiting = false;
+volatile bool producerDone = false;
+volatile bool waiterStackless = false;
+volatile bool waiterDone = false;
+volatile bool loopMoved = false;
+BaseThread * volatile helperThread = NULL;
+BaseThread * volatile producerThread = NULL;
+BaseThread * volatile waiterThread = NULL;
+
+void submitTask ( void ( *task )( void * ), bool tied );
+void submitTask ( void ( *task )( void * ), bool tied )
+{
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   WD *wd = new WD( new SMPDD( task ), 0, 1, NULL );
+   if ( tied ) wd->tied();
+   wg->addWork( *wd );
+   sys.submit( *wd );
+}
+
+void helperTask ( void *args );
+void helperTask ( void *args )
+{
+   helperThread = getMyThreadSafe();
+   helperRunning = true;
+   while ( !producerWaiting ) {}
+
+   // Gives the thread of the producer time to go idle on the moved loop
+   usleep( 10000 );
+   helperReady = 1;
+   memoryFence();
+   helperCond.signal();
+}
+
+void producerTask ( void *args );
+void producerTask ( void *args )
+{
+   BaseThread *thread = getMyThreadSafe();
+   thread->getCurrentWD()->tieTo( *thread );
+   producerThread = thread;
+   producerStarted = true;
+
+   // Suspended until the waiter needs it
+   producerCond.wait();
+   loopMoved = getMyThreadSafe()->hasMovedSchedulingLoop();
+
+   // Neither the producer nor the waiter are ready now
+   producerWaiting = true;
+   helperCond.wait();
+
+   waiterReady = 1;
+   memoryFence();
+   waiterCond.signal();
+   producerDone = true;
+}
+
+void waiterTask ( void *args );
+void waiterTask ( void *args )
+{
+   waiterThread = getMyThreadSafe();
+   waiterStackless = getMyThreadSafe()->getCurrentWD()->isStackless();
+
+   // Wakes up the producer, which is deferred, and blocks until it finishes its work
+   producerReady = 1;
+   memoryFence();
+   producerCond.signal();
+   waiterCond.wait();
+
+   waiterDone = producerDone;
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+
+   if ( !sys.getSchedulerConf().getStacklessTasksEnabled() ) {
+      cout << "Skipping " << argv[0] << " test, it needs --stackless-tasks" << endl;
+      return 0;
+   }
+   if ( sys.getSMPPlugin()->getNumWorkers() < 2 ) {
+      cout << "Skipping " << argv[0] << " test, it needs two threads" << endl;
+      return 0;
+   }
+
+   // The helper keeps the other thread busy, so the producer starts here when this task yields
+   submitTask( helperTask, false );
+   while ( !helperRunning ) {}
+   submitTask( producerTask, false );
+   while ( !producerStarted ) Scheduler::yield();
+
+   submitTask( waiterTask, true );
+   getMyThreadSafe()->getCurrentWD()->waitCompletion();
+
+   if ( producerThread != getMyThreadSafe() || waiterThread != getMyThreadSafe() || helperThread == getMyThreadSafe() ) {
+      cerr << "The producer and the waiter did not run on the same thread" << endl;
+      check = false;
+   }
+   if ( !waiterStackless ) {
+      cerr << "The waiter was not run stackless" << endl;
+      check = false;
+   }
+   if ( !loopMoved ) {
+      cerr << "The producer was resumed without moving the scheduling loop" << endl;
+      check = false;
+   }
+   if ( !waiterDone ) {
+      cerr << "The waiter finished before the producer" << endl;
+      check = false;
+   }
+   if ( getMyThreadSafe()->hasMovedSchedulingLoop() ) {
+      cerr << "The scheduling loop was not restored after the waiter finished" << endl;
+      check = false;
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,166 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+/*
+<testinfo>
+   test_generator="gens/core-generator"
+   test_generator_ENV=( "NX_TEST_MAX_CPUS=4"
+                        "NX_TEST_SCHEDULE=dbf"
+                        "NX_TEST_ARCH=smp")
+   test_exec_command="timeout 1m"
+</testinfo>
+*/
+
+/* DESCRIPTION: Builds the steal order of every thread of the team and checks that it visits
+ * every other member exactly once, level by level: SMT siblings first, then the threads in the
+ * same socket and finally the remote ones. A farther level is only visited after the backoff.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "config.hpp"
+#include "nanos.h"
+#include "system.hpp"
+#include "threadteam.hpp"
+#include "stealorder.hpp"
+
+using namespace nanos;
+
+int distance( int cpu, int other );
+
+int distance( int cpu, int other )
+{
+   if ( sys._hwloc.getCoreOfCpu( cpu ) == sys._hwloc.getCoreOfCpu( other ) ) return StealOrder::SAME_CORE;
+   if ( sys._hwloc.getSocketOfCpu( cpu ) == sys._hwloc.getSocketOfCpu( other ) ) return StealOrder::SAME_SOCKET;
+   return StealOrder::REMOTE;
+}
+
+/* Records the victims visited, never steals anything */
+struct VisitRecorder {
+   std::vector<BaseThread *> _visited;
+
+   WD * operator() ( BaseThread *thread, BaseThread &victim )
+   {
+      _visited.push_back( &victim );
+      return NULL;
+   }
+};
+
+bool check_thread ( BaseThread *thread, std::vector<BaseThread *> const &members );
+
+bool check_thread ( BaseThread *thread, std::vector<BaseThread *> const &members )
+{
+   bool check = true;
+   int cpu = thread->getCpuId();
+   int backoff = sys.getSchedulerConf().getStealBackoff();
+
+   // Enough failed rounds to reach every level
+   StealOrder order;
+   VisitRecorder all;
+   order.steal( thread, 1 + backoff * StealOrder::NUM_LEVELS, all );
+
+   std::map<BaseThread *, int> visits;
+   int last_level = StealOrder::SAME_CORE;
+   for ( size_t i = 0; i < all._visited.size(); i++ ) {
+      BaseThread *victim = all._visited[i];
+      visits[victim]++;
+
+      int level = distance( cpu, victim->getCpuId() );
+      if ( level < last_level ) {
+         std::cerr << "Thread " << thread->getId() << " visited victim " << victim->getId() << " at level "
+                   << level << " after one at level " << last_level << std::endl;
+         check = false;
+      }
+      last_level = level;
+   }
+
+   for ( size_t i = 0; i < members.size(); i++ ) {
+      BaseThread *member = members[i];
+      int expected = member == thread ? 0 : 1;
+      if ( visits[member] != expected ) {
+         std::cerr << "Thread " << thread->getId() << " visited member " << member->getId() << " "
+                   << visits[member] << " times, " << expected << " expected" << std::endl;
+         check = false;
+      }
+   }
+   if ( visits.size() != members.size() ) {
+      std::cerr << "Thread " << thread->getId() << " visited threads out of its team" << std::endl;
+      check = false;
+   }
+
+   // Each level only has victims at its distance
+   for ( int level = 0; level < StealOrder::NUM_LEVELS; level++ ) {
+      StealOrder::VictimList const &victims = order.getVictims( (StealOrder::Level) level );
+      for ( size_t i = 0; i < victims.size(); i++ ) {
+         if ( distance( cpu, victims[i]->getCpuId() ) != level ) {
+            std::cerr << "Thread " << thread->getId() << " has victim " << victims[i]->getId()
+                      << " in level " << level << std::endl;
+            check = false;
+         }
+      }
+   }
+
+   // The first round only visits the closest level with victims
+   VisitRecorder first;
+   order.steal( thread, 1, first );
+   if ( !all._visited.empty() ) {
+      int closest = distance( cpu, all._visited[0]->getCpuId() );
+      size_t expected = order.getVictims( (StealOrder::Level) closest ).size();
+      if ( first._visited.size() != expected ) {
+         std::cerr << "Thread " << thread->getId() << " visited " << first._visited.size()
+                   << " victims in its first round, " << expected << " expected" << std::endl;
+         check = false;
+      }
+      for ( size_t i = 0; i < first._visited.size(); i++ ) {
+         if ( distance( cpu, first._visited[i]->getCpuId() ) != closest ) {
+            std::cerr << "Thread " << thread->getId() << " visited a farther level in its first round" << std::endl;
+            check = false;
+         }
+      }
+   }
+
+   return check;
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+   ThreadTeam *team = getMyThreadSafe()->getTeam();
+
+   std::vector<BaseThread *> members;
+   team->lock();
+   for ( unsigned i = 0; i < team->size(); i++ ) {
+      members.push_back( &team->getThread( i ) );
+   }
+   team->unlock();
+
+   for ( size_t i = 0; i < members.size(); i++ ) {
+      check = check_thread( members[i], members ) && check;
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return EXIT_SUCCESS;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return EXIT_FAILURE;
+   }
+}
@@ -0,0 +1,125 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+/*
+<testinfo>
+   test_generator="gens/core-generator"
+   test_generator_ENV=( "NX_TEST_SCHEDULE=bf"
+                        "NX_TEST_ARCH=smp")
+   test_exec_command="timeout 1m"
+</testinfo>
+*/
+
+/* DESCRIPTION: Only the CPU of the main thread is active and every submitted task keeps its
+ * thread busy, so submissions must wake up at most one more thread each, closer CPUs first.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include "config.hpp"
+#include "nanos.h"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+
+using namespace nanos;
+using namespace nanos::ext;
+
+enum { NUM_TASKS = 2 };
+
+volatile bool release_tasks = false;
+
+int distance( int cpu, int other );
+void busy_task ( void *args );
+
+int distance( int cpu, int other )
+{
+   if ( sys._hwloc.getCoreOfCpu( cpu ) == sys._hwloc.getCoreOfCpu( other ) ) return 0;
+   if ( sys._hwloc.getSocketOfCpu( cpu ) == sys._hwloc.getSocketOfCpu( other ) ) return 1;
+   return 2;
+}
+
+void busy_task ( void *args )
+{
+   while ( !release_tasks ) {}
+}
+
+int main ( int argc, char **argv )
+{
+   /* Skip test if binding is disabled */
+   if ( !sys.getSMPPlugin()->getBinding() ) {
+      return EXIT_SUCCESS;
+   }
+
+   /* Skip test if process mask does not contain another CPU to wake up */
+   const CpuSet process_mask( sys.getCpuProcessMask() );
+   if ( process_mask.size() < 2 ) {
+      std::cout << "Skipping " << argv[0] << " test, not enough CPUs" << std::endl;
+      return EXIT_SUCCESS;
+   }
+
+   bool check = true;
+   int my_cpu = getMyThreadSafe()->getCpuId();
+   int num_tasks = std::min( (int) process_mask.size() - 1, (int) NUM_TASKS );
+
+   sys.setCpuActiveMask( CpuSet( my_cpu ) );
+
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   for ( int i = 0; i < num_tasks; i++ ) {
+      WD * wd = new WD( new SMPDD( busy_task ), 0, 1, NULL );
+      wg->addWork( *wd );
+      sys.submit( *wd );
+   }
+
+   const CpuSet active_mask( sys.getCpuActiveMask() );
+   int woken = 0;
+   int max_woken_distance = 0;
+   int min_asleep_distance = 2;
+   for ( CpuSet::const_iterator it = process_mask.begin(); it != process_mask.end(); ++it ) {
+      int cpu = *it;
+      if ( cpu == my_cpu ) continue;
+      if ( active_mask.isSet( cpu ) ) {
+         woken++;
+         max_woken_distance = std::max( max_woken_distance, distance( my_cpu, cpu ) );
+      } else {
+         min_asleep_distance = std::min( min_asleep_distance, distance( my_cpu, cpu ) );
+      }
+   }
+
+   release_tasks = true;
+   wg->waitCompletion();
+   sys.setCpuActiveMask( process_mask );
+
+   if ( woken == 0 || woken > num_tasks ) {
+      std::cerr << woken << " threads were woken up for " << num_tasks << " busy tasks" << std::endl;
+      check = false;
+   }
+   if ( woken < (int) process_mask.size() - 1 && max_woken_distance > min_asleep_distance ) {
+      std::cerr << "A thread at distance " << max_woken_distance << " was woken up before one at distance "
+                << min_asleep_distance << std::endl;
+      check = false;
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return EXIT_SUCCESS;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return EXIT_FAILURE;
+   }
+}
@@ -0,0 +1,125 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/* DESCRIPTION: Checking the WD chunk pool: chunks allocated by one thread and released
+ * by others go back to their owner, and threads releasing more chunks than they keep
+ * move them to the shared reservoir. Every live chunk is filled with its own pattern,
+ * so a chunk handed out twice is detected.
+ */
+
+/*<testinfo>
+test_generator="gens/core-generator -a \"--gpus=0\""
+</testinfo>*/
+
+#include <iostream>
+#include <string.h>
+#include "config.hpp"
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "wdchunkpool.hpp"
+
+using namespace std;
+using namespace nanos;
+using namespace nanos::ext;
+
+#define NUM_CHUNKS 512
+#define ROUNDS 8
+
+static size_t chunkSize ( int i )
+{
+   // Sizes of every class, plus some larger than the largest one
+   return ( i * 97 ) % ( WDChunkPool::NUM_CLASSES * WDChunkPool::CLASS_SIZE + 512 ) + 1;
+}
+
+static void fill ( void *chunk, int i )
+{
+   memset( chunk, i & 0xff, chunkSize( i ) );
+}
+
+static bool check ( void *chunk, int i )
+{
+   unsigned char *bytes = ( unsigned char * ) chunk;
+   for ( size_t b = 0; b < chunkSize( i ); b++ ) {
+      if ( bytes[b] != ( i & 0xff ) ) return false;
+   }
+   return true;
+}
+
+void *chunks[NUM_CHUNKS];
+Atomic<int> errors( 0 );
+
+typedef struct { int first; int last; } range_t;
+
+void release_and_reuse( void *args );
+
+void release_and_reuse( void *args )
+{
+   range_t *range = ( range_t * ) args;
+   WDChunkPool &pool = sys.getWDChunkPool();
+
+   // Release chunks of the main thread, then allocate and release them locally many times
+   for ( int i = range->first; i < range->last; i++ ) {
+      if ( !check( chunks[i], i ) ) errors++;
+      pool.deallocate( chunks[i] );
+   }
+   for ( int round = 0; round < ROUNDS; round++ ) {
+      for ( int i = range->first; i < range->last; i++ ) {
+         chunks[i] = pool.allocate( chunkSize( i ) );
+         fill( chunks[i], i );
+      }
+      for ( int i = range->first; i < range->last; i++ ) {
+         if ( !check( chunks[i], i ) ) errors++;
+         pool.deallocate( chunks[i] );
+      }
+   }
+}
+
+int main ( int argc, char **argv )
+{
+   int num_pes = sys.getSMPPlugin()->getNumWorkers();
+   range_t ranges[num_pes];
+   WDChunkPool &pool = sys.getWDChunkPool();
+
+   WD *wg = getMyThreadSafe()->getCurrentWD();
+   ThreadTeam &team = *getMyThreadSafe()->getTeam();
+
+   for ( int round = 0; round < ROUNDS; round++ ) {
+      for ( int i = 0; i < NUM_CHUNKS; i++ ) {
+         chunks[i] = pool.allocate( chunkSize( i ) );
+         fill( chunks[i], i );
+      }
+
+      for ( int t = 0; t < num_pes; t++ ) {
+         ranges[t].first = t * NUM_CHUNKS / num_pes;
+         ranges[t].last = ( t + 1 ) * NUM_CHUNKS / num_pes;
+         WD * wd = new WD( new SMPDD( release_and_reuse ), sizeof( range_t ), __alignof__( range_t ), &ranges[t] );
+         wg->addWork( *wd );
+         wd->tieTo( team[t] );
+         sys.submit( *wd );
+      }
+      wg->waitCompletion();
+   }
+
+   if ( errors.value() != 0 ) {
+      cout << errors.value() << " chunks were overwritten while in use" << endl;
+      return -1;
+   }
+
+   return 0;
+}
@@ -19,7 +19,7 @@
 
 /*
 <testinfo>
-test_generator="gens/core-generator -d plain,regions,perfect-regions"
+test_generator="gens/core-generator -d plain,regions,perfect-regions,intervals"
 test_generator_ENV=( "NX_TEST_SCHEDULE=bf" )
 </testinfo>
 */
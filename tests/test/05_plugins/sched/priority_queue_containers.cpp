@@ -0,0 +1,138 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_SCHEDULE=bf" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include <iostream>
+#include <map>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+#include "wddeque.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+// Priorities in [-8,80) to have WDs out of the range of the buckets
+#define NUM_WDS       5000
+#define MIN_PRIORITY  -8
+#define MAX_PRIORITY  80
+
+void dummy ( void *args );
+void dummy ( void *args ) {}
+
+/*
+ * Applies the same pushes, reorders and removals to a sorted list priority
+ * queue and to one using the given container, and checks both serve the WDs
+ * in the same order.
+ */
+static bool check ( WDPQ::ContainerType container, const char *name )
+{
+   WDPriorityQueue<> reference;
+   WDPriorityQueue<> queue;
+   queue.setContainer( container );
+
+   WD *refWDs[NUM_WDS], *wds[NUM_WDS];
+   std::map<WD *, int> refIds, ids;
+   unsigned seed = 12345;
+
+   for ( int i = 0; i < NUM_WDS; i++ ) {
+      seed = seed * 1103515245 + 12345;
+      int priority = MIN_PRIORITY + (int)( ( seed >> 16 ) % ( MAX_PRIORITY - MIN_PRIORITY ) );
+
+      refWDs[i] = new WD( new SMPDD( dummy ), 0, 1, NULL );
+      wds[i] = new WD( new SMPDD( dummy ), 0, 1, NULL );
+      refWDs[i]->setPriority( priority );
+      wds[i]->setPriority( priority );
+      refIds[refWDs[i]] = i;
+      ids[wds[i]] = i;
+
+      // Mix FIFO and LIFO insertions
+      if ( i % 3 == 0 ) {
+         reference.push_front( refWDs[i] );
+         queue.push_front( wds[i] );
+      } else {
+         reference.push_back( refWDs[i] );
+         queue.push_back( wds[i] );
+      }
+   }
+
+   // Change some priorities, also moving WDs in and out of the bucket range
+   for ( int i = 0; i < NUM_WDS; i += 7 ) {
+      int priority = ( i % 2 ) ? refWDs[i]->getPriority() + 50 : -refWDs[i]->getPriority();
+      refWDs[i]->setPriority( priority );
+      wds[i]->setPriority( priority );
+      if ( !reference.reorderWD( refWDs[i] ) || !queue.reorderWD( wds[i] ) ) {
+         cout << name << ": reorderWD did not find WD " << i << endl;
+         return false;
+      }
+   }
+
+   // Remove some WDs from the middle of the queue
+   for ( int i = 5; i < NUM_WDS; i += 11 ) {
+      WD *next;
+      if ( !reference.removeWD( myThread, refWDs[i], &next ) || !queue.removeWD( myThread, wds[i], &next ) ) {
+         cout << name << ": removeWD did not find WD " << i << endl;
+         return false;
+      }
+   }
+
+   if ( reference.size() != queue.size() ) {
+      cout << name << ": size is " << queue.size() << ", expected " << reference.size() << endl;
+      return false;
+   }
+
+   for ( int n = 0; !reference.empty(); n++ ) {
+      if ( reference.maxPriority() != queue.maxPriority() ) {
+         cout << name << ": max priority is " << queue.maxPriority() << ", expected " << reference.maxPriority() << endl;
+         return false;
+      }
+
+      WD *refWD = reference.pop_front( myThread );
+      WD *wd = queue.pop_front( myThread );
+      if ( wd == NULL || refIds[refWD] != ids[wd] ) {
+         cout << name << ": WD " << n << " served out of order" << endl;
+         return false;
+      }
+   }
+
+   return queue.empty();
+}
+
+int main ( int argc, char **argv )
+{
+   bool ok = check( WDPQ::HEAP, "heap" ) && check( WDPQ::BUCKETS, "buckets" );
+
+   if ( ok ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,211 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator="gens/api-generator"
+test_generator_ENV=( "NX_TEST_SCHEDULE=versioning" )
+</testinfo>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <nanos.h>
+
+/* The versioning history is kept between runs of this same binary: each phase below is a
+ * new process (and so a new runtime) using the same history file.
+ *
+ * Groups A and B have a slow version 0 and a fast version 1. Without history, the scheduler
+ * tries version 0 first. With a trusted history, it must choose version 1 at once.
+ *
+ * - record:  A and B are measured, the history is saved (age 0)
+ * - idle:    nothing measured, the records age 1
+ * - run a:   A is found at age 1 < max age 2. A is saved again and B reaches age 2, so it is
+ *            discarded when saving
+ * - run a b: A is found again, B is not
+ * - idle:    A ages 1
+ * - run a:   loaded with max age 1, A is discarded when loading
+ */
+#define MAX_AGE 2
+#define RECORD_TASKS 20
+#define SLOW_US 2000
+
+enum { SLOW = 0, FAST = 1 };
+
+int last_version = -1;
+
+typedef struct {
+   int dummy;
+} task_args;
+
+void slow_version ( void *args );
+void slow_version ( void *args )
+{
+   usleep( SLOW_US );
+   last_version = SLOW;
+}
+
+void fast_version ( void *args );
+void fast_version ( void *args )
+{
+   last_version = FAST;
+}
+
+nanos_smp_args_t slow_arg = { slow_version };
+nanos_smp_args_t fast_arg = { fast_version };
+
+/* ************** CONSTANT PARAMETERS IN WD CREATION ******************** */
+
+struct nanos_const_wd_definition_2
+{
+     nanos_const_wd_definition_t base;
+     nanos_device_t devices[2];
+};
+
+#define CONST_DATA \
+{ \
+   {{ \
+      .mandatory_creation = true, \
+      .tied = false}, \
+   __alignof__(task_args), \
+   0, \
+   2, \
+   0,NULL}, \
+   { \
+      { nanos_smp_factory, &slow_arg }, \
+      { nanos_smp_factory, &fast_arg } \
+   } \
+}
+
+/* Each definition is a different version group */
+struct nanos_const_wd_definition_2 group_a = CONST_DATA;
+struct nanos_const_wd_definition_2 group_b = CONST_DATA;
+
+static struct nanos_const_wd_definition_2 * get_group ( const char *name )
+{
+   return strcmp( name, "a" ) == 0 ? &group_a : &group_b;
+}
+
+/* Runs a task of the group and returns the version that ran */
+static int run_task ( struct nanos_const_wd_definition_2 *group )
+{
+   nanos_wd_t wd = 0;
+   nanos_wd_dyn_props_t dyn_props = {0};
+   task_args *args = NULL;
+
+   last_version = -1;
+   NANOS_SAFE( nanos_create_wd_compact ( &wd, &group->base, &dyn_props, sizeof(task_args), (void **) &args,
+                                         nanos_current_wd(), NULL, NULL ) );
+   NANOS_SAFE( nanos_submit( wd, 0, NULL, 0 ) );
+   NANOS_SAFE( nanos_wg_wait_completion( nanos_current_wd(), false ) );
+   return last_version;
+}
+
+/* Body of a phase, running in its own process */
+static int child ( int argc, char **argv )
+{
+   int i;
+
+   if ( strcmp( argv[1], "record" ) == 0 ) {
+      for ( i = 0; i < RECORD_TASKS; i++ ) {
+         run_task( &group_a );
+         run_task( &group_b );
+      }
+      return 0;
+   }
+
+   /* "run": the first task of each group given must run the fast version if the group is
+    * expected to be found in the history (+name), and the slow one otherwise (-name) */
+   for ( i = 2; i < argc; i++ ) {
+      int expected = argv[i][0] == '+' ? FAST : SLOW;
+      int version = run_task( get_group( &argv[i][1] ) );
+      if ( version != expected ) {
+         printf( "Error: group %s ran version %d at first, %d was expected\n", &argv[i][1], version, expected );
+         return 1;
+      }
+   }
+   return 0;
+}
+
+static int phase ( const char *file, int max_age, const char *arg0, const char *arg1, const char *arg2 )
+{
+   static char nx_args[4096];
+   const char *base = getenv( "NX_TEST_BASE_ARGS" );
+   pid_t pid;
+   int status;
+
+   snprintf( nx_args, sizeof(nx_args), "%s --versioning-history=%s --versioning-history-decay=100 "
+         "--versioning-history-max-age=%d", base, file, max_age );
+   setenv( "NX_ARGS", nx_args, 1 );
+
+   pid = fork();
+   if ( pid == 0 ) {
+      execl( "/proc/self/exe", "versioning_history", arg0, arg1, arg2, (char *) NULL );
+      _exit( 127 );
+   }
+
+   if ( waitpid( pid, &status, 0 ) != pid || !WIFEXITED( status ) ) return 1;
+   return WEXITSTATUS( status );
+}
+
+int main ( int argc, char **argv )
+{
+   char file[] = "/tmp/nanox-versioning-history-XXXXXX";
+   struct stat st;
+   int fd, errors = 0;
+
+   if ( argc > 1 ) return child( argc, argv );
+
+   setenv( "NX_TEST_BASE_ARGS", getenv( "NX_ARGS" ) ? getenv( "NX_ARGS" ) : "", 1 );
+
+   fd = mkstemp( file );
+   if ( fd == -1 ) {
+      printf( "Error: cannot create the history file\n" );
+      return 1;
+   }
+   close( fd );
+
+   errors += phase( file, MAX_AGE, "record", NULL, NULL );
+
+   // The history is not kept if the runtime has been built without SQLite3
+   if ( stat( file, &st ) != 0 || st.st_size == 0 ) {
+      printf( "Versioning history not supported, skipping\n" );
+      unlink( file );
+      return errors;
+   }
+
+   errors += phase( file, MAX_AGE, "idle", NULL, NULL );
+   errors += phase( file, MAX_AGE, "run", "+a", NULL );
+   errors += phase( file, MAX_AGE, "run", "+a", "-b" );
+   errors += phase( file, MAX_AGE, "idle", NULL, NULL );
+   errors += phase( file, 1, "run", "-a", NULL );
+
+   unlink( file );
+
+   if ( errors != 0 ) {
+      printf( "Error: %d phases failed\n", errors );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,103 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+/*
+<testinfo>
+test_generator=gens/core-generator
+test_generator_ENV=( "NX_TEST_SCHEDULE=ws" )
+</testinfo>
+*/
+
+#include "config.hpp"
+#include "nanos.h"
+#include "atomic.hpp"
+#include <iostream>
+#include "smpprocessor.hpp"
+#include "system.hpp"
+
+using namespace std;
+
+using namespace nanos;
+using namespace nanos::ext;
+
+// More tasks than the initial capacity of the deques, so that they grow
+#define NUM_TASKS     2000
+#define NUM_CHILDREN  10
+#define NUM_RUNS      10
+
+Atomic<int> A;
+
+typedef struct {
+   int children;
+} task_data_t;
+
+void task ( void *args );
+
+void task ( void *args )
+{
+   task_data_t *data = ( task_data_t * ) args;
+
+   if ( data->children > 0 ) {
+      // Children are pushed into the deque of the thread running this task
+      WD *wg = getMyThreadSafe()->getCurrentWD();
+      task_data_t child_data = { 0 };
+      for ( int i = 0; i < data->children; i++ ) {
+         WD * wd = new WD( new SMPDD( task ), sizeof( child_data ), __alignof__(task_data_t), ( void * ) &child_data );
+         wg->addWork( *wd );
+         sys.submit( *wd );
+      }
+      wg->waitCompletion();
+   }
+
+   A++;
+}
+
+int main ( int argc, char **argv )
+{
+   bool check = true;
+
+   task_data_t data = { NUM_CHILDREN };
+
+   for ( int testNumber = 0; testNumber < NUM_RUNS; ++testNumber ) {
+      A = 0;
+
+      WD *wg = getMyThreadSafe()->getCurrentWD();
+      for ( int i = 0; i < NUM_TASKS; i++ ) {
+         WD * wd = new WD( new SMPDD( task ), sizeof( data ), __alignof__(task_data_t), ( void * ) &data );
+         wg->addWork( *wd );
+         sys.submit( *wd );
+      }
+      wg->waitCompletion();
+
+      /*
+       * Every task must run exactly once, regardless of which thread
+       * popped or stole it.
+       */
+      if ( A.value() != NUM_TASKS * ( NUM_CHILDREN + 1 ) ) check = false;
+   }
+
+   if ( check ) {
+      fprintf(stderr, "%s : %s\n", argv[0], "successful");
+      return 0;
+   }
+   else {
+      fprintf(stderr, "%s: %s\n", argv[0], "unsuccessful");
+      return -1;
+   }
+}
@@ -0,0 +1,102 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "common.h"
+
+/*
+<testinfo>
+test_generator="gens/mcc-openmp-generator -d regions,cregions,perfect-regions,intervals"
+test_generator_ENV=( "NX_TEST_MODE=performance" )
+</testinfo>
+*/
+
+// TEST: Block Regions Dependencies Overhead ***************************************************
+// Each sample submits one sweep of a 1D stencil over an array partitioned in blocks: every task
+// updates its block and reads the last element of the previous block and the first one of the
+// next block. The halo accesses partially overlap the block ones, so the regions based plugins
+// have to track many small fragments. Tasks are empty, so the submission time measures the
+// dependence analysis and the taskwait time the dependence release.
+#define NUM_BLOCKS   256
+#define BLOCK_SIZE   64
+
+double array[NUM_BLOCKS * BLOCK_SIZE];
+
+typedef struct _nx_data_env_1_t_tag { } _nx_data_env_1_t;
+static void _smp__ol_test_block_regions_1(_nx_data_env_1_t *const __restrict__ _args) { }
+
+void test_block_regions_overhead ( stats_t *create, stats_t *release )
+{
+   int i, b;
+   double create_times[TEST_NSAMPLES];
+   double release_times[TEST_NSAMPLES];
+   for ( i = 0; i < TEST_NSAMPLES; i++ ) {
+      create_times[i] = GET_TIME;
+      for ( b = 0; b < NUM_BLOCKS; b++ ) {
+         /* SMP device descriptor */
+         static nanos_smp_args_t _ol_test_block_regions_1_smp_args = {(void (*)(void *)) _smp__ol_test_block_regions_1};
+         _nx_data_env_1_t *ol_args = (_nx_data_env_1_t *) 0;
+         nanos_wd_t wd = (nanos_wd_t) 0;
+         struct nanos_const_wd_definition_local_t { nanos_const_wd_definition_t base; nanos_device_t devices[1];
+         };
+         static struct nanos_const_wd_definition_local_t _const_def = {
+            { { 1, 1, 0, 0, 0, 0, 0, 0 }, __alignof__(_nx_data_env_1_t), 0, 1, 0, NULL }, {{ nanos_smp_factory, &_ol_test_block_regions_1_smp_args }}
+         };
+         nanos_wd_dyn_props_t dyn_props = {0};
+         nanos_err_t err;
+
+         nanos_region_dimension_t block_dimensions[1] = {{BLOCK_SIZE * sizeof(double), 0, BLOCK_SIZE * sizeof(double)}};
+         nanos_region_dimension_t halo_dimensions[1] = {{sizeof(double), 0, sizeof(double)}};
+         nanos_data_access_t data_accesses[3];
+         int num_accesses = 0;
+         nanos_data_access_t inout = {&array[b * BLOCK_SIZE], {1,1,0,0,0}, 1, block_dimensions};
+         data_accesses[num_accesses++] = inout;
+         if ( b > 0 ) { nanos_data_access_t in = {&array[b * BLOCK_SIZE - 1], {1,0,0,0,0}, 1, halo_dimensions}; data_accesses[num_accesses++] = in; }
+         if ( b < NUM_BLOCKS - 1 ) { nanos_data_access_t in = {&array[(b + 1) * BLOCK_SIZE], {1,0,0,0,0}, 1, halo_dimensions}; data_accesses[num_accesses++] = in; }
+
+         err = nanos_create_wd_compact(&wd, &_const_def.base, &dyn_props, sizeof(_nx_data_env_1_t),
+                                       (void **) &ol_args, nanos_current_wd(), (nanos_copy_data_t **) 0, NULL
+               );
+         if (err != NANOS_OK) nanos_handle_error(err);
+
+         err = nanos_submit(wd, num_accesses, data_accesses, (nanos_team_t) 0);
+         if (err != NANOS_OK) nanos_handle_error(err);
+      }
+      create_times[i] = ( GET_TIME - create_times[i] ) / NUM_BLOCKS;
+
+      release_times[i] = GET_TIME;
+      nanos_wg_wait_completion( nanos_current_wd(), false );
+      release_times[i] = ( GET_TIME - release_times[i] ) / NUM_BLOCKS;
+   }
+   stats( create, create_times, TEST_NSAMPLES);
+   stats( release, release_times, TEST_NSAMPLES);
+}
+
+int main ( int argc, char *argv[] )
+{
+   stats_t create, release;
+
+   test_block_regions_overhead( &create, &release );
+   print_stats ( "Block regions dependencies creation overhead","warm-up", &create );
+   print_stats ( "Block regions dependencies release overhead","warm-up", &release );
+   test_block_regions_overhead( &create, &release );
+   print_stats ( "Block regions dependencies creation overhead","test", &create );
+   print_stats ( "Block regions dependencies release overhead","test", &release );
+
+   return 0;
+}
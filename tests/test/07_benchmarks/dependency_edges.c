@@ -0,0 +1,103 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "common.h"
+
+/*
+<testinfo>
+test_generator=gens/mcc-openmp-generator
+test_generator_ENV=( "NX_TEST_MODE=performance" )
+</testinfo>
+*/
+
+// TEST: Dependency Edges Creation and Release Overhead ********************************************
+// Each sample submits one sweep of a 5-point stencil over a grid of blocks: every task updates its
+// block and reads its four neighbours, so most tasks get 5 predecessors and 5 successors. Tasks are
+// empty, so the submission time measures edge creation and the taskwait time edge release.
+#define GRID_SIZE    32
+#define NUM_BLOCKS   ( GRID_SIZE * GRID_SIZE )
+
+double grid[GRID_SIZE][GRID_SIZE];
+
+typedef struct _nx_data_env_1_t_tag { } _nx_data_env_1_t;
+static void _smp__ol_test_dependency_edges_1(_nx_data_env_1_t *const __restrict__ _args) { }
+
+void test_dependency_edges_overhead ( stats_t *create, stats_t *release )
+{
+   int i, x, y;
+   double create_times[TEST_NSAMPLES];
+   double release_times[TEST_NSAMPLES];
+   for ( i = 0; i < TEST_NSAMPLES; i++ ) {
+      create_times[i] = GET_TIME;
+      for ( x = 0; x < GRID_SIZE; x++ ) {
+         for ( y = 0; y < GRID_SIZE; y++ ) {
+            /* SMP device descriptor */
+            static nanos_smp_args_t _ol_test_dependency_edges_1_smp_args = {(void (*)(void *)) _smp__ol_test_dependency_edges_1};
+            _nx_data_env_1_t *ol_args = (_nx_data_env_1_t *) 0;
+            nanos_wd_t wd = (nanos_wd_t) 0;
+            struct nanos_const_wd_definition_local_t { nanos_const_wd_definition_t base; nanos_device_t devices[1];
+            };
+            static struct nanos_const_wd_definition_local_t _const_def = {
+               { { 1, 1, 0, 0, 0, 0, 0, 0 }, __alignof__(_nx_data_env_1_t), 0, 1, 0, NULL }, {{ nanos_smp_factory, &_ol_test_dependency_edges_1_smp_args }}
+            };
+            nanos_wd_dyn_props_t dyn_props = {0};
+            nanos_err_t err;
+
+            nanos_region_dimension_t dimensions[1] = {{sizeof(double), 0, sizeof(double)}};
+            nanos_data_access_t data_accesses[5];
+            int num_accesses = 0;
+            nanos_data_access_t inout = {&grid[x][y], {1,1,0,0,0}, 1, dimensions};
+            data_accesses[num_accesses++] = inout;
+            if ( x > 0 ) { nanos_data_access_t in = {&grid[x-1][y], {1,0,0,0,0}, 1, dimensions}; data_accesses[num_accesses++] = in; }
+            if ( x < GRID_SIZE - 1 ) { nanos_data_access_t in = {&grid[x+1][y], {1,0,0,0,0}, 1, dimensions}; data_accesses[num_accesses++] = in; }
+            if ( y > 0 ) { nanos_data_access_t in = {&grid[x][y-1], {1,0,0,0,0}, 1, dimensions}; data_accesses[num_accesses++] = in; }
+            if ( y < GRID_SIZE - 1 ) { nanos_data_access_t in = {&grid[x][y+1], {1,0,0,0,0}, 1, dimensions}; data_accesses[num_accesses++] = in; }
+
+            err = nanos_create_wd_compact(&wd, &_const_def.base, &dyn_props, sizeof(_nx_data_env_1_t),
+                                          (void **) &ol_args, nanos_current_wd(), (nanos_copy_data_t **) 0, NULL
+                  );
+            if (err != NANOS_OK) nanos_handle_error(err);
+
+            err = nanos_submit(wd, num_accesses, data_accesses, (nanos_team_t) 0);
+            if (err != NANOS_OK) nanos_handle_error(err);
+         }
+      }
+      create_times[i] = ( GET_TIME - create_times[i] ) / NUM_BLOCKS;
+
+      release_times[i] = GET_TIME;
+      nanos_wg_wait_completion( nanos_current_wd(), false );
+      release_times[i] = ( GET_TIME - release_times[i] ) / NUM_BLOCKS;
+   }
+   stats( create, create_times, TEST_NSAMPLES);
+   stats( release, release_times, TEST_NSAMPLES);
+}
+
+int main ( int argc, char *argv[] )
+{
+   stats_t create, release;
+
+   test_dependency_edges_overhead( &create, &release );
+   print_stats ( "Dependency edges creation overhead","warm-up", &create );
+   print_stats ( "Dependency edges release overhead","warm-up", &release );
+   test_dependency_edges_overhead( &create, &release );
+   print_stats ( "Dependency edges creation overhead","test", &create );
+   print_stats ( "Dependency edges release overhead","test", &release );
+
+   return 0;
+}
@@ -0,0 +1,105 @@
+/*************************************************************************************/
+/*      Copyright 2009-2018 Barcelona Supercomputing Center                          */
+/*                                                                                   */
+/*      This file is part of the NANOS++ library.                                    */
+/*                                                                                   */
+/*      NANOS++ is free software: you can redistribute it and/or modify              */
+/*      it under the terms of the GNU Lesser General Public License as published by  */
+/*      the Free Software Foundation, either version 3 of the License, or            */
+/*      (at your option) any later version.                                          */
+/*                                                                                   */
+/*      NANOS++ is distributed in the hope that it will be useful,                   */
+/*      but WITHOUT ANY WARRANTY; without even the implied warranty of               */
+/*      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                */
+/*      GNU Lesser General Public License for more details.                          */
+/*                                                                                   */
+/*      You should have received a copy of the GNU Lesser General Public License     */
+/*      along with NANOS++.  If not, see <https://www.gnu.org/licenses/>.            */
+/*************************************************************************************/
+
+#include "common.h"
+
+/*
+<testinfo>
+test_generator="gens/mcc-openmp-generator -d regions,cregions,intervals"
+test_generator_ENV=( "NX_TEST_MODE=performance" )
+</testinfo>
+*/
+
+// TEST: Tile Regions Dependencies Overhead ****************************************************
+// Each sample submits one wavefront sweep over a square matrix partitioned in tiles: every task
+// updates its tile and reads the tiles above and to its left. Tiles are 2D regions, so their
+// covering address ranges interleave with those of every other tile in the same tile row and
+// thousands of regions are live at once. Tasks are empty, so the submission time measures the
+// dependence analysis and the taskwait time the dependence release.
+#define MATRIX_SIZE  1024
+#define TILE_SIZE    32
+#define NUM_TILES    ( MATRIX_SIZE / TILE_SIZE )
+
+double matrix[MATRIX_SIZE][MATRIX_SIZE];
+
+typedef struct _nx_data_env_1_t_tag { } _nx_data_env_1_t;
+static void _smp__ol_test_tile_regions_1(_nx_data_env_1_t *const __restrict__ _args) { }
+
+void test_tile_regions_overhead ( stats_t *create, stats_t *release )
+{
+   int i, ti, tj;
+   double create_times[TEST_NSAMPLES];
+   double release_times[TEST_NSAMPLES];
+   for ( i = 0; i < TEST_NSAMPLES; i++ ) {
+      create_times[i] = GET_TIME;
+      for ( ti = 0; ti < NUM_TILES; ti++ ) {
+         for ( tj = 0; tj < NUM_TILES; tj++ ) {
+            /* SMP device descriptor */
+            static nanos_smp_args_t _ol_test_tile_regions_1_smp_args = {(void (*)(void *)) _smp__ol_test_tile_regions_1};
+            _nx_data_env_1_t *ol_args = (_nx_data_env_1_t *) 0;
+            nanos_wd_t wd = (nanos_wd_t) 0;
+            struct nanos_const_wd_definition_local_t { nanos_const_wd_definition_t base; nanos_device_t devices[1];
+            };
+            static struct nanos_const_wd_definition_local_t _const_def = {
+               { { 1, 1, 0, 0, 0, 0, 0, 0 }, __alignof__(_nx_data_env_1_t), 0, 1, 0, NULL }, {{ nanos_smp_factory, &_ol_test_tile_regions_1_smp_args }}
+            };
+            nanos_wd_dyn_props_t dyn_props = {0};
+            nanos_err_t err;
+
+            nanos_region_dimension_t tile_dimensions[2] = {{MATRIX_SIZE * sizeof(double), 0, TILE_SIZE * sizeof(double)},
+                                                           {MATRIX_SIZE, 0, TILE_SIZE}};
+            nanos_data_access_t data_accesses[3];
+            int num_accesses = 0;
+            nanos_data_access_t inout = {&matrix[ti * TILE_SIZE][tj * TILE_SIZE], {1,1,0,0,0}, 2, tile_dimensions};
+            data_accesses[num_accesses++] = inout;
+            if ( ti > 0 ) { nanos_data_access_t in = {&matrix[(ti - 1) * TILE_SIZE][tj * TILE_SIZE], {1,0,0,0,0}, 2, tile_dimensions}; data_accesses[num_accesses++] = in; }
+            if ( tj > 0 ) { nanos_data_access_t in = {&matrix[ti * TILE_SIZE][(tj - 1) * TILE_SIZE], {1,0,0,0,0}, 2, tile_dimensions}; data_accesses[num_accesses++] = in; }
+
+            err = nanos_create_wd_compact(&wd, &_const_def.base, &dyn_props, sizeof(_nx_data_env_1_t),
+                                          (void **) &ol_args, nanos_current_wd(), (nanos_copy_data_t **) 0, NULL
+                  );
+            if (err != NANOS_OK) nanos_handle_error(err);
+
+            err = nanos_submit(wd, num_accesses, data_accesses, (nanos_team_t) 0);
+            if (err != NANOS_OK) nanos_handle_error(err);
+         }
+      }
+      create_times[i] = ( GET_TIME - create_times[i] ) / ( NUM_TILES * NUM_TILES );
+
+      release_times[i] = GET_TIME;
+      nanos_wg_wait_completion( nanos_current_wd(), false );
+      release_times[i] = ( GET_TIME - release_times[i] ) / ( NUM_TILES * NUM_TILES );
+   }
+   stats( create, create_times, TEST_NSAMPLES);
+   stats( release, release_times, TEST_NSAMPLES);
+}
+
+int main ( int argc, char *argv[] )
+{
+   stats_t create, release;
+
+   test_tile_regions_overhead( &create, &release );
+   print_stats ( "Tile regions dependencies creation overhead","warm-up", &create );
+   print_stats ( "Tile regions dependencies release overhead","warm-up", &release );
+   test_tile_regions_overhead( &create, &release );
+   print_stats ( "Tile regions dependencies creation overhead","test", &create );
+   print_stats ( "Tile regions dependencies release overhead","test", &release );
+
+   return 0;
+}